@@ -0,0 +1,129 @@
+// Command line options of the app
+
+#ifndef COMMON_APP_OPTIONS_H
+#define COMMON_APP_OPTIONS_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "ErrorHandling.h"
+#include "VulkanConfig.h"
+
+
+struct AppOptions{
+	bool help = false;
+	bool offscreen = false; // render into plain images and read them back instead of presenting
+	bool recordBenchmark = false; // measure multi-threaded command recording against thread count
+	bool meshBenchmark = false; // measure chunk meshing speed and triangle counts on synthetic terrains
+	bool genBenchmark = false; // measure procedural chunk generation speed per SIMD path
+	bool streamBenchmark = false; // fly a camera over streamed terrain and measure frame loop stalls and chunk load times
+	bool storageBenchmark = false; // save chunks to region files and load them back, measuring speed and file size
+	bool cullBenchmark = false; // measure frustum culling of chunk boxes per code path
+	bool indirectBenchmark = false; // draw chunk meshes culled on the CPU, then culled and drawn indirectly by the GPU
+	bool occlusionBenchmark = false; // draw chunk meshes frustum culled by the GPU, then occlusion culled against a Hi-Z pyramid
+	uint32_t threadCount = 0; // of the job system, and the highest one of --record-benchmark; 0 means all hardware threads
+	uint64_t drawCount = 0; // 0 means the default of the selected mode
+	uint64_t chunkCount = 0; // 0 means the default of the selected mode
+	uint64_t frameCount = 0; // 0 means the default of the selected mode
+	uint32_t framesInFlight = 0; // 0 means the default of the selected mode
+	uint64_t chunkBudget = 0; // MiB; 0 means VulkanConfig::chunkMemoryBudget
+	uint32_t width = 0; // 0 means VulkanConfig::initialWindowWidth
+	uint32_t height = 0; // 0 means VulkanConfig::initialWindowHeight
+	std::string reportPath; // where benchmark modes write their JSON report; empty means stdout
+	bool pipelineCache = true; // false forces cold pipeline compilation and leaves the cache file alone
+	std::string pipelineCachePath; // empty means VulkanConfig::pipelineCachePath
+};
+
+inline void printAppUsage( const char* programName ){
+	logger << "Usage: " << programName << " [options]\n"
+	       << "  --offscreen            render offscreen with readback and write a benchmark report\n"
+	       << "  --frames N             number of frames to render (offscreen, headless and benchmark modes)\n"
+	       << "  --frames-in-flight N   frames the CPU may record ahead of the GPU\n"
+	       << "  --width N              render target width\n"
+	       << "  --height N             render target height\n"
+	       << "  --report FILE          benchmark JSON report file (default: stdout)\n"
+	       << "  --record-benchmark     measure command recording time against thread count\n"
+	       << "  --threads N            job system threads; the highest count tried by --record-benchmark\n"
+	       << "  --draws N              number of draws recorded per frame by --record-benchmark\n"
+	       << "  --mesh-benchmark       measure chunk meshing speed and triangles per chunk (no GPU needed)\n"
+	       << "  --gen-benchmark        measure world generation speed per SIMD path (no GPU needed)\n"
+	       << "  --chunks N             chunks meshed per terrain by --mesh-benchmark, generated per path by --gen-benchmark,\n"
+	       << "                         saved and loaded by --storage-benchmark\n"
+	       << "  --stream-benchmark     fly over streamed terrain, measure chunk loading and frame stalls (no GPU needed)\n"
+	       << "  --chunk-budget N       MiB of chunk voxels kept in memory, loaded, cached and compressed (--stream-benchmark)\n"
+	       << "  --storage-benchmark    save chunks to region files and load them back, measure speed and size (no GPU needed)\n"
+	       << "  --cull-benchmark       measure frustum culling of chunk boxes, hierarchical and per chunk (no GPU needed)\n"
+	       << "  --indirect-benchmark   compare drawing chunks culled on the CPU with GPU culling and indirect drawing\n"
+	       << "  --occlusion-benchmark  compare GPU frustum culling of chunks with two-phase Hi-Z occlusion culling\n"
+	       << "  --pipeline-cache FILE  pipeline cache file to load and save\n"
+	       << "  --no-pipeline-cache    compile pipelines from scratch (cold start)\n"
+	       << "  --help                 show this text" << std::endl;
+}
+
+// unknown or malformed arguments are reported and ignored, so the app still runs with defaults
+inline AppOptions parseAppOptions( const int argc, char* argv[] ){
+	using std::strcmp;
+
+	AppOptions options;
+
+	const auto parseNumber = [&]( int& i, uint64_t& value ){
+		if( i + 1 >= argc ){
+			logger << "WARNING: Missing value for command line argument " << argv[i] << std::endl;
+			return;
+		}
+
+		const char* const arg = argv[i];
+		const std::string text = argv[++i];
+		try{
+			size_t parsed;
+			const unsigned long long number = std::stoull( text, &parsed );
+			if( parsed != text.size() ) throw std::invalid_argument( text );
+			value = number;
+		}
+		catch( ... ){
+			logger << "WARNING: Ignoring malformed value \"" << text << "\" of command line argument " << arg << std::endl;
+		}
+	};
+
+	for( int i = 1; i < argc; ++i ){
+		if( strcmp( argv[i], "--help" ) == 0 || strcmp( argv[i], "-h" ) == 0 ) options.help = true;
+		else if( strcmp( argv[i], "--offscreen" ) == 0 ) options.offscreen = true;
+		else if( strcmp( argv[i], "--record-benchmark" ) == 0 ) options.recordBenchmark = true;
+		else if( strcmp( argv[i], "--mesh-benchmark" ) == 0 ) options.meshBenchmark = true;
+		else if( strcmp( argv[i], "--gen-benchmark" ) == 0 ) options.genBenchmark = true;
+		else if( strcmp( argv[i], "--stream-benchmark" ) == 0 ) options.streamBenchmark = true;
+		else if( strcmp( argv[i], "--storage-benchmark" ) == 0 ) options.storageBenchmark = true;
+		else if( strcmp( argv[i], "--cull-benchmark" ) == 0 ) options.cullBenchmark = true;
+		else if( strcmp( argv[i], "--indirect-benchmark" ) == 0 ) options.indirectBenchmark = true;
+		else if( strcmp( argv[i], "--occlusion-benchmark" ) == 0 ) options.occlusionBenchmark = true;
+		else if( strcmp( argv[i], "--chunks" ) == 0 ) parseNumber( i, options.chunkCount );
+		else if( strcmp( argv[i], "--chunk-budget" ) == 0 ) parseNumber( i, options.chunkBudget );
+		else if( strcmp( argv[i], "--threads" ) == 0 ){ uint64_t t = options.threadCount; parseNumber( i, t ); options.threadCount = static_cast<uint32_t>( t ); }
+		else if( strcmp( argv[i], "--draws" ) == 0 ) parseNumber( i, options.drawCount );
+		else if( strcmp( argv[i], "--frames" ) == 0 ) parseNumber( i, options.frameCount );
+		else if( strcmp( argv[i], "--frames-in-flight" ) == 0 ){ uint64_t f = options.framesInFlight; parseNumber( i, f ); options.framesInFlight = static_cast<uint32_t>( f ); }
+		else if( strcmp( argv[i], "--width" ) == 0 ){ uint64_t w = options.width; parseNumber( i, w ); options.width = static_cast<uint32_t>( w ); }
+		else if( strcmp( argv[i], "--height" ) == 0 ){ uint64_t h = options.height; parseNumber( i, h ); options.height = static_cast<uint32_t>( h ); }
+		else if( strcmp( argv[i], "--report" ) == 0 ){
+			if( i + 1 < argc ) options.reportPath = argv[++i];
+			else logger << "WARNING: Missing value for command line argument " << argv[i] << std::endl;
+		}
+		else if( strcmp( argv[i], "--pipeline-cache" ) == 0 ){
+			if( i + 1 < argc ) options.pipelineCachePath = argv[++i];
+			else logger << "WARNING: Missing value for command line argument " << argv[i] << std::endl;
+		}
+		else if( strcmp( argv[i], "--no-pipeline-cache" ) == 0 ) options.pipelineCache = false;
+		else logger << "WARNING: Ignoring unknown command line argument " << argv[i] << std::endl;
+	}
+
+	return options;
+}
+
+inline std::string getPipelineCachePath( const AppOptions& options ){
+	if( !options.pipelineCache ) return ""; // in memory only
+	return options.pipelineCachePath.empty() ? VulkanConfig::pipelineCachePath : options.pipelineCachePath;
+}
+
+#endif //COMMON_APP_OPTIONS_H
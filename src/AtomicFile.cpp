@@ -0,0 +1,71 @@
+// Replacing a file in one step, so a crash leaves either the old version or the whole new one behind
+#if defined(_WIN32)
+	#include "LeanWindowsEnvironment.h"
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <cerrno>
+#endif
+
+#include "AtomicFile.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+// Implementation
+//////////////////////////////////
+
+#if defined(_WIN32)
+
+static bool writeSynced( const std::string& path, const void* const data, const size_t size ){
+	const HANDLE file = CreateFileA( path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( file == INVALID_HANDLE_VALUE ) return false;
+
+	DWORD written = 0;
+	const bool synced = WriteFile( file, data, static_cast<DWORD>( size ), &written, nullptr ) && written == size && FlushFileBuffers( file );
+	return CloseHandle( file ) && synced;
+}
+
+bool replaceFile( const std::string& from, const std::string& to ){
+	return MoveFileExA( from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != 0;
+}
+
+#else
+
+static bool writeSynced( const std::string& path, const void* const data, const size_t size ){
+	const int file = ::open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+	if( file < 0 ) return false;
+
+	const char* bytes = static_cast<const char*>( data );
+	size_t left = size;
+	bool synced = true;
+	while( left ){
+		const ssize_t written = ::write( file, bytes, left );
+		if( written < 0 && errno == EINTR ) continue;
+		if( written <= 0 ){
+			synced = false;
+			break;
+		}
+		bytes += written;
+		left -= size_t( written );
+	}
+	synced = synced && fsync( file ) == 0;
+	return ::close( file ) == 0 && synced;
+}
+
+bool replaceFile( const std::string& from, const std::string& to ){
+	return std::rename( from.c_str(), to.c_str() ) == 0; // atomic on POSIX
+}
+
+#endif
+
+bool writeFileAtomically( const std::string& path, const void* const data, const size_t size ){
+	const std::string temporaryPath = path + ".tmp";
+	if(  !writeSynced( temporaryPath, data, size ) || !replaceFile( temporaryPath, path )  ){
+		std::remove( temporaryPath.c_str() );
+		return false;
+	}
+	return true;
+}
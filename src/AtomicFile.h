@@ -0,0 +1,18 @@
+// Replacing a file in one step, so a crash leaves either the old version or the whole new one behind
+
+#ifndef COMMON_ATOMIC_FILE_H
+#define COMMON_ATOMIC_FILE_H
+
+#include <cstddef>
+#include <string>
+
+
+// Writes data to path + ".tmp", waits until it is on the disk, and only then renames it over path; false if any of it
+// failed, with path left as it was and the temporary file removed.
+bool writeFileAtomically( const std::string& path, const void* data, size_t size );
+
+// Renames from over to, replacing it if it exists, in one step: rename() on POSIX, MoveFileEx() on Windows, where
+// rename() refuses to replace. from should be on the disk already, or a crash may leave to empty; false on failure.
+bool replaceFile( const std::string& from, const std::string& to );
+
+#endif //COMMON_ATOMIC_FILE_H
@@ -0,0 +1,137 @@
+// Timing statistics and JSON benchmark reports
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Implementation
+//////////////////////////////////
+
+SampleStatistics getSampleStatistics( vector<double> samples ){
+	if( samples.empty() ) return { 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+	std::sort( samples.begin(), samples.end() );
+
+	const auto percentile = [&samples]( const double p ){
+		const size_t rank = static_cast<size_t>(  std::ceil( p / 100.0 * samples.size() )  );
+		return samples[ std::max<size_t>( rank, 1 ) - 1 ];
+	};
+
+	const double sum = std::accumulate( samples.begin(), samples.end(), 0.0 );
+
+	return {
+		samples.size(),
+		samples.front(), // min
+		sum / samples.size(), // mean
+		percentile( 50.0 ),
+		percentile( 90.0 ),
+		percentile( 95.0 ),
+		percentile( 99.0 ),
+		samples.back() // max
+	};
+}
+
+
+static string jsonNumber( const double value ){
+	if( !std::isfinite( value ) ) return "null"; // JSON has no NaN or infinity
+
+	std::ostringstream ss;
+	ss.precision( 9 );
+	ss << value;
+	return ss.str();
+}
+
+static string jsonString( const string& value ){
+	string escaped = "\"";
+	for( const char c : value ){
+		switch( c ){
+			case '"': escaped += "\\\""; break;
+			case '\\': escaped += "\\\\"; break;
+			case '\n': escaped += "\\n"; break;
+			case '\r': escaped += "\\r"; break;
+			case '\t': escaped += "\\t"; break;
+			default:
+				if( static_cast<unsigned char>( c ) < 0x20 ){
+					char code[8];
+					std::snprintf( code, sizeof( code ), "\\u%04x", static_cast<unsigned>( c ) );
+					escaped += code;
+				}
+				else escaped += c;
+		}
+	}
+	escaped += '"';
+
+	return escaped;
+}
+
+
+BenchmarkReport::BenchmarkReport( const string& name ){
+	setString( "benchmark", name );
+}
+
+void BenchmarkReport::setField( const string& key, const string& json ){
+	const auto it = std::find_if(  m_fields.begin(), m_fields.end(), [&key]( const std::pair<string, string>& f ){ return f.first == key; }  );
+	if( it != m_fields.end() ) it->second = json;
+	else m_fields.emplace_back( key, json );
+}
+
+void BenchmarkReport::setNumber( const string& key, const double value ){
+	setField( key, jsonNumber( value ) );
+}
+
+void BenchmarkReport::setInteger( const string& key, const uint64_t value ){
+	setField( key, std::to_string( value ) );
+}
+
+void BenchmarkReport::setString( const string& key, const string& value ){
+	setField( key, jsonString( value ) );
+}
+
+void BenchmarkReport::setStatistics( const string& key, const SampleStatistics& s ){
+	const string json = string( "{ " )
+		+ "\"count\": " + std::to_string( s.count )
+		+ ", \"min\": " + jsonNumber( s.min )
+		+ ", \"mean\": " + jsonNumber( s.mean )
+		+ ", \"p50\": " + jsonNumber( s.p50 )
+		+ ", \"p90\": " + jsonNumber( s.p90 )
+		+ ", \"p95\": " + jsonNumber( s.p95 )
+		+ ", \"p99\": " + jsonNumber( s.p99 )
+		+ ", \"max\": " + jsonNumber( s.max )
+		+ " }";
+
+	setField( key, json );
+}
+
+string BenchmarkReport::toJson() const{
+	string json = "{\n";
+	for( size_t i = 0; i < m_fields.size(); ++i ){
+		json += "\t" + jsonString( m_fields[i].first ) + ": " + m_fields[i].second;
+		json += (i + 1 < m_fields.size()) ? ",\n" : "\n";
+	}
+	json += "}\n";
+
+	return json;
+}
+
+void BenchmarkReport::write( const string& path ) const{
+	if( path.empty() || path == "-" ){
+		std::cout << toJson() << std::flush;
+		return;
+	}
+
+	std::ofstream ofs( path, std::ios::out | std::ios::trunc );
+	if( !ofs ) throw string( "Cannot open benchmark report file " ) + path;
+	ofs << toJson();
+	if( !ofs ) throw string( "Failed writing benchmark report file " ) + path;
+}
@@ -0,0 +1,48 @@
+// Timing statistics and JSON benchmark reports
+
+#ifndef COMMON_BENCHMARK_H
+#define COMMON_BENCHMARK_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+struct SampleStatistics{
+	size_t count;
+	double min;
+	double mean;
+	double p50;
+	double p90;
+	double p95;
+	double p99;
+	double max;
+};
+
+// nearest-rank percentiles; takes the samples by value because it has to sort them
+SampleStatistics getSampleStatistics( std::vector<double> samples );
+
+
+// A flat JSON object; fields are written in the order they were set
+class BenchmarkReport{
+public:
+	explicit BenchmarkReport( const std::string& name );
+
+	void setNumber( const std::string& key, double value );
+	void setInteger( const std::string& key, uint64_t value );
+	void setString( const std::string& key, const std::string& value );
+	void setStatistics( const std::string& key, const SampleStatistics& statistics );
+
+	std::string toJson() const;
+
+	// empty path or "-" writes to stdout
+	void write( const std::string& path ) const;
+
+private:
+	void setField( const std::string& key, const std::string& json );
+
+	std::vector< std::pair<std::string, std::string> > m_fields; // key and its already serialized value
+};
+
+#endif //COMMON_BENCHMARK_H
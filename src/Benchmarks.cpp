@@ -0,0 +1,1461 @@
+// The benchmark modes of the app; each writes a BenchmarkReport and returns the exit status of the app
+#include "VulkanEnvironment.h" // first include must be before vulkan.h and platform header
+
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream> // VulkanImpl.h relies on the includer for these
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "AppOptions.h"
+#include "Benchmark.h"
+#include "Camera.h"
+#include "CpuFeatures.h"
+#include "ErrorHandling.h"
+#include "FrameScheduler.h"
+#include "HiZPyramid.h"
+#include "IndirectChunkRenderer.h"
+#include "JobSystem.h"
+#include "OffscreenGpu.h"
+#include "ParallelRecorder.h"
+#include "Vertex.h"
+#include "VulkanConfig.h"
+#include "VulkanImpl.h"
+
+#include "World/BinaryMesher.h"
+#include "World/ChunkCuller.h"
+#include "World/ChunkResidency.h"
+#include "World/ChunkStreamer.h"
+#include "World/ChunkMesh.h"
+#include "World/GreedyMesher.h"
+#include "World/TestTerrain.h"
+#include "World/VoxelWorld.h"
+#include "World/WorldGenerator.h"
+#include "World/WorldStorage.h"
+
+
+using std::string;
+using std::to_string;
+using std::vector;
+
+// Implementation
+//////////////////////////////////
+
+// Renders into plain images instead of a swapchain and reads every frame back to the host.
+// Needs no presentation support, so it gives a repeatable throughput number anywhere.
+int offscreenBenchmark( const AppOptions& options ) try{
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	const auto startupTime = steady_clock::now();
+
+	const uint32_t vertexBufferBinding = 0;
+	const vector<Vertex2D_ColorF_pack> triangle = makeTriangle();
+
+	const uint64_t frameCount = options.frameCount ? options.frameCount : VulkanConfig::benchmarkFrameCount;
+
+	OffscreenGpu::Settings settings;
+	settings.width = options.width ? options.width : VulkanConfig::initialWindowWidth;
+	settings.height = options.height ? options.height : VulkanConfig::initialWindowHeight;
+	settings.framesInFlight = options.framesInFlight ? options.framesInFlight : VulkanConfig::readbackRingSize;
+	settings.timestampsPerFrame = 2; // the start and the end of the frame
+	OffscreenGpu gpu( settings, getPipelineCachePath( options ) );
+
+	const VkDevice device = gpu.getDevice();
+	const VkPhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties = gpu.getMemoryProperties();
+	const uint32_t width = gpu.getWidth();
+	const uint32_t height = gpu.getHeight();
+	const uint32_t ringSize = gpu.getFramesInFlight();
+	UploadManager& uploader = gpu.getUploader();
+
+	vector<uint32_t> vertexShaderBinary = {
+#include "shaders/hello_triangle.vert.spv.inl"
+	};
+	vector<uint32_t> fragmentShaderBinary = {
+#include "shaders/hello_triangle.frag.spv.inl"
+	};
+	VkShaderModule vertexShader = initShaderModule( device, vertexShaderBinary );
+	VkShaderModule fragmentShader = initShaderModule( device, fragmentShaderBinary );
+	VkPipelineLayout pipelineLayout = initPipelineLayout( device );
+
+	VkBuffer vertexBuffer = initBuffer( device, sizeof( decltype( triangle )::value_type ) * triangle.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, uploader.getQueueFamilies() );
+	MemoryAllocation vertexBufferMemory = initMemory<ResourceType::Buffer>(
+		device,
+		physicalDeviceMemoryProperties,
+		vertexBuffer,
+		{VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT}
+	);
+	uploader.wait(  setVertexData( uploader, vertexBuffer, triangle )  );
+
+	const auto pipelineStart = steady_clock::now();
+	VkPipeline pipeline = initPipeline(
+		device,
+		gpu.getPipelineCache().get(),
+		gpu.getProperties().limits,
+		pipelineLayout,
+		gpu.getRenderPass(),
+		vertexShader,
+		fragmentShader,
+		vertexBufferBinding
+	);
+	const double pipelineCreateMs = duration<double, std::milli>( steady_clock::now() - pipelineStart ).count();
+
+
+	// one readback buffer per render target, so a frame never waits for the readback of the previous one
+	const VkDeviceSize frameBytes = VkDeviceSize( width ) * height * VulkanConfig::offscreenTexelSize;
+	const std::vector<VkMemoryPropertyFlags> readbackMemoryPriority{
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, // cached makes the CPU reads fast
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT // guaranteed to allways be supported
+	};
+
+	vector<VkBuffer> readbackBuffers;
+	vector<MemoryAllocation> readbackMemories;
+	vector<const uint64_t*> readbackData; // persistently mapped
+	for( uint32_t i = 0; i < ringSize; ++i ){
+		readbackBuffers.push_back(  initBuffer( device, frameBytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT )  );
+		readbackMemories.push_back(  initMemory<ResourceType::Buffer>( device, physicalDeviceMemoryProperties, readbackBuffers.back(), readbackMemoryPriority )  );
+		readbackData.push_back(  static_cast<const uint64_t*>( mapMemory( device, readbackMemories.back() ) )  );
+	}
+
+	// recorded every frame, like a real scene would need to
+	vector<DrawCommand> drawList;
+
+
+	vector<double> cpuFrameTimes;
+	vector<double> gpuFrameTimes;
+	cpuFrameTimes.reserve( frameCount );
+	gpuFrameTimes.reserve( frameCount );
+	uint64_t bytesReadBack = 0;
+	uint64_t checksum = 0; // actually touches the read back texels, so the host reads cannot be skipped
+	double timeToFirstFrameMs = 0.0; // until the first frame is read back
+
+	const auto benchmarkStart = steady_clock::now();
+	gpu.runFrames(
+		frameCount,
+		[&]( const VkCommandBuffer commandBuffer, uint64_t /*frame*/, const uint32_t slot ){
+			drawList.clear();
+			drawList.push_back(  {pipeline, vertexBuffer, 0 /*offset*/, static_cast<uint32_t>( triangle.size() )}  );
+
+			gpu.recordFrameStart( commandBuffer, slot );
+
+			recordBeginRenderPass( commandBuffer, gpu.getRenderPass(), gpu.getFramebuffer( slot ), VulkanConfig::clearColor, width, height );
+				recordSetViewport( commandBuffer, width, height );
+				recordDrawList( commandBuffer, vertexBufferBinding, drawList );
+			recordEndRenderPass( commandBuffer );
+
+			recordReadback( commandBuffer, gpu.getTarget( slot ), readbackBuffers[slot], width, height );
+
+			gpu.recordTimestamp( commandBuffer, slot, 1 );
+		},
+		// the slot's frame is complete, i.e. its readback and timestamps are
+		[&]( const uint32_t slot ){
+			double gpuFrameTime;
+			if(  gpu.getTimestampIntervals( slot, &gpuFrameTime )  ) gpuFrameTimes.push_back( gpuFrameTime );
+
+			const uint64_t* const data = readbackData[slot];
+			for( VkDeviceSize i = 0; i < frameBytes / sizeof( uint64_t ); ++i ) checksum ^= data[i];
+			if( bytesReadBack == 0 ) timeToFirstFrameMs = duration<double, std::milli>( steady_clock::now() - startupTime ).count();
+			bytesReadBack += frameBytes;
+		},
+		&cpuFrameTimes
+	);
+	const double seconds = duration<double>( steady_clock::now() - benchmarkStart ).count();
+
+
+	BenchmarkReport report( "offscreen" );
+	report.setString( "device", gpu.getProperties().deviceName );
+	report.setInteger( "width", width );
+	report.setInteger( "height", height );
+	report.setInteger( "frames", frameCount );
+	report.setInteger( "framesInFlight", ringSize );
+	report.setNumber( "seconds", seconds );
+	report.setNumber( "framesPerSecond", seconds > 0.0 ? frameCount / seconds : 0.0 );
+	report.setStatistics( "cpuFrameTimeMs", getSampleStatistics( cpuFrameTimes ) );
+	if( gpu.hasGpuTiming() ) report.setStatistics( "gpuFrameTimeMs", getSampleStatistics( gpuFrameTimes ) );
+	report.setInteger( "bytesReadBack", bytesReadBack );
+	report.setInteger( "readbackChecksum", checksum );
+	report.setString( "uploadQueue", uploader.isDedicatedTransferQueue() ? "transfer" : "graphics" );
+	report.setInteger( "bytesUploaded", uploader.getStatistics().bytesUploaded );
+	report.setString( "pipelineCache", !options.pipelineCache ? "disabled" : gpu.getPipelineCache().isWarm() ? "warm" : "cold" );
+	report.setNumber( "pipelineCreateMs", pipelineCreateMs );
+	report.setNumber( "timeToFirstFrameMs", timeToFirstFrameMs );
+	for( const auto& heap : getMemoryStatistics( device ) ){
+		if( heap.reservedBytes == 0 ) continue;
+		const string prefix = "memoryHeap" + to_string( heap.heapIndex );
+		report.setInteger( prefix + "ReservedBytes", heap.reservedBytes );
+		report.setInteger( prefix + "UsedBytes", heap.usedBytes );
+		report.setNumber( prefix + "Fragmentation", heap.fragmentation );
+	}
+	report.write( options.reportPath );
+
+
+	// proper Vulkan cleanup; gpu destroys the device and the rest
+	{VkResult errorCode = vkDeviceWaitIdle( device ); RESULT_HANDLER( errorCode, "vkDeviceWaitIdle" );}
+
+	for( uint32_t i = 0; i < ringSize; ++i ){
+		killBuffer( device, readbackBuffers[i] );
+		killMemory( device, readbackMemories[i] );
+	}
+	killPipeline( device, pipeline );
+	killBuffer( device, vertexBuffer );
+	killMemory( device, vertexBufferMemory );
+	killPipelineLayout( device, pipelineLayout );
+	killShaderModule( device, fragmentShader );
+	killShaderModule( device, vertexShader );
+
+	return EXIT_SUCCESS;
+}
+catch( ... ){
+	return exitOnUncaughtException();
+}
+
+
+// Records one big draw list into secondary command buffers with 1, 2, 4, ... threads and reports the time of each.
+// Nothing is submitted -- only the CPU cost of recording (vkEndCommandBuffer included) is measured.
+int recordingBenchmark( const AppOptions& options ) try{
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	const uint32_t vertexBufferBinding = 0;
+	const vector<Vertex2D_ColorF_pack> triangle = makeTriangle();
+
+	const uint64_t frameCount = options.frameCount ? options.frameCount : VulkanConfig::recordBenchmarkFrameCount;
+	const uint64_t drawCount = options.drawCount ? options.drawCount : VulkanConfig::recordBenchmarkDrawCount;
+	const uint32_t maxThreads = options.threadCount ? options.threadCount : std::max( 1u, std::thread::hardware_concurrency() );
+
+	OffscreenGpu::Settings settings;
+	settings.width = options.width ? options.width : VulkanConfig::initialWindowWidth;
+	settings.height = options.height ? options.height : VulkanConfig::initialWindowHeight;
+	settings.framesInFlight = 1; // nothing is submitted; the scheduler only recycles the pool
+	OffscreenGpu gpu( settings, getPipelineCachePath( options ) );
+
+	const VkDevice device = gpu.getDevice();
+	const uint32_t width = gpu.getWidth();
+	const uint32_t height = gpu.getHeight();
+	const VkRenderPass renderPass = gpu.getRenderPass();
+	const VkFramebuffer framebuffer = gpu.getFramebuffer( 0 );
+	UploadManager& uploader = gpu.getUploader();
+
+	vector<uint32_t> vertexShaderBinary = {
+#include "shaders/hello_triangle.vert.spv.inl"
+	};
+	vector<uint32_t> fragmentShaderBinary = {
+#include "shaders/hello_triangle.frag.spv.inl"
+	};
+	VkShaderModule vertexShader = initShaderModule( device, vertexShaderBinary );
+	VkShaderModule fragmentShader = initShaderModule( device, fragmentShaderBinary );
+	VkPipelineLayout pipelineLayout = initPipelineLayout( device );
+	VkPipeline pipeline = initPipeline(
+		device,
+		gpu.getPipelineCache().get(),
+		gpu.getProperties().limits,
+		pipelineLayout,
+		renderPass,
+		vertexShader,
+		fragmentShader,
+		vertexBufferBinding
+	);
+
+	// like chunk meshes, every draw reads different vertices, so each one rebinds the vertex buffer
+	const uint32_t meshCount = 64;
+	vector<Vertex2D_ColorF_pack> meshes;
+	for( uint32_t i = 0; i < meshCount; ++i ) meshes.insert( meshes.end(), triangle.begin(), triangle.end() );
+	const VkDeviceSize meshBytes = sizeof( Vertex2D_ColorF_pack ) * triangle.size();
+
+	VkBuffer vertexBuffer = initBuffer( device, meshBytes * meshCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, uploader.getQueueFamilies() );
+	MemoryAllocation vertexBufferMemory = initMemory<ResourceType::Buffer>( device, gpu.getMemoryProperties(), vertexBuffer, {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT} );
+	uploader.wait(  setVertexData( uploader, vertexBuffer, meshes )  );
+
+	vector<DrawCommand> drawList;
+	drawList.reserve( drawCount );
+	for( uint64_t i = 0; i < drawCount; ++i ){
+		drawList.push_back(  {pipeline, vertexBuffer, (i % meshCount) * meshBytes, static_cast<uint32_t>( triangle.size() )}  );
+	}
+
+
+	BenchmarkReport report( "recording" );
+	report.setString( "device", gpu.getProperties().deviceName );
+	report.setInteger( "draws", drawCount );
+	report.setInteger( "frames", frameCount );
+	report.setInteger( "hardwareThreads", std::thread::hardware_concurrency() );
+
+	double singleThreadMedian = 0.0;
+	for( uint32_t threads = 1;; threads = std::min( 2 * threads, maxThreads ) ){
+		JobSystem jobs( threads, VulkanConfig::mainThreadRunsJobs );
+		ParallelRecorder recorder( device, gpu.getQueueFamily(), 1 /*frames in flight*/, jobs );
+
+		vector<double> recordTimes;
+		recordTimes.reserve( frameCount );
+		for( uint64_t frame = 0; frame < frameCount; ++frame ){
+			const VkCommandBuffer commandBuffer = gpu.getScheduler().beginFrame().commandBuffer;
+
+			const auto recordStart = steady_clock::now();
+			recordBeginRenderPass( commandBuffer, renderPass, framebuffer, VulkanConfig::clearColor, width, height, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+				recorder.record( commandBuffer, 0, renderPass, framebuffer, width, height, vertexBufferBinding, drawList );
+			recordEndRenderPass( commandBuffer );
+			endCommandBuffer( commandBuffer );
+			recordTimes.push_back(  duration<double, std::milli>( steady_clock::now() - recordStart ).count()  );
+		}
+
+		const SampleStatistics statistics = getSampleStatistics( recordTimes );
+		if( threads == 1 ) singleThreadMedian = statistics.p50;
+
+		report.setStatistics( "recordTimeMsThreads" + to_string( threads ), statistics );
+		report.setNumber( "speedupThreads" + to_string( threads ), statistics.p50 > 0.0 ? singleThreadMedian / statistics.p50 : 0.0 );
+
+		if( threads == maxThreads ) break;
+	}
+
+	report.write( options.reportPath );
+
+
+	// proper Vulkan cleanup; gpu destroys the device and the rest
+	{VkResult errorCode = vkDeviceWaitIdle( device ); RESULT_HANDLER( errorCode, "vkDeviceWaitIdle" );}
+
+	killBuffer( device, vertexBuffer );
+	killMemory( device, vertexBufferMemory );
+	killPipeline( device, pipeline );
+	killPipelineLayout( device, pipelineLayout );
+	killShaderModule( device, fragmentShader );
+	killShaderModule( device, vertexShader );
+
+	return EXIT_SUCCESS;
+}
+catch( ... ){
+	return exitOnUncaughtException();
+}
+
+
+// Meshes the chunks of each synthetic terrain, with their neighbors loaded, on one thread. No Vulkan involved.
+int meshingBenchmark( const AppOptions& options ) try{
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	const uint64_t chunkCount = options.chunkCount ? options.chunkCount : VulkanConfig::meshBenchmarkChunkCount;
+
+	// the meshed chunks; one more chunk all around is generated only to be their neighbors
+	const int32_t worldWidth = 4;
+	const int32_t worldHeight = 2;
+
+	GreedyMesher greedy;
+	BinaryMesher binary( false );
+	BinaryMesher binaryAvx2;
+
+	// for the throughput on all threads; a mesher and mesh per thread, as they keep scratch memory
+	JobSystem jobs( options.threadCount, VulkanConfig::mainThreadRunsJobs );
+	vector<BinaryMesher> threadMeshers( jobs.getSlotCount() );
+	vector<ChunkMesh> threadMeshes( jobs.getSlotCount() );
+
+	BenchmarkReport report( "meshing" );
+	report.setString( "meshers", binaryAvx2.usesAvx2() ? "greedy binary binaryAvx2" : "greedy binary" );
+	report.setInteger( "avx2", getCpuFeatures().avx2 );
+	report.setInteger( "chunksPerTerrain", chunkCount );
+	report.setInteger( "threads", jobs.getThreadCount() );
+
+	ChunkMesh mesh;
+	ChunkMesh reference;
+	bool identicalQuads = true;
+	for( const TestTerrain terrain : testTerrains ){
+		VoxelWorld world;
+		for( int32_t y = -1; y <= worldHeight; ++y ){
+			for( int32_t z = -1; z <= worldWidth; ++z ){
+				for( int32_t x = -1; x <= worldWidth; ++x ){
+					std::unique_ptr<Chunk> chunk( new Chunk );
+					generateTestTerrain( terrain, {x, y, z}, *chunk );
+					world.insertChunk( {x, y, z}, std::move( chunk ) );
+				}
+			}
+		}
+
+		vector<ChunkNeighborhood> neighborhoods;
+		for( int32_t y = 0; y < worldHeight; ++y ){
+			for( int32_t z = 0; z < worldWidth; ++z ){
+				for( int32_t x = 0; x < worldWidth; ++x ) neighborhoods.push_back(  getNeighborhood( world, {x, y, z} )  );
+			}
+		}
+
+		const string name = getTestTerrainName( terrain );
+
+		// the binary mesher is only worth timing if it does produce the same mesh
+		for( const ChunkNeighborhood& chunks : neighborhoods ){
+			greedy.mesh( chunks, reference );
+			for( BinaryMesher* mesher : {&binary, &binaryAvx2} ){
+				mesher->mesh( chunks, mesh );
+				if( mesh.quads == reference.quads && mesh.faceCount == reference.faceCount ) continue;
+
+				if( identicalQuads ) logger << "WARNING: binary mesher output differs from the greedy mesher on " << name << " terrain" << std::endl;
+				identicalQuads = false;
+			}
+		}
+
+		const auto measure = [&]( const string& key, auto& mesher ){
+			vector<double> meshTimes;
+			meshTimes.reserve( chunkCount );
+
+			const auto start = steady_clock::now();
+			for( uint64_t i = 0; i < chunkCount; ++i ){
+				const auto meshStart = steady_clock::now();
+				mesher.mesh( neighborhoods[i % neighborhoods.size()], mesh );
+				meshTimes.push_back(  duration<double, std::micro>( steady_clock::now() - meshStart ).count()  );
+			}
+			const double seconds = duration<double>( steady_clock::now() - start ).count();
+
+			report.setNumber( key + "ChunksPerSecond", seconds > 0.0 ? chunkCount / seconds : 0.0 );
+			report.setStatistics( key + "MeshTimeUs", getSampleStatistics( meshTimes ) );
+		};
+		measure( name + "Greedy", greedy );
+		measure( name + "Binary", binary );
+		if( binaryAvx2.usesAvx2() ) measure( name + "BinaryAvx2", binaryAvx2 );
+
+		{
+			const size_t chunksPerJob = 4;
+			const auto start = steady_clock::now();
+			jobs.parallelFor(  0, chunkCount, chunksPerJob, [&]( size_t first, size_t last ){
+				const uint32_t thread = jobs.getThreadIndex();
+				for( size_t i = first; i < last; ++i ) threadMeshers[thread].mesh( neighborhoods[i % neighborhoods.size()], threadMeshes[thread] );
+			}  );
+			const double seconds = duration<double>( steady_clock::now() - start ).count();
+			report.setNumber( name + "ParallelChunksPerSecond", seconds > 0.0 ? chunkCount / seconds : 0.0 );
+		}
+
+		// the mesh itself is the same whichever mesher made it
+		uint64_t triangleCount = 0;
+		uint64_t faceCount = 0;
+		uint64_t vertexBytes = 0;
+		for( const ChunkNeighborhood& chunks : neighborhoods ){
+			greedy.mesh( chunks, mesh );
+			triangleCount += mesh.getTriangleCount();
+			faceCount += mesh.faceCount;
+			vertexBytes += mesh.vertices.size() * sizeof( ChunkVertex );
+		}
+		const double meshedChunks = double( neighborhoods.size() );
+		report.setNumber( name + "TrianglesPerChunk", triangleCount / meshedChunks );
+		report.setNumber( name + "NaiveTrianglesPerChunk", 2.0 * faceCount / meshedChunks ); // one quad per visible face
+		report.setNumber( name + "VertexBytesPerChunk", vertexBytes / meshedChunks );
+	}
+
+	report.setInteger( "identicalQuads", identicalQuads );
+
+	report.write( options.reportPath );
+
+	return identicalQuads ? EXIT_SUCCESS : EXIT_FAILURE; // the timings are of no use if the meshers disagree
+}
+catch( ... ){
+	return exitOnUncaughtException();
+}
+
+
+// Generates chunks of the procedural world with each SIMD path of the noise the CPU has: the chunks must come out the
+// same as with scalar code, and it measures how fast each path is on one thread, and the best one on all threads.
+int generationBenchmark( const AppOptions& options ) try{
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	const uint64_t chunkCount = options.chunkCount ? options.chunkCount : VulkanConfig::genBenchmarkChunkCount;
+
+	// from caves deep down up to the mountain tops
+	const int32_t worldWidth = 8;
+	const int32_t bottom = -2;
+	const int32_t top = WorldGenerator::maxHeight / int32_t( Chunk::size );
+	vector<ChunkCoord> coords;
+	for( int32_t y = bottom; y <= top; ++y ){
+		for( int32_t z = 0; z < worldWidth; ++z ){
+			for( int32_t x = 0; x < worldWidth; ++x ) coords.push_back( {x, y, z} );
+		}
+	}
+
+	JobSystem jobs( options.threadCount, VulkanConfig::mainThreadRunsJobs );
+
+	BenchmarkReport report( "generation" );
+	report.setInteger( "seed", VulkanConfig::worldSeed );
+	report.setString( "simdLevel", getSimdLevelName( getSimdLevel() ) ); // the best the CPU has
+	report.setInteger( "chunksPerPath", chunkCount );
+	report.setInteger( "threads", jobs.getThreadCount() );
+
+	vector<Chunk> reference( coords.size() );
+	vector<BlockId> blocks( Chunk::volume );
+	vector<BlockId> referenceBlocks( Chunk::volume );
+	bool identicalChunks = true;
+
+	for( const SimdLevel level : {SimdLevel::scalar, SimdLevel::sse41, SimdLevel::avx2} ){
+		const WorldGenerator generator( VulkanConfig::worldSeed, level );
+		if( generator.getSimdLevel() != level ) continue; // the CPU does not have it
+
+		const string name = getSimdLevelName( level );
+		Chunk chunk;
+
+		// the SIMD paths are only worth timing if they do produce the same world
+		for( size_t i = 0; i < coords.size(); ++i ){
+			if( level == SimdLevel::scalar ){
+				generator.generate( coords[i], reference[i] );
+				continue;
+			}
+
+			generator.generate( coords[i], chunk );
+			chunk.getSpan( 0, Chunk::volume, blocks.data() );
+			reference[i].getSpan( 0, Chunk::volume, referenceBlocks.data() );
+			if( blocks == referenceBlocks ) continue;
+
+			if( identicalChunks ) logger << "WARNING: " << name << " world generation differs from the scalar one" << std::endl;
+			identicalChunks = false;
+		}
+
+		vector<double> generateTimes;
+		generateTimes.reserve( chunkCount );
+
+		const auto start = steady_clock::now();
+		for( uint64_t i = 0; i < chunkCount; ++i ){
+			const auto generateStart = steady_clock::now();
+			generator.generate( coords[i % coords.size()], chunk );
+			generateTimes.push_back(  duration<double, std::micro>( steady_clock::now() - generateStart ).count()  );
+		}
+		const double seconds = duration<double>( steady_clock::now() - start ).count();
+
+		report.setNumber( name + "ChunksPerSecond", seconds > 0.0 ? chunkCount / seconds : 0.0 );
+		report.setStatistics( name + "GenerateTimeUs", getSampleStatistics( generateTimes ) );
+	}
+
+	{
+		const WorldGenerator generator( VulkanConfig::worldSeed );
+		vector<Chunk> threadChunks( jobs.getSlotCount() );
+
+		const size_t chunksPerJob = 4;
+		const auto start = steady_clock::now();
+		jobs.parallelFor(  0, chunkCount, chunksPerJob, [&]( size_t first, size_t last ){
+			Chunk& chunk = threadChunks[jobs.getThreadIndex()];
+			for( size_t i = first; i < last; ++i ) generator.generate( coords[i % coords.size()], chunk );
+		}  );
+		const double seconds = duration<double>( steady_clock::now() - start ).count();
+		report.setNumber( "parallelChunksPerSecond", seconds > 0.0 ? chunkCount / seconds : 0.0 );
+	}
+
+	report.setInteger( "identicalChunks", identicalChunks );
+
+	report.write( options.reportPath );
+
+	return identicalChunks ? EXIT_SUCCESS : EXIT_FAILURE; // a SIMD path that makes another world is a bug
+}
+catch( ... ){
+	return exitOnUncaughtException();
+}
+
+
+// Flies a camera over streamed hills in a frame loop paced at 60 Hz, turning back halfway, blasting craters into the
+// ground ahead now and then. Measures what streaming costs the frame loop, how soon the chunks around the camera are there
+// to draw, and how soon an edit is. No Vulkan involved; "upload" only tracks which chunks the renderer would have.
+// The chunks come from a ChunkResidency without storage, so the way back finds those of the way out cached or compressed
+// as far as the memory budget allows.
+int streamingBenchmark( const AppOptions& options ) try{
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	const uint64_t frameCount = options.frameCount ? options.frameCount : VulkanConfig::streamBenchmarkFrameCount;
+	const double frameTime = 1.0 / 60.0;
+
+	// the chunks that must be drawable for a frame to count as complete
+	const int32_t nearDistance = 2;
+	const int32_t nearVerticalDistance = 1;
+
+	const size_t memoryBudget = options.chunkBudget ? size_t( options.chunkBudget ) * 1024 * 1024 : VulkanConfig::chunkMemoryBudget;
+
+	VoxelWorld world;
+	JobSystem jobs( options.threadCount, false ); // the frame loop thread must not get caught up in chunk jobs
+	const ChunkResidency::Settings residencySettings = {
+		memoryBudget,
+		VulkanConfig::viewDistance,
+		VulkanConfig::verticalViewDistance,
+		VulkanConfig::prefetchDistance,
+		VulkanConfig::maxPrefetchJobs,
+		[]( const ChunkCoord coord, Chunk& chunk ){ generateTestTerrain( TestTerrain::hills, coord, chunk ); }
+	};
+	ChunkResidency residency( world, jobs, nullptr, residencySettings );
+	const ChunkStreamer::Settings settings = {
+		VulkanConfig::viewDistance,
+		VulkanConfig::verticalViewDistance,
+		0, // ChunkStreamer::defaultJobsPerThread
+		[&residency]( const ChunkCoord coord, Chunk& chunk ){ residency.load( coord, chunk ); },
+		[&residency]( const ChunkCoord coord, std::unique_ptr<Chunk> chunk, const bool edited ){ residency.release( coord, std::move( chunk ), edited ); }
+	};
+	std::unique_ptr<ChunkStreamer> streamer(  new ChunkStreamer( world, jobs, settings )  );
+
+	std::unordered_set<ChunkCoord, ChunkCoordHash> drawable;
+	uint64_t vertexBytes = 0;
+	const auto upload = [&]( const ChunkCoord coord, const ChunkMesh* const mesh ){
+		if( !mesh ){
+			drawable.erase( coord );
+			return;
+		}
+		drawable.insert( coord );
+		vertexBytes += mesh->vertices.size() * sizeof( ChunkVertex );
+	};
+
+	float position[3] = { 0.5f, 48.0f, 0.5f };
+	float direction[3] = { 1.0f, -0.3f, 0.0f };
+	const float step = static_cast<float>( VulkanConfig::streamBenchmarkSpeed * frameTime );
+
+	vector<double> streamingTimes;
+	streamingTimes.reserve( frameCount );
+	double timeToNearChunksMs = -1.0;
+	double timeToFullViewMs = -1.0;
+	uint64_t framesMissingNearChunks = 0;
+	uint64_t explosions = 0;
+	size_t peakResidentBytes = 0;
+	uint64_t framesOverBudget = 0;
+
+	// an air ball straddling a chunk border, in what is loaded of it
+	const auto explode = [&]( const int32_t cx, const int32_t cy, const int32_t cz ){
+		const int32_t r = VulkanConfig::streamBenchmarkExplosionRadius;
+		for( int32_t y = cy - r; y <= cy + r; ++y ){
+			for( int32_t z = cz - r; z <= cz + r; ++z ){
+				for( int32_t x = cx - r; x <= cx + r; ++x ){
+					const int32_t dx = x - cx, dy = y - cy, dz = z - cz;
+					if( dx * dx + dy * dy + dz * dz > r * r ) continue;
+					if(  !world.getChunk( VoxelWorld::toChunkCoord( x, y, z ) )  ) continue;
+					world.setBlock( x, y, z, Block::air );
+				}
+			}
+		}
+		++explosions;
+	};
+
+	const auto start = steady_clock::now();
+	for( uint64_t frame = 0; frame < frameCount; ++frame ){
+		std::this_thread::sleep_until(  start + std::chrono::duration_cast<steady_clock::duration>( duration<double>( frame * frameTime ) )  );
+
+		if( frame == frameCount / 2 ) direction[0] = -direction[0];
+		if( frame ) position[0] += direction[0] > 0.0f ? step : -step;
+		if( frame && frame % VulkanConfig::streamBenchmarkExplosionInterval == 0 ){
+			const float ahead = direction[0] > 0.0f ? 24.0f : -24.0f;
+			explode( int32_t( std::floor( position[0] + ahead ) ), 24, 0 );
+		}
+
+		const auto streamingStart = steady_clock::now();
+		streamer->update( position, direction );
+		streamer->upload( VulkanConfig::maxChunkUploadsPerFrame, upload );
+		residency.update( position );
+		streamingTimes.push_back(  duration<double, std::milli>( steady_clock::now() - streamingStart ).count()  );
+
+		const size_t residentBytes = residency.getStatistics().residentBytes;
+		peakResidentBytes = std::max( peakResidentBytes, residentBytes );
+		if( residentBytes > memoryBudget ) ++framesOverBudget;
+
+		const double now = duration<double, std::milli>( steady_clock::now() - start ).count();
+
+		const ChunkCoord center = VoxelWorld::toChunkCoord( int32_t( std::floor( position[0] ) ), int32_t( std::floor( position[1] ) ), int32_t( std::floor( position[2] ) ) );
+		bool nearChunksThere = true;
+		for( int32_t dy = -nearVerticalDistance; dy <= nearVerticalDistance && nearChunksThere; ++dy ){
+			for( int32_t dz = -nearDistance; dz <= nearDistance && nearChunksThere; ++dz ){
+				for( int32_t dx = -nearDistance; dx <= nearDistance && nearChunksThere; ++dx ){
+					if( dx * dx + dz * dz > nearDistance * nearDistance ) continue;
+					nearChunksThere = drawable.count( {center.x + dx, center.y + dy, center.z + dz} ) > 0;
+				}
+			}
+		}
+		if( nearChunksThere && timeToNearChunksMs < 0.0 ) timeToNearChunksMs = now;
+		if( !nearChunksThere && timeToNearChunksMs >= 0.0 ) ++framesMissingNearChunks;
+
+		const ChunkStreamer::Statistics statistics = streamer->getStatistics();
+		if( !statistics.jobsInFlight && !statistics.pendingUploads && timeToFullViewMs < 0.0 ) timeToFullViewMs = now;
+	}
+	const double seconds = duration<double>( steady_clock::now() - start ).count();
+
+	const ChunkStreamer::Statistics statistics = streamer->getStatistics();
+	vector<double> editLatencies;
+	streamer->takeEditLatencies( editLatencies );
+	streamer.reset(); // waits for its jobs
+	const ChunkResidency::Statistics residencyStatistics = residency.getStatistics();
+	const uint64_t loads = residencyStatistics.cacheHits + residencyStatistics.compressedHits + residencyStatistics.storageLoads + residencyStatistics.generated;
+
+	BenchmarkReport report( "streaming" );
+	report.setInteger( "threads", jobs.getThreadCount() );
+	report.setInteger( "frames", frameCount );
+	report.setInteger( "viewDistance", VulkanConfig::viewDistance );
+	report.setInteger( "verticalViewDistance", VulkanConfig::verticalViewDistance );
+	report.setNumber( "cameraSpeed", VulkanConfig::streamBenchmarkSpeed );
+	report.setStatistics( "streamingTimeMs", getSampleStatistics( streamingTimes ) ); // update() + upload() + residency update() per frame
+	report.setNumber( "timeToNearChunksMs", timeToNearChunksMs ); // -1 if never
+	report.setNumber( "timeToFullViewMs", timeToFullViewMs );
+	report.setInteger( "framesMissingNearChunks", framesMissingNearChunks ); // after the near chunks were first there
+	report.setInteger( "chunksGenerated", statistics.generated );
+	report.setInteger( "chunksMeshed", statistics.meshed );
+	report.setInteger( "chunksUnloaded", statistics.unloaded );
+	report.setInteger( "jobsCancelled", statistics.cancelled );
+	report.setInteger( "explosions", explosions );
+	report.setInteger( "editBatches", statistics.editBatches ); // handed over; fewer than explosions when one hit only chunks not meshed yet
+	report.setInteger( "editRemeshes", statistics.editRemeshes );
+	report.setStatistics( "editToVisibleMs", getSampleStatistics( editLatencies ) ); // from setBlock() to upload()
+	report.setNumber( "uploadsPerSecond", seconds > 0.0 ? statistics.uploaded / seconds : 0.0 );
+	report.setNumber( "vertexBytesPerSecond", seconds > 0.0 ? vertexBytes / seconds : 0.0 );
+	report.setInteger( "worldMemoryBytes", world.getMemoryUsage() );
+	report.setInteger( "memoryBudgetBytes", memoryBudget );
+	report.setInteger( "peakResidentBytes", peakResidentBytes ); // loaded + cached + compressed
+	report.setInteger( "framesOverBudget", framesOverBudget ); // the loaded chunks alone were more than the budget
+	report.setNumber( "residencyHitRate", loads ? double( loads - residencyStatistics.generated ) / loads : 0.0 ); // loads not generated
+	report.setInteger( "cacheHits", residencyStatistics.cacheHits );
+	report.setInteger( "compressedHits", residencyStatistics.compressedHits );
+	report.setInteger( "chunksPrefetched", residencyStatistics.prefetched );
+	report.setNumber( "compressionsPerSecond", seconds > 0.0 ? residencyStatistics.compressions / seconds : 0.0 );
+	report.setNumber( "evictionsPerSecond", seconds > 0.0 ? residencyStatistics.evictions / seconds : 0.0 );
+	report.setInteger( "lostEdits", residencyStatistics.lostEdits ); // edited chunks evicted; there is no storage
+	report.write( options.reportPath );
+
+	return EXIT_SUCCESS;
+}
+catch( ... ){
+	return exitOnUncaughtException();
+}
+
+
+// Saves a patch of the procedural world into region files and loads it back in random order with the files opened
+// anew, checking it comes back the same; then resaves some chunks scribbled over, which moves them to fresh sectors,
+// and compacts the gaps that leaves. Measures saves and loads per second, the compression ratio and the file sizes.
+int storageBenchmark( const AppOptions& options ) try{
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	const uint64_t chunkCount = options.chunkCount ? options.chunkCount : VulkanConfig::storageBenchmarkChunkCount;
+	const string directory = VulkanConfig::storageBenchmarkDirectory;
+
+	// columns of chunks from caves deep down up to the mountain tops, in a square as big as it takes
+	const int32_t bottom = -2;
+	const int32_t top = WorldGenerator::maxHeight / int32_t( Chunk::size );
+	const uint64_t columnCount = (chunkCount + (top - bottom)) / (top - bottom + 1);
+	int32_t worldWidth = 1;
+	while( uint64_t( worldWidth ) * worldWidth < columnCount ) ++worldWidth;
+	vector<ChunkCoord> coords;
+	for( int32_t z = 0; z < worldWidth && coords.size() < chunkCount; ++z ){
+		for( int32_t x = 0; x < worldWidth && coords.size() < chunkCount; ++x ){
+			for( int32_t y = bottom; y <= top && coords.size() < chunkCount; ++y ) coords.push_back( {x, y, z} );
+		}
+	}
+
+	JobSystem jobs( options.threadCount, VulkanConfig::mainThreadRunsJobs );
+	vector<Chunk> chunks( coords.size() );
+	{
+		const WorldGenerator generator( VulkanConfig::worldSeed );
+		jobs.parallelFor(  0, coords.size(), 4, [&]( size_t first, size_t last ){
+			for( size_t i = first; i < last; ++i ) generator.generate( coords[i], chunks[i] );
+		}  );
+	}
+
+	BenchmarkReport report( "storage" );
+	report.setInteger( "chunks", coords.size() );
+
+	vector<BlockId> blocks( Chunk::volume );
+	vector<BlockId> loadedBlocks( Chunk::volume );
+	Chunk loaded;
+	bool identicalChunks = true;
+	const auto check = [&]( const size_t i ){
+		chunks[i].getSpan( 0, Chunk::volume, blocks.data() );
+		loaded.getSpan( 0, Chunk::volume, loadedBlocks.data() );
+		if( blocks == loadedBlocks ) return;
+
+		if( identicalChunks ) logger << "WARNING: a chunk loaded from " << directory << " differs from the one saved" << std::endl;
+		identicalChunks = false;
+	};
+
+	{
+		WorldStorage storage( directory );
+
+		vector<double> saveTimes;
+		saveTimes.reserve( coords.size() );
+		const auto start = steady_clock::now();
+		for( size_t i = 0; i < coords.size(); ++i ){
+			const auto saveStart = steady_clock::now();
+			storage.save( coords[i], chunks[i] );
+			saveTimes.push_back(  duration<double, std::micro>( steady_clock::now() - saveStart ).count()  );
+		}
+		const double seconds = duration<double>( steady_clock::now() - start ).count();
+
+		const auto flushStart = steady_clock::now();
+		storage.flush();
+		report.setNumber(  "flushMs", duration<double, std::milli>( steady_clock::now() - flushStart ).count()  );
+
+		const WorldStorage::Statistics statistics = storage.getStatistics();
+		report.setNumber( "savesPerSecond", seconds > 0.0 ? coords.size() / seconds : 0.0 );
+		report.setStatistics( "saveTimeUs", getSampleStatistics( saveTimes ) );
+		report.setInteger( "regions", statistics.regions );
+		report.setNumber( "storedBytesPerChunk", double( statistics.storedBytes ) / coords.size() );
+		report.setNumber( "compressionRatio", statistics.storedBytes ? double( statistics.rawBytes ) / statistics.storedBytes : 0.0 ); // of the palette + indices
+		report.setNumber( "flatCompressionRatio", statistics.storedBytes ? double( Chunk::flatMemoryUsage() * coords.size() ) / statistics.storedBytes : 0.0 );
+		report.setInteger( "fileBytes", statistics.fileBytes );
+	}
+
+	{
+		WorldStorage storage( directory ); // nothing cached from the saves
+
+		vector<size_t> order( coords.size() );
+		for( size_t i = 0; i < order.size(); ++i ) order[i] = i;
+		std::shuffle( order.begin(), order.end(), std::mt19937( VulkanConfig::worldSeed ) );
+
+		vector<double> loadTimes;
+		loadTimes.reserve( coords.size() );
+		const auto start = steady_clock::now();
+		for( const size_t i : order ){
+			const auto loadStart = steady_clock::now();
+			const bool found = storage.load( coords[i], loaded );
+			loadTimes.push_back(  duration<double, std::micro>( steady_clock::now() - loadStart ).count()  );
+
+			if( found ) check( i );
+			else identicalChunks = false;
+		}
+		const double seconds = duration<double>( steady_clock::now() - start ).count();
+
+		report.setNumber( "loadsPerSecond", seconds > 0.0 ? coords.size() / seconds : 0.0 );
+		report.setStatistics( "loadTimeUs", getSampleStatistics( loadTimes ) );
+
+		// every fourth chunk gets a layer of noise, which compresses worse than terrain
+		const uint32_t noiseLayers = 8;
+		for( size_t i = 0; i < coords.size(); i += 4 ){
+			chunks[i].getSpan( 0, Chunk::volume, blocks.data() );
+			for( uint32_t v = 0; v < noiseLayers * Chunk::size * Chunk::size; ++v ) blocks[v] = BlockId(  ((v + i) * 2654435761u >> 16) % (Block::wood + 1)  );
+			chunks[i].setSpan( 0, Chunk::volume, blocks.data() );
+			storage.save( coords[i], chunks[i] );
+		}
+
+		const WorldStorage::Statistics before = storage.getStatistics();
+		const auto compactStart = steady_clock::now();
+		storage.compact( 0.0 );
+		report.setNumber(  "compactMs", duration<double, std::milli>( steady_clock::now() - compactStart ).count()  );
+		const WorldStorage::Statistics after = storage.getStatistics();
+
+		report.setInteger( "fileBytesBeforeCompaction", before.fileBytes );
+		report.setInteger( "freeBytesBeforeCompaction", before.freeBytes );
+		report.setInteger( "fileBytesAfterCompaction", after.fileBytes );
+
+		for( size_t i = 0; i < coords.size(); ++i ){
+			if( storage.load( coords[i], loaded ) ) check( i );
+			else identicalChunks = false;
+		}
+	}
+
+	report.setInteger( "identicalChunks", identicalChunks );
+
+	{
+		WorldStorage storage( directory );
+		std::unordered_set<ChunkCoord, ChunkCoordHash> regions;
+		for( const ChunkCoord coord : coords ) regions.insert( WorldStorage::toRegionCoord( coord ) );
+		for( const ChunkCoord region : regions ) std::remove( storage.getRegionPath( region ).c_str() );
+	}
+
+	report.write( options.reportPath );
+
+	return identicalChunks ? EXIT_SUCCESS : EXIT_FAILURE; // a chunk did not come back as saved
+}
+catch( ... ){
+	return exitOnUncaughtException();
+}
+
+// Turns a camera full circle amid a square of chunk columns, culling their boxes to the frustum every frame: with the
+// per-chunk scalar loop it replaces, and with ChunkCuller's scalar and AVX2 paths. Then builds the draw list of the
+// visible chunks the way a frame would record it. No Vulkan involved; the draws are never recorded.
+int cullingBenchmark( const AppOptions& options ) try{
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	const uint64_t frameCount = options.frameCount ? options.frameCount : VulkanConfig::cullBenchmarkFrameCount;
+	const int32_t distance = VulkanConfig::cullBenchmarkViewDistance;
+	const uint32_t width = options.width ? options.width : VulkanConfig::initialWindowWidth;
+	const uint32_t height = options.height ? options.height : VulkanConfig::initialWindowHeight;
+
+	// the chunks, and what a frame would draw each of them with
+	vector<ChunkCoord> coords;
+	for( int32_t y = 0; y < VulkanConfig::cullBenchmarkHeight; ++y ){
+		for( int32_t z = -distance; z <= distance; ++z ){
+			for( int32_t x = -distance; x <= distance; ++x ) coords.push_back( {x, y - VulkanConfig::cullBenchmarkHeight / 4, z} );
+		}
+	}
+	vector<ChunkPushConstants> pushConstants( coords.size() );
+	vector<DrawCommand> chunkDraws( coords.size() );
+	for( size_t i = 0; i < coords.size(); ++i ){
+		const float origin[4] = { float( coords[i].x * int32_t( Chunk::size ) ), float( coords[i].y * int32_t( Chunk::size ) ), float( coords[i].z * int32_t( Chunk::size ) ), 0.0f };
+		std::copy( origin, origin + 4, pushConstants[i].chunkOrigin );
+		chunkDraws[i] = { VK_NULL_HANDLE, VK_NULL_HANDLE, 0, 0, VK_NULL_HANDLE, VK_NULL_HANDLE, offsetof( ChunkPushConstants, chunkOrigin ), sizeof( pushConstants[i].chunkOrigin ), pushConstants[i].chunkOrigin };
+	}
+
+	ChunkCuller scalar( false );
+	ChunkCuller avx2;
+	for( size_t i = 0; i < coords.size(); ++i ){
+		scalar.insert( coords[i], static_cast<uint32_t>( i ) );
+		avx2.insert( coords[i], static_cast<uint32_t>( i ) );
+	}
+
+	// what it replaces: every box against every plane, one after another
+	const auto cullEachChunk = [&]( const float planes[6][4], vector<uint32_t>& visible ){
+		visible.clear();
+		const float size = float( Chunk::size );
+		for( size_t i = 0; i < coords.size(); ++i ){
+			const float min[3] = { coords[i].x * size, coords[i].y * size, coords[i].z * size };
+			bool inside = true;
+			for( int p = 0; p < 6 && inside; ++p ){
+				const float* const plane = planes[p];
+				const float farthest[3] = { min[0] + (plane[0] > 0.0f ? size : 0.0f), min[1] + (plane[1] > 0.0f ? size : 0.0f), min[2] + (plane[2] > 0.0f ? size : 0.0f) };
+				inside = plane[0] * farthest[0] + plane[1] * farthest[1] + plane[2] * farthest[2] + plane[3] >= 0.0f;
+			}
+			if( inside ) visible.push_back( static_cast<uint32_t>( i ) );
+		}
+	};
+
+	float projection[16];
+	makeReversedZPerspective( VulkanConfig::fieldOfView, float( width ) / float( height ), VulkanConfig::nearPlane, 0.0f, projection );
+	const float position[3] = { 0.5f, 48.0f, 0.5f };
+
+	vector<double> perChunkTimes, scalarTimes, avx2Times, drawListTimes;
+	vector<uint32_t> visible, reference;
+	vector<DrawCommand> drawList;
+	uint64_t visibleChunks = 0, nodesCulled = 0, nodesInside = 0, chunksTested = 0;
+	bool identicalVisibleChunks = true;
+
+	for( uint64_t frame = 0; frame < frameCount; ++frame ){
+		const float angle = float( frame ) * 3.14159265f / 180.0f;
+		const float direction[3] = { std::cos( angle ), -0.25f, std::sin( angle ) };
+		float view[16], viewProjection[16], planes[6][4];
+		makeViewMatrix( position, direction, view );
+		multiplyMatrices( projection, view, viewProjection );
+		extractFrustumPlanes( viewProjection, planes );
+
+		auto start = steady_clock::now();
+		cullEachChunk( planes, visible );
+		perChunkTimes.push_back(  duration<double, std::milli>( steady_clock::now() - start ).count()  );
+
+		start = steady_clock::now();
+		scalar.cull( planes, reference );
+		scalarTimes.push_back(  duration<double, std::milli>( steady_clock::now() - start ).count()  );
+
+		if( avx2.usesAvx2() ){
+			start = steady_clock::now();
+			avx2.cull( planes, visible );
+			avx2Times.push_back(  duration<double, std::milli>( steady_clock::now() - start ).count()  );
+
+			if( visible != reference && identicalVisibleChunks ){
+				logger << "WARNING: the AVX2 culling path keeps other chunks than the scalar one" << std::endl;
+				identicalVisibleChunks = false;
+			}
+		}
+
+		start = steady_clock::now();
+		drawList.clear();
+		for( const uint32_t id : reference ) drawList.push_back( chunkDraws[id] );
+		drawListTimes.push_back(  duration<double, std::milli>( steady_clock::now() - start ).count()  );
+
+		const ChunkCuller::Statistics& statistics = scalar.getStatistics();
+		visibleChunks += statistics.visibleChunks;
+		nodesCulled += statistics.nodesCulled;
+		nodesInside += statistics.nodesInside;
+		chunksTested += statistics.chunksTested;
+	}
+
+	BenchmarkReport report( "culling" );
+	report.setInteger( "avx2", avx2.usesAvx2() );
+	report.setInteger( "frames", frameCount );
+	report.setInteger( "chunks", coords.size() );
+	report.setInteger( "nodes", scalar.getStatistics().nodes );
+	report.setInteger( "chunksPerNode", ChunkCuller::nodeSize * ChunkCuller::nodeSize * ChunkCuller::nodeSize );
+	report.setStatistics( "perChunkCullTimeMs", getSampleStatistics( perChunkTimes ) ); // the flat scalar loop
+	report.setStatistics( "scalarCullTimeMs", getSampleStatistics( scalarTimes ) );
+	if( avx2.usesAvx2() ) report.setStatistics( "avx2CullTimeMs", getSampleStatistics( avx2Times ) );
+	report.setStatistics( "drawListTimeMs", getSampleStatistics( drawListTimes ) ); // DrawCommands of the visible chunks
+	report.setNumber( "visibleChunksPerFrame", double( visibleChunks ) / frameCount );
+	report.setNumber( "nodesCulledPerFrame", double( nodesCulled ) / frameCount );
+	report.setNumber( "nodesInsidePerFrame", double( nodesInside ) / frameCount ); // taken whole, their chunks untested
+	report.setNumber( "chunksTestedPerFrame", double( chunksTested ) / frameCount );
+	report.setInteger( "identicalVisibleChunks", identicalVisibleChunks );
+	report.write( options.reportPath );
+
+	return identicalVisibleChunks ? EXIT_SUCCESS : EXIT_FAILURE; // the AVX2 path must cull like the scalar one
+}
+catch( ... ){
+	return exitOnUncaughtException();
+}
+
+
+// The chunks of the GPU-driven benchmarks: the meshes of a small world of terrain, in one vertex buffer, tiled over the
+// chunk columns -distance to distance along x and z, in the layers (chunk y) firstLayer to firstLayer + layerCount - 1.
+// chunkData tells which mesh each chunk of coords draws, where, and the box the culling tests.
+static void makeTiledChunks(
+	const TestTerrain terrain,
+	const int32_t firstLayer, const int32_t layerCount,
+	const int32_t distance,
+	vector<ChunkVertex>& vertices,
+	vector<ChunkCoord>& coords,
+	vector<ChunkDrawData>& chunkData,
+	uint32_t& maxQuadCount
+){
+	// one more chunk all around the small world only to be the neighbors of its chunks
+	const int32_t worldWidth = 4;
+
+	struct MeshRange{
+		uint32_t firstVertex;
+		uint32_t quadCount;
+		float min[3], max[3]; // bounds of the vertices, relative to the chunk origin
+	};
+	vector<MeshRange> meshes; // [y][z][x]
+	vertices.clear();
+	maxQuadCount = 0;
+	{
+		VoxelWorld world;
+		for( int32_t y = firstLayer - 1; y <= firstLayer + layerCount; ++y ){
+			for( int32_t z = -1; z <= worldWidth; ++z ){
+				for( int32_t x = -1; x <= worldWidth; ++x ){
+					std::unique_ptr<Chunk> chunk( new Chunk );
+					generateTestTerrain( terrain, {x, y, z}, *chunk );
+					world.insertChunk( {x, y, z}, std::move( chunk ) );
+				}
+			}
+		}
+
+		BinaryMesher mesher;
+		ChunkMesh mesh;
+		for( int32_t y = firstLayer; y < firstLayer + layerCount; ++y ){
+			for( int32_t z = 0; z < worldWidth; ++z ){
+				for( int32_t x = 0; x < worldWidth; ++x ){
+					mesher.mesh( getNeighborhood( world, {x, y, z} ), mesh );
+
+					MeshRange range{ static_cast<uint32_t>( vertices.size() ), static_cast<uint32_t>( mesh.quads.size() ), {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f} };
+					for( size_t i = 0; i < mesh.vertices.size(); ++i ){
+						const float position[3] = { float( mesh.vertices[i].getX() ), float( mesh.vertices[i].getY() ), float( mesh.vertices[i].getZ() ) };
+						for( int axis = 0; axis < 3; ++axis ){
+							range.min[axis] = i ? std::min( range.min[axis], position[axis] ) : position[axis];
+							range.max[axis] = i ? std::max( range.max[axis], position[axis] ) : position[axis];
+						}
+					}
+					meshes.push_back( range );
+					vertices.insert( vertices.end(), mesh.vertices.begin(), mesh.vertices.end() );
+					maxQuadCount = std::max( maxQuadCount, range.quadCount );
+				}
+			}
+		}
+	}
+	if( vertices.empty() ) throw "The benchmark terrain has nothing to draw!";
+
+	coords.clear();
+	chunkData.clear();
+	for( int32_t y = firstLayer; y < firstLayer + layerCount; ++y ){
+		for( int32_t z = -distance; z <= distance; ++z ){
+			for( int32_t x = -distance; x <= distance; ++x ){
+				const int32_t tileX = (x % worldWidth + worldWidth) % worldWidth;
+				const int32_t tileZ = (z % worldWidth + worldWidth) % worldWidth;
+				const MeshRange& range = meshes[((y - firstLayer) * worldWidth + tileZ) * worldWidth + tileX];
+
+				ChunkDrawData data = {};
+				const float origin[3] = { float( x * int32_t( Chunk::size ) ), float( y * int32_t( Chunk::size ) ), float( z * int32_t( Chunk::size ) ) };
+				for( int axis = 0; axis < 3; ++axis ){
+					data.origin[axis] = origin[axis];
+					data.boundsMin[axis] = origin[axis] + range.min[axis];
+					data.boundsMax[axis] = origin[axis] + range.max[axis];
+				}
+				data.vertexOffset = static_cast<int32_t>( range.firstVertex );
+				data.indexCount = 6 * range.quadCount;
+
+				coords.push_back( {x, y, z} );
+				chunkData.push_back( data );
+			}
+		}
+	}
+}
+
+// What the GPU-driven benchmarks share, so they differ only in what they record and measure: the chunks of
+// makeTiledChunks in one vertex buffer with an index buffer, on an OffscreenGpu that can run IndirectChunkRenderer with
+// three timestamps per frame, the shaders any IndirectChunkRenderer takes, and a camera turning a degree per frame.
+class ChunkScene{
+public:
+	static constexpr uint32_t vertexBufferBinding = 0;
+
+	ChunkScene(
+		const AppOptions& options,
+		const TestTerrain terrain, const int32_t firstLayer, const int32_t layerCount, const int32_t distance,
+		const bool sampledDepth // see OffscreenGpu::Settings
+	)
+	: m_gpu( getSettings( options, sampledDepth ), getPipelineCachePath( options ) )
+	{
+		uint32_t maxQuadCount;
+		vector<ChunkVertex> vertices;
+		makeTiledChunks( terrain, firstLayer, layerCount, distance, vertices, m_coords, m_chunkData, maxQuadCount );
+
+		const VkDevice device = m_gpu.getDevice();
+		UploadManager& uploader = m_gpu.getUploader();
+
+		const vector<uint32_t> indices = makeQuadIndices( maxQuadCount );
+		m_vertexBuffer = initBuffer( device, sizeof( ChunkVertex ) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, uploader.getQueueFamilies() );
+		m_vertexBufferMemory = initMemory<ResourceType::Buffer>( device, m_gpu.getMemoryProperties(), m_vertexBuffer, {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT} );
+		m_indexBuffer = initBuffer( device, sizeof( uint32_t ) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, uploader.getQueueFamilies() );
+		m_indexBufferMemory = initMemory<ResourceType::Buffer>( device, m_gpu.getMemoryProperties(), m_indexBuffer, {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT} );
+		uploader.uploadBuffer( m_indexBuffer, 0 /*offset*/, indices.data(), sizeof( uint32_t ) * indices.size() );
+		uploader.wait(  setVertexData( uploader, m_vertexBuffer, vertices )  ); // flushes the indices too
+
+		vector<uint32_t> fragmentShaderBinary = {
+#include "shaders/chunk.frag.spv.inl"
+		};
+		vector<uint32_t> indirectVertexShaderBinary = {
+#include "shaders/chunk_indirect.vert.spv.inl"
+		};
+		vector<uint32_t> cullShaderBinary = {
+#include "shaders/chunk_cull.comp.spv.inl"
+		};
+		m_fragmentShader = initShaderModule( device, fragmentShaderBinary );
+		m_indirectVertexShader = initShaderModule( device, indirectVertexShaderBinary );
+		m_cullShader = initShaderModule( device, cullShaderBinary );
+
+		makeReversedZPerspective( VulkanConfig::fieldOfView, float( m_gpu.getWidth() ) / float( m_gpu.getHeight() ), VulkanConfig::nearPlane, 0.0f, m_projection );
+	}
+
+	~ChunkScene(){ // the GPU must be done with it
+		const VkDevice device = m_gpu.getDevice();
+		killShaderModule( device, m_cullShader );
+		killShaderModule( device, m_indirectVertexShader );
+		killShaderModule( device, m_fragmentShader );
+		killBuffer( device, m_indexBuffer );
+		killMemory( device, m_indexBufferMemory );
+		killBuffer( device, m_vertexBuffer );
+		killMemory( device, m_vertexBufferMemory );
+	}
+
+	ChunkScene( const ChunkScene& ) = delete;
+	ChunkScene& operator=( const ChunkScene& ) = delete;
+
+	OffscreenGpu& getGpu(){ return m_gpu; }
+	uint32_t getChunkCount() const{ return static_cast<uint32_t>( m_coords.size() ); }
+	const vector<ChunkCoord>& getCoords() const{ return m_coords; }
+	const vector<ChunkDrawData>& getChunkData() const{ return m_chunkData; } // by chunk id, which is the index into coords
+	VkBuffer getVertexBuffer() const{ return m_vertexBuffer; }
+	VkBuffer getIndexBuffer() const{ return m_indexBuffer; }
+	VkShaderModule getFragmentShader() const{ return m_fragmentShader; } // chunk.frag
+
+	// a renderer of all the chunks into the render targets, with the chunk data uploaded; kill it before the scene
+	std::unique_ptr<IndirectChunkRenderer> makeRenderer( const VkShaderModule occlusionCullShader = VK_NULL_HANDLE ){
+		std::unique_ptr<IndirectChunkRenderer> renderer( new IndirectChunkRenderer(
+			m_gpu.getDevice(),
+			m_gpu.getMemoryProperties(),
+			m_gpu.getProperties().limits,
+			m_gpu.getFeatures(),
+			m_gpu.getPipelineCache().get(),
+			m_gpu.getRenderPass(),
+			vertexBufferBinding,
+			m_cullShader,
+			m_indirectVertexShader,
+			m_fragmentShader,
+			getChunkCount(),
+			m_gpu.getFramesInFlight(),
+			m_gpu.getUploader().getQueueFamilies(),
+			occlusionCullShader
+		) );
+
+		UploadManager& uploader = m_gpu.getUploader();
+		uploader.uploadBuffer( renderer->getChunkBuffer(), 0 /*offset*/, m_chunkData.data(), sizeof( ChunkDrawData ) * m_chunkData.size() );
+		uploader.wait( uploader.flush() );
+		return renderer;
+	}
+
+	// the camera of the frame: above the origin at eyeHeight, looking down by lookDown (of a unit step forward)
+	void getCamera( const uint64_t frame, const float eyeHeight, const float lookDown, float viewProjection[16], float planes[6][4] ) const{
+		const float position[3] = { 0.5f, eyeHeight, 0.5f };
+		const float angle = float( frame ) * 3.14159265f / 180.0f;
+		const float direction[3] = { std::cos( angle ), -lookDown, std::sin( angle ) };
+		float view[16];
+		makeViewMatrix( position, direction, view );
+		multiplyMatrices( m_projection, view, viewProjection );
+		extractFrustumPlanes( viewProjection, planes );
+	}
+
+	// a render pass on the render target of the slot that draws what the latest cull of renderer kept; renderPass is
+	// the one of the gpu, or one compatible with it
+	void recordDraw( const VkCommandBuffer commandBuffer, const uint32_t slot, const VkRenderPass renderPass, IndirectChunkRenderer& renderer, const float viewProjection[16] ){
+		recordBeginRenderPass( commandBuffer, renderPass, m_gpu.getFramebuffer( slot ), VulkanConfig::clearColor, m_gpu.getWidth(), m_gpu.getHeight() );
+			recordSetViewport( commandBuffer, m_gpu.getWidth(), m_gpu.getHeight() );
+			renderer.recordDraw( commandBuffer, slot, viewProjection, m_vertexBuffer, m_indexBuffer );
+		recordEndRenderPass( commandBuffer );
+	}
+
+	// what every report of the GPU-driven benchmarks starts with
+	void reportScene( BenchmarkReport& report, const uint64_t frameCount, const IndirectChunkRenderer& renderer ){
+		report.setString( "device", m_gpu.getProperties().deviceName );
+		report.setInteger( "width", m_gpu.getWidth() );
+		report.setInteger( "height", m_gpu.getHeight() );
+		report.setInteger( "frames", frameCount );
+		report.setInteger( "chunks", getChunkCount() );
+		report.setInteger( "drawIndirectCount", renderer.usesDrawIndirectCount() ); // else vkCmdDrawIndexedIndirect over all chunks
+	}
+
+private:
+	static OffscreenGpu::Settings getSettings( const AppOptions& options, const bool sampledDepth ){
+		OffscreenGpu::Settings settings;
+		settings.width = options.width ? options.width : VulkanConfig::initialWindowWidth;
+		settings.height = options.height ? options.height : VulkanConfig::initialWindowHeight;
+		settings.framesInFlight = options.framesInFlight ? options.framesInFlight : VulkanConfig::framesInFlight;
+		settings.features.multiDrawIndirect = VK_TRUE; // IndirectChunkRenderer checks them
+		settings.features.drawIndirectFirstInstance = VK_TRUE;
+		settings.optionalExtensions = { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME };
+		settings.compute = true; // the culling compute shaders
+		settings.sampledDepth = sampledDepth;
+		settings.timestampsPerFrame = 3; // the start, and the end of each of two ways to draw the frame
+		return settings;
+	}
+
+	OffscreenGpu m_gpu;
+	vector<ChunkCoord> m_coords;
+	vector<ChunkDrawData> m_chunkData;
+	VkBuffer m_vertexBuffer, m_indexBuffer;
+	MemoryAllocation m_vertexBufferMemory, m_indexBufferMemory;
+	VkShaderModule m_fragmentShader, m_indirectVertexShader, m_cullShader;
+	float m_projection[16];
+};
+
+// Draws the chunk meshes of a wide square of chunk columns while a camera turns full circle, both ways in every frame:
+// culled by ChunkCuller and recorded as one draw per visible chunk, as before, and culled and drawn by the GPU alone
+// (IndirectChunkRenderer). Measures the CPU time to record each path and, with timestamps, the GPU time of each.
+int indirectBenchmark( const AppOptions& options ) try{
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	const uint64_t frameCount = options.frameCount ? options.frameCount : VulkanConfig::indirectBenchmarkFrameCount;
+
+	ChunkScene scene( options, TestTerrain::hills, 0 /*first layer*/, 2 /*layers*/, VulkanConfig::indirectBenchmarkViewDistance, false /*sampled depth*/ );
+	OffscreenGpu& gpu = scene.getGpu();
+	const VkDevice device = gpu.getDevice();
+	const vector<ChunkDrawData>& chunkData = scene.getChunkData();
+	const uint32_t chunkCount = scene.getChunkCount();
+
+	ChunkCuller culler;
+	for( uint32_t i = 0; i < chunkCount; ++i ){
+		if( chunkData[i].indexCount ) culler.insert( scene.getCoords()[i], i, chunkData[i].boundsMin, chunkData[i].boundsMax );
+	}
+
+	// the CPU path draws the chunks one by one, with the chunk origin pushed per draw, straight from the chunk data
+	vector<uint32_t> vertexShaderBinary = {
+#include "shaders/chunk.vert.spv.inl"
+	};
+	VkShaderModule vertexShader = initShaderModule( device, vertexShaderBinary );
+	VkPipelineLayout pipelineLayout = initPipelineLayout( device, sizeof( ChunkPushConstants ) );
+	VkPipeline pipeline = initPipeline(
+		device,
+		gpu.getPipelineCache().get(),
+		gpu.getProperties().limits,
+		pipelineLayout,
+		gpu.getRenderPass(),
+		vertexShader,
+		scene.getFragmentShader(),
+		ChunkScene::vertexBufferBinding,
+		VertexFormat::Chunk
+	);
+
+	vector<DrawCommand> chunkDraws( chunkCount );
+	for( uint32_t i = 0; i < chunkCount; ++i ){
+		const ChunkDrawData& data = chunkData[i];
+		chunkDraws[i] = {
+			pipeline,
+			scene.getVertexBuffer(), sizeof( ChunkVertex ) * VkDeviceSize( data.vertexOffset ),
+			data.indexCount,
+			scene.getIndexBuffer(),
+			pipelineLayout, offsetof( ChunkPushConstants, chunkOrigin ), sizeof( data.origin ), data.origin
+		};
+	}
+
+	std::unique_ptr<IndirectChunkRenderer> renderer = scene.makeRenderer();
+
+
+	vector<double> cpuPathRecordTimes, gpuPathRecordTimes, cpuPathGpuTimes, gpuPathGpuTimes;
+	vector<uint32_t> visible;
+	vector<DrawCommand> drawList;
+	vector<uint32_t> cpuVisibleChunks( gpu.getFramesInFlight(), 0 ); // of the frame in flight in the slot
+	uint64_t cpuVisibleTotal = 0, gpuVisibleTotal = 0, framesConsumed = 0;
+	uint32_t maxVisibleChunkDifference = 0; // float rounding may differ between the CPU and the GPU on boxes touching a plane
+
+	gpu.runFrames(
+		frameCount,
+		[&]( const VkCommandBuffer commandBuffer, const uint64_t frame, const uint32_t slot ){
+			float viewProjection[16], planes[6][4];
+			scene.getCamera( frame, 80.0f /*eye height*/, 0.25f /*look down*/, viewProjection, planes );
+
+			gpu.recordFrameStart( commandBuffer, slot );
+
+			auto start = steady_clock::now();
+			culler.cull( planes, visible );
+			drawList.clear();
+			for( const uint32_t id : visible ) drawList.push_back( chunkDraws[id] );
+			recordBeginRenderPass( commandBuffer, gpu.getRenderPass(), gpu.getFramebuffer( slot ), VulkanConfig::clearColor, gpu.getWidth(), gpu.getHeight() );
+				recordSetViewport( commandBuffer, gpu.getWidth(), gpu.getHeight() );
+				recordPushConstants( commandBuffer, pipelineLayout, offsetof( ChunkPushConstants, viewProjection ), sizeof( viewProjection ), viewProjection );
+				recordDrawList( commandBuffer, ChunkScene::vertexBufferBinding, drawList );
+			recordEndRenderPass( commandBuffer );
+			cpuPathRecordTimes.push_back(  duration<double, std::milli>( steady_clock::now() - start ).count()  );
+			cpuVisibleChunks[slot] = static_cast<uint32_t>( visible.size() );
+
+			gpu.recordTimestamp( commandBuffer, slot, 1 );
+
+			start = steady_clock::now();
+			renderer->recordCull( commandBuffer, slot, planes, chunkCount );
+			scene.recordDraw( commandBuffer, slot, gpu.getRenderPass(), *renderer, viewProjection );
+			gpuPathRecordTimes.push_back(  duration<double, std::milli>( steady_clock::now() - start ).count()  );
+
+			gpu.recordTimestamp( commandBuffer, slot, 2 );
+		},
+		// the slot's frame is complete: its timestamps and draw count are in
+		[&]( const uint32_t slot ){
+			double gpuTimes[2];
+			if(  gpu.getTimestampIntervals( slot, gpuTimes )  ){
+				cpuPathGpuTimes.push_back( gpuTimes[0] );
+				gpuPathGpuTimes.push_back( gpuTimes[1] );
+			}
+
+			const uint32_t gpuVisible = renderer->getDrawCount( slot );
+			const uint32_t cpuVisible = cpuVisibleChunks[slot];
+			maxVisibleChunkDifference = std::max( maxVisibleChunkDifference, gpuVisible > cpuVisible ? gpuVisible - cpuVisible : cpuVisible - gpuVisible );
+			cpuVisibleTotal += cpuVisible;
+			gpuVisibleTotal += gpuVisible;
+			++framesConsumed;
+		}
+	);
+
+
+	BenchmarkReport report( "indirect" );
+	scene.reportScene( report, frameCount, *renderer );
+	report.setStatistics( "cpuPathRecordTimeMs", getSampleStatistics( cpuPathRecordTimes ) ); // ChunkCuller + a draw per chunk
+	report.setStatistics( "gpuPathRecordTimeMs", getSampleStatistics( gpuPathRecordTimes ) ); // a dispatch + one indirect draw
+	if( gpu.hasGpuTiming() ){
+		report.setStatistics( "cpuPathGpuTimeMs", getSampleStatistics( cpuPathGpuTimes ) );
+		report.setStatistics( "gpuPathGpuTimeMs", getSampleStatistics( gpuPathGpuTimes ) ); // culling included
+	}
+	report.setNumber( "cpuVisibleChunksPerFrame", framesConsumed ? double( cpuVisibleTotal ) / framesConsumed : 0.0 );
+	report.setNumber( "gpuVisibleChunksPerFrame", framesConsumed ? double( gpuVisibleTotal ) / framesConsumed : 0.0 );
+	report.setInteger( "maxVisibleChunkDifference", maxVisibleChunkDifference );
+	report.write( options.reportPath );
+
+
+	// proper Vulkan cleanup; scene and gpu destroy the rest
+	{VkResult errorCode = vkDeviceWaitIdle( device ); RESULT_HANDLER( errorCode, "vkDeviceWaitIdle" );}
+
+	renderer.reset();
+	killPipeline( device, pipeline );
+	killPipelineLayout( device, pipelineLayout );
+	killShaderModule( device, vertexShader );
+
+	return EXIT_SUCCESS;
+}
+catch( ... ){
+	return exitOnUncaughtException();
+}
+
+
+// Draws the chunks of a wide square of cave terrain, the ground over three layers of caves, while a camera just above the
+// ground turns full circle, both ways in every frame: frustum culled by the GPU (IndirectChunkRenderer::recordCull), and
+// occlusion culled in two phases against a HiZPyramid, which hides most of the caves under the ground. Measures the GPU
+// time of each with timestamps, and counts the chunks each draws; the late pass draws what comes into view.
+int occlusionBenchmark( const AppOptions& options ) try{
+	const uint64_t frameCount = options.frameCount ? options.frameCount : VulkanConfig::occlusionBenchmarkFrameCount;
+
+	ChunkScene scene( options, TestTerrain::caves, -2 /*first layer*/, 4 /*layers*/, VulkanConfig::occlusionBenchmarkViewDistance, true /*sampled depth*/ );
+	OffscreenGpu& gpu = scene.getGpu();
+	const VkDevice device = gpu.getDevice();
+	const uint32_t chunkCount = scene.getChunkCount();
+
+	// compatible with the render pass of gpu, so they share the framebuffers
+	VkRenderPass earlyRenderPass = initEarlyRenderPass( device, gpu.getFormat(), gpu.getDepthFormat() );
+	VkRenderPass lateRenderPass = initLateRenderPass( device, gpu.getFormat(), gpu.getDepthFormat() );
+
+	vector<uint32_t> occlusionCullShaderBinary = {
+#include "shaders/chunk_occlusion_cull.comp.spv.inl"
+	};
+	vector<uint32_t> reduceShaderBinary = {
+#include "shaders/hiz_reduce.comp.spv.inl"
+	};
+	VkShaderModule occlusionCullShader = initShaderModule( device, occlusionCullShaderBinary );
+	VkShaderModule reduceShader = initShaderModule( device, reduceShaderBinary );
+
+	// one renderer per path, so each has its own draws per frame; only the second one culls occlusion
+	std::unique_ptr<IndirectChunkRenderer> frustumRenderer = scene.makeRenderer();
+	std::unique_ptr<IndirectChunkRenderer> occlusionRenderer = scene.makeRenderer( occlusionCullShader );
+
+	std::unique_ptr<HiZPyramid> pyramid( new HiZPyramid( device, gpu.getMemoryProperties(), gpu.getPipelineCache().get(), reduceShader, gpu.getDepthView(), gpu.getWidth(), gpu.getHeight() ) );
+	occlusionRenderer->setHiZPyramid( *pyramid );
+
+
+	vector<double> frustumGpuTimes, occlusionGpuTimes;
+	uint64_t frustumDrawnTotal = 0, earlyDrawnTotal = 0, lateDrawnTotal = 0, framesConsumed = 0;
+	uint32_t maxLateDrawn = 0;
+
+	gpu.runFrames(
+		frameCount,
+		[&]( const VkCommandBuffer commandBuffer, const uint64_t frame, const uint32_t slot ){
+			float viewProjection[16], planes[6][4];
+			scene.getCamera( frame, VulkanConfig::occlusionBenchmarkEyeHeight, 0.15f /*look down*/, viewProjection, planes );
+
+			gpu.recordFrameStart( commandBuffer, slot );
+
+			frustumRenderer->recordCull( commandBuffer, slot, planes, chunkCount );
+			scene.recordDraw( commandBuffer, slot, gpu.getRenderPass(), *frustumRenderer, viewProjection );
+
+			gpu.recordTimestamp( commandBuffer, slot, 1 );
+
+			occlusionRenderer->recordEarlyCull( commandBuffer, slot, planes, chunkCount );
+			scene.recordDraw( commandBuffer, slot, earlyRenderPass, *occlusionRenderer, viewProjection );
+			pyramid->recordBuild( commandBuffer );
+			occlusionRenderer->recordLateCull( commandBuffer, slot, viewProjection, chunkCount );
+			scene.recordDraw( commandBuffer, slot, lateRenderPass, *occlusionRenderer, viewProjection );
+
+			gpu.recordTimestamp( commandBuffer, slot, 2 );
+		},
+		// the slot's frame is complete: its timestamps and draw counts are in
+		[&]( const uint32_t slot ){
+			double gpuTimes[2];
+			if(  gpu.getTimestampIntervals( slot, gpuTimes )  ){
+				frustumGpuTimes.push_back( gpuTimes[0] );
+				occlusionGpuTimes.push_back( gpuTimes[1] );
+			}
+
+			frustumDrawnTotal += frustumRenderer->getDrawCount( slot );
+			earlyDrawnTotal += occlusionRenderer->getDrawCount( slot );
+			const uint32_t lateDrawn = occlusionRenderer->getDrawCount( slot, true /*late*/ );
+			lateDrawnTotal += lateDrawn;
+			if( framesConsumed ) maxLateDrawn = std::max( maxLateDrawn, lateDrawn ); // the first frame draws all in the late pass
+			++framesConsumed;
+		}
+	);
+
+
+	const auto perFrame = [framesConsumed]( const uint64_t total ){ return framesConsumed ? double( total ) / framesConsumed : 0.0; };
+
+	BenchmarkReport report( "occlusion" );
+	scene.reportScene( report, frameCount, *frustumRenderer );
+	report.setInteger( "hiZLevels", pyramid->getLevelCount() );
+	if( gpu.hasGpuTiming() ){
+		report.setStatistics( "frustumGpuTimeMs", getSampleStatistics( frustumGpuTimes ) );
+		report.setStatistics( "occlusionGpuTimeMs", getSampleStatistics( occlusionGpuTimes ) ); // both passes, culling and pyramid included
+	}
+	report.setNumber( "frustumDrawnChunksPerFrame", perFrame( frustumDrawnTotal ) );
+	report.setNumber( "occlusionDrawnChunksPerFrame", perFrame( earlyDrawnTotal + lateDrawnTotal ) );
+	report.setNumber( "earlyDrawnChunksPerFrame", perFrame( earlyDrawnTotal ) ); // visible last frame
+	report.setNumber( "lateDrawnChunksPerFrame", perFrame( lateDrawnTotal ) ); // came into view; drawn without popping
+	report.setInteger( "maxLateDrawnChunks", maxLateDrawn ); // but the first frame's
+	report.write( options.reportPath );
+
+
+	// proper Vulkan cleanup; scene and gpu destroy the rest
+	{VkResult errorCode = vkDeviceWaitIdle( device ); RESULT_HANDLER( errorCode, "vkDeviceWaitIdle" );}
+
+	pyramid.reset();
+	occlusionRenderer.reset();
+	frustumRenderer.reset();
+	killShaderModule( device, reduceShader );
+	killShaderModule( device, occlusionCullShader );
+	killRenderPass( device, lateRenderPass );
+	killRenderPass( device, earlyRenderPass );
+
+	return EXIT_SUCCESS;
+}
+catch( ... ){
+	return exitOnUncaughtException();
+}
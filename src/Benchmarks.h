@@ -0,0 +1,21 @@
+// The benchmark modes of the app; each writes a BenchmarkReport and returns the exit status of the app
+
+#ifndef COMMON_BENCHMARKS_H
+#define COMMON_BENCHMARKS_H
+
+#include "AppOptions.h"
+
+
+// The report goes to AppOptions::reportPath. The modes that check their results (meshing, generation, storage, culling)
+// fail if the check does; the others fail only on errors. See the README for what each measures.
+int offscreenBenchmark( const AppOptions& options ); // --offscreen
+int recordingBenchmark( const AppOptions& options ); // --record-benchmark
+int meshingBenchmark( const AppOptions& options ); // --mesh-benchmark
+int generationBenchmark( const AppOptions& options ); // --gen-benchmark
+int streamingBenchmark( const AppOptions& options ); // --stream-benchmark
+int storageBenchmark( const AppOptions& options ); // --storage-benchmark
+int cullingBenchmark( const AppOptions& options ); // --cull-benchmark
+int indirectBenchmark( const AppOptions& options ); // --indirect-benchmark
+int occlusionBenchmark( const AppOptions& options ); // --occlusion-benchmark
+
+#endif //COMMON_BENCHMARKS_H
@@ -0,0 +1,86 @@
+// Binary buddy allocator of offsets inside a fixed size range; knows nothing about Vulkan
+#include "BuddyAllocator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+// Implementation
+//////////////////////////////////
+
+static bool isPowerOfTwo( const uint64_t x ){ return x && !(x & (x - 1)); }
+
+static uint32_t log2Floor( uint64_t x ){
+	uint32_t log = 0;
+	while( x >>= 1 ) ++log;
+	return log;
+}
+
+BuddyAllocator::BuddyAllocator( const uint64_t capacity, const uint64_t minBlockSize )
+: m_capacity( capacity ), m_minBlockSize( minBlockSize )
+{
+	if( !isPowerOfTwo( capacity ) || !isPowerOfTwo( minBlockSize ) || capacity < minBlockSize ){
+		throw std::string( "BuddyAllocator: capacity " ) + std::to_string( capacity ) + " and min block size " + std::to_string( minBlockSize ) + " must be powers of two, capacity >= min block size";
+	}
+
+	m_maxOrder = log2Floor( capacity / minBlockSize );
+	m_freeBlocks.resize( m_maxOrder + 1 );
+	m_freeBlocks[m_maxOrder].insert( 0 );
+}
+
+uint64_t BuddyAllocator::allocate( const uint64_t size, const uint64_t alignment ){
+	const uint64_t needed = std::max( {size, alignment, m_minBlockSize} );
+	if( needed > m_capacity ) return invalidOffset;
+
+	uint32_t order = log2Floor( needed / m_minBlockSize );
+	if( blockSize( order ) < needed ) ++order;
+	if( order > m_maxOrder ) return invalidOffset;
+
+	uint32_t freeOrder = order;
+	while( freeOrder <= m_maxOrder && m_freeBlocks[freeOrder].empty() ) ++freeOrder;
+	if( freeOrder > m_maxOrder ) return invalidOffset;
+
+	const uint64_t offset = *m_freeBlocks[freeOrder].begin();
+	m_freeBlocks[freeOrder].erase( m_freeBlocks[freeOrder].begin() );
+
+	// split down; the upper halves become free buddies
+	while( freeOrder > order ){
+		--freeOrder;
+		m_freeBlocks[freeOrder].insert( offset + blockSize( freeOrder ) );
+	}
+
+	m_allocated.emplace( offset, order );
+	m_usedSize += blockSize( order );
+
+	return offset;
+}
+
+void BuddyAllocator::free( uint64_t offset ){
+	const auto it = m_allocated.find( offset );
+	if( it == m_allocated.end() ) throw std::string( "BuddyAllocator: freeing offset " ) + std::to_string( offset ) + " that was not allocated";
+
+	uint32_t order = it->second;
+	m_allocated.erase( it );
+	m_usedSize -= blockSize( order );
+
+	// merge with the buddy for as long as it is free too
+	while( order < m_maxOrder ){
+		const uint64_t buddy = offset ^ blockSize( order );
+		const auto buddyIt = m_freeBlocks[order].find( buddy );
+		if( buddyIt == m_freeBlocks[order].end() ) break;
+
+		m_freeBlocks[order].erase( buddyIt );
+		offset = std::min( offset, buddy );
+		++order;
+	}
+
+	m_freeBlocks[order].insert( offset );
+}
+
+uint64_t BuddyAllocator::largestFreeBlock() const{
+	for( uint32_t order = m_maxOrder + 1; order-- > 0; ){
+		if( !m_freeBlocks[order].empty() ) return blockSize( order );
+	}
+
+	return 0;
+}
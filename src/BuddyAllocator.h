@@ -0,0 +1,45 @@
+// Binary buddy allocator of offsets inside a fixed size range; knows nothing about Vulkan
+
+#ifndef COMMON_BUDDY_ALLOCATOR_H
+#define COMMON_BUDDY_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+
+// Every allocation is rounded up to a power of two (at least minBlockSize) and lands on an offset
+// that is a multiple of its rounded size, so any power-of-two alignment up to the size comes for free.
+class BuddyAllocator{
+public:
+	static constexpr uint64_t invalidOffset = UINT64_MAX;
+
+	// both must be powers of two, capacity >= minBlockSize
+	BuddyAllocator( uint64_t capacity, uint64_t minBlockSize );
+
+	// alignment must be a power of two; returns invalidOffset if there is no free block large enough
+	uint64_t allocate( uint64_t size, uint64_t alignment = 1 );
+	void free( uint64_t offset );
+
+	uint64_t capacity() const{ return m_capacity; }
+	uint64_t usedSize() const{ return m_usedSize; } // including the rounding to power of two
+	uint64_t freeSize() const{ return m_capacity - m_usedSize; }
+	uint64_t largestFreeBlock() const;
+	size_t allocationCount() const{ return m_allocated.size(); }
+	bool empty() const{ return m_allocated.empty(); }
+
+private:
+	uint64_t blockSize( uint32_t order ) const{ return m_minBlockSize << order; }
+
+	uint64_t m_capacity;
+	uint64_t m_minBlockSize;
+	uint32_t m_maxOrder;
+	uint64_t m_usedSize = 0;
+
+	std::vector< std::set<uint64_t> > m_freeBlocks; // free block offsets per order; ordered, so allocations pack to low offsets
+	std::unordered_map<uint64_t, uint32_t> m_allocated; // offset -> order
+};
+
+#endif //COMMON_BUDDY_ALLOCATOR_H
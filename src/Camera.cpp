@@ -0,0 +1,68 @@
+// Camera matrices: a reversed-Z perspective projection for Vulkan's clip space, products of 4x4 matrices, frustum planes
+#include "Camera.h"
+
+#include <cmath>
+
+// Implementation
+//////////////////////////////////
+
+void makeReversedZPerspective( const float fovY, const float aspect, const float nearPlane, const float farPlane, float result[16] ){
+	if( !(nearPlane > 0.0f) ) throw "makeReversedZPerspective: the near plane has to be in front of the camera";
+	if( farPlane != 0.0f && !(farPlane > nearPlane) ) throw "makeReversedZPerspective: the far plane has to be beyond the near one";
+
+	const float focal = 1.0f / std::tan( fovY * 0.5f );
+
+	// depth = (a * z + b) / -z: near -> 1, far -> 0; with the far plane at infinity a = 0, b = near
+	const float a = farPlane == 0.0f ? 0.0f : nearPlane / (farPlane - nearPlane);
+	const float b = farPlane == 0.0f ? nearPlane : nearPlane * farPlane / (farPlane - nearPlane);
+
+	for( int i = 0; i < 16; ++i ) result[i] = 0.0f;
+	result[0] = focal / aspect;
+	result[5] = -focal; // Vulkan's Y points down
+	result[10] = a;
+	result[11] = -1.0f; // w = -z
+	result[14] = b;
+}
+
+void makeViewMatrix( const float position[3], const float direction[3], float result[16] ){
+	const float length = std::sqrt( direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2] );
+	const float sideLength = std::sqrt( direction[0] * direction[0] + direction[2] * direction[2] );
+	if( !(sideLength > 0.0f) ) throw "makeViewMatrix: the camera cannot look straight up or down";
+
+	// the basis of view space in world space: x right, y up, z back (the camera looks down -z)
+	const float back[3] = { -direction[0] / length, -direction[1] / length, -direction[2] / length };
+	const float right[3] = { -back[2] * length / sideLength, 0.0f, back[0] * length / sideLength }; // up x back, up = +Y
+	const float up[3] = { back[1] * right[2] - back[2] * right[1], back[2] * right[0] - back[0] * right[2], back[0] * right[1] - back[1] * right[0] };
+
+	// rows of the rotation are the basis vectors; the translation moves the camera to the origin
+	const float* const axes[3] = { right, up, back };
+	for( int row = 0; row < 3; ++row ){
+		for( int column = 0; column < 3; ++column ) result[column * 4 + row] = axes[row][column];
+		result[12 + row] = -(axes[row][0] * position[0] + axes[row][1] * position[1] + axes[row][2] * position[2]);
+		result[row * 4 + 3] = 0.0f;
+	}
+	result[15] = 1.0f;
+}
+
+void multiplyMatrices( const float left[16], const float right[16], float result[16] ){
+	for( int column = 0; column < 4; ++column ){
+		for( int row = 0; row < 4; ++row ){
+			float sum = 0.0f;
+			for( int k = 0; k < 4; ++k ) sum += left[k * 4 + row] * right[column * 4 + k];
+			result[column * 4 + row] = sum;
+		}
+	}
+}
+
+void extractFrustumPlanes( const float viewProjection[16], float planes[6][4] ){
+	// a clip space point is inside if -w <= x <= w, -w <= y <= w and 0 <= z <= w; each bound is a plane through the rows
+	const auto row = [viewProjection]( const int i, const int k ){ return viewProjection[k * 4 + i]; };
+	for( int k = 0; k < 4; ++k ){
+		planes[0][k] = row( 3, k ) + row( 0, k ); // x >= -w
+		planes[1][k] = row( 3, k ) - row( 0, k ); // x <= w
+		planes[2][k] = row( 3, k ) + row( 1, k ); // y >= -w
+		planes[3][k] = row( 3, k ) - row( 1, k ); // y <= w
+		planes[4][k] = row( 3, k ) - row( 2, k ); // z <= w: the near plane, as reversed-Z puts it at depth 1
+		planes[5][k] = row( 2, k ); // z >= 0: the far one
+	}
+}
@@ -0,0 +1,23 @@
+// Camera matrices: a reversed-Z perspective projection for Vulkan's clip space, products of 4x4 matrices, frustum planes
+
+#ifndef COMMON_CAMERA_H
+#define COMMON_CAMERA_H
+
+// All matrices are 16 floats, column-major like GLSL, so they go into ChunkPushConstants::viewProjection as they are.
+
+// Right-handed view space looking down -Z, to Vulkan clip space (Y down, depth 0..1).
+// Reversed-Z: the near plane maps to depth 1 and the far one to 0; far 0 puts the far plane at infinity.
+// Pairs with VulkanConfig::depthClearValue and depthCompareOp.
+void makeReversedZPerspective( float fovY, float aspect, float nearPlane, float farPlane, float result[16] ); // fovY in radians
+
+// world to view space of a camera at position looking along direction, with +Y up; direction need not be normalized
+void makeViewMatrix( const float position[3], const float direction[3], float result[16] );
+
+void multiplyMatrices( const float left[16], const float right[16], float result[16] ); // result = left * right; may alias neither
+
+// The six planes of the frustum of a view-projection matrix (the two X sides, the two Y sides, near, far), in the space the
+// matrix takes points from: a point p is inside all of them if a * p.x + b * p.y + c * p.z + d >= 0, for { a, b, c, d }.
+// Not normalized, which the sign tests do not need. A far plane at infinity comes out as { 0, 0, 0, d > 0 }: never culls.
+void extractFrustumPlanes( const float viewProjection[16], float planes[6][4] );
+
+#endif //COMMON_CAMERA_H
@@ -0,0 +1,61 @@
+// Runtime detection of the SIMD instruction sets of the CPU, to pick code paths without separate builds
+#include "CpuFeatures.h"
+
+#if CPU_X86 && defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+// Implementation
+//////////////////////////////////
+
+static CpuFeatures detectCpuFeatures(){
+	CpuFeatures features = {};
+
+#if CPU_X86 && defined(_MSC_VER)
+	int info[4];
+	__cpuid( info, 0 );
+	const int maxLeaf = info[0];
+
+	__cpuid( info, 1 );
+	features.sse41 = (info[2] & (1 << 19)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	const bool osYmm = osxsave && (_xgetbv( 0 ) & 0x6) == 0x6; // the OS saves XMM and YMM state
+
+	if( maxLeaf >= 7 && avx && osYmm ){
+		__cpuidex( info, 7, 0 );
+		const bool avx2 = (info[1] & (1 << 5)) != 0;
+		const bool bmi1 = (info[1] & (1 << 3)) != 0;
+		const bool bmi2 = (info[1] & (1 << 8)) != 0;
+		features.avx2 = avx2 && bmi1 && bmi2;
+	}
+#elif CPU_X86 && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	features.sse41 = __builtin_cpu_supports( "sse4.1" );
+	features.avx2 = __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "bmi" ) && __builtin_cpu_supports( "bmi2" );
+#endif
+
+	return features;
+}
+
+const CpuFeatures& getCpuFeatures(){
+	static const CpuFeatures features = detectCpuFeatures();
+	return features;
+}
+
+SimdLevel getSimdLevel( const SimdLevel highest ){
+	const CpuFeatures& features = getCpuFeatures();
+	if( highest >= SimdLevel::avx2 && features.avx2 ) return SimdLevel::avx2;
+	if( highest >= SimdLevel::sse41 && features.sse41 ) return SimdLevel::sse41;
+	return SimdLevel::scalar;
+}
+
+const char* getSimdLevelName( const SimdLevel level ){
+	switch( level ){
+		case SimdLevel::scalar: return "scalar";
+		case SimdLevel::sse41: return "sse41";
+		case SimdLevel::avx2: return "avx2";
+	}
+
+	return "unknown";
+}
@@ -0,0 +1,39 @@
+// Runtime detection of the SIMD instruction sets of the CPU, to pick code paths without separate builds
+
+#ifndef COMMON_CPU_FEATURES_H
+#define COMMON_CPU_FEATURES_H
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define CPU_X86 1
+	#include <immintrin.h>
+#else
+	#define CPU_X86 0
+#endif
+
+// Functions using AVX2 (or SSE4.1) intrinsics are marked with this, so the rest of the file keeps the baseline instruction
+// set and they are only called once getCpuFeatures().avx2 (or .sse41) says so. MSVC allows the intrinsics anywhere.
+#if CPU_X86 && (defined(__GNUC__) || defined(__clang__))
+	#define TARGET_AVX2 __attribute__(( target( "avx2,bmi,bmi2,popcnt" ) ))
+	#define TARGET_SSE41 __attribute__(( target( "sse4.1" ) ))
+#else
+	#define TARGET_AVX2
+	#define TARGET_SSE41
+#endif
+
+
+struct CpuFeatures{
+	bool sse41;
+	bool avx2; // with BMI1/2 and OS support for the YMM registers
+};
+
+const CpuFeatures& getCpuFeatures(); // detected once
+
+// code paths of modules that have one per instruction set; each level has the ones below it
+enum class SimdLevel : uint8_t{ scalar, sse41, avx2 };
+
+SimdLevel getSimdLevel( SimdLevel highest = SimdLevel::avx2 ); // the best one the CPU has, up to highest
+const char* getSimdLevelName( SimdLevel level ); // e.g. "avx2"
+
+#endif //COMMON_CPU_FEATURES_H
@@ -1,6 +1,8 @@
 // Reusable error handling primitives for Vulkan
 #include "ErrorHandling.h"
 
+#include <cstdlib>
+#include <exception>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -9,10 +11,34 @@
 
 #include "VulkanIntrospection.h"
 
-//Dummy exception handling for now
-void RESULT_HANDLER( VkResult errorCode, const char* source ) {};
-void RESULT_HANDLER_EX( uint32_t cond, VkResult errorCode, const char* source ) {};
-void RUNTIME_ASSERT( uint32_t cond, VkResult errorCode, const char* source ) {};
+void throwResultException( const char* file, unsigned line, const char* func, const char* source, VkResult result ){
+	throw VulkanResultException( file, line, func, source, result );
+}
+
+int exitOnUncaughtException(){
+	try{
+		throw;
+	}
+	catch( VulkanResultException vkE ){
+		logger << "ERROR: Terminated due to an uncaught VkResult exception: "
+		       << vkE.file << ":" << vkE.line << ":" << vkE.func << "() " << vkE.source << "() returned " << to_string( vkE.result )
+		       << std::endl;
+	}
+	catch( const char* e ){
+		logger << "ERROR: Terminated due to an uncaught exception: " << e << std::endl;
+	}
+	catch( std::string e ){
+		logger << "ERROR: Terminated due to an uncaught exception: " << e << std::endl;
+	}
+	catch( std::exception e ){
+		logger << "ERROR: Terminated due to an uncaught exception: " << e.what() << std::endl;
+	}
+	catch( ... ){
+		logger << "ERROR: Terminated due to an unrecognized uncaught exception." << std::endl;
+	}
+
+	return EXIT_FAILURE;
+}
 
 
 enum class Highlight{ off, on };
@@ -22,13 +22,36 @@ struct VulkanResultException{
 	: file( file ), line( line ), func( func ), source( source ), result( result ){}
 };
 
-void RESULT_HANDLER( VkResult errorCode, const char* source );
-void RESULT_HANDLER_EX( uint32_t cond, VkResult errorCode, const char* source );
-void RUNTIME_ASSERT( uint32_t cond, VkResult errorCode, const char* source );
+#if defined(__GNUC__) || defined(__clang__)
+	#define VULKAN_UNLIKELY( cond ) __builtin_expect( !!(cond), 0 )
+#else
+	#define VULKAN_UNLIKELY( cond ) (cond)
+#endif
+
+// the cold path of the macros below; out of line, so at the call site they are one compare and a not-taken branch
+[[noreturn]] void throwResultException( const char* file, unsigned line, const char* func, const char* source, VkResult result );
+
+// Throws on error codes (negative) only. Success codes pass, so those a caller cares about (VK_INCOMPLETE, VK_NOT_READY,
+// VK_SUBOPTIMAL_KHR, ...) are checked by the caller -- e.g. acquireNextImage and present return them as status.
+#define RESULT_HANDLER( errorCode, source ) do{ \
+	const VkResult resultHandlerCode = (errorCode); \
+	if(  VULKAN_UNLIKELY( resultHandlerCode < VK_SUCCESS )  ) throwResultException( __FILE__, __LINE__, __func__, source, resultHandlerCode ); \
+}while( false )
+
+#define RESULT_HANDLER_EX( cond, errorCode, source ) do{ \
+	if(  VULKAN_UNLIKELY( cond )  ) throwResultException( __FILE__, __LINE__, __func__, source, errorCode ); \
+}while( false )
+
+#define RUNTIME_ASSERT( cond, source ) do{ \
+	if(  VULKAN_UNLIKELY( !(cond) )  ) throw source " failed"; \
+}while( false )
 
 // just use cout for logging now
 static std::ostream& logger = std::cout;
 
+// to be called from a catch block; logs the in-flight exception and returns the exit status
+int exitOnUncaughtException();
+
 enum class Highlight;
 void genericDebugCallback( std::string flags, Highlight highlight, std::string msgCode, std::string object, const char* message );
 
@@ -29,6 +29,7 @@ void loadInstanceExtensionsCommands( const VkInstance instance, const std::vecto
 		if( strcmp( e, VK_EXT_DEBUG_REPORT_EXTENSION_NAME ) == 0 ) loadDebugReportCommands( instance );
 		if( strcmp( e, VK_EXT_DEBUG_UTILS_EXTENSION_NAME ) == 0 ) loadDebugUtilsCommands( instance );
 		if( strcmp( e, VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME ) == 0 ) loadExternalMemoryCapsCommands( instance );
+		if( strcmp( e, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME ) == 0 ) loadHeadlessSurfaceCommands( instance );
 		// ...
 	}
 }
@@ -41,6 +42,7 @@ void unloadInstanceExtensionsCommands( const VkInstance instance ){
 		if( strcmp( e, VK_EXT_DEBUG_REPORT_EXTENSION_NAME ) == 0 ) unloadDebugReportCommands( instance );
 		if( strcmp( e, VK_EXT_DEBUG_UTILS_EXTENSION_NAME ) == 0 ) unloadDebugUtilsCommands( instance );
 		if( strcmp( e, VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME ) == 0 ) unloadExternalMemoryCapsCommands( instance );
+		if( strcmp( e, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME ) == 0 ) unloadHeadlessSurfaceCommands( instance );
 		// ...
 	}
 
@@ -58,6 +60,8 @@ void loadDeviceExtensionsCommands( const VkDevice device, const std::vector<cons
 		if( strcmp( e, VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME ) == 0 ) loadExternalMemoryWin32Commands( device );
 #endif
 		if( strcmp( e, VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME ) == 0 ) loadDedicatedAllocationCommands( device );
+		if( strcmp( e, VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME ) == 0 ) loadGetMemoryRequirements2Commands( device );
+		if( strcmp( e, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME ) == 0 ) loadTimelineSemaphoreCommands( device );
 		// ...
 	}
 }
@@ -71,12 +75,22 @@ void unloadDeviceExtensionsCommands( const VkDevice device ){
 		if( strcmp( e, VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME ) == 0 ) unloadExternalMemoryWin32Commands( device );
 #endif
 		if( strcmp( e, VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME ) == 0 ) unloadDedicatedAllocationCommands( device );
+		if( strcmp( e, VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME ) == 0 ) unloadGetMemoryRequirements2Commands( device );
+		if( strcmp( e, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME ) == 0 ) unloadTimelineSemaphoreCommands( device );
 		// ...
 	}
 
 	deviceExtensionsMap.erase( device );
 }
 
+bool isDeviceExtensionEnabled( const VkDevice device, const char* const extension ){
+	const auto it = deviceExtensionsMap.find( device );
+	if( it == deviceExtensionsMap.end() ) return false;
+
+	for( const auto e : it->second ) if( std::strcmp( e, extension ) == 0 ) return true;
+	return false;
+}
+
 
 // VK_KHR_get_physical_device_properties2
 ///////////////////////////////////////////
@@ -362,4 +376,102 @@ void unloadDedicatedAllocationCommands( VkDevice ){
 	// no commands
 }
 
+// VK_KHR_get_memory_requirements2
+///////////////////////////////////////////
+void loadGetMemoryRequirements2Commands( VkDevice device ){
+	PFN_vkVoidFunction temp_fp;
+
+	temp_fp = vkGetDeviceProcAddr( device, "vkGetBufferMemoryRequirements2KHR" );
+	if( !temp_fp ) throw "Failed to load vkGetBufferMemoryRequirements2KHR"; // check shouldn't be necessary (based on spec)
+	GetBufferMemoryRequirements2KHRDispatchTable[device] = reinterpret_cast<PFN_vkGetBufferMemoryRequirements2KHR>( temp_fp );
+
+	temp_fp = vkGetDeviceProcAddr( device, "vkGetImageMemoryRequirements2KHR" );
+	if( !temp_fp ) throw "Failed to load vkGetImageMemoryRequirements2KHR"; // check shouldn't be necessary (based on spec)
+	GetImageMemoryRequirements2KHRDispatchTable[device] = reinterpret_cast<PFN_vkGetImageMemoryRequirements2KHR>( temp_fp );
+}
+
+void unloadGetMemoryRequirements2Commands( VkDevice device ){
+	GetBufferMemoryRequirements2KHRDispatchTable.erase( device );
+	GetImageMemoryRequirements2KHRDispatchTable.erase( device );
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements2KHR(
+	VkDevice device,
+	const VkBufferMemoryRequirementsInfo2* pInfo,
+	VkMemoryRequirements2* pMemoryRequirements
+){
+	auto dispatched_cmd = GetBufferMemoryRequirements2KHRDispatchTable.at( device );
+	return dispatched_cmd( device, pInfo, pMemoryRequirements );
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements2KHR(
+	VkDevice device,
+	const VkImageMemoryRequirementsInfo2* pInfo,
+	VkMemoryRequirements2* pMemoryRequirements
+){
+	auto dispatched_cmd = GetImageMemoryRequirements2KHRDispatchTable.at( device );
+	return dispatched_cmd( device, pInfo, pMemoryRequirements );
+}
+
+// VK_EXT_headless_surface
+///////////////////////////////////////////
+void loadHeadlessSurfaceCommands( VkInstance instance ){
+	PFN_vkVoidFunction temp_fp;
+
+	temp_fp = vkGetInstanceProcAddr( instance, "vkCreateHeadlessSurfaceEXT" );
+	if( !temp_fp ) throw "Failed to load vkCreateHeadlessSurfaceEXT"; // check shouldn't be necessary (based on spec)
+	CreateHeadlessSurfaceEXTDispatchTable[instance] = reinterpret_cast<PFN_vkCreateHeadlessSurfaceEXT>( temp_fp );
+}
+
+void unloadHeadlessSurfaceCommands( VkInstance instance ){
+	CreateHeadlessSurfaceEXTDispatchTable.erase( instance );
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateHeadlessSurfaceEXT(
+	VkInstance instance,
+	const VkHeadlessSurfaceCreateInfoEXT* pCreateInfo,
+	const VkAllocationCallbacks* pAllocator,
+	VkSurfaceKHR* pSurface
+){
+	auto dispatched_cmd = CreateHeadlessSurfaceEXTDispatchTable.at( instance );
+	return dispatched_cmd( instance, pCreateInfo, pAllocator, pSurface );
+}
+
+// VK_KHR_timeline_semaphore
+///////////////////////////////////////////
+void loadTimelineSemaphoreCommands( VkDevice device ){
+	PFN_vkVoidFunction temp_fp;
+
+	temp_fp = vkGetDeviceProcAddr( device, "vkGetSemaphoreCounterValueKHR" );
+	if( !temp_fp ) throw "Failed to load vkGetSemaphoreCounterValueKHR"; // check shouldn't be necessary (based on spec)
+	GetSemaphoreCounterValueKHRDispatchTable[device] = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>( temp_fp );
+
+	temp_fp = vkGetDeviceProcAddr( device, "vkWaitSemaphoresKHR" );
+	if( !temp_fp ) throw "Failed to load vkWaitSemaphoresKHR"; // check shouldn't be necessary (based on spec)
+	WaitSemaphoresKHRDispatchTable[device] = reinterpret_cast<PFN_vkWaitSemaphoresKHR>( temp_fp );
+}
+
+void unloadTimelineSemaphoreCommands( VkDevice device ){
+	GetSemaphoreCounterValueKHRDispatchTable.erase( device );
+	WaitSemaphoresKHRDispatchTable.erase( device );
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetSemaphoreCounterValueKHR(
+	VkDevice device,
+	VkSemaphore semaphore,
+	uint64_t* pValue
+){
+	auto dispatched_cmd = GetSemaphoreCounterValueKHRDispatchTable.at( device );
+	return dispatched_cmd( device, semaphore, pValue );
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkWaitSemaphoresKHR(
+	VkDevice device,
+	const VkSemaphoreWaitInfo* pWaitInfo,
+	uint64_t timeout
+){
+	auto dispatched_cmd = WaitSemaphoresKHRDispatchTable.at( device );
+	return dispatched_cmd( device, pWaitInfo, timeout );
+}
+
 ///////////////////////////////////////////
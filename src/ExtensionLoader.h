@@ -32,6 +32,9 @@ void unloadDebugUtilsCommands( VkInstance instance );
 void loadExternalMemoryCapsCommands( VkInstance instance );
 void unloadExternalMemoryCapsCommands( VkInstance instance );
 
+void loadHeadlessSurfaceCommands( VkInstance instance );
+void unloadHeadlessSurfaceCommands( VkInstance instance );
+
 
 void loadExternalMemoryCommands( VkDevice device );
 void unloadExternalMemoryCommands( VkDevice device );
@@ -44,6 +47,15 @@ void unloadExternalMemoryWin32Commands( VkDevice device );
 void loadDedicatedAllocationCommands( VkDevice device );
 void unloadDedicatedAllocationCommands( VkDevice device );
 
+void loadGetMemoryRequirements2Commands( VkDevice device );
+void unloadGetMemoryRequirements2Commands( VkDevice device );
+
+void loadTimelineSemaphoreCommands( VkDevice device );
+void unloadTimelineSemaphoreCommands( VkDevice device );
+
+// whether the extension was in the list the device was created with
+bool isDeviceExtensionEnabled( VkDevice device, const char* extension );
+
 ////////////////////////////////////////////////////////
 
 static std::unordered_map< VkInstance, std::vector<const char*> > instanceExtensionsMap;
@@ -203,4 +215,61 @@ VKAPI_ATTR VkResult VKAPI_CALL vkGetMemoryWin32HandlePropertiesKHR(
 void loadDedicatedAllocationCommands( VkDevice );
 void unloadDedicatedAllocationCommands( VkDevice );
 
+// VK_KHR_get_memory_requirements2
+///////////////////////////////////////////
+
+static std::unordered_map< VkDevice, PFN_vkGetBufferMemoryRequirements2KHR > GetBufferMemoryRequirements2KHRDispatchTable;
+static std::unordered_map< VkDevice, PFN_vkGetImageMemoryRequirements2KHR > GetImageMemoryRequirements2KHRDispatchTable;
+
+void loadGetMemoryRequirements2Commands( VkDevice device );
+void unloadGetMemoryRequirements2Commands( VkDevice device );
+
+VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements2KHR(
+	VkDevice device,
+	const VkBufferMemoryRequirementsInfo2* pInfo,
+	VkMemoryRequirements2* pMemoryRequirements
+);
+
+VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements2KHR(
+	VkDevice device,
+	const VkImageMemoryRequirementsInfo2* pInfo,
+	VkMemoryRequirements2* pMemoryRequirements
+);
+
+// VK_EXT_headless_surface
+///////////////////////////////////////////
+
+static std::unordered_map< VkInstance, PFN_vkCreateHeadlessSurfaceEXT > CreateHeadlessSurfaceEXTDispatchTable;
+
+void loadHeadlessSurfaceCommands( VkInstance instance );
+void unloadHeadlessSurfaceCommands( VkInstance instance );
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateHeadlessSurfaceEXT(
+	VkInstance instance,
+	const VkHeadlessSurfaceCreateInfoEXT* pCreateInfo,
+	const VkAllocationCallbacks* pAllocator,
+	VkSurfaceKHR* pSurface
+);
+
+// VK_KHR_timeline_semaphore
+///////////////////////////////////////////
+
+static std::unordered_map< VkDevice, PFN_vkGetSemaphoreCounterValueKHR > GetSemaphoreCounterValueKHRDispatchTable;
+static std::unordered_map< VkDevice, PFN_vkWaitSemaphoresKHR > WaitSemaphoresKHRDispatchTable;
+
+void loadTimelineSemaphoreCommands( VkDevice device );
+void unloadTimelineSemaphoreCommands( VkDevice device );
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetSemaphoreCounterValueKHR(
+	VkDevice device,
+	VkSemaphore semaphore,
+	uint64_t* pValue
+);
+
+VKAPI_ATTR VkResult VKAPI_CALL vkWaitSemaphoresKHR(
+	VkDevice device,
+	const VkSemaphoreWaitInfo* pWaitInfo,
+	uint64_t timeout
+);
+
 #endif //EXTENSION_LOADER_H
@@ -0,0 +1,50 @@
+// Per in-flight frame command recording: a transient command pool per frame, re-recorded every frame from a draw list
+#include "VulkanEnvironment.h"
+
+#include "FrameContext.h"
+
+#include <fstream> // VulkanImpl.h relies on the includer for these
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "VulkanImpl.h"
+
+// Implementation
+//////////////////////////////////
+
+void recordDrawList( const VkCommandBuffer commandBuffer, const uint32_t vertexBufferBinding, const vector<DrawCommand>& drawList ){
+	recordDrawList( commandBuffer, vertexBufferBinding, drawList.data(), drawList.size() );
+}
+
+void recordDrawList( const VkCommandBuffer commandBuffer, const uint32_t vertexBufferBinding, const DrawCommand* const draws, const size_t drawCount ){
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkBuffer boundBuffer = VK_NULL_HANDLE;
+	VkDeviceSize boundOffset = 0;
+	VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+
+	for( size_t i = 0; i < drawCount; ++i ){
+		const DrawCommand& draw = draws[i];
+		if( draw.pipeline != boundPipeline ){
+			recordBindPipeline( commandBuffer, draw.pipeline );
+			boundPipeline = draw.pipeline;
+		}
+
+		if( draw.vertexBuffer != boundBuffer || draw.vertexBufferOffset != boundOffset ){
+			vkCmdBindVertexBuffers( commandBuffer, vertexBufferBinding, 1, &draw.vertexBuffer, &draw.vertexBufferOffset );
+			boundBuffer = draw.vertexBuffer;
+			boundOffset = draw.vertexBufferOffset;
+		}
+
+		if( draw.indexBuffer != VK_NULL_HANDLE && draw.indexBuffer != boundIndexBuffer ){
+			recordBindIndexBuffer( commandBuffer, draw.indexBuffer );
+			boundIndexBuffer = draw.indexBuffer;
+		}
+
+		if( draw.pushConstantsSize ) recordPushConstants( commandBuffer, draw.pipelineLayout, draw.pushConstantsOffset, draw.pushConstantsSize, draw.pushConstants );
+
+		if( draw.indexBuffer != VK_NULL_HANDLE ) recordDrawIndexed( commandBuffer, draw.vertexCount );
+		else recordDraw( commandBuffer, draw.vertexCount );
+	}
+}
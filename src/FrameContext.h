@@ -0,0 +1,42 @@
+// Per in-flight frame command recording: a transient command pool per frame, re-recorded every frame from a draw list
+
+#ifndef COMMON_FRAME_CONTEXT_H
+#define COMMON_FRAME_CONTEXT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+
+// Everything a frame needs that cannot be touched until the GPU is done with that frame; FrameScheduler owns them.
+// The whole pool is reset at once, which is much cheaper than resetting or freeing individual command buffers.
+struct FrameContext{
+	VkCommandPool commandPool; // TRANSIENT
+	VkCommandBuffer commandBuffer;
+	uint64_t timelineValue; // signaled on the scheduler's timeline semaphore when the frame's submission finished
+};
+
+
+struct DrawCommand{
+	VkPipeline pipeline;
+	VkBuffer vertexBuffer;
+	VkDeviceSize vertexBufferOffset;
+	uint32_t vertexCount; // of indices, if indexBuffer is given
+
+	VkBuffer indexBuffer; // optional; 32-bit indices from offset 0, e.g. makeQuadIndices() for chunk meshes
+
+	// optional vertex stage push constants, pushed right before the draw; e.g. ChunkPushConstants::chunkOrigin
+	VkPipelineLayout pipelineLayout; // only needed with pushConstantsSize
+	uint32_t pushConstantsOffset;
+	uint32_t pushConstantsSize; // 0 = none
+	const void* pushConstants; // must stay valid until recordDrawList returns
+};
+
+// Rebuilt by the app every frame; clear() keeps the capacity, so the steady state does not allocate.
+// Consecutive draws sharing the pipeline, vertex buffer or index buffer do not rebind them.
+void recordDrawList( VkCommandBuffer commandBuffer, uint32_t vertexBufferBinding, const std::vector<DrawCommand>& drawList );
+void recordDrawList( VkCommandBuffer commandBuffer, uint32_t vertexBufferBinding, const DrawCommand* draws, size_t drawCount );
+
+#endif //COMMON_FRAME_CONTEXT_H
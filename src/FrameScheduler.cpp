@@ -0,0 +1,176 @@
+// Paces frames in flight on one timeline semaphore (VK_KHR_timeline_semaphore), and defers deletion of resources until
+// the GPU is done with them
+#include "VulkanEnvironment.h"
+
+#include "FrameScheduler.h"
+
+#include <algorithm>
+#include <fstream> // VulkanImpl.h relies on the includer for these
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "ErrorHandling.h"
+#include "VulkanImpl.h"
+
+// Implementation
+//////////////////////////////////
+
+static FrameContext initFrameContext( const VkDevice device, const uint32_t queueFamily ){
+	FrameContext frame;
+	frame.commandPool = initCommandPool( device, queueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT );
+
+	vector<VkCommandBuffer> commandBuffer;
+	acquireCommandBuffers( device, frame.commandPool, 1, commandBuffer );
+	frame.commandBuffer = commandBuffer[0];
+
+	frame.timelineValue = 0; // the initial value of the semaphore, i.e. already complete
+
+	return frame;
+}
+
+static uint32_t clampFramesInFlight( const uint32_t framesInFlight ){
+	return std::min( std::max( framesInFlight, 1u ), VulkanConfig::maxFramesInFlight );
+}
+
+FrameScheduler::FrameScheduler( const VkDevice device, const uint32_t queueFamily, const uint32_t framesInFlight )
+: m_device( device ), m_queueFamily( queueFamily ), m_timeline( initTimelineSemaphore( device ) )
+{
+	setFramesInFlight( framesInFlight );
+}
+
+FrameScheduler::~FrameScheduler(){
+	try{
+		waitIdle();
+
+		// nothing else will be submitted, so all of them are safe now
+		while( !m_deletions.empty() ){
+			const auto deleter = std::move( m_deletions.front().second );
+			m_deletions.pop_front();
+			deleter();
+		}
+	}
+	catch( ... ){
+		logger << "WARNING: Failed to wait for frames to finish while destroying the frame scheduler" << std::endl;
+	}
+
+	for( const auto& frame : m_frames ) killCommandPool( m_device, frame.commandPool ); // frees the command buffer too
+	killSemaphore( m_device, m_timeline );
+}
+
+void FrameScheduler::setFramesInFlight( uint32_t framesInFlight ){
+	framesInFlight = clampFramesInFlight( framesInFlight );
+	if( framesInFlight == m_frames.size() ) return;
+
+	waitIdle();
+
+	while( m_frames.size() > framesInFlight ){
+		killCommandPool( m_device, m_frames.back().commandPool );
+		m_frames.pop_back();
+	}
+	while( m_frames.size() < framesInFlight ) m_frames.push_back(  initFrameContext( m_device, m_queueFamily )  );
+}
+
+FrameContext& FrameScheduler::beginFrame(){
+	m_frameIndex = static_cast<uint32_t>( m_submittedValue % m_frames.size() );
+	FrameContext& frame = m_frames[m_frameIndex];
+
+	wait( frame.timelineValue );
+	collectGarbage();
+
+	{VkResult errorCode = vkResetCommandPool( m_device, frame.commandPool, 0 ); RESULT_HANDLER( errorCode, "vkResetCommandPool" );}
+	beginCommandBuffer( frame.commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT );
+
+	return frame;
+}
+
+void FrameScheduler::waitForTimeline( const VkSemaphore timelineSemaphore, const uint64_t value, const VkPipelineStageFlags stage ){
+	m_waitSs.resize( m_timelineWaitCount );
+	m_waitValues.resize( m_timelineWaitCount );
+	m_waitStages.resize( m_timelineWaitCount );
+
+	m_waitSs.push_back( timelineSemaphore );
+	m_waitValues.push_back( value );
+	m_waitStages.push_back( stage );
+	++m_timelineWaitCount;
+}
+
+uint64_t FrameScheduler::submitFrame( const VkQueue queue, const VkSemaphore waitS, const VkPipelineStageFlags waitStage, const VkSemaphore signalS ){
+	FrameContext& frame = m_frames[m_frameIndex];
+	endCommandBuffer( frame.commandBuffer );
+
+	// a previous submitFrame that threw may have left its binary semaphore behind
+	m_waitSs.resize( m_timelineWaitCount );
+	m_waitValues.resize( m_timelineWaitCount );
+	m_waitStages.resize( m_timelineWaitCount );
+	if( waitS ){
+		m_waitSs.push_back( waitS );
+		m_waitValues.push_back( 0 );
+		m_waitStages.push_back( waitStage );
+	}
+
+	const uint64_t value = m_submittedValue + 1;
+	const VkSemaphore signalSs[] = { m_timeline, signalS };
+	const uint64_t signalValues[] = { value, 0 }; // binary semaphores ignore theirs
+	const uint32_t signalCount = signalS ? 2 : 1;
+
+	const VkTimelineSemaphoreSubmitInfoKHR timelineInfo{
+		VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+		nullptr, // pNext
+		static_cast<uint32_t>( m_waitValues.size() ), m_waitValues.data(), // wait values
+		signalCount, signalValues // signal values
+	};
+
+	const VkSubmitInfo submit{
+		VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		&timelineInfo, // pNext
+		static_cast<uint32_t>( m_waitSs.size() ), m_waitSs.data(), // wait semaphores
+		m_waitStages.data(), // pipeline stages to wait for semaphore
+		1, &frame.commandBuffer,
+		signalCount, signalSs // signal semaphores
+	};
+
+	{VkResult errorCode = vkQueueSubmit( queue, 1 /*submit count*/, &submit, VK_NULL_HANDLE ); RESULT_HANDLER( errorCode, "vkQueueSubmit" );}
+
+	frame.timelineValue = m_submittedValue = value;
+
+	m_waitSs.clear();
+	m_waitValues.clear();
+	m_waitStages.clear();
+	m_timelineWaitCount = 0;
+
+	return value;
+}
+
+uint64_t FrameScheduler::getCompletedValue(){
+	m_completedValue = getSemaphoreCounterValue( m_device, m_timeline );
+	return m_completedValue;
+}
+
+bool FrameScheduler::isComplete( const uint64_t value ){
+	if( value <= m_completedValue ) return true;
+	if( value > m_submittedValue ) return false; // nothing is going to signal it yet
+
+	return value <= getCompletedValue();
+}
+
+void FrameScheduler::wait( const uint64_t value ){
+	if( value <= m_completedValue ) return;
+	if( value > m_submittedValue ) throw "Waiting for a frame that was not submitted yet!";
+
+	waitSemaphore( m_device, m_timeline, value );
+	m_completedValue = value;
+}
+
+void FrameScheduler::deferDeletion( std::function<void()> deleter ){
+	m_deletions.emplace_back( m_submittedValue + 1, std::move( deleter ) );
+}
+
+void FrameScheduler::collectGarbage(){
+	while(  !m_deletions.empty() && isComplete( m_deletions.front().first )  ){
+		const auto deleter = std::move( m_deletions.front().second );
+		m_deletions.pop_front();
+		deleter();
+	}
+}
@@ -0,0 +1,82 @@
+// Paces frames in flight on one timeline semaphore (VK_KHR_timeline_semaphore), and defers deletion of resources until
+// the GPU is done with them
+
+#ifndef COMMON_FRAME_SCHEDULER_H
+#define COMMON_FRAME_SCHEDULER_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "FrameContext.h"
+#include "VulkanConfig.h"
+
+
+// Frame N signals value N on the timeline semaphore, so "has frame N finished" is a comparison against one counter
+// that is queried at most once per beginFrame -- no fence per frame to wait on, reset, or recreate.
+// Not thread-safe; all calls come from the thread that submits the frames.
+class FrameScheduler{
+public:
+	FrameScheduler( VkDevice device, uint32_t queueFamily, uint32_t framesInFlight = VulkanConfig::framesInFlight ); // clamped like below
+	~FrameScheduler(); // waits for all submitted frames, then runs all pending deletions
+	FrameScheduler( const FrameScheduler& ) = delete;
+	FrameScheduler& operator=( const FrameScheduler& ) = delete;
+
+	uint32_t getFramesInFlight() const{ return static_cast<uint32_t>( m_frames.size() ); }
+	// waits for the GPU to finish all submitted frames first, so do not call it every frame; not between beginFrame and submitFrame
+	void setFramesInFlight( uint32_t framesInFlight ); // clamped to [1, VulkanConfig::maxFramesInFlight]
+
+	VkSemaphore getTimelineSemaphore() const{ return m_timeline; }
+
+	// Waits for the frame submitted getFramesInFlight() frames ago, runs the deletions that became safe, and recycles its pool.
+	// Returns the frame with its command buffer in recording state. A frame begun but not submitted is simply begun again.
+	FrameContext& beginFrame();
+	uint32_t getFrameIndex() const{ return m_frameIndex; } // slot of the current frame in [0, getFramesInFlight())
+
+	// the next submitFrame waits on the GPU until timelineSemaphore reaches value, e.g. UploadManager's ticket
+	void waitForTimeline( VkSemaphore timelineSemaphore, uint64_t value, VkPipelineStageFlags stage );
+
+	// ends the command buffer of the current frame and submits it; binary semaphores are optional (VK_NULL_HANDLE)
+	// returns the value the frame signals
+	uint64_t submitFrame(
+		VkQueue queue,
+		VkSemaphore waitS = VK_NULL_HANDLE,
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		VkSemaphore signalS = VK_NULL_HANDLE
+	);
+
+	uint64_t getSubmittedValue() const{ return m_submittedValue; } // also the number of frames submitted so far
+	uint64_t getCompletedValue(); // queries the semaphore
+	bool isComplete( uint64_t value ); // queries the semaphore only if the last known value does not answer it
+	void wait( uint64_t value );
+	void waitIdle(){ wait( m_submittedValue ); }
+
+	// deleter runs once the GPU is done with everything submitted so far and with the frame being recorded
+	void deferDeletion( std::function<void()> deleter );
+	void collectGarbage(); // runs the deleters that became safe; beginFrame calls it
+	size_t getPendingDeletionCount() const{ return m_deletions.size(); }
+
+private:
+	VkDevice m_device;
+	uint32_t m_queueFamily;
+	VkSemaphore m_timeline;
+	std::vector<FrameContext> m_frames;
+	uint32_t m_frameIndex = 0;
+
+	uint64_t m_submittedValue = 0;
+	uint64_t m_completedValue = 0; // last value read from the semaphore
+
+	std::deque< std::pair<uint64_t, std::function<void()>> > m_deletions; // ordered by the value they wait for
+
+	// waits of the next submission; the timeline first, then the binary semaphore of submitFrame
+	std::vector<VkSemaphore> m_waitSs;
+	std::vector<uint64_t> m_waitValues; // ignored for binary semaphores
+	std::vector<VkPipelineStageFlags> m_waitStages;
+	size_t m_timelineWaitCount = 0;
+};
+
+#endif //COMMON_FRAME_SCHEDULER_H
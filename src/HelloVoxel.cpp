@@ -10,15 +10,12 @@
 // Includes
 //////////////////////////////////////////////////////////////////////////////////
 
-#include <algorithm>
-#include <cassert>
-#include <cmath>
+#include <chrono>
 #include <cstdlib>
-#include <cstring>
 #include <exception>
 #include <fstream>
 #include <functional>
-#include <iterator>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -29,6 +26,8 @@
 #include <vulkan/vulkan.h> // also assume core+WSI commands are loaded
 static_assert( VK_HEADER_VERSION >= REQUIRED_HEADER_VERSION, "Update your SDK! This app is written against Vulkan header version " STRINGIZE(REQUIRED_HEADER_VERSION) "." );
 
+#include "AppOptions.h"
+#include "Benchmarks.h"
 #include "EnumerateScheme.h"
 #include "ErrorHandling.h"
 #include "ExtensionLoader.h"
@@ -37,6 +36,8 @@ static_assert( VK_HEADER_VERSION >= REQUIRED_HEADER_VERSION, "Update your SDK! T
 
 #include "VulkanConfig.h"
 #include "VulkanImpl.h"
+#include "FrameScheduler.h"
+#include "SwapchainManager.h"
 #include <VulkanValidation.h>
 
 
@@ -49,15 +50,14 @@ using std::vector;
 // main()!
 //////////////////////////////////////////////////////////////////////////////////
 
-int helloTriangle() try{
+int helloTriangle( const AppOptions& options = AppOptions() ) try{
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	const auto startupTime = steady_clock::now();
 	const uint32_t vertexBufferBinding = 0;
 
-	const float triangleSize = 1.6f;
-	const vector<Vertex2D_ColorF_pack> triangle = {
-		{ /*rb*/ { { 0.5f * triangleSize,  sqrtf( 3.0f ) * 0.25f * triangleSize} }, /*R*/{ {1.0f, 0.0f, 0.0f} }  },
-		{ /* t*/ { {                0.0f, -sqrtf( 3.0f ) * 0.25f * triangleSize} }, /*G*/{ {0.0f, 1.0f, 0.0f} }  },
-		{ /*lb*/ { {-0.5f * triangleSize,  sqrtf( 3.0f ) * 0.25f * triangleSize} }, /*B*/{ {0.0f, 0.0f, 1.0f} }  }
-	};
+	const vector<Vertex2D_ColorF_pack> triangle = makeTriangle();
 
   VulkanManager manager;
   const VkInstance instance = manager.getVkInstance();
@@ -72,21 +72,29 @@ int helloTriangle() try{
 
 	uint32_t graphicsQueueFamily, presentQueueFamily;
 	std::tie( graphicsQueueFamily, presentQueueFamily ) = getQueueFamilies( physicalDevice, surface );
+	const uint32_t transferQueueFamily = getTransferQueueFamily( physicalDevice, graphicsQueueFamily );
 
 	const VkPhysicalDeviceFeatures features = {}; // don't need any special feature for this demo
 #ifdef __APPLE__ //
-	const vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, "VK_KHR_portability_subset" };
+	vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME, "VK_KHR_portability_subset" };
 #else
-	const vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+	vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME };
 #endif
+	// optional; lets the memory allocator give resources their own allocation when the driver prefers it
+	enableOptionalDeviceExtensions( physicalDevice, manager.getRequestedLayers(), {VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME, VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME}, deviceExtensions );
 
-	const VkDevice device = initDevice( physicalDevice, features, graphicsQueueFamily, presentQueueFamily, manager.getRequestedLayers(), deviceExtensions );
+	const VkDevice device = initDevice( physicalDevice, features, graphicsQueueFamily, presentQueueFamily, transferQueueFamily, manager.getRequestedLayers(), deviceExtensions );
 	const VkQueue graphicsQueue = getQueue( device, graphicsQueueFamily, 0 );
 	const VkQueue presentQueue = getQueue( device, presentQueueFamily, 0 );
+	const VkQueue transferQueue = getQueue( device, transferQueueFamily, 0 ); // same as graphicsQueue if there is no separate transfer family
 
 
 	VkSurfaceFormatKHR surfaceFormat = getSurfaceFormat( physicalDevice, surface );
-	VkRenderPass renderPass = initRenderPass( device, surfaceFormat );
+	const VkFormat depthFormat = getDepthFormat( physicalDevice );
+	VkRenderPass renderPass = initRenderPass( device, surfaceFormat, depthFormat );
+
+	std::unique_ptr<PipelineCache> pipelineCache( new PipelineCache( device, physicalDeviceProperties, getPipelineCachePath( options ) ) );
+	bool firstFrame = true;
 
 	vector<uint32_t> vertexShaderBinary = {
 #include "shaders/hello_triangle.vert.spv.inl"
@@ -98,184 +106,91 @@ int helloTriangle() try{
 	VkShaderModule fragmentShader = initShaderModule( device, fragmentShaderBinary );
 	VkPipelineLayout pipelineLayout = initPipelineLayout( device );
 
-	VkBuffer vertexBuffer = initBuffer( device, sizeof( decltype( triangle )::value_type ) * triangle.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT );
-	const std::vector<VkMemoryPropertyFlags> memoryTypePriority{
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, // preferably wanna device-side memory that can be updated from host without hassle
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT // guaranteed to allways be supported
-	};
-	VkDeviceMemory vertexBufferMemory = initMemory<ResourceType::Buffer>(
+	// does not depend on the swapchain size, so it lives until exit -- only the render pass (surface format) must stay compatible
+	const auto pipelineStart = steady_clock::now();
+	VkPipeline pipeline = initPipeline(
+		device,
+		pipelineCache->get(),
+		physicalDeviceProperties.limits,
+		pipelineLayout,
+		renderPass,
+		vertexShader,
+		fragmentShader,
+		vertexBufferBinding
+	);
+	logger << "INFO: Pipeline created in " << duration<double, std::milli>( steady_clock::now() - pipelineStart ).count() << " ms ("
+	       << (pipelineCache->isWarm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
+
+	std::unique_ptr<UploadManager> uploader( new UploadManager( device, physicalDeviceMemoryProperties, transferQueueFamily, transferQueue, graphicsQueueFamily ) );
+
+	VkBuffer vertexBuffer = initBuffer( device, sizeof( decltype( triangle )::value_type ) * triangle.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, uploader->getQueueFamilies() );
+	MemoryAllocation vertexBufferMemory = initMemory<ResourceType::Buffer>(
 		device,
 		physicalDeviceMemoryProperties,
 		vertexBuffer,
-		memoryTypePriority
+		{VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT}
 	);
-	setVertexData( device, vertexBufferMemory, triangle ); // Writes throug memory map. Synchronization is implicit for any subsequent vkQueueSubmit batches.
 
-	VkCommandPool commandPool = initCommandPool( device, graphicsQueueFamily );
+	// paces the CPU against the GPU; frame N signals N on the scheduler's timeline semaphore
+	std::unique_ptr<FrameScheduler> scheduler(  new FrameScheduler( device, graphicsQueueFamily, options.framesInFlight ? options.framesInFlight : VulkanConfig::framesInFlight )  );
+
+	// the first frame waits for the upload on the GPU, so startup does not block on it
+	scheduler->waitForTimeline(  uploader->getTimelineSemaphore(), setVertexData( *uploader, vertexBuffer, triangle ), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT  );
 
 	// might need synchronization if init is more advanced than this
 	//VkResult errorCode = vkDeviceWaitIdle( device ); RESULT_HANDLER( errorCode, "vkDeviceWaitIdle" );
 
 
-	// place-holder swapchain dependent objects
-	VkSwapchainKHR swapchain = VK_NULL_HANDLE; // has to be NULL -- signifies that there's no swapchain
-	vector<VkImageView> swapchainImageViews;
-	vector<VkFramebuffer> framebuffers;
-
-	VkPipeline pipeline = VK_NULL_HANDLE; // has to be NULL for the case the app ends before even first swapchain
-	vector<VkCommandBuffer> commandBuffers;
-
-	vector<VkSemaphore> imageReadySs;
-	vector<VkSemaphore> renderDoneSs;
-
-	// workaround for validation layer "memory leak" + might also help the driver to cleanup old resources
-	// this should not be needed for a real-word app, because they are likely to use fences naturaly (e.g. responding to user input )
-	// read https://github.com/KhronosGroup/Vulkan-LoaderAndValidationLayers/issues/1628
-	const uint32_t maxInflightSubmissions = 2; // more than 2 probably does not make much sense
-	uint32_t submissionNr = 0; // index of the current submission modulo maxInflightSubmission
-	vector<VkFence> submissionFences;
+	// created by the first prepareFrame, and recreated only there
+	std::unique_ptr<SwapchainManager> swapchain(  new SwapchainManager( physicalDevice, device, surface, window, surfaceFormat, renderPass, depthFormat, graphicsQueueFamily, presentQueueFamily, *scheduler )  );
 
+	// one per frame slot; an acquire either signals it and the frame's submission waits on it, or (out of date) leaves it alone,
+	// so unlike the swapchain it never has to be replaced
+	vector<VkSemaphore> imageReadySs = initSemaphores( device, scheduler->getFramesInFlight() );
 
-	const std::function<bool(void)> recreateSwapchain = [&](){
-		// swapchain recreation -- will be done before the first frame too;
-		TODO( "This may be triggered from many sources (e.g. WM_SIZE event, and VK_ERROR_OUT_OF_DATE_KHR too). Should prevent duplicate swapchain recreation." )
-
-		const VkSwapchainKHR oldSwapchain = swapchain;
-		swapchain = VK_NULL_HANDLE;
-
-		VkSurfaceCapabilitiesKHR capabilities = getSurfaceCapabilities( physicalDevice, surface );
-
-		if( capabilities.currentExtent.width == UINT32_MAX && capabilities.currentExtent.height == UINT32_MAX ){
-			capabilities.currentExtent.width = getWindowWidth( window );
-			capabilities.currentExtent.height = getWindowHeight( window );
-		}
-		VkExtent2D surfaceSize = { capabilities.currentExtent.width, capabilities.currentExtent.height };
-
-		const bool swapchainCreatable = {
-			   surfaceSize.width >= capabilities.minImageExtent.width
-			&& surfaceSize.width <= capabilities.maxImageExtent.width
-			&& surfaceSize.width > 0
-			&& surfaceSize.height >= capabilities.minImageExtent.height
-			&& surfaceSize.height <= capabilities.maxImageExtent.height
-			&& surfaceSize.height > 0
-		};
-
-
-		// cleanup old
-		vector<VkSemaphore> oldImageReadySs = imageReadySs; imageReadySs.clear();
-		if( oldSwapchain ){
-			{VkResult errorCode = vkDeviceWaitIdle( device ); RESULT_HANDLER( errorCode, "vkDeviceWaitIdle" );}
-
-			// fences might be in unsignaled state, so kill them too to get fresh signaled
-			killFences( device, submissionFences );
-
-			// semaphores might be in signaled state, so kill them too to get fresh unsignaled
-			killSemaphores( device, renderDoneSs );
-			// kill imageReadySs later when oldSwapchain is destroyed
-
-			// only reset + later reuse already allocated and create new only if needed
-			{VkResult errorCode = vkResetCommandPool( device, commandPool, 0 ); RESULT_HANDLER( errorCode, "vkResetCommandPool" );}
-
-			killPipeline( device, pipeline );
-			killFramebuffers( device, framebuffers );
-			killSwapchainImageViews( device, swapchainImageViews );
-
-			// kill oldSwapchain later, after it is potentially used by vkCreateSwapchainKHR
-		}
-
-		// creating new
-		if( swapchainCreatable ){
-			// reuses & destroys the oldSwapchain
-			swapchain = initSwapchain( physicalDevice, device, surface, surfaceFormat, capabilities, graphicsQueueFamily, presentQueueFamily, oldSwapchain );
-
-			vector<VkImage> swapchainImages = enumerate<VkImage>( device, swapchain );
-			swapchainImageViews = initSwapchainImageViews( device, swapchainImages, surfaceFormat.format );
-			framebuffers = initFramebuffers( device, renderPass, swapchainImageViews, surfaceSize.width, surfaceSize.height );
-
-			pipeline = initPipeline(
-				device,
-				physicalDeviceProperties.limits,
-				pipelineLayout,
-				renderPass,
-				vertexShader,
-				fragmentShader,
-				vertexBufferBinding,
-				surfaceSize.width, surfaceSize.height
-			);
-
-			acquireCommandBuffers(  device, commandPool, static_cast<uint32_t>( swapchainImages.size() ), commandBuffers  );
-			for( size_t i = 0; i < swapchainImages.size(); ++i ){
-				beginCommandBuffer( commandBuffers[i] );
-					recordBeginRenderPass( commandBuffers[i], renderPass, framebuffers[i], VulkanConfig::clearColor, surfaceSize.width, surfaceSize.height );
-
-					recordBindPipeline( commandBuffers[i], pipeline );
-					recordBindVertexBuffer( commandBuffers[i], vertexBufferBinding, vertexBuffer );
-
-					recordDraw(  commandBuffers[i], static_cast<uint32_t>( triangle.size() )  );
-
-					recordEndRenderPass( commandBuffers[i] );
-				endCommandBuffer( commandBuffers[i] );
-			}
-
-			imageReadySs = initSemaphores( device, maxInflightSubmissions );
-			// per https://github.com/KhronosGroup/Vulkan-Docs/issues/1150 need upto swapchain-image count
-			renderDoneSs = initSemaphores( device, swapchainImages.size());
-
-			submissionFences = initFences( device, maxInflightSubmissions, VK_FENCE_CREATE_SIGNALED_BIT ); // signaled fence means previous execution finished, so we start rendering presignaled
-			submissionNr = 0;
-		}
-
-		if( oldSwapchain ){
-			killSwapchain( device, oldSwapchain );
-
-			// per current spec, we can't really be sure these are not used :/ at least kill them after the swapchain
-			// https://github.com/KhronosGroup/Vulkan-Docs/issues/152
-			killSemaphores( device, oldImageReadySs );
-		}
-
-		return swapchain != VK_NULL_HANDLE;
-	};
+	vector<DrawCommand> drawList; // rebuilt every frame
 
 
 	// Finally, rendering! Yay!
+	// Swapchain changes come back as status, not exceptions, and a frame that cannot be presented is dropped, not retried
+	// in a recursion -- the message loop paints again right away anyway.
 	const std::function<void(void)> render = [&](){
-		assert( swapchain ); // should be always true; should have yielded CPU if false
-
-		// vkAcquireNextImageKHR produces unsafe semaphore that needs extra cleanup. Track that with this variable.
-		bool unsafeSemaphore = false;
-
-		try{
-			// remove oldest frame from being in flight before starting new one
-			// refer to doc/, which talks about the cycle of how the synch primitives are (re)used here
-			{VkResult errorCode = vkWaitForFences( device, 1, &submissionFences[submissionNr], VK_TRUE, UINT64_MAX ); RESULT_HANDLER( errorCode, "vkWaitForFences" );}
-			{VkResult errorCode = vkResetFences( device, 1, &submissionFences[submissionNr] ); RESULT_HANDLER( errorCode, "vkResetFences" );}
-
-			unsafeSemaphore = true;
-			uint32_t nextSwapchainImageIndex = getNextImageIndex( device, swapchain, imageReadySs[submissionNr] );
-			unsafeSemaphore = false;
-
-			submitToQueue( graphicsQueue, commandBuffers[nextSwapchainImageIndex], imageReadySs[submissionNr], renderDoneSs[nextSwapchainImageIndex], submissionFences[submissionNr] );
-			present( presentQueue, swapchain, nextSwapchainImageIndex, renderDoneSs[nextSwapchainImageIndex] );
-
-			submissionNr = (submissionNr + 1) % maxInflightSubmissions;
-		}
-		catch( VulkanResultException ex ){
-			if( ex.result == VK_SUBOPTIMAL_KHR || ex.result == VK_ERROR_OUT_OF_DATE_KHR ){
-				if( unsafeSemaphore && ex.result == VK_SUBOPTIMAL_KHR ){
-					cleanupUnsafeSemaphore( graphicsQueue, imageReadySs[submissionNr] );
-					// no way to sanitize vkQueuePresentKHR semaphores, really
-				}
-				recreateSwapchain();
-
-				// we need to start over...
-				render();
-			}
-			else throw;
+		// the one point per frame where the swapchain may get recreated -- however many size events or bad statuses came since
+		if( !swapchain->prepareFrame() ) return; // e.g. minimized; the size event brings the swapchain back
+
+		// remove oldest frame from being in flight before starting new one
+		// refer to doc/, which talks about the cycle of how the synch primitives are (re)used here
+		const VkCommandBuffer commandBuffer = scheduler->beginFrame().commandBuffer;
+		const uint32_t frameIndex = scheduler->getFrameIndex();
+
+		uint32_t nextSwapchainImageIndex;
+		const SwapchainStatus acquired = swapchain->acquire( imageReadySs[frameIndex], nextSwapchainImageIndex );
+		if( acquired == SwapchainStatus::outOfDate ) return; // the begun frame is simply begun again by the next render
+		// a suboptimal image is still acquired (its semaphore will be signaled), so it is rendered and presented as usual
+
+		// the scene may change any frame, so it is recorded anew every time
+		drawList.clear();
+		drawList.push_back(  {pipeline, vertexBuffer, 0 /*offset*/, static_cast<uint32_t>( triangle.size() )}  );
+
+		const VkExtent2D extent = swapchain->getExtent();
+		recordBeginRenderPass( commandBuffer, renderPass, swapchain->getFramebuffer( nextSwapchainImageIndex ), VulkanConfig::clearColor, extent.width, extent.height );
+			recordSetViewport( commandBuffer, extent.width, extent.height );
+			recordDrawList( commandBuffer, vertexBufferBinding, drawList );
+		recordEndRenderPass( commandBuffer );
+
+		scheduler->submitFrame( graphicsQueue, imageReadySs[frameIndex], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, swapchain->getRenderDoneSemaphore( nextSwapchainImageIndex ) );
+		swapchain->present( presentQueue, nextSwapchainImageIndex );
+
+		if( firstFrame ){
+			logger << "INFO: First frame presented " << duration<double, std::milli>( steady_clock::now() - startupTime ).count() << " ms after startup ("
+			       << (pipelineCache->isWarm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
+			firstFrame = false;
 		}
+		pipelineCache->saveIfDue();
 	};
 
 
-	setSizeEventHandler( recreateSwapchain );
+	setSizeEventHandler(  [&]{ return swapchain->onResize(); }  );
 	setPaintEventHandler( render );
 
 
@@ -284,19 +199,21 @@ int helloTriangle() try{
 	int exitStatus = messageLoop( window );
 
 
+	logMemoryStatistics( device );
+
 	// proper Vulkan cleanup
 	VkResult errorCode = vkDeviceWaitIdle( device ); RESULT_HANDLER( errorCode, "vkDeviceWaitIdle" );
 
+	logger << "INFO: Swapchain created " << swapchain->getRecreationCount() << " times" << std::endl;
+	swapchain.reset();
+	scheduler.reset(); // runs the pending deletions, including retired swapchains
+	uploader.reset();
+	pipelineCache.reset(); // saves it
+
   cleanupVulkan(device,
       instance,
-      renderDoneSs,
       pipeline,
-      framebuffers,
-      swapchainImageViews,
-      swapchain,
       imageReadySs,
-      submissionFences,
-      commandPool,
       vertexBufferMemory,
       vertexBuffer,
       pipelineLayout,
@@ -313,27 +230,8 @@ int helloTriangle() try{
 
 	return exitStatus;
 }
-catch( VulkanResultException vkE ){
-	logger << "ERROR: Terminated due to an uncaught VkResult exception: "
-	       << vkE.file << ":" << vkE.line << ":" << vkE.func << "() " << vkE.source << "() returned " << to_string( vkE.result )
-	       << std::endl;
-	return EXIT_FAILURE;
-}
-catch( const char* e ){
-	logger << "ERROR: Terminated due to an uncaught exception: " << e << std::endl;
-	return EXIT_FAILURE;
-}
-catch( string e ){
-	logger << "ERROR: Terminated due to an uncaught exception: " << e << std::endl;
-	return EXIT_FAILURE;
-}
-catch( std::exception e ){
-	logger << "ERROR: Terminated due to an uncaught exception: " << e.what() << std::endl;
-	return EXIT_FAILURE;
-}
 catch( ... ){
-	logger << "ERROR: Terminated due to an unrecognized uncaught exception." << std::endl;
-	return EXIT_FAILURE;
+	return exitOnUncaughtException();
 }
 
 
@@ -342,7 +240,27 @@ int WINAPI WinMain( HINSTANCE, HINSTANCE, LPSTR, int ){
 	return helloTriangle();
 }
 #else
-int main(){
-	return helloTriangle();
+int main( int argc, char* argv[] ){
+	const AppOptions options = parseAppOptions( argc, argv );
+	if( options.help ){
+		printAppUsage( argv[0] );
+		return EXIT_SUCCESS;
+	}
+
+	if( options.offscreen ) return offscreenBenchmark( options );
+	if( options.recordBenchmark ) return recordingBenchmark( options );
+	if( options.meshBenchmark ) return meshingBenchmark( options );
+	if( options.genBenchmark ) return generationBenchmark( options );
+	if( options.streamBenchmark ) return streamingBenchmark( options );
+	if( options.storageBenchmark ) return storageBenchmark( options );
+	if( options.cullBenchmark ) return cullingBenchmark( options );
+	if( options.indirectBenchmark ) return indirectBenchmark( options );
+	if( options.occlusionBenchmark ) return occlusionBenchmark( options );
+
+#ifdef USE_PLATFORM_NONE
+	if( options.frameCount ) setHeadlessFrameCount( options.frameCount );
+#endif
+
+	return helloTriangle( options );
 }
 #endif
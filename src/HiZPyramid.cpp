@@ -0,0 +1,105 @@
+// Hierarchical-Z pyramid: a mip chain of the farthest depth under each texel, reduced from a depth buffer by compute passes
+#include "VulkanEnvironment.h"
+
+#include "HiZPyramid.h"
+
+#include <fstream> // VulkanImpl.h relies on the includer for these
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "ErrorHandling.h"
+#include "VulkanImpl.h"
+
+// Implementation
+//////////////////////////////////
+
+HiZPyramid::HiZPyramid(
+	const VkDevice device,
+	const VkPhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties,
+	const VkPipelineCache pipelineCache,
+	const VkShaderModule reduceShader,
+	const VkImageView depthView,
+	const uint32_t width,
+	const uint32_t height
+)
+: m_device( device ), m_depthWidth( width ), m_depthHeight( height )
+{
+	if( width == 0 || height == 0 ) throw "A Hi-Z pyramid needs a depth buffer that is not empty!";
+
+	uint32_t levelWidth = (width + 1) / 2, levelHeight = (height + 1) / 2;
+	m_levels.push_back(  { VK_NULL_HANDLE, VK_NULL_HANDLE, levelWidth, levelHeight }  );
+	while( levelWidth > 1 || levelHeight > 1 ){
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+		m_levels.push_back(  { VK_NULL_HANDLE, VK_NULL_HANDLE, levelWidth, levelHeight }  );
+	}
+	const uint32_t levelCount = getLevelCount();
+
+	// R32_SFLOAT is one of the storage image formats every device supports
+	const VkFormat format = VK_FORMAT_R32_SFLOAT;
+	m_image = initImage( device, format, m_levels[0].width, m_levels[0].height, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, levelCount );
+	m_memory = initMemory<ResourceType::Image>( device, physicalDeviceMemoryProperties, m_image, {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT} );
+	m_view = initImageView( device, m_image, format );
+	m_sampler = initSampler( device );
+
+	m_descriptorSetLayout = initDescriptorSetLayout( device, {
+		{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+		{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+	} );
+	m_descriptorPool = initDescriptorPool( device, levelCount, {
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, levelCount },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levelCount }
+	} );
+	m_pipelineLayout = initPipelineLayout( device, m_descriptorSetLayout, 0 /*no push constants*/, 0 );
+	m_pipeline = initComputePipeline( device, pipelineCache, m_pipelineLayout, reduceShader );
+
+	const vector<VkDescriptorSet> descriptorSets = allocateDescriptorSets( device, m_descriptorPool, m_descriptorSetLayout, levelCount );
+	for( uint32_t i = 0; i < levelCount; ++i ){
+		Level& level = m_levels[i];
+		level.view = initImageView( device, m_image, format, VK_IMAGE_ASPECT_COLOR_BIT, i /*base mip level*/, 1 /*mip level count*/ );
+		level.descriptorSet = descriptorSets[i];
+
+		if( i == 0 ) writeImageDescriptor( device, level.descriptorSet, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_sampler, depthView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL );
+		else writeImageDescriptor( device, level.descriptorSet, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_sampler, m_levels[i - 1].view, VK_IMAGE_LAYOUT_GENERAL );
+		writeImageDescriptor( device, level.descriptorSet, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_NULL_HANDLE, level.view, VK_IMAGE_LAYOUT_GENERAL );
+	}
+}
+
+HiZPyramid::~HiZPyramid(){
+	for( const Level& level : m_levels ) killImageView( m_device, level.view );
+	killPipeline( m_device, m_pipeline );
+	killPipelineLayout( m_device, m_pipelineLayout );
+	killDescriptorPool( m_device, m_descriptorPool ); // frees the sets too
+	killDescriptorSetLayout( m_device, m_descriptorSetLayout );
+	killSampler( m_device, m_sampler );
+	killImageView( m_device, m_view );
+	killImage( m_device, m_image );
+	killMemory( m_device, m_memory );
+}
+
+void HiZPyramid::recordBuild( const VkCommandBuffer commandBuffer ){
+	// the frames before built and sampled the pyramid; that must be over before it is overwritten
+	recordImageBarrier(
+		commandBuffer, m_image, VK_IMAGE_ASPECT_COLOR_BIT,
+		m_built ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT
+	);
+	m_built = true;
+
+	recordBindPipeline( commandBuffer, m_pipeline );
+	for( const Level& level : m_levels ){
+		vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0 /*first set*/, 1, &level.descriptorSet, 0, nullptr /*dynamic offsets*/ );
+		vkCmdDispatch( commandBuffer, (level.width + workGroupSize - 1) / workGroupSize, (level.height + workGroupSize - 1) / workGroupSize, 1 );
+
+		// for the next level, and after the last one for the culling
+		recordImageBarrier(
+			commandBuffer, m_image, VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT
+		);
+	}
+}
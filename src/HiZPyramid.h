@@ -0,0 +1,72 @@
+// Hierarchical-Z pyramid: a mip chain of the farthest depth under each texel, reduced from a depth buffer by compute passes
+
+#ifndef COMMON_HIZ_PYRAMID_H
+#define COMMON_HIZ_PYRAMID_H
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "MemoryAllocator.h"
+
+
+// Level 0 halves the depth buffer (rounding up), every further level halves the one before, down to 1x1; texel (x, y) of
+// level k covers the depth pixels [x, x + 1) * 2^(k + 1) by [y, y + 1) * 2^(k + 1). Each texel keeps the farthest depth
+// under it: the minimum reduction, as the depth is reversed-Z. A box whose nearest depth is farther still than that, over
+// all texels its screen rectangle covers, is hidden -- the occlusion test of IndirectChunkRenderer::recordLateCull().
+// The reduction reads texels with texelFetch and clamps at the edge of odd-sized levels, so it needs no min/max sampler
+// (VK_EXT_sampler_filter_minmax) and every depth pixel lands in exactly one texel of each level.
+// The pyramid is one R32_SFLOAT image in VK_IMAGE_LAYOUT_GENERAL, shared by all frames in flight: a frame's build waits
+// on the compute shaders of the frames before it that sampled it.
+class HiZPyramid{
+public:
+	static constexpr uint32_t workGroupSize = 8; // local_size_x and local_size_y of hiz_reduce.comp
+
+	HiZPyramid(
+		VkDevice device,
+		const VkPhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties,
+		VkPipelineCache pipelineCache,
+		VkShaderModule reduceShader, // hiz_reduce.comp; may be killed once constructed
+		VkImageView depthView, // DepthBuffer::view of a sampled depth buffer (initDepthBuffer with sampled)
+		uint32_t width, uint32_t height // of the depth buffer; a resized one needs a new pyramid
+	);
+	~HiZPyramid(); // the GPU must be done with it
+	HiZPyramid( const HiZPyramid& ) = delete;
+	HiZPyramid& operator=( const HiZPyramid& ) = delete;
+
+	// Outside of a render pass, after one that left the depth in DEPTH_STENCIL_READ_ONLY_OPTIMAL and made it visible to
+	// compute shaders (initEarlyRenderPass): reduces it level by level, and makes the pyramid ready for compute shaders to sample.
+	void recordBuild( VkCommandBuffer commandBuffer );
+
+	// all levels, for texelFetch with getSampler(); in VK_IMAGE_LAYOUT_GENERAL
+	VkImageView getView() const{ return m_view; }
+	VkSampler getSampler() const{ return m_sampler; }
+	uint32_t getLevelCount() const{ return static_cast<uint32_t>( m_levels.size() ); }
+	uint32_t getDepthWidth() const{ return m_depthWidth; }
+	uint32_t getDepthHeight() const{ return m_depthHeight; }
+
+private:
+	struct Level{
+		VkImageView view; // this level only; written as storage image, read by the next level
+		VkDescriptorSet descriptorSet; // the level before (or the depth) as source, this one as destination
+		uint32_t width, height;
+	};
+
+	VkDevice m_device;
+	uint32_t m_depthWidth, m_depthHeight;
+	bool m_built = false; // the image is still in VK_IMAGE_LAYOUT_UNDEFINED until the first build
+
+	VkImage m_image;
+	MemoryAllocation m_memory;
+	VkImageView m_view;
+	VkSampler m_sampler;
+	std::vector<Level> m_levels;
+
+	VkDescriptorSetLayout m_descriptorSetLayout;
+	VkDescriptorPool m_descriptorPool;
+	VkPipelineLayout m_pipelineLayout;
+	VkPipeline m_pipeline;
+};
+
+#endif //COMMON_HIZ_PYRAMID_H
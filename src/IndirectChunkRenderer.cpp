@@ -0,0 +1,270 @@
+// GPU-driven chunk drawing: a compute pass culls the chunks and writes their indirect draws, one indirect call draws them
+#include "VulkanEnvironment.h"
+
+#include "IndirectChunkRenderer.h"
+
+#include <cstring>
+#include <fstream> // VulkanImpl.h relies on the includer for these
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "ErrorHandling.h"
+#include "ExtensionLoader.h"
+#include "HiZPyramid.h"
+#include "Vertex.h"
+#include "VulkanImpl.h"
+
+// Implementation
+//////////////////////////////////
+
+IndirectChunkRenderer::IndirectChunkRenderer(
+	const VkDevice device,
+	const VkPhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties,
+	const VkPhysicalDeviceLimits& limits,
+	const VkPhysicalDeviceFeatures& enabledFeatures,
+	const VkPipelineCache pipelineCache,
+	const VkRenderPass renderPass,
+	const uint32_t vertexBufferBinding,
+	const VkShaderModule cullShader,
+	const VkShaderModule vertexShader,
+	const VkShaderModule fragmentShader,
+	const uint32_t capacity,
+	const uint32_t framesInFlight,
+	const vector<uint32_t>& queueFamilies,
+	const VkShaderModule occlusionCullShader
+)
+: m_device( device ), m_capacity( capacity ), m_vertexBufferBinding( vertexBufferBinding )
+{
+	if( !enabledFeatures.multiDrawIndirect || !enabledFeatures.drawIndirectFirstInstance ){
+		throw "GPU-driven chunk drawing needs the multiDrawIndirect and drawIndirectFirstInstance features!";
+	}
+	if(  capacity == 0 || capacity > limits.maxDrawIndirectCount
+	  || (capacity + workGroupSize - 1) / workGroupSize > limits.maxComputeWorkGroupCount[0]
+	  || VkDeviceSize( capacity ) * sizeof( ChunkDrawData ) > limits.maxStorageBufferRange  ){
+		throw string( "The device cannot draw " ) + to_string( capacity ) + " chunks in one indirect call!";
+	}
+
+	if(  isDeviceExtensionEnabled( device, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME )  ){
+		const PFN_vkVoidFunction function = vkGetDeviceProcAddr( device, "vkCmdDrawIndexedIndirectCountKHR" );
+		if( !function ) throw "Failed to load vkCmdDrawIndexedIndirectCountKHR"; // check shouldn't be necessary (based on spec)
+		m_drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>( function );
+	}
+
+	// the chunks for both pipelines; the draws, their count, the visibility and the pyramid only for the culling;
+	// the frustum culling never reads the pyramid, so it may stay unwritten without occlusion culling
+	m_descriptorSetLayout = initDescriptorSetLayout( device, {
+		{ 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT, nullptr },
+		{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+		{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+		{ 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+		{ 4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+	} );
+	const uint32_t setCount = 2 * framesInFlight; // one per pass
+	m_descriptorPool = initDescriptorPool( device, setCount, {
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * setCount },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount }
+	} );
+
+	m_cullLayout = initPipelineLayout( device, m_descriptorSetLayout, VK_SHADER_STAGE_COMPUTE_BIT, sizeof( ChunkCullPushConstants ) );
+	m_cullPipeline = initComputePipeline( device, pipelineCache, m_cullLayout, cullShader );
+	m_drawLayout = initPipelineLayout( device, m_descriptorSetLayout, VK_SHADER_STAGE_VERTEX_BIT, sizeof( ChunkIndirectPushConstants ) );
+	m_drawPipeline = initPipeline( device, pipelineCache, limits, m_drawLayout, renderPass, vertexShader, fragmentShader, vertexBufferBinding, VertexFormat::Chunk );
+	if( occlusionCullShader ){
+		m_occlusionCullLayout = initPipelineLayout( device, m_descriptorSetLayout, VK_SHADER_STAGE_COMPUTE_BIT, sizeof( ChunkOcclusionCullPushConstants ) );
+		m_occlusionCullPipeline = initComputePipeline( device, pipelineCache, m_occlusionCullLayout, occlusionCullShader );
+	}
+
+	m_chunkBuffer = initBuffer( device, VkDeviceSize( capacity ) * sizeof( ChunkDrawData ), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, queueFamilies );
+	m_chunkMemory = initMemory<ResourceType::Buffer>( device, physicalDeviceMemoryProperties, m_chunkBuffer, {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT} );
+	m_visibility = initBuffer( device, VkDeviceSize( capacity ) * sizeof( uint32_t ), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT );
+	m_visibilityMemory = initMemory<ResourceType::Buffer>( device, physicalDeviceMemoryProperties, m_visibility, {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT} );
+
+	const vector<VkDescriptorSet> descriptorSets = allocateDescriptorSets( device, m_descriptorPool, m_descriptorSetLayout, setCount );
+	m_frames.resize( framesInFlight );
+	for( uint32_t i = 0; i < framesInFlight; ++i ){
+		Frame& frame = m_frames[i];
+		for( uint32_t p = 0; p < 2; ++p ){
+			Pass& pass = frame.passes[p];
+			pass.draws = initBuffer( device, VkDeviceSize( capacity ) * sizeof( VkDrawIndexedIndirectCommand ), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT );
+			pass.drawsMemory = initMemory<ResourceType::Buffer>( device, physicalDeviceMemoryProperties, pass.draws, {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT} );
+			pass.count = initBuffer(
+				device,
+				sizeof( uint32_t ),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+			);
+			pass.countMemory = initMemory<ResourceType::Buffer>( device, physicalDeviceMemoryProperties, pass.count, {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT} );
+			pass.descriptorSet = descriptorSets[i * 2 + p];
+
+			writeStorageBufferDescriptors(  device, pass.descriptorSet, { m_chunkBuffer, pass.draws, pass.count, m_visibility }  );
+		}
+		frame.pass = 0;
+		frame.chunkCount = 0;
+	}
+
+	m_readback = initBuffer( device, sizeof( uint32_t ) * 2 * framesInFlight, VK_BUFFER_USAGE_TRANSFER_DST_BIT );
+	m_readbackMemory = initMemory<ResourceType::Buffer>( device, physicalDeviceMemoryProperties, m_readback, {
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+	} );
+	uint32_t* const drawCounts = static_cast<uint32_t*>(  mapMemory( device, m_readbackMemory )  );
+	std::memset( drawCounts, 0, sizeof( uint32_t ) * 2 * framesInFlight );
+	m_drawCounts = drawCounts;
+}
+
+IndirectChunkRenderer::~IndirectChunkRenderer(){
+	killBuffer( m_device, m_readback );
+	killMemory( m_device, m_readbackMemory );
+	for( const Frame& frame : m_frames ){
+		for( const Pass& pass : frame.passes ){
+			killBuffer( m_device, pass.draws );
+			killMemory( m_device, pass.drawsMemory );
+			killBuffer( m_device, pass.count );
+			killMemory( m_device, pass.countMemory );
+		}
+	}
+	killBuffer( m_device, m_visibility );
+	killMemory( m_device, m_visibilityMemory );
+	killBuffer( m_device, m_chunkBuffer );
+	killMemory( m_device, m_chunkMemory );
+
+	if( m_occlusionCullPipeline ){
+		killPipeline( m_device, m_occlusionCullPipeline );
+		killPipelineLayout( m_device, m_occlusionCullLayout );
+	}
+	killPipeline( m_device, m_drawPipeline );
+	killPipelineLayout( m_device, m_drawLayout );
+	killPipeline( m_device, m_cullPipeline );
+	killPipelineLayout( m_device, m_cullLayout );
+	killDescriptorPool( m_device, m_descriptorPool ); // frees the sets too
+	killDescriptorSetLayout( m_device, m_descriptorSetLayout );
+}
+
+void IndirectChunkRenderer::recordDispatch(
+	const VkCommandBuffer commandBuffer,
+	const uint32_t frameIndex, const uint32_t pass, const uint32_t chunkCount,
+	const VkPipeline pipeline, const VkPipelineLayout pipelineLayout,
+	const void* const pushConstants, const uint32_t pushConstantsSize
+){
+	if( chunkCount > m_capacity ) throw "Culling more chunks than the IndirectChunkRenderer has room for!";
+
+	Frame& frame = m_frames[frameIndex];
+	const Pass& target = frame.passes[pass];
+	frame.pass = pass;
+	frame.chunkCount = chunkCount;
+
+	// the GPU finished the previous frame of this slot, so nothing reads the count or the draws anymore
+	vkCmdFillBuffer( commandBuffer, target.count, 0 /*offset*/, VK_WHOLE_SIZE, 0 /*value*/ );
+	recordBufferBarrier(
+		commandBuffer, target.count,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+	);
+
+	recordBindPipeline( commandBuffer, pipeline );
+	vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0 /*first set*/, 1, &target.descriptorSet, 0, nullptr /*dynamic offsets*/ );
+	vkCmdPushConstants( commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0 /*offset*/, pushConstantsSize, pushConstants );
+	if( chunkCount ) vkCmdDispatch( commandBuffer, (chunkCount + workGroupSize - 1) / workGroupSize, 1, 1 );
+
+	recordBufferBarrier(
+		commandBuffer, target.draws,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+	);
+	recordBufferBarrier(
+		commandBuffer, target.count,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT
+	);
+
+	const VkBufferCopy region{ 0 /*src offset*/, sizeof( uint32_t ) * (frameIndex * 2 + pass) /*dst offset*/, sizeof( uint32_t ) };
+	vkCmdCopyBuffer( commandBuffer, target.count, m_readback, 1, &region );
+	recordBufferBarrier(
+		commandBuffer, m_readback,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT
+	);
+}
+
+void IndirectChunkRenderer::recordCull( const VkCommandBuffer commandBuffer, const uint32_t frameIndex, const float planes[6][4], const uint32_t chunkCount ){
+	ChunkCullPushConstants pushConstants;
+	std::memcpy( pushConstants.planes, planes, sizeof( pushConstants.planes ) );
+	pushConstants.chunkCount = chunkCount;
+	pushConstants.compact = usesDrawIndirectCount() ? 1 : 0;
+	pushConstants.visibleOnly = 0;
+
+	recordDispatch( commandBuffer, frameIndex, 0 /*pass*/, chunkCount, m_cullPipeline, m_cullLayout, &pushConstants, sizeof( pushConstants ) );
+}
+
+void IndirectChunkRenderer::recordEarlyCull( const VkCommandBuffer commandBuffer, const uint32_t frameIndex, const float planes[6][4], const uint32_t chunkCount ){
+	if( !m_visibilityCleared ){
+		vkCmdFillBuffer( commandBuffer, m_visibility, 0 /*offset*/, VK_WHOLE_SIZE, 0 /*value*/ );
+		m_visibilityCleared = true;
+	}
+	// the late pass of the frame before (or the clear) wrote the visibility
+	recordBufferBarrier(
+		commandBuffer, m_visibility,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+	);
+
+	ChunkCullPushConstants pushConstants;
+	std::memcpy( pushConstants.planes, planes, sizeof( pushConstants.planes ) );
+	pushConstants.chunkCount = chunkCount;
+	pushConstants.compact = usesDrawIndirectCount() ? 1 : 0;
+	pushConstants.visibleOnly = 1;
+
+	recordDispatch( commandBuffer, frameIndex, 0 /*pass*/, chunkCount, m_cullPipeline, m_cullLayout, &pushConstants, sizeof( pushConstants ) );
+}
+
+void IndirectChunkRenderer::recordLateCull( const VkCommandBuffer commandBuffer, const uint32_t frameIndex, const float viewProjection[16], const uint32_t chunkCount ){
+	if( !m_occlusionCullPipeline ) throw "The IndirectChunkRenderer was made without the occlusion culling shader!";
+	if( !m_hiZPyramid ) throw "Occlusion culling needs a Hi-Z pyramid to test against!";
+
+	// the early pass wrote which chunks it drew
+	recordBufferBarrier(
+		commandBuffer, m_visibility,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+	);
+
+	ChunkOcclusionCullPushConstants pushConstants;
+	std::memcpy( pushConstants.viewProjection, viewProjection, sizeof( pushConstants.viewProjection ) );
+	pushConstants.depthSize[0] = static_cast<float>(  m_hiZPyramid->getDepthWidth()  );
+	pushConstants.depthSize[1] = static_cast<float>(  m_hiZPyramid->getDepthHeight()  );
+	pushConstants.chunkCount = chunkCount;
+	pushConstants.compact = usesDrawIndirectCount() ? 1 : 0;
+
+	recordDispatch( commandBuffer, frameIndex, 1 /*pass*/, chunkCount, m_occlusionCullPipeline, m_occlusionCullLayout, &pushConstants, sizeof( pushConstants ) );
+}
+
+void IndirectChunkRenderer::setHiZPyramid( const HiZPyramid& pyramid ){
+	m_hiZPyramid = &pyramid;
+	for( const Frame& frame : m_frames ){
+		writeImageDescriptor( m_device, frame.passes[1].descriptorSet, 4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, pyramid.getSampler(), pyramid.getView(), VK_IMAGE_LAYOUT_GENERAL );
+	}
+}
+
+void IndirectChunkRenderer::recordDraw( const VkCommandBuffer commandBuffer, const uint32_t frameIndex, const float viewProjection[16], const VkBuffer vertexBuffer, const VkBuffer indexBuffer ){
+	const Frame& frame = m_frames[frameIndex];
+	const Pass& pass = frame.passes[frame.pass];
+	if( frame.chunkCount == 0 ) return;
+
+	ChunkIndirectPushConstants pushConstants;
+	std::memcpy( pushConstants.viewProjection, viewProjection, sizeof( pushConstants.viewProjection ) );
+
+	recordBindPipeline( commandBuffer, m_drawPipeline );
+	vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_drawLayout, 0 /*first set*/, 1, &pass.descriptorSet, 0, nullptr /*dynamic offsets*/ );
+	recordPushConstants( commandBuffer, m_drawLayout, 0 /*offset*/, sizeof( pushConstants ), &pushConstants );
+	recordBindVertexBuffer( commandBuffer, m_vertexBufferBinding, vertexBuffer );
+	recordBindIndexBuffer( commandBuffer, indexBuffer );
+
+	const uint32_t stride = sizeof( VkDrawIndexedIndirectCommand );
+	if( m_drawIndexedIndirectCount ){
+		m_drawIndexedIndirectCount( commandBuffer, pass.draws, 0 /*offset*/, pass.count, 0 /*count offset*/, frame.chunkCount /*max draws*/, stride );
+	}
+	else{
+		vkCmdDrawIndexedIndirect( commandBuffer, pass.draws, 0 /*offset*/, frame.chunkCount, stride );
+	}
+}
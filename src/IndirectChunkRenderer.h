@@ -0,0 +1,174 @@
+// GPU-driven chunk drawing: a compute pass culls the chunks and writes their indirect draws, one indirect call draws them
+
+#ifndef COMMON_INDIRECT_CHUNK_RENDERER_H
+#define COMMON_INDIRECT_CHUNK_RENDERER_H
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "MemoryAllocator.h"
+
+class HiZPyramid;
+
+// One chunk of the chunk buffer, read by shaders/chunk_cull.comp and shaders/chunk_indirect.vert; std430 layout
+struct ChunkDrawData{
+	float boundsMin[4]; // xyz, world (voxel) units, e.g. of the mesh; w unused
+	float boundsMax[4];
+	float origin[4]; // xyz: position of the chunk's (0, 0, 0) corner; w unused
+	uint32_t firstIndex; // into the index buffer, e.g. 0 with makeQuadIndices()
+	int32_t vertexOffset; // first vertex of the chunk's mesh in the vertex buffer
+	uint32_t indexCount; // 0 = nothing to draw, e.g. a free slot
+	uint32_t padding;
+};
+static_assert( sizeof( ChunkDrawData ) == 64, "ChunkDrawData must match the std430 layout of the shaders" );
+
+// Compute stage push constants of shaders/chunk_cull.comp; std430 layout
+struct ChunkCullPushConstants{
+	float planes[6][4]; // e.g. from extractFrustumPlanes()
+	uint32_t chunkCount;
+	uint32_t compact; // 0: every chunk writes its own draw, culled ones with no instance
+	uint32_t visibleOnly; // 1: the early pass of the occlusion culling
+};
+static_assert( sizeof( ChunkCullPushConstants ) <= 128, "Vulkan only guarantees 128 bytes of push constants" );
+
+// Compute stage push constants of shaders/chunk_occlusion_cull.comp; std430 layout
+// (no room for the planes next to the matrix, so the shader takes them from its rows, like extractFrustumPlanes())
+struct ChunkOcclusionCullPushConstants{
+	float viewProjection[16]; // column-major, like GLSL
+	float depthSize[2]; // of the depth buffer of the HiZPyramid, in pixels
+	uint32_t chunkCount;
+	uint32_t compact;
+};
+static_assert( sizeof( ChunkOcclusionCullPushConstants ) <= 128, "Vulkan only guarantees 128 bytes of push constants" );
+
+// Vertex stage push constants of shaders/chunk_indirect.vert; std430 layout
+struct ChunkIndirectPushConstants{
+	float viewProjection[16]; // column-major, like GLSL
+};
+
+// The chunks live in one storage buffer of ChunkDrawData, filled by the app (e.g. through the UploadManager); their meshes
+// in one vertex buffer with a shared index buffer. Per frame, recordCull() dispatches chunk_cull.comp, which frustum
+// culls every chunk and appends a VkDrawIndexedIndirectCommand for each visible one, counting them on the GPU, and
+// recordDraw() draws the lot with a single vkCmdDrawIndexedIndirectCountKHR. The CPU does nothing per chunk.
+// Without VK_KHR_draw_indirect_count (Vulkan 1.0 has no draw count from a buffer) every chunk keeps its own draw, the
+// culled ones with no instance, and vkCmdDrawIndexedIndirect walks all of them; still one call, but the GPU front end
+// skips the empty draws one by one.
+// Needs the multiDrawIndirect and drawIndirectFirstInstance features: the instance index tells the vertex shader the chunk.
+// The draws and the count are per frame in flight, so a frame culls while the GPU may still draw the previous ones.
+//
+// Occlusion culling takes two phases per frame, so the chunks that come into view are drawn the frame they do:
+//   recordEarlyCull()  the chunks visible last frame that are in the frustum  -> early render pass (initEarlyRenderPass)
+//   HiZPyramid::recordBuild()  from the depth of those
+//   recordLateCull()  every chunk in the frustum against the pyramid; the visible ones are kept for the next frame, and
+//                     those the early pass did not draw are drawn now  -> late render pass (initLateRenderPass)
+// The chunks visible last frame are good occluders for this one, so the pyramid of their depth hides most of what they
+// hid before; testing against last frame's depth instead would need it reprojected, and would draw the chunks coming
+// into view a frame late. The visibility is one flag per chunk slot, shared by the frames in flight; it starts out with
+// nothing visible, so the first frame draws all of it in the late pass. Each pass has its own draws and count.
+class IndirectChunkRenderer{
+public:
+	static constexpr uint32_t workGroupSize = 64; // local_size_x of chunk_cull.comp
+
+	IndirectChunkRenderer(
+		VkDevice device,
+		const VkPhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties,
+		const VkPhysicalDeviceLimits& limits,
+		const VkPhysicalDeviceFeatures& enabledFeatures, // those the device was created with
+		VkPipelineCache pipelineCache,
+		VkRenderPass renderPass, // subpass 0, like initPipeline
+		uint32_t vertexBufferBinding,
+		VkShaderModule cullShader, // chunk_cull.comp; the modules may be killed once constructed
+		VkShaderModule vertexShader, // chunk_indirect.vert
+		VkShaderModule fragmentShader, // e.g. chunk.frag
+		uint32_t capacity, // chunks
+		uint32_t framesInFlight,
+		const std::vector<uint32_t>& queueFamilies, // sharing the chunk buffer, e.g. UploadManager::getQueueFamilies()
+		VkShaderModule occlusionCullShader = VK_NULL_HANDLE // chunk_occlusion_cull.comp; only for recordLateCull()
+	);
+	~IndirectChunkRenderer(); // the GPU must be done with it
+	IndirectChunkRenderer( const IndirectChunkRenderer& ) = delete;
+	IndirectChunkRenderer& operator=( const IndirectChunkRenderer& ) = delete;
+
+	uint32_t getCapacity() const{ return m_capacity; }
+	bool usesDrawIndirectCount() const{ return m_drawIndexedIndirectCount != nullptr; }
+
+	// ChunkDrawData[getCapacity()], DEVICE_LOCAL, TRANSFER_DST; written by the app, read by every frame
+	VkBuffer getChunkBuffer() const{ return m_chunkBuffer; }
+
+	// Outside of a render pass: clears the draw count of frameIndex, culls the first chunkCount chunks of the chunk buffer,
+	// and makes the draws ready for the indirect draw and the count for getDrawCount().
+	void recordCull( VkCommandBuffer commandBuffer, uint32_t frameIndex, const float planes[6][4], uint32_t chunkCount );
+
+	// The occlusion culling (needs occlusionCullShader and setHiZPyramid()); both outside of a render pass, like recordCull().
+	// The early pass is recordCull() of only the chunks visible last frame; the late one needs the pyramid built from the
+	// depth the early pass drew, and the viewProjection that was drawn with.
+	void recordEarlyCull( VkCommandBuffer commandBuffer, uint32_t frameIndex, const float planes[6][4], uint32_t chunkCount );
+	void recordLateCull( VkCommandBuffer commandBuffer, uint32_t frameIndex, const float viewProjection[16], uint32_t chunkCount );
+
+	// the pyramid recordLateCull() tests against, until set again; the GPU must be done with all frames, e.g. after a resize
+	void setHiZPyramid( const HiZPyramid& pyramid );
+
+	// Inside the render pass, with the viewport set: draws what the latest cull of frameIndex kept.
+	// indexBuffer holds 32-bit indices, like recordBindIndexBuffer.
+	void recordDraw( VkCommandBuffer commandBuffer, uint32_t frameIndex, const float viewProjection[16], VkBuffer vertexBuffer, VkBuffer indexBuffer );
+
+	// chunks the latest recordCull() or recordEarlyCull() of frameIndex kept, or with late its recordLateCull();
+	// valid once the GPU finished that frame
+	uint32_t getDrawCount( uint32_t frameIndex, bool late = false ) const{ return m_drawCounts[frameIndex * 2 + (late ? 1 : 0)]; }
+
+private:
+	struct Pass{
+		VkBuffer draws; // VkDrawIndexedIndirectCommand[capacity]
+		MemoryAllocation drawsMemory;
+		VkBuffer count; // uint32_t
+		MemoryAllocation countMemory;
+		VkDescriptorSet descriptorSet;
+	};
+
+	struct Frame{
+		Pass passes[2]; // [0] for recordCull() and recordEarlyCull(), [1] for recordLateCull()
+		uint32_t pass; // of the latest cull, which recordDraw() draws
+		uint32_t chunkCount; // of the latest cull
+	};
+
+	// clears the count of the pass, dispatches over chunkCount chunks, and makes the draws and the count ready
+	void recordDispatch(
+		VkCommandBuffer commandBuffer,
+		uint32_t frameIndex, uint32_t pass, uint32_t chunkCount,
+		VkPipeline pipeline, VkPipelineLayout pipelineLayout,
+		const void* pushConstants, uint32_t pushConstantsSize
+	);
+
+	VkDevice m_device;
+	uint32_t m_capacity;
+	uint32_t m_vertexBufferBinding;
+	PFN_vkCmdDrawIndexedIndirectCountKHR m_drawIndexedIndirectCount = nullptr; // VK_KHR_draw_indirect_count, if enabled
+
+	VkDescriptorSetLayout m_descriptorSetLayout;
+	VkDescriptorPool m_descriptorPool;
+	VkPipelineLayout m_cullLayout;
+	VkPipeline m_cullPipeline;
+	VkPipelineLayout m_drawLayout;
+	VkPipeline m_drawPipeline;
+	VkPipelineLayout m_occlusionCullLayout = VK_NULL_HANDLE;
+	VkPipeline m_occlusionCullPipeline = VK_NULL_HANDLE;
+	const HiZPyramid* m_hiZPyramid = nullptr;
+
+	VkBuffer m_chunkBuffer;
+	MemoryAllocation m_chunkMemory;
+	std::vector<Frame> m_frames;
+
+	// uint32_t per chunk slot: 1 if visible in the latest late pass, or drawn by the early pass since
+	VkBuffer m_visibility;
+	MemoryAllocation m_visibilityMemory;
+	bool m_visibilityCleared = false;
+
+	// the draw counts, copied back for the host; two uint32_t (early, late) per frame in flight, persistently mapped
+	VkBuffer m_readback;
+	MemoryAllocation m_readbackMemory;
+	const uint32_t* m_drawCounts;
+};
+
+#endif //COMMON_INDIRECT_CHUNK_RENDERER_H
@@ -0,0 +1,238 @@
+// Engine-wide thread pool running small jobs, with work stealing, completion counters, dependencies and parallelFor
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Implementation
+//////////////////////////////////
+
+// the system and slot the current thread runs jobs for
+static thread_local const JobSystem* t_system = nullptr;
+static thread_local uint32_t t_slot = JobSystem::noThreadIndex;
+
+// steal victims are picked at random, so the thieves do not all queue up on the same deque
+static thread_local uint32_t t_random = 0x9E3779B9u;
+static uint32_t nextRandom(){ // xorshift32
+	t_random ^= t_random << 13;
+	t_random ^= t_random >> 17;
+	t_random ^= t_random << 5;
+	return t_random;
+}
+
+JobSystem::JobSystem( uint32_t threadCount, const bool mainThreadParticipates )
+: m_mainThreadParticipates( mainThreadParticipates )
+{
+	if( !threadCount ) threadCount = std::max( 1u, std::thread::hardware_concurrency() );
+	m_workerCount = mainThreadParticipates ? threadCount - 1 : std::max( 1u, threadCount );
+
+	for( uint32_t slot = 0; slot < getSlotCount(); ++slot ) m_deques.emplace_back( new WorkStealingDeque<Job> );
+
+	t_system = this;
+	t_slot = 0;
+
+	for( uint32_t slot = 1; slot < getSlotCount(); ++slot ) m_workers.emplace_back( &JobSystem::workerLoop, this, slot );
+}
+
+JobSystem::~JobSystem(){
+	{
+		std::lock_guard<std::mutex> lock( m_sleepMutex );
+		m_quit.store( true );
+	}
+	m_wake.notify_all();
+	for( auto& worker : m_workers ) worker.join();
+
+	// jobs nobody waited for; with the workers gone, popping the deques is safe from here
+	for( auto& deque : m_deques ){
+		while( Job* const job = deque->pop() ) delete job;
+	}
+	for( Job* const job : m_injected ) delete job;
+
+	if( t_system == this ){
+		t_system = nullptr;
+		t_slot = noThreadIndex;
+	}
+}
+
+uint32_t JobSystem::getThreadIndex() const{
+	return t_system == this ? t_slot : noThreadIndex;
+}
+
+void JobSystem::run( std::function<void()> function, JobCounter* const counter ){
+	Job* const job = new Job{ std::move( function ), counter };
+	if( counter ) counter->m_pending.fetch_add( 1, std::memory_order_relaxed );
+	push( job );
+}
+
+void JobSystem::runAfter( JobCounter& dependency, std::function<void()> function, JobCounter* const counter ){
+	Job* const job = new Job{ std::move( function ), counter };
+	if( counter ) counter->m_pending.fetch_add( 1, std::memory_order_relaxed );
+
+	{
+		std::lock_guard<std::mutex> lock( dependency.m_mutex );
+		if( !dependency.isDone() ){
+			dependency.m_continuations.push_back( job ); // pushed by the job taking the count to 0
+			return;
+		}
+	}
+	push( job );
+}
+
+void JobSystem::wait( JobCounter& counter ){
+	const uint32_t slot = getThreadIndex();
+	if( runsJobs( slot ) ){
+		while( !counter.isDone() ){
+			if( Job* const job = findJob( slot ) ) execute( job );
+			else std::this_thread::yield(); // the rest of the counter's jobs are running on other threads
+		}
+	}
+	else{
+		std::unique_lock<std::mutex> lock( counter.m_mutex );
+		counter.m_done.wait(  lock, [&counter]{ return counter.isDone(); }  );
+	}
+
+	std::exception_ptr error;
+	{
+		std::lock_guard<std::mutex> lock( counter.m_mutex ); // the last job may still be in finish(); see JobCounter
+		std::swap( error, counter.m_error );
+	}
+	if( error ) std::rethrow_exception( error );
+}
+
+void JobSystem::workerLoop( const uint32_t slot ){
+	t_system = this;
+	t_slot = slot;
+	t_random = 0x9E3779B9u * (slot + 1);
+
+	// a short spin before sleeping; the jobs of a frame tend to come in bursts
+	const uint32_t spinsBeforeSleep = 64;
+	uint32_t idleSpins = 0;
+
+	while( !m_quit.load( std::memory_order_relaxed ) ){
+		if( Job* const job = findJob( slot ) ){
+			execute( job );
+			idleSpins = 0;
+			continue;
+		}
+
+		if( ++idleSpins < spinsBeforeSleep ){
+			std::this_thread::yield();
+			continue;
+		}
+		idleSpins = 0;
+
+		// push() bumps m_queuedJobs before it looks at m_sleepers, and a sleeper registers before it checks m_queuedJobs,
+		// so either the pusher sees the sleeper and notifies it, or the sleeper sees the job and does not sleep
+		std::unique_lock<std::mutex> lock( m_sleepMutex );
+		m_sleepers.fetch_add( 1 );
+		m_wake.wait(  lock, [this]{ return m_quit.load() || m_queuedJobs.load() > 0; }  );
+		m_sleepers.fetch_sub( 1 );
+	}
+}
+
+Job* JobSystem::findJob( const uint32_t slot ){
+	const auto taken = [this]( Job* const job ){
+		m_queuedJobs.fetch_sub( 1 );
+		return job;
+	};
+
+	if( slot != noThreadIndex ){
+		if( Job* const job = m_deques[slot]->pop() ) return taken( job );
+	}
+
+	if( m_injectedCount.load( std::memory_order_relaxed ) ){
+		std::lock_guard<std::mutex> lock( m_injectedMutex );
+		if( !m_injected.empty() ){
+			Job* const job = m_injected.front();
+			m_injected.pop_front();
+			m_injectedCount.fetch_sub( 1, std::memory_order_relaxed );
+			return taken( job );
+		}
+	}
+
+	const uint32_t slots = getSlotCount();
+	uint32_t victim = nextRandom() % slots;
+	for( uint32_t i = 0; i < slots; ++i, victim = (victim + 1 == slots ? 0 : victim + 1) ){
+		if( victim == slot ) continue;
+		if( Job* const job = m_deques[victim]->steal() ) return taken( job );
+	}
+
+	return nullptr;
+}
+
+void JobSystem::execute( Job* const job ){
+	const std::unique_ptr<Job> owner( job );
+
+	if( !job->counter ){
+		try{
+			job->function();
+		}
+		catch( ... ){
+			std::terminate(); // see run()
+		}
+		return;
+	}
+
+	try{
+		job->function();
+	}
+	catch( ... ){
+		std::lock_guard<std::mutex> lock( job->counter->m_mutex );
+		if( !job->counter->m_error ) job->counter->m_error = std::current_exception();
+	}
+	finish( *job->counter );
+}
+
+void JobSystem::push( Job* const job ){
+	const uint32_t slot = getThreadIndex();
+	if( slot != noThreadIndex ) m_deques[slot]->push( job );
+	else{
+		std::lock_guard<std::mutex> lock( m_injectedMutex );
+		m_injected.push_back( job );
+		m_injectedCount.fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	m_queuedJobs.fetch_add( 1 );
+	if( m_sleepers.load() ){
+		{ std::lock_guard<std::mutex> lock( m_sleepMutex ); } // so the notification cannot fall between a sleeper's check and its wait
+		m_wake.notify_one();
+	}
+}
+
+void JobSystem::finish( JobCounter& counter ){
+	// while other jobs of the counter are unfinished, no lock is needed
+	uint32_t pending = counter.m_pending.load( std::memory_order_relaxed );
+	while( pending > 1 ){
+		if( counter.m_pending.compare_exchange_weak( pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed ) ) return;
+	}
+
+	std::vector<Job*> continuations;
+	{
+		std::lock_guard<std::mutex> lock( counter.m_mutex );
+		if( counter.m_pending.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ){
+			continuations.swap( counter.m_continuations );
+			counter.m_done.notify_all();
+		}
+	}
+	for( Job* const job : continuations ) push( job ); // the counter may be gone by now; they are no longer in it
+}
+
+void JobSystem::runInline( const std::function<void()>& function, JobCounter& counter ){
+	counter.m_pending.fetch_add( 1, std::memory_order_relaxed );
+	try{
+		function();
+	}
+	catch( ... ){
+		std::lock_guard<std::mutex> lock( counter.m_mutex );
+		if( !counter.m_error ) counter.m_error = std::current_exception();
+	}
+	finish( counter );
+}
@@ -0,0 +1,136 @@
+// Engine-wide thread pool running small jobs, with work stealing, completion counters, dependencies and parallelFor
+
+#ifndef COMMON_JOB_SYSTEM_H
+#define COMMON_JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "WorkStealingDeque.h"
+
+
+struct Job;
+
+// Counts the unfinished jobs given to it. Waited for by JobSystem::wait(), which also rethrows the first exception of its jobs,
+// and other jobs can be made to start once it reaches zero (JobSystem::runAfter). Reusable once waited for.
+// Must outlive its jobs and continuations -- wait() for it before destroying it.
+class JobCounter{
+public:
+	JobCounter() = default;
+	JobCounter( const JobCounter& ) = delete;
+	JobCounter& operator=( const JobCounter& ) = delete;
+
+	bool isDone() const{ return m_pending.load( std::memory_order_acquire ) == 0; }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<uint32_t> m_pending{ 0 };
+
+	// the last job takes the count from 1 to 0 only under the mutex, so a waiter that takes the mutex after seeing 0
+	// knows the job is done with the counter
+	std::mutex m_mutex;
+	std::condition_variable m_done; // for waiters that do not run jobs
+	std::vector<Job*> m_continuations; // started when the count reaches 0
+	std::exception_ptr m_error;
+};
+
+struct Job{
+	std::function<void()> function;
+	JobCounter* counter; // may be null
+};
+
+
+// Every thread that runs jobs has a Chase-Lev deque. A thread pushes its new jobs to its own deque and pops them LIFO;
+// a thread out of jobs steals the oldest job of a random other thread. Threads that are not part of the system
+// submit through a shared locked queue. Idle workers sleep until new jobs are pushed.
+// The thread constructing the system is its "main thread": slot 0. If it participates, it runs jobs while it waits for
+// counters, and threadCount includes it. If not, it only submits and blocks in wait(), e.g. to keep the frame loop responsive.
+// (So with threadCount 1 and a participating main thread, there are no workers: jobs run only while the main thread waits.)
+class JobSystem{
+public:
+	static constexpr uint32_t noThreadIndex = ~0u;
+
+	// threadCount: threads running jobs; 0 means std::thread::hardware_concurrency()
+	explicit JobSystem( uint32_t threadCount = 0, bool mainThreadParticipates = true );
+	~JobSystem(); // all counters must have been waited for
+	JobSystem( const JobSystem& ) = delete;
+	JobSystem& operator=( const JobSystem& ) = delete;
+
+	uint32_t getThreadCount() const{ return m_workerCount + (m_mainThreadParticipates ? 1 : 0); } // that run jobs
+	uint32_t getSlotCount() const{ return m_workerCount + 1; } // getThreadIndex() is below this
+	bool mainThreadParticipates() const{ return m_mainThreadParticipates; }
+
+	// 0 on the main thread, 1 to getSlotCount() - 1 on the workers, noThreadIndex on other threads;
+	// e.g. to pick per-thread scratch memory inside jobs
+	uint32_t getThreadIndex() const;
+
+	// A job without a counter must not throw; nothing would be there to catch it, so it terminates the app.
+	void run( std::function<void()> function, JobCounter* counter = nullptr );
+	void runAfter( JobCounter& dependency, std::function<void()> function, JobCounter* counter = nullptr ); // once dependency is done
+	void wait( JobCounter& counter ); // rethrows the first exception of the counter's jobs
+
+	// Calls function( begin, end ) on consecutive subranges of at most grainSize items covering [begin, end), in parallel, and waits.
+	// Ranges are split in halves; the halves not worked on are stealable, so threads that run dry take big pieces of the rest.
+	template<typename Function>
+	void parallelFor( size_t begin, size_t end, size_t grainSize, const Function& function );
+
+private:
+	void workerLoop( uint32_t slot );
+	Job* findJob( uint32_t slot ); // own deque, then the shared queue, then stealing
+	void execute( Job* job );
+	void push( Job* job );
+	void finish( JobCounter& counter ); // one of its jobs is done
+	void runInline( const std::function<void()>& function, JobCounter& counter ); // as if a job of counter, on this thread
+	bool runsJobs( uint32_t slot ) const{ return slot != noThreadIndex && (slot != 0 || m_mainThreadParticipates); }
+
+	uint32_t m_workerCount;
+	bool m_mainThreadParticipates;
+
+	std::vector< std::unique_ptr< WorkStealingDeque<Job> > > m_deques; // per slot
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_injectedMutex;
+	std::deque<Job*> m_injected; // from threads without a slot
+	std::atomic<uint32_t> m_injectedCount{ 0 };
+
+	// idle workers sleep on m_wake; pushers only take the mutex if someone sleeps
+	std::atomic<int64_t> m_queuedJobs{ 0 }; // pushed, not yet taken
+	std::atomic<uint32_t> m_sleepers{ 0 };
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::atomic<bool> m_quit{ false };
+};
+
+
+template<typename Function>
+void JobSystem::parallelFor( const size_t begin, const size_t end, size_t grainSize, const Function& function ){
+	if( begin >= end ) return;
+	grainSize = std::max<size_t>( grainSize, 1 );
+
+	JobCounter counter;
+	std::function<void(size_t, size_t)> split = [&]( size_t first, size_t last ){
+		while( last - first > grainSize ){
+			const size_t middle = first + (last - first) / 2;
+			run( [&split, middle, last]{ split( middle, last ); }, &counter );
+			last = middle;
+		}
+		function( first, last );
+	};
+
+	if( runsJobs( getThreadIndex() ) ) runInline( [&]{ split( begin, end ); }, counter );
+	else run( [&]{ split( begin, end ); }, &counter );
+	wait( counter );
+}
+
+#endif //COMMON_JOB_SYSTEM_H
@@ -0,0 +1,243 @@
+// Device memory sub-allocator: big VkDeviceMemory blocks per memory type, carved up by a buddy allocator
+#include "VulkanEnvironment.h"
+
+#include "MemoryAllocator.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "BuddyAllocator.h"
+#include "ErrorHandling.h"
+#include "ExtensionLoader.h"
+#include "VulkanConfig.h"
+
+// Implementation
+//////////////////////////////////
+
+struct MemoryBlock{
+	VkDeviceMemory memory;
+	void* mapped; // whole block stays mapped for its lifetime -- a VkDeviceMemory can be mapped only once
+	BuddyAllocator allocator;
+};
+
+struct DedicatedMemory{
+	uint32_t memoryType;
+	VkDeviceSize size;
+};
+
+struct DeviceMemoryAllocator{
+	VkPhysicalDeviceMemoryProperties properties;
+	std::map< std::pair<uint32_t, ResourceKind>, std::vector< std::unique_ptr<MemoryBlock> > > pools;
+	std::unordered_map< VkDeviceMemory, DedicatedMemory > dedicatedAllocations;
+};
+
+static std::mutex allocatorsMutex;
+static std::unordered_map< VkDevice, DeviceMemoryAllocator > allocators;
+
+
+// small heaps (e.g. the 256 MiB BAR heap) would be eaten by a few full-size blocks
+static VkDeviceSize getBlockSize( const VkDeviceSize heapSize ){
+	VkDeviceSize blockSize = VulkanConfig::memoryBlockSize;
+	while( blockSize > heapSize / 8 && blockSize > VulkanConfig::memoryMinAllocationSize ) blockSize /= 2;
+	return blockSize;
+}
+
+static bool isHostVisible( const VkPhysicalDeviceMemoryProperties& properties, const uint32_t memoryType ){
+	return properties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+}
+
+static VkDeviceMemory allocateDeviceMemory( const VkDevice device, const VkDeviceSize size, const uint32_t memoryType, const void* pNext ){
+	const VkMemoryAllocateInfo memoryInfo{
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+		pNext,
+		size,
+		memoryType
+	};
+
+	VkDeviceMemory memory;
+	VkResult errorCode = vkAllocateMemory( device, &memoryInfo, nullptr, &memory ); RESULT_HANDLER( errorCode, "vkAllocateMemory" );
+	return memory;
+}
+
+static void* mapWholeMemory( const VkDevice device, const VkDeviceMemory memory ){
+	void* data;
+	VkResult errorCode = vkMapMemory( device, memory, 0 /*offset*/, VK_WHOLE_SIZE, 0 /*flags - reserved*/, &data ); RESULT_HANDLER( errorCode, "vkMapMemory" );
+	return data;
+}
+
+
+MemoryAllocation allocateMemory(
+	const VkDevice device,
+	const VkPhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties,
+	const VkMemoryRequirements& memoryRequirements,
+	const uint32_t memoryType,
+	const ResourceKind kind,
+	const bool preferDedicated,
+	const VkMemoryDedicatedAllocateInfoKHR* const dedicatedInfo
+){
+	std::lock_guard<std::mutex> lock( allocatorsMutex );
+
+	const auto inserted = allocators.emplace( device, DeviceMemoryAllocator{} );
+	DeviceMemoryAllocator& allocator = inserted.first->second;
+	if( inserted.second ) allocator.properties = physicalDeviceMemoryProperties;
+
+	const uint32_t heapIndex = allocator.properties.memoryTypes[memoryType].heapIndex;
+	const VkDeviceSize blockSize = getBlockSize( allocator.properties.memoryHeaps[heapIndex].size );
+	const bool hostVisible = isHostVisible( allocator.properties, memoryType );
+
+	MemoryAllocation allocation;
+	allocation.size = memoryRequirements.size;
+	allocation.memoryType = memoryType;
+	allocation.kind = kind;
+
+	// anything bigger than half a block would mostly waste the block anyway
+	if( preferDedicated || memoryRequirements.size > blockSize / 2 ){
+		allocation.memory = allocateDeviceMemory( device, memoryRequirements.size, memoryType, dedicatedInfo );
+		allocation.offset = 0;
+		allocation.dedicated = true;
+		if( hostVisible ) allocation.mapped = mapWholeMemory( device, allocation.memory );
+
+		allocator.dedicatedAllocations[allocation.memory] = { memoryType, memoryRequirements.size };
+		return allocation;
+	}
+
+	auto& blocks = allocator.pools[{memoryType, kind}];
+
+	const auto suballocate = [&]( MemoryBlock& block ){
+		const uint64_t offset = block.allocator.allocate( memoryRequirements.size, memoryRequirements.alignment );
+		if( offset == BuddyAllocator::invalidOffset ) return false;
+
+		allocation.memory = block.memory;
+		allocation.offset = offset;
+		if( block.mapped ) allocation.mapped = static_cast<char*>( block.mapped ) + offset;
+		return true;
+	};
+
+	for( auto& block : blocks ){
+		if(  suballocate( *block )  ) return allocation;
+	}
+
+	const VkDeviceMemory memory = allocateDeviceMemory( device, blockSize, memoryType, nullptr );
+	blocks.push_back(  std::unique_ptr<MemoryBlock>( new MemoryBlock{
+		memory,
+		hostVisible ? mapWholeMemory( device, memory ) : nullptr,
+		BuddyAllocator( blockSize, VulkanConfig::memoryMinAllocationSize )
+	} )  );
+
+	if(  !suballocate( *blocks.back() )  ) throw "Fresh device memory block cannot fit an allocation smaller than half of it!";
+	return allocation;
+}
+
+void freeMemory( const VkDevice device, const MemoryAllocation& allocation ){
+	if( allocation.memory == VK_NULL_HANDLE ) return;
+
+	std::lock_guard<std::mutex> lock( allocatorsMutex );
+	DeviceMemoryAllocator& allocator = allocators.at( device );
+
+	if( allocation.dedicated ){
+		allocator.dedicatedAllocations.erase( allocation.memory );
+		vkFreeMemory( device, allocation.memory, nullptr ); // implicitly unmaps
+		return;
+	}
+
+	auto& blocks = allocator.pools.at( {allocation.memoryType, allocation.kind} );
+	const auto it = std::find_if(  blocks.begin(), blocks.end(), [&allocation]( const std::unique_ptr<MemoryBlock>& b ){ return b->memory == allocation.memory; }  );
+	if( it == blocks.end() ) throw "Freeing memory allocation that does not belong to any block!";
+
+	MemoryBlock& block = **it;
+	block.allocator.free( allocation.offset );
+
+	// keep the last block of a pool around, so alloc/free of a single resource does not hit the driver every time
+	if( block.allocator.empty() && blocks.size() > 1 ){
+		vkFreeMemory( device, block.memory, nullptr );
+		blocks.erase( it );
+	}
+}
+
+bool isDedicatedAllocationEnabled( const VkDevice device ){
+	return isDeviceExtensionEnabled( device, VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME )
+	    && isDeviceExtensionEnabled( device, VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME );
+}
+
+std::vector<MemoryHeapStatistics> getMemoryStatistics( const VkDevice device ){
+	std::lock_guard<std::mutex> lock( allocatorsMutex );
+
+	const auto allocatorIt = allocators.find( device );
+	if( allocatorIt == allocators.end() ) return {};
+	const DeviceMemoryAllocator& allocator = allocatorIt->second;
+
+	std::vector<MemoryHeapStatistics> heaps;
+	for( uint32_t h = 0; h < allocator.properties.memoryHeapCount; ++h ){
+		heaps.push_back( { h, allocator.properties.memoryHeaps[h].size, 0, 0, 0, 0, 0, 0.0 } );
+	}
+
+	std::vector<VkDeviceSize> freeBytes( heaps.size(), 0 );
+	std::vector<VkDeviceSize> largestFree( heaps.size(), 0 );
+
+	for( const auto& pool : allocator.pools ){
+		const uint32_t h = allocator.properties.memoryTypes[pool.first.first].heapIndex;
+		for( const auto& block : pool.second ){
+			++heaps[h].blockCount;
+			heaps[h].allocationCount += static_cast<uint32_t>( block->allocator.allocationCount() );
+			heaps[h].reservedBytes += block->allocator.capacity();
+			heaps[h].usedBytes += block->allocator.usedSize();
+			freeBytes[h] += block->allocator.freeSize();
+			largestFree[h] = std::max( largestFree[h], block->allocator.largestFreeBlock() );
+		}
+	}
+
+	for( const auto& d : allocator.dedicatedAllocations ){
+		const uint32_t h = allocator.properties.memoryTypes[d.second.memoryType].heapIndex;
+		++heaps[h].dedicatedCount;
+		++heaps[h].allocationCount;
+		heaps[h].reservedBytes += d.second.size;
+		heaps[h].usedBytes += d.second.size;
+	}
+
+	for( size_t h = 0; h < heaps.size(); ++h ){
+		if( freeBytes[h] > 0 ) heaps[h].fragmentation = 1.0 - static_cast<double>( largestFree[h] ) / freeBytes[h];
+	}
+
+	return heaps;
+}
+
+void logMemoryStatistics( const VkDevice device ){
+	const double MiB = 1024.0 * 1024.0;
+
+	for( const auto& heap : getMemoryStatistics( device ) ){
+		if( heap.reservedBytes == 0 ) continue;
+
+		logger << "INFO: Memory heap " << heap.heapIndex << " (" << heap.heapSize / MiB << " MiB): "
+		       << heap.blockCount << " blocks, " << heap.dedicatedCount << " dedicated, " << heap.allocationCount << " allocations, "
+		       << heap.reservedBytes / MiB << " MiB reserved, " << heap.usedBytes / MiB << " MiB used, "
+		       << "fragmentation " << heap.fragmentation << std::endl;
+	}
+}
+
+void killMemoryAllocator( const VkDevice device ){
+	std::lock_guard<std::mutex> lock( allocatorsMutex );
+
+	const auto it = allocators.find( device );
+	if( it == allocators.end() ) return;
+	DeviceMemoryAllocator& allocator = it->second;
+
+	size_t leaked = allocator.dedicatedAllocations.size();
+	for( const auto& pool : allocator.pools ){
+		for( const auto& block : pool.second ){
+			leaked += block->allocator.allocationCount();
+			vkFreeMemory( device, block->memory, nullptr );
+		}
+	}
+	for( const auto& d : allocator.dedicatedAllocations ) vkFreeMemory( device, d.first, nullptr );
+
+	if( leaked ) logger << "WARNING: " << leaked << " device memory allocations were not freed before the device was destroyed" << std::endl;
+
+	allocators.erase( it );
+}
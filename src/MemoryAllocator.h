@@ -0,0 +1,58 @@
+// Device memory sub-allocator: big VkDeviceMemory blocks per memory type, carved up by a buddy allocator
+
+#ifndef COMMON_MEMORY_ALLOCATOR_H
+#define COMMON_MEMORY_ALLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+
+// Buffers and optimal-tiling images never share a block, so bufferImageGranularity can never bite
+enum class ResourceKind{ Linear, Optimal };
+
+struct MemoryAllocation{
+	VkDeviceMemory memory = VK_NULL_HANDLE; // shared with other allocations unless dedicated
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	uint32_t memoryType = UINT32_MAX;
+	ResourceKind kind = ResourceKind::Linear;
+	bool dedicated = false;
+	void* mapped = nullptr; // already points at offset; null if the memory type is not HOST_VISIBLE
+};
+
+struct MemoryHeapStatistics{
+	uint32_t heapIndex;
+	VkDeviceSize heapSize;
+	uint32_t blockCount;
+	uint32_t dedicatedCount;
+	uint32_t allocationCount; // sub-allocations + dedicated
+	VkDeviceSize reservedBytes; // what was taken from the driver by vkAllocateMemory
+	VkDeviceSize usedBytes; // what is handed out, including the rounding to power of two
+	double fragmentation; // 1 - largest free range / all free bytes, over the heap's blocks; 0 means none
+};
+
+// dedicatedInfo (VkMemoryDedicatedAllocateInfoKHR) is chained to vkAllocateMemory; pass it only if
+// VK_KHR_dedicated_allocation is enabled. Large requests get their own VkDeviceMemory even without it.
+MemoryAllocation allocateMemory(
+	VkDevice device,
+	const VkPhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties,
+	const VkMemoryRequirements& memoryRequirements,
+	uint32_t memoryType,
+	ResourceKind kind,
+	bool preferDedicated,
+	const VkMemoryDedicatedAllocateInfoKHR* dedicatedInfo = nullptr
+);
+void freeMemory( VkDevice device, const MemoryAllocation& allocation );
+
+// VK_KHR_dedicated_allocation and VK_KHR_get_memory_requirements2 are both enabled on the device
+bool isDedicatedAllocationEnabled( VkDevice device );
+
+std::vector<MemoryHeapStatistics> getMemoryStatistics( VkDevice device );
+void logMemoryStatistics( VkDevice device );
+
+// releases every block of the device; called by killDevice()
+void killMemoryAllocator( VkDevice device );
+
+#endif //COMMON_MEMORY_ALLOCATOR_H
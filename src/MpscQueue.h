@@ -0,0 +1,68 @@
+// Lock-free intrusive queue of many producer threads and one consumer thread; pushing never allocates or blocks
+
+#ifndef COMMON_MPSC_QUEUE_H
+#define COMMON_MPSC_QUEUE_H
+
+#include <atomic>
+
+
+// the link an item of an MpscQueue carries itself; an item can be in one queue at a time
+struct MpscNode{
+	std::atomic<MpscNode*> mpscNext{ nullptr };
+};
+
+// After Dmitry Vyukov's intrusive MPSC queue: a push is one atomic exchange plus a store, a pop touches no shared
+// cache line unless the queue is about to run empty. T must derive from MpscNode.
+template<typename T>
+class MpscQueue{
+public:
+	MpscQueue() : m_head( &m_stub ), m_tail( &m_stub ) {}
+	MpscQueue( const MpscQueue& ) = delete;
+	MpscQueue& operator=( const MpscQueue& ) = delete;
+
+	// any thread
+	void push( T* const item ){ pushNode( item ); }
+
+	// consumer only; nullptr if empty -- or if a producer is in the middle of a push, in which case its item, and what
+	// was pushed after it, show up on a later pop
+	T* pop(){
+		MpscNode* tail = m_tail;
+		MpscNode* next = tail->mpscNext.load( std::memory_order_acquire );
+
+		if( tail == &m_stub ){
+			if( !next ) return nullptr;
+			m_tail = next;
+			tail = next;
+			next = next->mpscNext.load( std::memory_order_acquire );
+		}
+
+		if( next ){
+			m_tail = next;
+			return static_cast<T*>( tail );
+		}
+
+		if( tail != m_head.load( std::memory_order_acquire ) ) return nullptr; // a push is midway
+
+		// tail is the last item; the stub goes behind it, so tail can be handed out without leaving the queue headless
+		pushNode( &m_stub );
+		next = tail->mpscNext.load( std::memory_order_acquire );
+		if( next ){
+			m_tail = next;
+			return static_cast<T*>( tail );
+		}
+		return nullptr;
+	}
+
+private:
+	void pushNode( MpscNode* const node ){
+		node->mpscNext.store( nullptr, std::memory_order_relaxed );
+		MpscNode* const previous = m_head.exchange( node, std::memory_order_acq_rel );
+		previous->mpscNext.store( node, std::memory_order_release );
+	}
+
+	std::atomic<MpscNode*> m_head; // the newest item; producers
+	MpscNode* m_tail; // the oldest item; consumer
+	MpscNode m_stub;
+};
+
+#endif //COMMON_MPSC_QUEUE_H
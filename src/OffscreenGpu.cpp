@@ -0,0 +1,173 @@
+// The Vulkan setup the offscreen benchmark modes share: a device without any surface, and render targets to draw into
+#include "VulkanEnvironment.h"
+
+#include "OffscreenGpu.h"
+
+#include <chrono>
+#include <fstream> // VulkanImpl.h relies on the includer for these
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "ErrorHandling.h"
+#include "VulkanConfig.h"
+#include "VulkanImpl.h"
+
+// Implementation
+//////////////////////////////////
+
+// the wanted ones the device supports; VkPhysicalDeviceFeatures is nothing but VkBool32s
+static VkPhysicalDeviceFeatures getSupportedFeatures( const VkPhysicalDevice physicalDevice, const VkPhysicalDeviceFeatures& wanted ){
+	VkPhysicalDeviceFeatures features;
+	vkGetPhysicalDeviceFeatures( physicalDevice, &features );
+
+	VkBool32* const supported = reinterpret_cast<VkBool32*>( &features );
+	const VkBool32* const wantedOnes = reinterpret_cast<const VkBool32*>( &wanted );
+	for( size_t i = 0; i < sizeof( VkPhysicalDeviceFeatures ) / sizeof( VkBool32 ); ++i ) supported[i] = supported[i] && wantedOnes[i];
+	return features;
+}
+
+OffscreenGpu::OffscreenGpu( const Settings& settings, const std::string& pipelineCachePath )
+: m_width( settings.width ), m_height( settings.height ), m_timestampsPerFrame( settings.timestampsPerFrame )
+{
+	const VkInstance instance = m_manager.getVkInstance();
+
+	m_physicalDevice = ::getPhysicalDevice( instance ); // no surface -- presentation support does not matter
+	m_properties = getPhysicalDeviceProperties( m_physicalDevice );
+	m_memoryProperties = getPhysicalDeviceMemoryProperties( m_physicalDevice );
+
+	m_queueFamily = getGraphicsQueueFamily( m_physicalDevice );
+	const uint32_t transferQueueFamily = getTransferQueueFamily( m_physicalDevice, m_queueFamily );
+	const VkQueueFamilyProperties queueFamilyProperties = getQueueFamilyProperties( m_physicalDevice )[m_queueFamily];
+	if( settings.compute && !(queueFamilyProperties.queueFlags & VK_QUEUE_COMPUTE_BIT) ) throw "The graphics queue family cannot run compute shaders!";
+
+	m_features = getSupportedFeatures( m_physicalDevice, settings.features );
+#ifdef __APPLE__
+	vector<const char*> deviceExtensions = { VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME, "VK_KHR_portability_subset" };
+#else
+	vector<const char*> deviceExtensions = { VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME };
+#endif
+	// optional; lets the memory allocator give resources their own allocation when the driver prefers it
+	enableOptionalDeviceExtensions( m_physicalDevice, m_manager.getRequestedLayers(), {VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME, VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME}, deviceExtensions );
+	if( !settings.optionalExtensions.empty() ) enableOptionalDeviceExtensions( m_physicalDevice, m_manager.getRequestedLayers(), settings.optionalExtensions, deviceExtensions );
+
+	m_device = initDevice( m_physicalDevice, m_features, m_queueFamily, m_queueFamily, transferQueueFamily, m_manager.getRequestedLayers(), deviceExtensions );
+	m_queue = ::getQueue( m_device, m_queueFamily, 0 );
+	const VkQueue transferQueue = ::getQueue( m_device, transferQueueFamily, 0 );
+
+	m_pipelineCache.reset( new PipelineCache( m_device, m_properties, pipelineCachePath ) );
+	m_uploader.reset( new UploadManager( m_device, m_memoryProperties, transferQueueFamily, transferQueue, m_queueFamily ) );
+	m_scheduler.reset(  new FrameScheduler( m_device, m_queueFamily, settings.framesInFlight )  ); // frame N uses slot N % getFramesInFlight()
+	const uint32_t ringSize = m_scheduler->getFramesInFlight();
+
+
+	m_format = VulkanConfig::offscreenFormat;
+	m_depthFormat = ::getDepthFormat( m_physicalDevice, settings.sampledDepth ? VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT : 0 );
+	m_renderPass = initOffscreenRenderPass( m_device, m_format, m_depthFormat );
+
+	for( uint32_t i = 0; i < ringSize; ++i ){
+		m_targets.push_back(  initImage( m_device, m_format, m_width, m_height, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT )  );
+		m_targetMemories.push_back(  initMemory<ResourceType::Image>( m_device, m_memoryProperties, m_targets.back(), {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT} )  );
+		m_targetViews.push_back(  initImageView( m_device, m_targets.back(), m_format )  );
+	}
+	const DepthBuffer depthBuffer = initDepthBuffer( m_device, m_memoryProperties, m_depthFormat, m_width, m_height, settings.sampledDepth );
+	m_depthImage = depthBuffer.image;
+	m_depthMemory = depthBuffer.memory;
+	m_depthView = depthBuffer.view;
+	m_framebuffers = initFramebuffers( m_device, m_renderPass, m_targetViews, m_width, m_height, m_depthView );
+
+
+	m_timestampPeriodMs = m_properties.limits.timestampPeriod * 1e-6;
+	if( m_timestampsPerFrame && queueFamilyProperties.timestampValidBits > 0 ){
+		m_timestampPool = initQueryPool( m_device, VK_QUERY_TYPE_TIMESTAMP, m_timestampsPerFrame * ringSize );
+	}
+}
+
+OffscreenGpu::~OffscreenGpu(){
+	try{
+		VkResult errorCode = vkDeviceWaitIdle( m_device ); RESULT_HANDLER( errorCode, "vkDeviceWaitIdle" );
+	}
+	catch( ... ){
+		logger << "WARNING: Failed to wait for the device to be idle while destroying it" << std::endl;
+	}
+
+	m_scheduler.reset();
+	m_uploader.reset();
+	m_pipelineCache.reset(); // saves it
+	if( m_timestampPool ) killQueryPool( m_device, m_timestampPool );
+	killFramebuffers( m_device, m_framebuffers );
+	killDepthBuffer( m_device, {m_depthImage, m_depthMemory, m_depthView} );
+	for( size_t i = 0; i < m_targets.size(); ++i ){
+		killImageView( m_device, m_targetViews[i] );
+		killImage( m_device, m_targets[i] );
+		killMemory( m_device, m_targetMemories[i] );
+	}
+	killRenderPass( m_device, m_renderPass );
+	killDevice( m_device );
+
+	const VkInstance instance = m_manager.getVkInstance();
+#if VULKAN_VALIDATION
+	killDebug( instance, m_manager.getDebugHandle() );
+#endif
+	killInstance( instance );
+}
+
+void OffscreenGpu::runFrames(
+	const uint64_t frameCount,
+	const std::function<void( VkCommandBuffer commandBuffer, uint64_t frame, uint32_t slot )>& record,
+	const std::function<void( uint32_t slot )>& consume,
+	std::vector<double>* const cpuFrameTimesMs
+){
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	const uint32_t ringSize = getFramesInFlight();
+	std::vector<bool> inFlight( ringSize, false );
+
+	for( uint64_t frame = 0; frame < frameCount; ++frame ){
+		const auto frameStart = steady_clock::now();
+
+		// only ever waits for the frame submitted ringSize frames ago
+		const VkCommandBuffer commandBuffer = m_scheduler->beginFrame().commandBuffer;
+		const uint32_t slot = m_scheduler->getFrameIndex();
+		if( inFlight[slot] ) consume( slot );
+
+		record( commandBuffer, frame, slot );
+
+		m_scheduler->submitFrame( m_queue );
+		inFlight[slot] = true;
+
+		if( cpuFrameTimesMs ) cpuFrameTimesMs->push_back(  duration<double, std::milli>( steady_clock::now() - frameStart ).count()  );
+	}
+
+	// drain the ring, oldest frame first
+	m_scheduler->waitIdle();
+	for( uint64_t frame = frameCount; frame < frameCount + ringSize; ++frame ){
+		const uint32_t slot = static_cast<uint32_t>( frame % ringSize );
+		if( inFlight[slot] ) consume( slot );
+	}
+}
+
+void OffscreenGpu::recordFrameStart( const VkCommandBuffer commandBuffer, const uint32_t slot ){
+	if( !hasGpuTiming() ) return;
+
+	recordResetQueries( commandBuffer, m_timestampPool, m_timestampsPerFrame * slot, m_timestampsPerFrame );
+	::recordTimestamp( commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPool, m_timestampsPerFrame * slot );
+}
+
+void OffscreenGpu::recordTimestamp( const VkCommandBuffer commandBuffer, const uint32_t slot, const uint32_t index ){
+	if( !hasGpuTiming() ) return;
+
+	::recordTimestamp( commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPool, m_timestampsPerFrame * slot + index );
+}
+
+bool OffscreenGpu::getTimestampIntervals( const uint32_t slot, double* const intervalsMs ){
+	if( !hasGpuTiming() ) return false;
+
+	std::vector<uint64_t> timestamps( m_timestampsPerFrame );
+	if(  !getTimestamps( m_device, m_timestampPool, m_timestampsPerFrame * slot, m_timestampsPerFrame, timestamps.data() )  ) return false;
+
+	for( uint32_t i = 1; i < m_timestampsPerFrame; ++i ) intervalsMs[i - 1] = (timestamps[i] - timestamps[i - 1]) * m_timestampPeriodMs;
+	return true;
+}
@@ -0,0 +1,116 @@
+// The Vulkan setup the offscreen benchmark modes share: a device without any surface, and render targets to draw into
+
+#ifndef COMMON_OFFSCREEN_GPU_H
+#define COMMON_OFFSCREEN_GPU_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "ErrorHandling.h"
+#include "FrameScheduler.h"
+#include "MemoryAllocator.h"
+#include "PipelineCache.h"
+#include "UploadManager.h"
+#include "VulkanValidation.h"
+
+
+// Instance, device, the queue of the graphics family (getGraphicsQueueFamily), an UploadManager on the transfer family, a
+// PipelineCache, and a FrameScheduler; a render target (color image + framebuffer of getRenderPass()) per frame in flight,
+// all sharing one depth buffer, so a frame never waits for the previous one to be done drawing; and optionally a few
+// timestamps per frame in flight. Whatever the user makes on the device has to be gone before the destructor runs.
+class OffscreenGpu{
+public:
+	struct Settings{
+		uint32_t width, height; // of the render targets
+		uint32_t framesInFlight; // of the FrameScheduler, clamped like there; one render target each
+		VkPhysicalDeviceFeatures features = {}; // wanted; those the device lacks are left off -- see getFeatures()
+		std::vector<const char*> optionalExtensions; // enabled as a group, if the device supports all of them
+		bool compute = false; // the queue has to run compute shaders too; throws if it cannot
+		bool sampledDepth = false; // shaders may read the depth buffer after an initEarlyRenderPass, e.g. HiZPyramid
+		uint32_t timestampsPerFrame = 0; // see recordFrameStart()
+	};
+
+	OffscreenGpu( const Settings& settings, const std::string& pipelineCachePath ); // see getPipelineCachePath()
+	~OffscreenGpu(); // waits for the GPU; saves the pipeline cache
+	OffscreenGpu( const OffscreenGpu& ) = delete;
+	OffscreenGpu& operator=( const OffscreenGpu& ) = delete;
+
+	VkPhysicalDevice getPhysicalDevice() const{ return m_physicalDevice; }
+	const VkPhysicalDeviceProperties& getProperties() const{ return m_properties; }
+	const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const{ return m_memoryProperties; }
+	const VkPhysicalDeviceFeatures& getFeatures() const{ return m_features; } // enabled ones
+	VkDevice getDevice() const{ return m_device; }
+	uint32_t getQueueFamily() const{ return m_queueFamily; }
+	VkQueue getQueue() const{ return m_queue; }
+
+	UploadManager& getUploader(){ return *m_uploader; }
+	PipelineCache& getPipelineCache(){ return *m_pipelineCache; }
+	FrameScheduler& getScheduler(){ return *m_scheduler; }
+	uint32_t getFramesInFlight() const{ return m_scheduler->getFramesInFlight(); }
+
+	// render targets; the render pass is initOffscreenRenderPass, so others made compatible with it share the framebuffers
+	uint32_t getWidth() const{ return m_width; }
+	uint32_t getHeight() const{ return m_height; }
+	VkFormat getFormat() const{ return m_format; }
+	VkFormat getDepthFormat() const{ return m_depthFormat; }
+	VkRenderPass getRenderPass() const{ return m_renderPass; }
+	VkImage getTarget( uint32_t slot ) const{ return m_targets[slot]; } // COLOR_ATTACHMENT and TRANSFER_SRC usage
+	VkFramebuffer getFramebuffer( uint32_t slot ) const{ return m_framebuffers[slot]; }
+	VkImageView getDepthView() const{ return m_depthView; }
+
+	// Records frameCount frames; each is submitted to getQueue() after record() filled its command buffer. consume( slot )
+	// runs once the GPU finished the frame of the slot: before the slot is recorded again, or when all are done at the end.
+	// cpuFrameTimesMs gets the CPU time of every frame, from waiting for its slot to its submission.
+	void runFrames(
+		uint64_t frameCount,
+		const std::function<void( VkCommandBuffer commandBuffer, uint64_t frame, uint32_t slot )>& record,
+		const std::function<void( uint32_t slot )>& consume,
+		std::vector<double>* cpuFrameTimesMs = nullptr
+	);
+
+	// Timestamps are optional; without them these do nothing, and the reports just have no GPU times.
+	// recordFrameStart() resets the timestamps of the slot and writes the first one, recordTimestamp() the later ones, once
+	// the work recorded before it is done; getTimestampIntervals() gives the timestampsPerFrame - 1 milliseconds between
+	// them, when the frame is done, or returns false.
+	bool hasGpuTiming() const{ return m_timestampPool != VK_NULL_HANDLE; }
+	void recordFrameStart( VkCommandBuffer commandBuffer, uint32_t slot );
+	void recordTimestamp( VkCommandBuffer commandBuffer, uint32_t slot, uint32_t index );
+	bool getTimestampIntervals( uint32_t slot, double* intervalsMs );
+
+private:
+	VulkanManager m_manager; // the instance
+	VkPhysicalDevice m_physicalDevice;
+	VkPhysicalDeviceProperties m_properties;
+	VkPhysicalDeviceMemoryProperties m_memoryProperties;
+	VkPhysicalDeviceFeatures m_features;
+	uint32_t m_queueFamily;
+	VkDevice m_device;
+	VkQueue m_queue;
+
+	std::unique_ptr<PipelineCache> m_pipelineCache;
+	std::unique_ptr<UploadManager> m_uploader;
+	std::unique_ptr<FrameScheduler> m_scheduler;
+
+	uint32_t m_width, m_height;
+	VkFormat m_format;
+	VkFormat m_depthFormat;
+	VkRenderPass m_renderPass;
+	std::vector<VkImage> m_targets;
+	std::vector<MemoryAllocation> m_targetMemories;
+	std::vector<VkImageView> m_targetViews;
+	VkImage m_depthImage;
+	MemoryAllocation m_depthMemory;
+	VkImageView m_depthView;
+	std::vector<VkFramebuffer> m_framebuffers;
+
+	uint32_t m_timestampsPerFrame;
+	double m_timestampPeriodMs;
+	VkQueryPool m_timestampPool = VK_NULL_HANDLE;
+};
+
+#endif //COMMON_OFFSCREEN_GPU_H
@@ -0,0 +1,90 @@
+// Records a draw list on several threads into secondary command buffers, executed by one primary buffer
+#include "VulkanEnvironment.h"
+
+#include "ParallelRecorder.h"
+
+#include <algorithm>
+#include <fstream> // VulkanImpl.h relies on the includer for these
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "ErrorHandling.h"
+#include "VulkanConfig.h"
+#include "VulkanImpl.h"
+
+// Implementation
+//////////////////////////////////
+
+ParallelRecorder::ParallelRecorder( const VkDevice device, const uint32_t queueFamily, const uint32_t framesInFlight, JobSystem& jobs, const uint32_t sliceCount )
+: m_device( device ), m_jobs( jobs ), m_sliceCount( sliceCount ? sliceCount : jobs.getThreadCount() )
+{
+	m_frames.resize( framesInFlight );
+	for( auto& frame : m_frames ){
+		for( uint32_t s = 0; s < m_sliceCount; ++s ){
+			SliceFrame sliceFrame;
+			sliceFrame.commandPool = initCommandPool( device, queueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT );
+
+			vector<VkCommandBuffer> commandBuffer;
+			acquireCommandBuffers( device, sliceFrame.commandPool, 1, commandBuffer, VK_COMMAND_BUFFER_LEVEL_SECONDARY );
+			sliceFrame.commandBuffer = commandBuffer[0];
+
+			frame.push_back( sliceFrame );
+		}
+	}
+
+	m_executed.reserve( m_sliceCount );
+}
+
+ParallelRecorder::~ParallelRecorder(){
+	for( const auto& frame : m_frames ){
+		for( const auto& sliceFrame : frame ) killCommandPool( m_device, sliceFrame.commandPool );
+	}
+}
+
+void ParallelRecorder::record(
+	const VkCommandBuffer primary,
+	const uint32_t frameIndex,
+	const VkRenderPass renderPass,
+	const VkFramebuffer framebuffer,
+	const uint32_t width, const uint32_t height,
+	const uint32_t vertexBufferBinding,
+	const vector<DrawCommand>& drawList
+){
+	// a slice of only a handful of draws costs more in job overhead and an extra secondary buffer than it saves
+	const size_t wantedSlices = (drawList.size() + VulkanConfig::minDrawsPerRecordingThread - 1) / VulkanConfig::minDrawsPerRecordingThread;
+	const uint32_t activeSlices = static_cast<uint32_t>(  std::max<size_t>( 1, std::min<size_t>( wantedSlices, m_sliceCount ) )  );
+
+	m_activeSlices = activeSlices;
+	m_frameIndex = frameIndex;
+	m_renderPass = renderPass;
+	m_framebuffer = framebuffer;
+	m_width = width;
+	m_height = height;
+	m_vertexBufferBinding = vertexBufferBinding;
+	m_drawList = &drawList;
+
+	m_jobs.parallelFor(  0, activeSlices, 1, [this]( size_t first, size_t last ){
+		for( size_t slice = first; slice < last; ++slice ) recordSlice( static_cast<uint32_t>( slice ) );
+	}  );
+
+	m_executed.clear();
+	for( uint32_t s = 0; s < activeSlices; ++s ) m_executed.push_back( m_frames[frameIndex][s].commandBuffer );
+	vkCmdExecuteCommands( primary, activeSlices, m_executed.data() );
+}
+
+void ParallelRecorder::recordSlice( const uint32_t slice ){
+	const SliceFrame& sliceFrame = m_frames[m_frameIndex][slice];
+	const vector<DrawCommand>& drawList = *m_drawList;
+
+	const size_t begin = drawList.size() * slice / m_activeSlices;
+	const size_t end = drawList.size() * (slice + 1) / m_activeSlices;
+
+	{VkResult errorCode = vkResetCommandPool( m_device, sliceFrame.commandPool, 0 ); RESULT_HANDLER( errorCode, "vkResetCommandPool" );}
+
+	beginSecondaryCommandBuffer( sliceFrame.commandBuffer, m_renderPass, m_framebuffer );
+		recordSetViewport( sliceFrame.commandBuffer, m_width, m_height ); // dynamic state is not inherited from the primary buffer
+		recordDrawList( sliceFrame.commandBuffer, m_vertexBufferBinding, drawList.data() + begin, end - begin );
+	endCommandBuffer( sliceFrame.commandBuffer );
+}
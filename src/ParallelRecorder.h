@@ -0,0 +1,66 @@
+// Records a draw list on several threads into secondary command buffers, executed by one primary buffer
+
+#ifndef COMMON_PARALLEL_RECORDER_H
+#define COMMON_PARALLEL_RECORDER_H
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "FrameContext.h"
+#include "JobSystem.h"
+
+
+// The draw list is split into slices, recorded as jobs of a JobSystem. Each slice has its own transient command pool
+// per frame in flight, so recording never contends on a pool, whichever thread happens to record the slice.
+class ParallelRecorder{
+public:
+	// sliceCount: most secondary buffers per record(); 0 means jobs.getThreadCount()
+	ParallelRecorder( VkDevice device, uint32_t queueFamily, uint32_t framesInFlight, JobSystem& jobs, uint32_t sliceCount = 0 );
+	~ParallelRecorder();
+	ParallelRecorder( const ParallelRecorder& ) = delete;
+	ParallelRecorder& operator=( const ParallelRecorder& ) = delete;
+
+	uint32_t getSliceCount() const{ return m_sliceCount; }
+
+	// Splits drawList into contiguous slices (no more of them than VulkanConfig::minDrawsPerRecordingThread allows),
+	// records each into a secondary buffer inheriting subpass 0 of renderPass, then vkCmdExecuteCommands them.
+	// primary must be inside that render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+	// The pools of frameIndex are reset, so the GPU must be done with that frame (FrameScheduler::beginFrame waited for it).
+	// Not reentrant; the calling thread takes part in the recording if the JobSystem lets it.
+	void record(
+		VkCommandBuffer primary,
+		uint32_t frameIndex,
+		VkRenderPass renderPass,
+		VkFramebuffer framebuffer,
+		uint32_t width, uint32_t height,
+		uint32_t vertexBufferBinding,
+		const std::vector<DrawCommand>& drawList
+	);
+
+private:
+	struct SliceFrame{
+		VkCommandPool commandPool; // TRANSIENT
+		VkCommandBuffer commandBuffer; // SECONDARY
+	};
+
+	void recordSlice( uint32_t slice );
+
+	VkDevice m_device;
+	JobSystem& m_jobs;
+	uint32_t m_sliceCount;
+	std::vector< std::vector<SliceFrame> > m_frames; // [frame][slice]
+	std::vector<VkCommandBuffer> m_executed; // reused by every record()
+
+	// the job of the current record() call; written before its jobs are started
+	uint32_t m_activeSlices = 0;
+	uint32_t m_frameIndex = 0;
+	VkRenderPass m_renderPass = VK_NULL_HANDLE;
+	VkFramebuffer m_framebuffer = VK_NULL_HANDLE;
+	uint32_t m_width = 0, m_height = 0;
+	uint32_t m_vertexBufferBinding = 0;
+	const std::vector<DrawCommand>* m_drawList = nullptr;
+};
+
+#endif //COMMON_PARALLEL_RECORDER_H
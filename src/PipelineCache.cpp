@@ -0,0 +1,118 @@
+// VkPipelineCache persisted on disk, so pipelines are not compiled from scratch on every launch
+#include "VulkanEnvironment.h"
+
+#include "PipelineCache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "AtomicFile.h"
+#include "ErrorHandling.h"
+#include "VulkanImpl.h"
+
+// Implementation
+//////////////////////////////////
+
+// the layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE; read by hand, the file data need not be aligned
+static const size_t headerSizeV1 = 16 + VK_UUID_SIZE;
+
+static uint32_t readU32( const unsigned char* bytes ){
+	uint32_t value;
+	std::memcpy( &value, bytes, sizeof( value ) );
+	return value;
+}
+
+bool isPipelineCacheCompatible( const void* const data, const size_t size, const VkPhysicalDeviceProperties& physicalDeviceProperties ){
+	const unsigned char* const bytes = static_cast<const unsigned char*>( data );
+
+	if( size < headerSizeV1 ){
+		logger << "WARNING: Pipeline cache data is too small to even hold the header" << std::endl;
+		return false;
+	}
+
+	const uint32_t headerSize = readU32( bytes + 0 );
+	const uint32_t headerVersion = readU32( bytes + 4 );
+	const uint32_t vendorID = readU32( bytes + 8 );
+	const uint32_t deviceID = readU32( bytes + 12 );
+	const unsigned char* const uuid = bytes + 16;
+
+	if( headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || headerSize < headerSizeV1 || headerSize > size ){
+		logger << "WARNING: Pipeline cache has unknown header version " << headerVersion << " or size " << headerSize << std::endl;
+		return false;
+	}
+
+	if( vendorID != physicalDeviceProperties.vendorID || deviceID != physicalDeviceProperties.deviceID ){
+		logger << "INFO: Pipeline cache was made by another device; starting with an empty one" << std::endl;
+		return false;
+	}
+
+	if(  std::memcmp( uuid, physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE ) != 0  ){
+		logger << "INFO: Pipeline cache was made by another driver version; starting with an empty one" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+PipelineCache::PipelineCache( const VkDevice device, const VkPhysicalDeviceProperties& physicalDeviceProperties, std::string path )
+: m_device( device ), m_path( std::move( path ) ), m_lastSave( std::chrono::steady_clock::now() )
+{
+	vector<uint8_t> data;
+	if( !m_path.empty() ){
+		data = loadBinaryFile( m_path );
+		if(  !data.empty() && !isPipelineCacheCompatible( data.data(), data.size(), physicalDeviceProperties )  ) data.clear();
+	}
+
+	const VkPipelineCacheCreateInfo cacheInfo{
+		VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		nullptr, // pNext
+		0, // flags
+		data.size(),
+		data.empty() ? nullptr : data.data()
+	};
+
+	VkResult errorCode = vkCreatePipelineCache( device, &cacheInfo, nullptr, &m_cache ); RESULT_HANDLER( errorCode, "vkCreatePipelineCache" );
+
+	m_loadedSize = m_savedSize = data.size();
+}
+
+PipelineCache::~PipelineCache(){
+	try{
+		save();
+	}
+	catch( ... ){
+		logger << "WARNING: Failed to save the pipeline cache to " << m_path << std::endl;
+	}
+
+	vkDestroyPipelineCache( m_device, m_cache, nullptr );
+}
+
+void PipelineCache::save(){
+	m_lastSave = std::chrono::steady_clock::now();
+	if( m_path.empty() ) return;
+
+	size_t size;
+	{VkResult errorCode = vkGetPipelineCacheData( m_device, m_cache, &size, nullptr ); RESULT_HANDLER( errorCode, "vkGetPipelineCacheData" );}
+	if( size == m_savedSize ) return; // the cache only ever grows; same size means nothing new
+
+	vector<char> data( size );
+	{VkResult errorCode = vkGetPipelineCacheData( m_device, m_cache, &size, data.data() ); RESULT_HANDLER( errorCode, "vkGetPipelineCacheData" );}
+	data.resize( size );
+
+	if(  !writeFileAtomically( m_path, data.data(), data.size() )  ) throw string( "Failed to write the pipeline cache to " ) + m_path;
+
+	m_savedSize = size;
+}
+
+void PipelineCache::saveIfDue(){
+	const auto interval = std::chrono::duration<double>( VulkanConfig::pipelineCacheSaveInterval );
+	if( std::chrono::steady_clock::now() - m_lastSave < interval ) return;
+
+	save();
+}
@@ -0,0 +1,46 @@
+// VkPipelineCache persisted on disk, so pipelines are not compiled from scratch on every launch
+
+#ifndef COMMON_PIPELINE_CACHE_H
+#define COMMON_PIPELINE_CACHE_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#include <vulkan/vulkan.h>
+
+#include "VulkanConfig.h"
+
+
+// The file is used only if its header matches the vendorID, deviceID and pipelineCacheUUID of the device;
+// otherwise (other GPU, new driver) the cache starts empty and the file gets overwritten on the next save.
+// Saves go through writeFileAtomically(): a temporary file, synced to the disk before it replaces the old one in one
+// step, so a crash never leaves a torn cache behind.
+class PipelineCache{
+public:
+	// empty path keeps the cache in memory only
+	PipelineCache( VkDevice device, const VkPhysicalDeviceProperties& physicalDeviceProperties, std::string path = VulkanConfig::pipelineCachePath );
+	~PipelineCache(); // saves
+	PipelineCache( const PipelineCache& ) = delete;
+	PipelineCache& operator=( const PipelineCache& ) = delete;
+
+	VkPipelineCache get() const{ return m_cache; }
+	bool isWarm() const{ return m_loadedSize > 0; } // started from a valid file
+
+	void save();
+	// cheap to call every frame; saves at most every VulkanConfig::pipelineCacheSaveInterval, and only if the cache grew
+	void saveIfDue();
+
+private:
+	VkDevice m_device;
+	VkPipelineCache m_cache;
+	std::string m_path;
+	size_t m_loadedSize = 0;
+	size_t m_savedSize = 0;
+	std::chrono::steady_clock::time_point m_lastSave;
+};
+
+// checks the VK_PIPELINE_CACHE_HEADER_VERSION_ONE header; logs why the data is rejected
+bool isPipelineCacheCompatible( const void* data, size_t size, const VkPhysicalDeviceProperties& physicalDeviceProperties );
+
+#endif //COMMON_PIPELINE_CACHE_H
@@ -0,0 +1,169 @@
+// Owns the swapchain and everything sized by it; coalesces recreation requests into at most one recreation per frame
+#include "VulkanEnvironment.h"
+
+#include "SwapchainManager.h"
+
+#include <fstream> // VulkanImpl.h relies on the includer for these
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "EnumerateScheme.h"
+#include "ErrorHandling.h"
+#include "VulkanConfig.h"
+#include "VulkanImpl.h"
+
+// Implementation
+//////////////////////////////////
+
+// the size the swapchain would get now, or {0, 0} if none can be created (e.g. minimized window)
+static VkExtent2D getPresentableExtent( const VkSurfaceCapabilitiesKHR& capabilities ){
+	const VkExtent2D extent = capabilities.currentExtent;
+
+	const bool creatable = {
+		   extent.width >= capabilities.minImageExtent.width
+		&& extent.width <= capabilities.maxImageExtent.width
+		&& extent.width > 0
+		&& extent.height >= capabilities.minImageExtent.height
+		&& extent.height <= capabilities.maxImageExtent.height
+		&& extent.height > 0
+	};
+
+	return creatable ? extent : VkExtent2D{0, 0};
+}
+
+SwapchainManager::SwapchainManager(
+	const VkPhysicalDevice physicalDevice,
+	const VkDevice device,
+	const VkSurfaceKHR surface,
+	const PlatformWindow window,
+	const VkSurfaceFormatKHR surfaceFormat,
+	const VkRenderPass renderPass,
+	const VkFormat depthFormat,
+	const uint32_t graphicsQueueFamily,
+	const uint32_t presentQueueFamily,
+	FrameScheduler& scheduler
+)
+: m_physicalDevice( physicalDevice ), m_device( device ), m_surface( surface ), m_window( window ), m_surfaceFormat( surfaceFormat ),
+  m_renderPass( renderPass ), m_depthFormat( depthFormat ), m_memoryProperties( getPhysicalDeviceMemoryProperties( physicalDevice ) ),
+  m_graphicsQueueFamily( graphicsQueueFamily ), m_presentQueueFamily( presentQueueFamily ), m_scheduler( scheduler )
+{}
+
+SwapchainManager::~SwapchainManager(){
+	killSemaphores( m_device, m_renderDoneSs );
+	killFramebuffers( m_device, m_framebuffers );
+	if( m_depthImage ) killDepthBuffer( m_device, {m_depthImage, m_depthMemory, m_depthView} );
+	killSwapchainImageViews( m_device, m_imageViews );
+	if( m_swapchain ) killSwapchain( m_device, m_swapchain );
+}
+
+bool SwapchainManager::onResize(){
+	m_lastResize = std::chrono::steady_clock::now();
+	if( m_state == State::valid ) m_state = State::stale;
+
+	VkSurfaceCapabilitiesKHR capabilities = getSurfaceCapabilities( m_physicalDevice, m_surface );
+	if( capabilities.currentExtent.width == UINT32_MAX && capabilities.currentExtent.height == UINT32_MAX ){
+		capabilities.currentExtent = { getWindowWidth( m_window ), getWindowHeight( m_window ) };
+	}
+
+	return getPresentableExtent( capabilities ).width != 0;
+}
+
+bool SwapchainManager::prepareFrame(){
+	if( m_state == State::stale ){
+		// keep presenting to the old one while the size is still changing
+		const auto settleTime = std::chrono::duration<double>( VulkanConfig::swapchainResizeSettleTime );
+		if( std::chrono::steady_clock::now() - m_lastResize < settleTime ) return true;
+	}
+
+	if( m_state != State::valid ) recreate();
+
+	return m_swapchain != VK_NULL_HANDLE;
+}
+
+SwapchainStatus SwapchainManager::acquire( const VkSemaphore imageReadyS, uint32_t& imageIndex ){
+	const SwapchainStatus status = acquireNextImage( m_device, m_swapchain, imageReadyS, imageIndex );
+
+	if( status == SwapchainStatus::outOfDate ) m_state = State::outOfDate;
+	else if( status == SwapchainStatus::suboptimal && m_state == State::valid ) m_state = State::stale;
+
+	return status;
+}
+
+SwapchainStatus SwapchainManager::present( const VkQueue queue, const uint32_t imageIndex ){
+	const SwapchainStatus status = ::present( queue, m_swapchain, imageIndex, m_renderDoneSs[imageIndex] );
+
+	if( status == SwapchainStatus::outOfDate ) m_state = State::outOfDate;
+	else if( status == SwapchainStatus::suboptimal && m_state == State::valid ) m_state = State::stale;
+
+	return status;
+}
+
+void SwapchainManager::recreate(){
+	VkSurfaceCapabilitiesKHR capabilities = getSurfaceCapabilities( m_physicalDevice, m_surface );
+	if( capabilities.currentExtent.width == UINT32_MAX && capabilities.currentExtent.height == UINT32_MAX ){
+		capabilities.currentExtent = { getWindowWidth( m_window ), getWindowHeight( m_window ) };
+	}
+
+	const VkExtent2D extent = getPresentableExtent( capabilities );
+	const VkSwapchainKHR oldSwapchain = m_swapchain;
+
+	VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+	if( extent.width != 0 ){
+		// oldSwapchain gets retired; its presentable images stay valid until it is destroyed
+		capabilities.currentExtent = extent;
+		swapchain = initSwapchain( m_physicalDevice, m_device, m_surface, m_surfaceFormat, capabilities, m_graphicsQueueFamily, m_presentQueueFamily, oldSwapchain );
+	}
+
+	retire();
+	m_swapchain = swapchain;
+	if( !m_swapchain ) return; // stays outOfDate; the next prepareFrame tries again
+
+	const vector<VkImage> images = enumerate<VkImage>( m_device, m_swapchain );
+	m_imageViews = initSwapchainImageViews( m_device, images, m_surfaceFormat.format );
+	if( m_depthFormat != VK_FORMAT_UNDEFINED ){
+		const DepthBuffer depthBuffer = initDepthBuffer( m_device, m_memoryProperties, m_depthFormat, extent.width, extent.height );
+		m_depthImage = depthBuffer.image;
+		m_depthMemory = depthBuffer.memory;
+		m_depthView = depthBuffer.view;
+	}
+	m_framebuffers = initFramebuffers( m_device, m_renderPass, m_imageViews, extent.width, extent.height, m_depthView );
+	m_renderDoneSs = initSemaphores( m_device, images.size() ); // fresh, so none is left signaled by a present that did not happen
+	m_extent = extent;
+
+	m_state = State::valid;
+	++m_recreationCount;
+}
+
+void SwapchainManager::retire(){
+	if( !m_swapchain ) return;
+
+	// Destroyed once every frame submitted so far (and the one being recorded) finished. Strictly, the spec offers no way
+	// to know when the presentation engine is done with the present wait semaphores (VK_EXT_swapchain_maintenance1 would),
+	// and the old vkDeviceWaitIdle did not guarantee more than this either.
+	const VkDevice device = m_device;
+	const VkSwapchainKHR swapchain = m_swapchain;
+	vector<VkImageView> imageViews = std::move( m_imageViews );
+	const DepthBuffer depthBuffer = { m_depthImage, m_depthMemory, m_depthView };
+	vector<VkFramebuffer> framebuffers = std::move( m_framebuffers );
+	vector<VkSemaphore> renderDoneSs = std::move( m_renderDoneSs );
+
+	m_scheduler.deferDeletion(  [=]() mutable{
+		killFramebuffers( device, framebuffers );
+		if( depthBuffer.image ) killDepthBuffer( device, depthBuffer );
+		killSwapchainImageViews( device, imageViews );
+		killSemaphores( device, renderDoneSs );
+		killSwapchain( device, swapchain );
+	}  );
+
+	m_swapchain = VK_NULL_HANDLE;
+	m_imageViews.clear();
+	m_depthImage = VK_NULL_HANDLE;
+	m_depthMemory = {};
+	m_depthView = VK_NULL_HANDLE;
+	m_framebuffers.clear();
+	m_renderDoneSs.clear();
+	m_extent = {0, 0};
+}
@@ -0,0 +1,102 @@
+// Owns the swapchain and everything sized by it; coalesces recreation requests into at most one recreation per frame
+
+#ifndef COMMON_SWAPCHAIN_MANAGER_H
+#define COMMON_SWAPCHAIN_MANAGER_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "FrameScheduler.h"
+#include "MemoryAllocator.h"
+#include "Wsi.h"
+
+
+// what acquire and present report about the swapchain, instead of throwing; real errors still throw
+enum class SwapchainStatus{
+	optimal,
+	suboptimal, // the operation succeeded, but the swapchain should be recreated when convenient
+	outOfDate // nothing was acquired or presented; the swapchain must be recreated
+};
+
+// Size events and suboptimal/out-of-date results only mark the swapchain; prepareFrame() is the one place it is recreated.
+// A swapchain that is merely stale (still presentable) is kept until the resizing settles, so a window drag does not
+// recreate it on every event. The old swapchain is retired through oldSwapchain, and it and its views, framebuffers and
+// semaphores are destroyed by FrameScheduler::deferDeletion once the frames that used them finished -- no vkDeviceWaitIdle.
+// The depth buffer is sized by the swapchain too, so it is made and retired along with it; one serves all images.
+class SwapchainManager{
+public:
+	SwapchainManager(
+		VkPhysicalDevice physicalDevice,
+		VkDevice device,
+		VkSurfaceKHR surface,
+		PlatformWindow window,
+		VkSurfaceFormatKHR surfaceFormat,
+		VkRenderPass renderPass,
+		VkFormat depthFormat, // of the render pass; VK_FORMAT_UNDEFINED if it has no depth
+		uint32_t graphicsQueueFamily,
+		uint32_t presentQueueFamily,
+		FrameScheduler& scheduler
+	);
+	~SwapchainManager(); // the GPU must be done with the swapchain already, e.g. after vkDeviceWaitIdle
+	SwapchainManager( const SwapchainManager& ) = delete;
+	SwapchainManager& operator=( const SwapchainManager& ) = delete;
+
+	// for the window size event; returns whether the window has a size that can be presented to at all
+	bool onResize();
+
+	// Recreates the swapchain if it was marked, at most once; call it before beginning a frame.
+	// Returns false when there is nothing to render to (e.g. minimized window); skip the frame then.
+	bool prepareFrame();
+
+	// both mark the swapchain for recreation by the next prepareFrame when they report anything but optimal
+	SwapchainStatus acquire( VkSemaphore imageReadyS, uint32_t& imageIndex );
+	SwapchainStatus present( VkQueue queue, uint32_t imageIndex ); // waits for getRenderDoneSemaphore( imageIndex )
+
+	VkSwapchainKHR get() const{ return m_swapchain; }
+	VkExtent2D getExtent() const{ return m_extent; }
+	VkFramebuffer getFramebuffer( uint32_t imageIndex ) const{ return m_framebuffers[imageIndex]; }
+	// one per image, not per frame -- https://github.com/KhronosGroup/Vulkan-Docs/issues/1150
+	VkSemaphore getRenderDoneSemaphore( uint32_t imageIndex ) const{ return m_renderDoneSs[imageIndex]; }
+
+	uint64_t getRecreationCount() const{ return m_recreationCount; }
+
+private:
+	enum class State{
+		valid,
+		stale, // still presentable; recreated once no size event came for VulkanConfig::swapchainResizeSettleTime
+		outOfDate // not presentable (or not created yet); recreated by the next prepareFrame
+	};
+
+	void recreate();
+	void retire(); // hands the current swapchain and its resources over to deferred deletion
+
+	VkPhysicalDevice m_physicalDevice;
+	VkDevice m_device;
+	VkSurfaceKHR m_surface;
+	PlatformWindow m_window;
+	VkSurfaceFormatKHR m_surfaceFormat;
+	VkRenderPass m_renderPass;
+	VkFormat m_depthFormat;
+	VkPhysicalDeviceMemoryProperties m_memoryProperties;
+	uint32_t m_graphicsQueueFamily;
+	uint32_t m_presentQueueFamily;
+	FrameScheduler& m_scheduler;
+
+	VkSwapchainKHR m_swapchain = VK_NULL_HANDLE;
+	VkExtent2D m_extent = {0, 0};
+	std::vector<VkImageView> m_imageViews;
+	MemoryAllocation m_depthMemory = {};
+	VkImage m_depthImage = VK_NULL_HANDLE;
+	VkImageView m_depthView = VK_NULL_HANDLE;
+	std::vector<VkFramebuffer> m_framebuffers;
+	std::vector<VkSemaphore> m_renderDoneSs;
+
+	State m_state = State::outOfDate; // nothing is created until the first prepareFrame
+	std::chrono::steady_clock::time_point m_lastResize;
+	uint64_t m_recreationCount = 0;
+};
+
+#endif //COMMON_SWAPCHAIN_MANAGER_H
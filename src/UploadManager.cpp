@@ -0,0 +1,226 @@
+// Streams data into DEVICE_LOCAL buffers: a persistently mapped staging ring + batched vkCmdCopyBuffer
+// on a dedicated transfer queue, if the device has one
+#include "VulkanEnvironment.h"
+
+#include "UploadManager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream> // VulkanImpl.h relies on the includer for these
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "ErrorHandling.h"
+#include "VulkanImpl.h"
+
+// Implementation
+//////////////////////////////////
+
+// not required by vkCmdCopyBuffer, but keeps the source offsets friendly to the DMA engines
+static constexpr VkDeviceSize copyAlignment = 256;
+
+static uint64_t alignUp( const uint64_t value, const uint64_t alignment ){
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+UploadManager::UploadManager(
+	const VkDevice device,
+	const VkPhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties,
+	const uint32_t transferQueueFamily,
+	const VkQueue transferQueue,
+	const uint32_t graphicsQueueFamily,
+	const VkDeviceSize ringSize
+)
+: m_device( device ), m_queue( transferQueue ), m_ringSize(  alignUp( std::max<VkDeviceSize>( ringSize, copyAlignment ), copyAlignment )  )
+{
+	m_queueFamilies.push_back( transferQueueFamily );
+	if( graphicsQueueFamily != transferQueueFamily ) m_queueFamilies.push_back( graphicsQueueFamily );
+
+	m_commandPool = initCommandPool( device, transferQueueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT );
+	m_timeline = initTimelineSemaphore( device );
+
+	m_stagingBuffer = initBuffer( device, m_ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT );
+	m_stagingMemory = initMemory<ResourceType::Buffer>(
+		device,
+		physicalDeviceMemoryProperties,
+		m_stagingBuffer,
+		{VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT} // coherent, so no flushes; host writes become visible on vkQueueSubmit
+	);
+	m_staging = static_cast<unsigned char*>( mapMemory( device, m_stagingMemory ) );
+}
+
+UploadManager::~UploadManager(){
+	try{
+		waitIdle();
+	}
+	catch( ... ){
+		logger << "WARNING: Failed to wait for uploads to finish while destroying the upload manager" << std::endl;
+	}
+
+	killSemaphore( m_device, m_timeline );
+	killCommandPool( m_device, m_commandPool ); // frees the command buffers too
+
+	killBuffer( m_device, m_stagingBuffer );
+	killMemory( m_device, m_stagingMemory );
+}
+
+void UploadManager::uploadBuffer( const VkBuffer dst, VkDeviceSize dstOffset, const void* const data, VkDeviceSize size ){
+	// the regions of one vkCmdCopyBuffer must not overlap, so rewriting the same bytes takes another batch
+	if(  overlapsPending( dst, dstOffset, size )  ) flush();
+
+	const unsigned char* src = static_cast<const unsigned char*>( data );
+	while( size > 0 ){
+		const VkDeviceSize pieceSize = std::min( size, m_ringSize );
+		const uint64_t position = reserve( pieceSize );
+		const VkDeviceSize srcOffset = position % m_ringSize;
+
+		std::memcpy( m_staging + srcOffset, src, pieceSize );
+		m_pending.push_back( {dst, {srcOffset, dstOffset, pieceSize}} );
+
+		src += pieceSize;
+		dstOffset += pieceSize;
+		size -= pieceSize;
+		m_statistics.bytesUploaded += pieceSize;
+	}
+}
+
+UploadManager::Ticket UploadManager::flush(){
+	if( m_pending.empty() ) return m_lastTicket;
+
+	Batch batch = acquireBatch();
+	batch.ticket = ++m_lastTicket;
+	batch.ringEnd = m_head;
+
+	beginCommandBuffer( batch.commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT );
+
+	// orders our copies after the copies of previous batches, in case they write the same bytes
+	const VkMemoryBarrier writeAfterWrite{
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		nullptr, // pNext
+		VK_ACCESS_TRANSFER_WRITE_BIT, // srcAccessMask
+		VK_ACCESS_TRANSFER_WRITE_BIT // dstAccessMask
+	};
+	vkCmdPipelineBarrier(
+		batch.commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, // srcStageMask
+		VK_PIPELINE_STAGE_TRANSFER_BIT, // dstStageMask
+		0, // dependencyFlags
+		1, &writeAfterWrite, // memory barriers
+		0, nullptr, // buffer barriers
+		0, nullptr // image barriers
+	);
+
+	// one vkCmdCopyBuffer per destination
+	std::stable_sort(  m_pending.begin(), m_pending.end(), []( const PendingCopy& l, const PendingCopy& r ){ return l.dst < r.dst; }  );
+	std::vector<VkBufferCopy> regions;
+	for( size_t i = 0; i < m_pending.size(); ){
+		const VkBuffer dst = m_pending[i].dst;
+		regions.clear();
+		for( ; i < m_pending.size() && m_pending[i].dst == dst; ++i ) regions.push_back( m_pending[i].region );
+
+		vkCmdCopyBuffer( batch.commandBuffer, m_stagingBuffer, dst, static_cast<uint32_t>( regions.size() ), regions.data() );
+	}
+
+	endCommandBuffer( batch.commandBuffer );
+
+	const VkTimelineSemaphoreSubmitInfoKHR timelineInfo{
+		VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+		nullptr, // pNext
+		0, nullptr, // wait values
+		1, &batch.ticket // signal values
+	};
+
+	const VkSubmitInfo submit{
+		VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		&timelineInfo, // pNext
+		0, nullptr, // wait semaphores
+		nullptr, // pipeline stages to wait for semaphore
+		1, &batch.commandBuffer,
+		1, &m_timeline // signal semaphores
+	};
+
+	{VkResult errorCode = vkQueueSubmit( m_queue, 1 /*submit count*/, &submit, VK_NULL_HANDLE ); RESULT_HANDLER( errorCode, "vkQueueSubmit" );}
+
+	m_statistics.copyCount += m_pending.size();
+	++m_statistics.batchCount;
+	m_pending.clear();
+
+	m_inFlight.push_back( batch );
+	return batch.ticket;
+}
+
+bool UploadManager::isComplete( const Ticket ticket ){
+	retireCompleted();
+	return ticket <= m_completedTicket;
+}
+
+void UploadManager::wait( const Ticket ticket ){
+	if( ticket > m_lastTicket ) throw "Waiting for an upload ticket that was not flushed yet!";
+	while( ticket > m_completedTicket ) retireOldest();
+}
+
+void UploadManager::waitIdle(){
+	wait( flush() );
+}
+
+uint64_t UploadManager::reserve( const VkDeviceSize size ){
+	for(;;){
+		retireCompleted();
+
+		// everything is free; start over at the beginning of the ring, so the whole capacity is available
+		if( m_inFlight.empty() && m_pending.empty() ) m_head = m_tail = alignUp( m_head, m_ringSize );
+
+		uint64_t begin = alignUp( m_head, copyAlignment );
+		if( begin % m_ringSize + size > m_ringSize ) begin = alignUp( begin, m_ringSize ); // would wrap around; skip the rest of the ring
+
+		if( begin + size - m_tail <= m_ringSize ){
+			m_head = begin + size;
+			return begin;
+		}
+
+		++m_statistics.ringStalls;
+		if( !m_pending.empty() ) flush(); // the space is held by copies that were not even submitted yet
+		retireOldest();
+	}
+}
+
+bool UploadManager::overlapsPending( const VkBuffer dst, const VkDeviceSize dstOffset, const VkDeviceSize size ) const{
+	return std::any_of(  m_pending.begin(), m_pending.end(), [=]( const PendingCopy& p ){
+		return p.dst == dst && dstOffset < p.region.dstOffset + p.region.size && p.region.dstOffset < dstOffset + size;
+	}  );
+}
+
+UploadManager::Batch UploadManager::acquireBatch(){
+	if( !m_idleBatches.empty() ){
+		const Batch batch = m_idleBatches.back();
+		m_idleBatches.pop_back();
+		return batch;
+	}
+
+	std::vector<VkCommandBuffer> commandBuffer;
+	acquireCommandBuffers( m_device, m_commandPool, 1, commandBuffer );
+
+	return { commandBuffer[0], 0, 0 };
+}
+
+void UploadManager::retireCompleted(){
+	if( m_inFlight.empty() ) return;
+
+	const Ticket completed = getSemaphoreCounterValue( m_device, m_timeline );
+	while( !m_inFlight.empty() && m_inFlight.front().ticket <= completed ) retireOldest(); // does not block now
+}
+
+void UploadManager::retireOldest(){
+	if( m_inFlight.empty() ) return;
+
+	const Batch batch = m_inFlight.front();
+	waitSemaphore( m_device, m_timeline, batch.ticket );
+
+	m_tail = batch.ringEnd;
+	m_completedTicket = batch.ticket;
+
+	m_inFlight.pop_front();
+	m_idleBatches.push_back( batch );
+}
@@ -0,0 +1,102 @@
+// Streams data into DEVICE_LOCAL buffers: a persistently mapped staging ring + batched vkCmdCopyBuffer
+// on a dedicated transfer queue, if the device has one
+
+#ifndef COMMON_UPLOAD_MANAGER_H
+#define COMMON_UPLOAD_MANAGER_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "MemoryAllocator.h"
+#include "VulkanConfig.h"
+
+
+struct UploadStatistics{
+	uint64_t bytesUploaded;
+	uint64_t copyCount; // VkBufferCopy regions
+	uint64_t batchCount; // vkQueueSubmit calls
+	uint64_t ringStalls; // times an upload had to wait for the GPU to free staging space
+};
+
+// Not thread-safe; owns the transfer queue for the time being.
+// Destination buffers must be created with VK_BUFFER_USAGE_TRANSFER_DST_BIT and shared by getQueueFamilies()
+// (see the initBuffer overload), so no queue family ownership transfer is needed.
+// A destination may be used by other queues once the ticket of its batch isComplete() (a wait on host), or by a submission
+// that waits for getTimelineSemaphore() to reach the ticket (e.g. FrameScheduler::waitForTimeline).
+class UploadManager{
+public:
+	using Ticket = uint64_t; // identifies a flushed batch; the value its batch signals on the timeline semaphore
+
+	UploadManager(
+		VkDevice device,
+		const VkPhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties,
+		uint32_t transferQueueFamily,
+		VkQueue transferQueue,
+		uint32_t graphicsQueueFamily,
+		VkDeviceSize ringSize = VulkanConfig::stagingRingSize
+	);
+	~UploadManager(); // waits for all in-flight batches
+	UploadManager( const UploadManager& ) = delete;
+	UploadManager& operator=( const UploadManager& ) = delete;
+
+	const std::vector<uint32_t>& getQueueFamilies() const{ return m_queueFamilies; }
+	bool isDedicatedTransferQueue() const{ return m_queueFamilies.size() > 1; }
+	VkSemaphore getTimelineSemaphore() const{ return m_timeline; }
+
+	// data is copied into the staging ring right away, so it can be discarded after the call;
+	// the GPU copy is recorded by the next flush(); data larger than the ring is split up
+	void uploadBuffer( VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size );
+
+	// submits everything uploaded so far as one batch; if nothing is pending returns the ticket of the last batch
+	Ticket flush();
+
+	bool isComplete( Ticket ticket ); // also recycles staging space of finished batches
+	void wait( Ticket ticket );
+	void waitIdle(); // flushes too
+
+	UploadStatistics getStatistics() const{ return m_statistics; }
+
+private:
+	struct Batch{
+		VkCommandBuffer commandBuffer;
+		Ticket ticket;
+		uint64_t ringEnd; // staging bytes up to here are free once the batch completes
+	};
+
+	struct PendingCopy{
+		VkBuffer dst;
+		VkBufferCopy region;
+	};
+
+	uint64_t reserve( VkDeviceSize size ); // returns unwrapped ring position
+	bool overlapsPending( VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize size ) const;
+	Batch acquireBatch();
+	void retireCompleted();
+	void retireOldest(); // blocks
+
+	VkDevice m_device;
+	VkQueue m_queue;
+	std::vector<uint32_t> m_queueFamilies;
+	VkCommandPool m_commandPool;
+	VkSemaphore m_timeline; // counts finished batches
+
+	VkBuffer m_stagingBuffer;
+	MemoryAllocation m_stagingMemory;
+	unsigned char* m_staging;
+	VkDeviceSize m_ringSize;
+	uint64_t m_head = 0; // both grow monotonically; the ring offset is position % m_ringSize
+	uint64_t m_tail = 0;
+
+	std::vector<PendingCopy> m_pending;
+	std::deque<Batch> m_inFlight;
+	std::vector<Batch> m_idleBatches; // command buffers for reuse
+	Ticket m_lastTicket = 0;
+	Ticket m_completedTicket = 0;
+
+	UploadStatistics m_statistics = {};
+};
+
+#endif //COMMON_UPLOAD_MANAGER_H
@@ -3,6 +3,10 @@
 #ifndef COMMON_VERTEX_H
 #define COMMON_VERTEX_H
 
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
 struct Vertex2D{
 	float position[2];
 };
@@ -16,4 +20,65 @@ struct Vertex2D_ColorF_pack{
 	ColorF color;
 };
 
+// the RGB triangle of the demo and of the benchmarks that draw it
+inline std::vector<Vertex2D_ColorF_pack> makeTriangle(){
+	const float triangleSize = 1.6f;
+	return {
+		{ /*rb*/ { { 0.5f * triangleSize,  sqrtf( 3.0f ) * 0.25f * triangleSize} }, /*R*/{ {1.0f, 0.0f, 0.0f} }  },
+		{ /* t*/ { {                0.0f, -sqrtf( 3.0f ) * 0.25f * triangleSize} }, /*G*/{ {0.0f, 1.0f, 0.0f} }  },
+		{ /*lb*/ { {-0.5f * triangleSize,  sqrtf( 3.0f ) * 0.25f * triangleSize} }, /*B*/{ {0.0f, 0.0f, 1.0f} }  }
+	};
+}
+
+// Which of the above a pipeline reads; see initPipeline
+enum class VertexFormat{
+	Vertex2D_ColorF, // Vertex2D_ColorF_pack; 20 bytes
+	Chunk // ChunkVertex; 8 bytes
+};
+
+// One corner of a meshed voxel face, packed into two words and unpacked by shaders/chunk.vert.
+// Four per quad, counter-clockwise seen from outside of the face.
+// Positions are relative to the chunk origin, which comes per draw in ChunkPushConstants.
+struct ChunkVertex{
+	// bits 0-5 x, 6-11 y, 12-17 z (0 to Chunk::size inclusive), 18-20 face the vertex belongs to
+	// (0 = +X, 1 = -X, 2 = +Y, 3 = -Y, 4 = +Z, 5 = -Z), 21-22 ambient occlusion (0 darkest, 3 unoccluded)
+	uint32_t position;
+	// bits 0-15 texture layer, 16-21 u, 22-27 v; u and v are in voxels from the quad corner,
+	// so a texture repeats once per voxel across merged faces
+	uint32_t material;
+
+	static constexpr uint32_t positionBits = 6;
+	static constexpr uint32_t positionMask = (1u << positionBits) - 1;
+	static constexpr uint32_t faceShift = 3 * positionBits;
+	static constexpr uint32_t aoShift = faceShift + 3;
+	static constexpr uint32_t aoUnoccluded = 3;
+	static constexpr uint32_t layerMask = 0xFFFF;
+	static constexpr uint32_t uShift = 16;
+	static constexpr uint32_t vShift = uShift + positionBits;
+
+	static ChunkVertex pack( const uint32_t x, const uint32_t y, const uint32_t z, const uint32_t face, const uint32_t ao, const uint32_t layer, const uint32_t u, const uint32_t v ){
+		return {
+			x | (y << positionBits) | (z << 2 * positionBits) | (face << faceShift) | (ao << aoShift),
+			layer | (u << uShift) | (v << vShift)
+		};
+	}
+
+	uint32_t getX() const{ return position & positionMask; }
+	uint32_t getY() const{ return (position >> positionBits) & positionMask; }
+	uint32_t getZ() const{ return (position >> 2 * positionBits) & positionMask; }
+	uint32_t getFace() const{ return (position >> faceShift) & 0x7; }
+	uint32_t getAo() const{ return (position >> aoShift) & 0x3; }
+	uint32_t getLayer() const{ return material & layerMask; }
+	uint32_t getU() const{ return (material >> uShift) & positionMask; }
+	uint32_t getV() const{ return (material >> vShift) & positionMask; }
+};
+static_assert( sizeof( ChunkVertex ) == 8, "ChunkVertex is meant to be tightly packed" );
+
+// Vertex stage push constants of shaders/chunk.vert; std430 layout
+struct ChunkPushConstants{
+	float viewProjection[16]; // column-major, like GLSL; the same for all chunks of a frame
+	float chunkOrigin[4]; // xyz: position of the chunk's (0, 0, 0) corner; per draw
+};
+static_assert( sizeof( ChunkPushConstants ) <= 128, "Vulkan only guarantees 128 bytes of push constants" );
+
 #endif //COMMON_VERTEX_H
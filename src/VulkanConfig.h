@@ -35,13 +35,94 @@ namespace VulkanConfig
 // window and swapchain
 	constexpr uint32_t initialWindowWidth = 800;
 	constexpr uint32_t initialWindowHeight = 800;
+	constexpr double swapchainResizeSettleTime = 0.1; // seconds without size events before a still presentable swapchain is recreated
+
+// frame pacing on a timeline semaphore (FrameScheduler); --frames-in-flight overrides it
+	constexpr uint32_t framesInFlight = 2; // frames the CPU may record ahead of the GPU; more adds latency, fewer adds stalls
+	constexpr uint32_t maxFramesInFlight = 16;
+
+// headless WSI (USE_PLATFORM_NONE) has no close button; it paints this many frames and quits
+	constexpr uint64_t headlessFrameCount = 1000;
+
+// offscreen benchmark (--offscreen)
+	constexpr VkFormat offscreenFormat = VK_FORMAT_R8G8B8A8_UNORM; // color attachment + transfer src support is mandatory for it
+	constexpr uint32_t offscreenTexelSize = 4; // bytes per texel of offscreenFormat
+	constexpr uint32_t readbackRingSize = 3; // default frames in flight; the oldest one's readback is consumed before its slot is reused
+	constexpr uint64_t benchmarkFrameCount = 1000;
+
+// job system (JobSystem); its thread count is --threads
+	constexpr bool mainThreadRunsJobs = true; // false keeps the main thread free of jobs, it then only waits for them
+
+// command recording on multiple threads (ParallelRecorder) and its benchmark (--record-benchmark)
+	constexpr size_t minDrawsPerRecordingThread = 256; // smaller draw lists use fewer slices, so fewer threads
+	constexpr uint64_t recordBenchmarkDrawCount = 20000;
+	constexpr uint64_t recordBenchmarkFrameCount = 200; // per thread count
+
+// chunk meshing benchmark (--mesh-benchmark); needs no GPU
+	constexpr uint64_t meshBenchmarkChunkCount = 2048; // chunks meshed per test terrain
+
+// procedural world generation (WorldGenerator) and its benchmark (--gen-benchmark); needs no GPU
+	constexpr uint32_t worldSeed = 1337;
+	constexpr uint64_t genBenchmarkChunkCount = 1024; // chunks generated per SIMD path
+
+// chunk streaming around the camera (ChunkStreamer) and its benchmark (--stream-benchmark); needs no GPU
+	constexpr int32_t viewDistance = 8; // chunks, horizontally
+	constexpr int32_t verticalViewDistance = 3; // chunks, up and down
+	constexpr uint32_t maxChunkUploadsPerFrame = 16;
+	constexpr uint64_t streamBenchmarkFrameCount = 600; // at 60 Hz
+	constexpr float streamBenchmarkSpeed = 64.0f; // camera speed in voxels per second
+	constexpr uint64_t streamBenchmarkExplosionInterval = 30; // frames between the craters blasted ahead of the camera
+	constexpr int32_t streamBenchmarkExplosionRadius = 6; // voxels
+
+// chunk residency under a memory budget (ChunkResidency); --chunk-budget overrides the budget
+	constexpr size_t chunkMemoryBudget = 32 * 1024 * 1024; // bytes of chunk voxels, loaded, cached and compressed
+	constexpr int32_t prefetchDistance = 2; // chunks of travel ahead whose view is loaded in advance
+	constexpr uint32_t maxPrefetchJobs = 8; // in flight
+
+// frustum culling of chunk boxes (ChunkCuller) and its benchmark (--cull-benchmark); needs no GPU
+	constexpr float fieldOfView = 1.2f; // vertical, radians
+	constexpr float nearPlane = 0.1f; // voxels; the far plane is at infinity
+	constexpr int32_t cullBenchmarkViewDistance = 40; // chunks, horizontally: 81 x 81 columns, about 105k chunks
+	constexpr int32_t cullBenchmarkHeight = 16; // chunk sections per column
+	constexpr uint64_t cullBenchmarkFrameCount = 360; // the camera turns by a degree per frame
+
+// GPU-driven culling and drawing of chunks (IndirectChunkRenderer) and its benchmark (--indirect-benchmark)
+	constexpr int32_t indirectBenchmarkViewDistance = 48; // chunks, horizontally: 97 x 97 columns of 2 meshed chunks
+	constexpr uint64_t indirectBenchmarkFrameCount = 360; // the camera turns by a degree per frame
+
+// two-phase occlusion culling of chunks against a Hi-Z pyramid (HiZPyramid) and its benchmark (--occlusion-benchmark)
+	constexpr int32_t occlusionBenchmarkViewDistance = 32; // chunks, horizontally: 65 x 65 columns of 4 chunks of caves
+	constexpr float occlusionBenchmarkEyeHeight = 62.0f; // voxels; the ground of the cave terrain is at 56
+	constexpr uint64_t occlusionBenchmarkFrameCount = 360; // the camera turns by a degree per frame
+
+// saved chunks in region files (WorldStorage) and their benchmark (--storage-benchmark); needs no GPU
+	const char storageBenchmarkDirectory[] = "storage_benchmark"; // made and emptied again by the benchmark
+	constexpr uint64_t storageBenchmarkChunkCount = 4096; // chunks saved and loaded back
 	
 //constexpr VkPresentModeKHR presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR; // better not be used often because of coil whine
 	constexpr VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
 //constexpr VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
 	
+// device memory sub-allocator
+	constexpr VkDeviceSize memoryBlockSize = 64 * 1024 * 1024; // per vkAllocateMemory; shrinks for small heaps
+	constexpr VkDeviceSize memoryMinAllocationSize = 256; // smallest buddy block
+	constexpr VkDeviceSize dedicatedImageThreshold = 16 * 1024 * 1024; // images at least this big get their own (dedicated) allocation
+
+// uploads into DEVICE_LOCAL memory
+	constexpr VkDeviceSize stagingRingSize = 16 * 1024 * 1024; // persistently mapped; uploads wait for the GPU when it is full
+
+// pipeline cache; a path relative to the working directory
+	const char pipelineCachePath[] = "pipeline_cache.bin";
+	constexpr double pipelineCacheSaveInterval = 60.0; // seconds; besides the save at exit, in case the app crashes
+
 // pipeline settings
 	constexpr VkClearValue clearColor = {  { {0.1f, 0.1f, 0.1f, 1.0f} }  };
+
+// depth buffer, reversed-Z: the near plane maps to depth 1 and infinity to 0 (see makeReversedZPerspective), so the float
+// exponent spends its precision on the far distances instead of right in front of the camera
+	constexpr VkFormat depthFormats[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT }; // in order of preference
+	constexpr float depthClearValue = 0.0f; // far
+	constexpr VkCompareOp depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL; // nearer is greater
 	
 // Makes present queue from different Queue Family than Graphics, for testing purposes
 	constexpr bool forceSeparatePresentQueue = false;
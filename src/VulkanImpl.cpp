@@ -1,5 +1,7 @@
 #include "VulkanEnvironment.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <vector>
 
@@ -90,6 +92,17 @@ bool checkDeviceExtensionSupport( const VkPhysicalDevice physDevice, const vecto
 	return checkExtensionSupport(  extensions, getSupportedDeviceExtensions( physDevice, providingLayers )  );
 }
 
+bool enableOptionalDeviceExtensions( const VkPhysicalDevice physDevice, const vector<const char*>& providingLayers, const vector<const char*>& group, vector<const char*>& extensions ){
+	const auto supportedExtensions = getSupportedDeviceExtensions( physDevice, providingLayers );
+
+	for( const auto extension : group ){
+		if(  !isExtensionSupported( extension, supportedExtensions )  ) return false;
+	}
+
+	extensions.insert( extensions.end(), group.begin(), group.end() );
+	return true;
+}
+
 VkInstance initInstance( const vector<const char*>& layers, const vector<const char*>& extensions ){
 	const VkApplicationInfo appInfo = {
 		VK_STRUCTURE_TYPE_APPLICATION_INFO,
@@ -164,15 +177,9 @@ void killInstance( const VkInstance instance ){
 
 void cleanupVulkan(VkDevice device,
     VkInstance instance,
-    vector<VkSemaphore>& renderSs,
     VkPipeline pipeline,
-    vector<VkFramebuffer>& framebuffers,
-    vector<VkImageView>& imageViews,
-    VkSwapchainKHR swapchain,
     vector<VkSemaphore>& imageSs,
-    vector<VkFence>& fences,
-    VkCommandPool commandPool,
-    VkDeviceMemory vertexBufferMemory,
+    const MemoryAllocation& vertexBufferMemory,
     VkBuffer vertexBuffer,
     VkPipelineLayout pipelineLayout,
     VkShaderModule fragmentShader,
@@ -181,16 +188,10 @@ void cleanupVulkan(VkDevice device,
     VkSurfaceKHR surface,
     PlatformWindow window
 ){
-  killSemaphores(device, renderSs);
   killPipeline(device, pipeline);
-  killFramebuffers(device, framebuffers);
-  killSwapchainImageViews(device, imageViews);
-  killSwapchain(device, swapchain);
   killSemaphores(device, imageSs);
-  killFences(device, fences);
-  killCommandPool(device, commandPool);
-  killMemory(device, vertexBufferMemory);
   killBuffer(device, vertexBuffer);
+  killMemory(device, vertexBufferMemory);
   killPipelineLayout(device, pipelineLayout);
   killShaderModule(device, fragmentShader);
   killShaderModule(device, vertexShader);
@@ -326,11 +327,42 @@ std::pair<uint32_t, uint32_t> getQueueFamilies( const VkPhysicalDevice physDevic
 	return std::make_pair( graphicsQueueFamily, presentQueueFamily );
 }
 
+uint32_t getGraphicsQueueFamily( const VkPhysicalDevice physDevice ){
+	const auto qfps = getQueueFamilyProperties( physDevice );
+	for( uint32_t qf = 0; qf < qfps.size(); ++qf ){
+		if( qfps[qf].queueFlags & VK_QUEUE_GRAPHICS_BIT ) return qf;
+	}
+
+	throw "Cannot find a graphics queue family!";
+}
+
+uint32_t getTransferQueueFamily( const VkPhysicalDevice physDevice, const uint32_t fallbackQueueFamily ){
+	const auto qfps = getQueueFamilyProperties( physDevice );
+
+	// graphics and compute families implicitly support transfer too
+	const auto canTransfer = []( const VkQueueFlags flags ){
+		return flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+	};
+
+	for( uint32_t qf = 0; qf < qfps.size(); ++qf ){
+		const VkQueueFlags flags = qfps[qf].queueFlags;
+		if( (flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) ) return qf;
+	}
+
+	for( uint32_t qf = 0; qf < qfps.size(); ++qf ){
+		const VkQueueFlags flags = qfps[qf].queueFlags;
+		if( canTransfer( flags ) && !(flags & VK_QUEUE_GRAPHICS_BIT) && qf != fallbackQueueFamily ) return qf;
+	}
+
+	return fallbackQueueFamily;
+}
+
 VkDevice initDevice(
 	const VkPhysicalDevice physDevice,
 	const VkPhysicalDeviceFeatures& features,
 	const uint32_t graphicsQueueFamily,
 	const uint32_t presentQueueFamily,
+	const uint32_t transferQueueFamily,
 	const vector<const char*>& layers,
 	const vector<const char*>& extensions
 ){
@@ -360,9 +392,28 @@ VkDevice initDevice(
 		});
 	}
 
+	if( transferQueueFamily != graphicsQueueFamily && transferQueueFamily != presentQueueFamily ){
+		queues.push_back({
+			VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+			nullptr, // pNext
+			0, // flags
+			transferQueueFamily,
+			1, // queue count
+			priority
+		});
+	}
+
+	// the extension alone does not turn the feature on
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures{
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR,
+		nullptr, // pNext
+		VK_TRUE // timelineSemaphore
+	};
+	const bool timelineSemaphore = std::any_of(  extensions.begin(), extensions.end(), []( const char* e ){ return std::strcmp( e, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME ) == 0; }  );
+
 	const VkDeviceCreateInfo deviceInfo{
 		VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-		nullptr, // pNext
+		timelineSemaphore ? &timelineSemaphoreFeatures : nullptr, // pNext
 		0, // flags
 		static_cast<uint32_t>( queues.size() ),
 		queues.data(),
@@ -383,6 +434,7 @@ VkDevice initDevice(
 }
 
 void killDevice( const VkDevice device ){
+	killMemoryAllocator( device );
 	unloadDeviceExtensionsCommands( device );
 
 	vkDestroyDevice( device, nullptr );
@@ -469,15 +521,17 @@ VkQueue getQueue( const VkDevice device, const uint32_t queueFamily, const uint3
 //	return memory;
 //}
 
-void setMemoryData( VkDevice device, VkDeviceMemory memory, void* begin, size_t size ){
-	void* data;
-	VkResult errorCode = vkMapMemory( device, memory, 0 /*offset*/, VK_WHOLE_SIZE, 0 /*flags - reserved*/, &data ); RESULT_HANDLER( errorCode, "vkMapMemory" );
-	memcpy( data, begin, size );
-	vkUnmapMemory( device, memory );
+void setMemoryData( VkDevice device, const MemoryAllocation& memory, void* begin, size_t size ){
+	memcpy( mapMemory( device, memory ), begin, size );
+}
+
+void* mapMemory( VkDevice, const MemoryAllocation& memory ){
+	if( !memory.mapped ) throw "Mapping memory allocation that is not HOST_VISIBLE!";
+	return memory.mapped;
 }
 
-void killMemory( VkDevice device, VkDeviceMemory memory ){
-	vkFreeMemory( device, memory, nullptr );
+void killMemory( VkDevice device, const MemoryAllocation& memory ){
+	freeMemory( device, memory );
 }
 
 
@@ -498,11 +552,34 @@ VkBuffer initBuffer( VkDevice device, VkDeviceSize size, VkBufferUsageFlags usag
 	return buffer;
 }
 
+VkBuffer initBuffer( VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, const vector<uint32_t>& queueFamilies ){
+	vector<uint32_t> uniqueFamilies = queueFamilies;
+	std::sort( uniqueFamilies.begin(), uniqueFamilies.end() );
+	uniqueFamilies.erase(  std::unique( uniqueFamilies.begin(), uniqueFamilies.end() ), uniqueFamilies.end()  );
+
+	if( uniqueFamilies.size() < 2 ) return initBuffer( device, size, usage );
+
+	VkBufferCreateInfo bufferInfo{
+		VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		nullptr, // pNext
+		0, // flags
+		size,
+		usage,
+		VK_SHARING_MODE_CONCURRENT,
+		static_cast<uint32_t>( uniqueFamilies.size() ),
+		uniqueFamilies.data()
+	};
+
+	VkBuffer buffer;
+	VkResult errorCode = vkCreateBuffer( device, &bufferInfo, nullptr, &buffer ); RESULT_HANDLER( errorCode, "vkCreateBuffer" );
+	return buffer;
+}
+
 void killBuffer( VkDevice device, VkBuffer buffer ){
 	vkDestroyBuffer( device, buffer, nullptr );
 }
 
-VkImage initImage( VkDevice device, VkFormat format, uint32_t width, uint32_t height, VkSampleCountFlagBits samples, VkImageUsageFlags usage ){
+VkImage initImage( VkDevice device, VkFormat format, uint32_t width, uint32_t height, VkSampleCountFlagBits samples, VkImageUsageFlags usage, const uint32_t mipLevels ){
 	VkExtent3D size{
 		width,
 		height,
@@ -516,7 +593,7 @@ VkImage initImage( VkDevice device, VkFormat format, uint32_t width, uint32_t he
 		VK_IMAGE_TYPE_2D,
 		format,
 		size,
-		1, // mipLevels
+		mipLevels,
 		1, // arrayLayers
 		samples,
 		VK_IMAGE_TILING_OPTIMAL,
@@ -537,7 +614,14 @@ void killImage( VkDevice device, VkImage image ){
 	vkDestroyImage( device, image, nullptr );
 }
 
-VkImageView initImageView( VkDevice device, VkImage image, VkFormat format ){
+VkImageView initImageView(
+	VkDevice device,
+	VkImage image,
+	VkFormat format,
+	const VkImageAspectFlags aspect,
+	const uint32_t baseMipLevel,
+	const uint32_t mipLevelCount
+){
 	VkImageViewCreateInfo iciv{
 		VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
 		nullptr, // pNext
@@ -547,9 +631,9 @@ VkImageView initImageView( VkDevice device, VkImage image, VkFormat format ){
 		format,
 		{ VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY },
 		{
-			VK_IMAGE_ASPECT_COLOR_BIT,
-			0, // base mip-level
-			VK_REMAINING_MIP_LEVELS, // level count
+			aspect,
+			baseMipLevel,
+			mipLevelCount,
 			0, // base array layer
 			VK_REMAINING_ARRAY_LAYERS // array layer count
 		}
@@ -565,6 +649,46 @@ void killImageView( VkDevice device, VkImageView imageView ){
 	vkDestroyImageView( device, imageView, nullptr );
 }
 
+VkFormat getDepthFormat( VkPhysicalDevice physicalDevice, const VkFormatFeatureFlags features ){
+	const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | features;
+	for( const VkFormat format : VulkanConfig::depthFormats ){
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties( physicalDevice, format, &properties );
+		if( (properties.optimalTilingFeatures & required) == required ) return format;
+	}
+
+	throw "The device supports none of the float depth formats!";
+}
+
+DepthBuffer initDepthBuffer(
+	VkDevice device,
+	VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties,
+	VkFormat format,
+	uint32_t width, uint32_t height,
+	const bool sampled
+){
+	DepthBuffer depthBuffer;
+	const VkImageUsageFlags usage = sampled ? VK_IMAGE_USAGE_SAMPLED_BIT : VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+	depthBuffer.image = initImage( device, format, width, height, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | usage );
+
+	// tilers keep a transient attachment in tile memory and never back it; elsewhere it is plain device memory
+	std::vector<VkMemoryPropertyFlags> memoryTypePriority{
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+	};
+	if( sampled ) memoryTypePriority.erase( memoryTypePriority.begin() ); // lazily allocated memory is for transient images only
+	depthBuffer.memory = initMemory<ResourceType::Image>( device, physicalDeviceMemoryProperties, depthBuffer.image, memoryTypePriority );
+	depthBuffer.view = initImageView( device, depthBuffer.image, format, VK_IMAGE_ASPECT_DEPTH_BIT );
+
+	return depthBuffer;
+}
+
+void killDepthBuffer( VkDevice device, const DepthBuffer& depthBuffer ){
+	killImageView( device, depthBuffer.view );
+	killImage( device, depthBuffer.image );
+	killMemory( device, depthBuffer.memory );
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // initSurface is platform dependent
@@ -706,18 +830,19 @@ void killSwapchain( VkDevice device, VkSwapchainKHR swapchain ){
 	vkDestroySwapchainKHR( device, swapchain, nullptr );
 }
 
-uint32_t getNextImageIndex( VkDevice device, VkSwapchainKHR swapchain, VkSemaphore imageReadyS ){
-	uint32_t nextImageIndex;
-	VkResult errorCode = vkAcquireNextImageKHR(
+SwapchainStatus acquireNextImage( VkDevice device, VkSwapchainKHR swapchain, VkSemaphore imageReadyS, uint32_t& imageIndex ){
+	const VkResult errorCode = vkAcquireNextImageKHR(
 		device,
 		swapchain,
 		UINT64_MAX /* no timeout */,
 		imageReadyS,
 		VK_NULL_HANDLE,
-		&nextImageIndex
-	); RESULT_HANDLER( errorCode, "vkAcquireNextImageKHR" );
+		&imageIndex
+	);
+	if( errorCode == VK_ERROR_OUT_OF_DATE_KHR ) return SwapchainStatus::outOfDate; // an error code, but an expected one
+	RESULT_HANDLER( errorCode, "vkAcquireNextImageKHR" );
 
-	return nextImageIndex;
+	return errorCode == VK_SUBOPTIMAL_KHR ? SwapchainStatus::suboptimal : SwapchainStatus::optimal;
 }
 
 vector<VkImageView> initSwapchainImageViews( VkDevice device, vector<VkImage> images, VkFormat format ){
@@ -739,24 +864,60 @@ void killSwapchainImageViews( VkDevice device, vector<VkImageView>& imageViews )
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-VkRenderPass initRenderPass( VkDevice device, VkSurfaceFormatKHR surfaceFormat ){
+// one color attachment render pass, plus depth unless depthFormat is VK_FORMAT_UNDEFINED;
+// dst* describe who consumes the attachments after the render pass;
+// keepDepth stores depth and leaves it in DEPTH_STENCIL_READ_ONLY_OPTIMAL for compute shaders to sample;
+// load continues the attachments where a keepDepth pass with finalLayout COLOR_ATTACHMENT_OPTIMAL left them, instead of clearing
+static VkRenderPass initColorRenderPass(
+	VkDevice device,
+	VkFormat format,
+	VkFormat depthFormat,
+	VkImageLayout finalLayout,
+	VkPipelineStageFlags dstStageMask,
+	VkAccessFlags dstAccessMask,
+	bool keepDepth = false,
+	bool load = false
+){
+	const bool depth = depthFormat != VK_FORMAT_UNDEFINED;
+	keepDepth = keepDepth && depth;
+
 	VkAttachmentDescription colorAtachment{
 		0, // flags
-		surfaceFormat.format,
+		format,
 		VK_SAMPLE_COUNT_1_BIT,
-		VK_ATTACHMENT_LOAD_OP_CLEAR, // color + depth
+		load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR, // color + depth
 		VK_ATTACHMENT_STORE_OP_STORE, // color + depth
 		VK_ATTACHMENT_LOAD_OP_DONT_CARE, // stencil
 		VK_ATTACHMENT_STORE_OP_DONT_CARE, // stencil
-		VK_IMAGE_LAYOUT_UNDEFINED,
-		VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+		load ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+		finalLayout
+	};
+
+	// unless kept, nobody reads depth after the pass, so it is never written out -- tilers keep it in tile memory only
+	VkAttachmentDescription depthAttachment{
+		0, // flags
+		depthFormat,
+		VK_SAMPLE_COUNT_1_BIT,
+		load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR, // depth
+		keepDepth ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE, // depth
+		VK_ATTACHMENT_LOAD_OP_DONT_CARE, // stencil
+		VK_ATTACHMENT_STORE_OP_DONT_CARE, // stencil
+		load ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+		keepDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
 	};
 
+	VkAttachmentDescription attachments[] = {colorAtachment, depthAttachment};
+
 	VkAttachmentReference colorReference{
 		0, // attachment
 		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
 	};
 
+	VkAttachmentReference depthReference{
+		1, // attachment
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+	};
+
 	VkSubpassDescription subpass{
 		0, // flags - reserved for future use
 		VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -765,30 +926,34 @@ VkRenderPass initRenderPass( VkDevice device, VkSurfaceFormatKHR surfaceFormat )
 		1, // color attachment count
 		&colorReference, // color attachments
 		nullptr, // resolve attachments
-		nullptr, // depth stencil attachment
+		depth ? &depthReference : nullptr, // depth stencil attachment
 		0, // preserve attachment count
 		nullptr // preserve attachments
 	};
 
+	// with depth, it also orders the depth writes (and layout transition) of this frame after those of the frames before it,
+	// as all frames share one depth buffer; a loading pass also waits for the compute shaders sampling the kept depth
+	// (the dependency is then not by region, as compute is no framebuffer stage)
+	const VkPipelineStageFlags depthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 	VkSubpassDependency srcDependency{
 		VK_SUBPASS_EXTERNAL, // srcSubpass
 		0, // dstSubpass
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // srcStageMask
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // dstStageMask
-		0, // srcAccessMask
-		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // dstAccessMask
-		VK_DEPENDENCY_BY_REGION_BIT, // dependencyFlags
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | (depth ? depthStages : 0) | (load ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : 0), // srcStageMask
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | (depth ? depthStages : 0), // dstStageMask
+		(depth ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : 0) | (load ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0), // srcAccessMask
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (load ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0) | (depth ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : 0), // dstAccessMask
+		load ? 0u : VK_DEPENDENCY_BY_REGION_BIT, // dependencyFlags
 	};
 
-	// implicitly defined dependency would cover this, but let's replace it with this explicitly defined dependency!
+	// implicitly defined dependency would cover the present case, but let's replace it with this explicitly defined dependency!
 	VkSubpassDependency dstDependency{
 		0, // srcSubpass
 		VK_SUBPASS_EXTERNAL, // dstSubpass
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // srcStageMask
-		VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, // dstStageMask
-		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // srcAccessMask
-		0, // dstAccessMask
-		VK_DEPENDENCY_BY_REGION_BIT, // dependencyFlags
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | (keepDepth ? depthStages : 0), // srcStageMask
+		dstStageMask, // dstStageMask
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (keepDepth ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : 0), // srcAccessMask
+		dstAccessMask, // dstAccessMask
+		keepDepth ? 0u : VK_DEPENDENCY_BY_REGION_BIT, // dependencyFlags
 	};
 
 	VkSubpassDependency dependencies[] = {srcDependency, dstDependency};
@@ -797,8 +962,8 @@ VkRenderPass initRenderPass( VkDevice device, VkSurfaceFormatKHR surfaceFormat )
 		VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
 		nullptr, // pNext
 		0, // flags - reserved for future use
-		1, // attachment count
-		&colorAtachment, // attachments
+		depth ? 2u : 1u, // attachment count
+		attachments, // attachments
 		1, // subpass count
 		&subpass, // subpasses
 		2, // dependency count
@@ -811,6 +976,28 @@ VkRenderPass initRenderPass( VkDevice device, VkSurfaceFormatKHR surfaceFormat )
 	return renderPass;
 }
 
+VkRenderPass initRenderPass( VkDevice device, VkSurfaceFormatKHR surfaceFormat, VkFormat depthFormat ){
+	return initColorRenderPass( device, surfaceFormat.format, depthFormat, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0 );
+}
+
+VkRenderPass initOffscreenRenderPass( VkDevice device, VkFormat format, VkFormat depthFormat ){
+	return initColorRenderPass( device, format, depthFormat, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT );
+}
+
+VkRenderPass initEarlyRenderPass( VkDevice device, VkFormat format, VkFormat depthFormat ){
+	if( depthFormat == VK_FORMAT_UNDEFINED ) throw "The early render pass needs depth to keep!";
+
+	// consumed by the compute shaders sampling depth, and by the late pass continuing both attachments
+	const VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	const VkAccessFlags dstAccess = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	return initColorRenderPass( device, format, depthFormat, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, dstStages, dstAccess, true /*keepDepth*/ );
+}
+
+VkRenderPass initLateRenderPass( VkDevice device, VkFormat format, VkFormat depthFormat ){
+	if( depthFormat == VK_FORMAT_UNDEFINED ) throw "The late render pass needs the depth the early one kept!";
+	return initColorRenderPass( device, format, depthFormat, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, false /*keepDepth*/, true /*load*/ );
+}
+
 void killRenderPass( VkDevice device, VkRenderPass renderPass ){
 	vkDestroyRenderPass( device, renderPass, nullptr );
 }
@@ -819,18 +1006,21 @@ vector<VkFramebuffer> initFramebuffers(
 	VkDevice device,
 	VkRenderPass renderPass,
 	vector<VkImageView> imageViews,
-	uint32_t width, uint32_t height
+	uint32_t width, uint32_t height,
+	VkImageView depthView
 ){
 	vector<VkFramebuffer> framebuffers;
 
 	for( auto imageView : imageViews ){
+		const VkImageView attachments[] = {imageView, depthView};
+
 		VkFramebufferCreateInfo framebufferInfo{
 			VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
 			nullptr, // pNext
 			0, // flags - reserved for future use
 			renderPass,
-			1, // ImageView count
-			&imageView,
+			depthView ? 2u : 1u, // ImageView count
+			attachments,
 			width, // width
 			height, // height
 			1 // layers
@@ -903,15 +1093,21 @@ void killShaderModule( VkDevice device, VkShaderModule shaderModule ){
 	vkDestroyShaderModule( device, shaderModule, nullptr );
 }
 
-VkPipelineLayout initPipelineLayout( VkDevice device ){
+VkPipelineLayout initPipelineLayout( VkDevice device, const uint32_t vertexPushConstantsSize ){
+	const VkPushConstantRange pushConstantRange{
+		VK_SHADER_STAGE_VERTEX_BIT,
+		0, // offset
+		vertexPushConstantsSize
+	};
+
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{
 		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
 		nullptr, // pNext
 		0, // flags - reserved for future use
 		0, // descriptorSetLayout count
 		nullptr,
-		0, // push constant range count
-		nullptr // push constant ranges
+		vertexPushConstantsSize ? 1u : 0u, // push constant range count
+		&pushConstantRange // push constant ranges
 	};
 
 	VkPipelineLayout pipelineLayout;
@@ -926,13 +1122,14 @@ void killPipelineLayout( VkDevice device, VkPipelineLayout pipelineLayout ){
 
 VkPipeline initPipeline(
 	VkDevice device,
+	VkPipelineCache pipelineCache,
 	VkPhysicalDeviceLimits limits,
 	VkPipelineLayout pipelineLayout,
 	VkRenderPass renderPass,
 	VkShaderModule vertexShader,
 	VkShaderModule fragmentShader,
 	const uint32_t vertexBufferBinding,
-	uint32_t width, uint32_t height
+	const VertexFormat vertexFormat
 ){/*
 	const VkPipelineShaderStageCreateInfo vertexShaderStage{
 		VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -975,7 +1172,7 @@ VkPipeline initPipeline(
 		}
 	};
 
-	const uint32_t vertexBufferStride = sizeof( Vertex2D_ColorF_pack );
+	const uint32_t vertexBufferStride = vertexFormat == VertexFormat::Chunk ? sizeof( ChunkVertex ) : sizeof( Vertex2D_ColorF_pack );
 	if( vertexBufferBinding > limits.maxVertexInputBindings ){
 		throw string("Implementation does not allow enough input bindings. Needed: ")
 		    + to_string( vertexBufferBinding ) + string(", max: ")
@@ -990,7 +1187,7 @@ VkPipeline initPipeline(
 
 	VkVertexInputBindingDescription vertexInputBindingDescription{
 		vertexBufferBinding,
-		sizeof( Vertex2D_ColorF_pack ), // stride in bytes
+		vertexBufferStride, // stride in bytes
 		VK_VERTEX_INPUT_RATE_VERTEX
 	};
 
@@ -999,34 +1196,50 @@ VkPipeline initPipeline(
 		throw "Implementation does not allow enough input bindings.";
 	}
 
-	const uint32_t positionLocation = 0;
-	const uint32_t colorLocation = 1;
+	vector<VkVertexInputAttributeDescription> inputAttributeDescriptions;
+	if( vertexFormat == VertexFormat::Chunk ){
+		// both words of ChunkVertex as one uvec2; chunk.vert takes the bit fields apart
+		const uint32_t packedLocation = 0;
 
-	if( colorLocation >= limits.maxVertexInputAttributes ){
-		throw "Implementation does not allow enough input attributes.";
-	}
-	if( offsetof( Vertex2D_ColorF_pack, color ) > limits.maxVertexInputAttributeOffset ){
-		throw "Implementation does not allow sufficient attribute offset.";
+		VkVertexInputAttributeDescription packedInputAttributeDescription{
+			packedLocation,
+			vertexBufferBinding,
+			VK_FORMAT_R32G32_UINT,
+			offsetof( ChunkVertex, position ) // offset in bytes
+		};
+
+		inputAttributeDescriptions = { packedInputAttributeDescription };
 	}
+	else{
+		const uint32_t positionLocation = 0;
+		const uint32_t colorLocation = 1;
 
-	VkVertexInputAttributeDescription positionInputAttributeDescription{
-		positionLocation,
-		vertexBufferBinding,
-		VK_FORMAT_R32G32_SFLOAT,
-		offsetof( Vertex2D_ColorF_pack, position ) // offset in bytes
-	};
+		if( colorLocation >= limits.maxVertexInputAttributes ){
+			throw "Implementation does not allow enough input attributes.";
+		}
+		if( offsetof( Vertex2D_ColorF_pack, color ) > limits.maxVertexInputAttributeOffset ){
+			throw "Implementation does not allow sufficient attribute offset.";
+		}
 
-	VkVertexInputAttributeDescription colorInputAttributeDescription{
-		colorLocation,
-		vertexBufferBinding,
-		VK_FORMAT_R32G32B32_SFLOAT,
-		offsetof( Vertex2D_ColorF_pack, color ) // offset in bytes
-	};
+		VkVertexInputAttributeDescription positionInputAttributeDescription{
+			positionLocation,
+			vertexBufferBinding,
+			VK_FORMAT_R32G32_SFLOAT,
+			offsetof( Vertex2D_ColorF_pack, position ) // offset in bytes
+		};
 
-	vector<VkVertexInputAttributeDescription> inputAttributeDescriptions = {
-		positionInputAttributeDescription,
-		colorInputAttributeDescription
-	};
+		VkVertexInputAttributeDescription colorInputAttributeDescription{
+			colorLocation,
+			vertexBufferBinding,
+			VK_FORMAT_R32G32B32_SFLOAT,
+			offsetof( Vertex2D_ColorF_pack, color ) // offset in bytes
+		};
+
+		inputAttributeDescriptions = {
+			positionInputAttributeDescription,
+			colorInputAttributeDescription
+		};
+	}
 
 	VkPipelineVertexInputStateCreateInfo vertexInputState{
 		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
@@ -1046,28 +1259,15 @@ VkPipeline initPipeline(
 		VK_FALSE // primitive restart
 	};
 
-	VkViewport viewport{
-		0.0f, // x
-		0.0f, // y
-		static_cast<float>( width ? width : 1 ),
-		static_cast<float>( height ? height : 1 ),
-		0.0f, // min depth
-		1.0f // max depth
-	};
-
-	VkRect2D scissor{
-		{0, 0}, // offset
-		{width, height}
-	};
-
+	// viewport and scissor are set at record time, so the pipeline survives swapchain resizes
 	VkPipelineViewportStateCreateInfo viewportState{
 		VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
 		nullptr, // pNext
 		0, // flags - reserved for future use
 		1, // Viewport count
-		&viewport,
+		nullptr, // viewports - dynamic
 		1, // scisor count,
-		&scissor
+		nullptr // scissors - dynamic
 	};
 
 	VkPipelineRasterizationStateCreateInfo rasterizationState{
@@ -1098,6 +1298,22 @@ VkPipeline initPipeline(
 		VK_FALSE // alphaToOne
 	};
 
+	// reversed-Z: near is 1 and far 0, so nearer is greater; ignored by render passes without depth
+	VkPipelineDepthStencilStateCreateInfo depthStencilState{
+		VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+		nullptr, // pNext
+		0, // flags - reserved for future use
+		VK_TRUE, // depth test
+		VK_TRUE, // depth write
+		VulkanConfig::depthCompareOp,
+		VK_FALSE, // depth bounds test
+		VK_FALSE, // stencil test
+		{}, // front stencil op state
+		{}, // back stencil op state
+		0.0f, // min depth bounds
+		1.0f // max depth bounds
+	};
+
 	VkPipelineColorBlendAttachmentState blendAttachmentState{
 		VK_FALSE, // blending enabled?
 		VK_BLEND_FACTOR_ZERO, // src blend factor -ignored?
@@ -1120,6 +1336,16 @@ VkPipeline initPipeline(
 		{0.0f, 0.0f, 0.0f, 0.0f} // blend constants
 	};
 
+	const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	VkPipelineDynamicStateCreateInfo dynamicState{
+		VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+		nullptr, // pNext
+		0, // flags - reserved for future use
+		2, // dynamic state count
+		dynamicStates
+	};
+
 	VkGraphicsPipelineCreateInfo pipelineInfo{
 		VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
 		nullptr, // pNext
@@ -1132,9 +1358,9 @@ VkPipeline initPipeline(
 		&viewportState,
 		&rasterizationState,
 		&multisampleState,
-		nullptr, // depth stencil
+		&depthStencilState,
 		&colorBlendState,
-		nullptr, // dynamic state
+		&dynamicState,
 		pipelineLayout,
 		renderPass,
 		0, // subpass index in renderpass
@@ -1145,7 +1371,7 @@ VkPipeline initPipeline(
 	VkPipeline pipeline;
 	VkResult errorCode = vkCreateGraphicsPipelines(
 		device,
-		VK_NULL_HANDLE /* pipeline cache */,
+		pipelineCache,
 		1 /* info count */,
 		&pipelineInfo,
 		nullptr,
@@ -1158,11 +1384,207 @@ void killPipeline( VkDevice device, VkPipeline pipeline ){
 	vkDestroyPipeline( device, pipeline, nullptr );
 }
 
+VkDescriptorSetLayout initDescriptorSetLayout( VkDevice device, const vector<VkDescriptorSetLayoutBinding>& bindings ){
+	const VkDescriptorSetLayoutCreateInfo layoutInfo{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		nullptr, // pNext
+		0, // flags
+		static_cast<uint32_t>( bindings.size() ),
+		bindings.data()
+	};
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	VkResult errorCode = vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &descriptorSetLayout ); RESULT_HANDLER( errorCode, "vkCreateDescriptorSetLayout" );
+	return descriptorSetLayout;
+}
+
+void killDescriptorSetLayout( VkDevice device, VkDescriptorSetLayout descriptorSetLayout ){
+	vkDestroyDescriptorSetLayout( device, descriptorSetLayout, nullptr );
+}
+
+VkDescriptorPool initDescriptorPool( VkDevice device, const uint32_t maxSets, const vector<VkDescriptorPoolSize>& poolSizes ){
+	const VkDescriptorPoolCreateInfo poolInfo{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		nullptr, // pNext
+		0, // flags -- sets are never freed one by one
+		maxSets,
+		static_cast<uint32_t>( poolSizes.size() ),
+		poolSizes.data()
+	};
+
+	VkDescriptorPool descriptorPool;
+	VkResult errorCode = vkCreateDescriptorPool( device, &poolInfo, nullptr, &descriptorPool ); RESULT_HANDLER( errorCode, "vkCreateDescriptorPool" );
+	return descriptorPool;
+}
+
+void killDescriptorPool( VkDevice device, VkDescriptorPool descriptorPool ){
+	vkDestroyDescriptorPool( device, descriptorPool, nullptr );
+}
+
+vector<VkDescriptorSet> allocateDescriptorSets( VkDevice device, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, const uint32_t count ){
+	const vector<VkDescriptorSetLayout> layouts( count, descriptorSetLayout );
+	const VkDescriptorSetAllocateInfo allocateInfo{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		nullptr, // pNext
+		descriptorPool,
+		count,
+		layouts.data()
+	};
+
+	vector<VkDescriptorSet> descriptorSets( count );
+	VkResult errorCode = vkAllocateDescriptorSets( device, &allocateInfo, descriptorSets.data() ); RESULT_HANDLER( errorCode, "vkAllocateDescriptorSets" );
+	return descriptorSets;
+}
+
+void writeStorageBufferDescriptors( VkDevice device, VkDescriptorSet descriptorSet, const vector<VkBuffer>& buffers ){
+	vector<VkDescriptorBufferInfo> bufferInfos;
+	for( const VkBuffer buffer : buffers ) bufferInfos.push_back(  { buffer, 0 /*offset*/, VK_WHOLE_SIZE }  );
+
+	vector<VkWriteDescriptorSet> writes;
+	for( uint32_t binding = 0; binding < buffers.size(); ++binding ){
+		writes.push_back({
+			VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			nullptr, // pNext
+			descriptorSet,
+			binding,
+			0, // array element
+			1, // descriptor count
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			nullptr, // image infos
+			&bufferInfos[binding],
+			nullptr // texel buffer views
+		});
+	}
+
+	vkUpdateDescriptorSets( device, static_cast<uint32_t>( writes.size() ), writes.data(), 0, nullptr /*copies*/ );
+}
+
+void writeImageDescriptor(
+	VkDevice device,
+	VkDescriptorSet descriptorSet,
+	const uint32_t binding,
+	const VkDescriptorType type,
+	VkSampler sampler,
+	VkImageView imageView,
+	const VkImageLayout imageLayout
+){
+	const VkDescriptorImageInfo imageInfo{
+		type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ? sampler : VK_NULL_HANDLE,
+		imageView,
+		imageLayout
+	};
+
+	const VkWriteDescriptorSet write{
+		VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+		nullptr, // pNext
+		descriptorSet,
+		binding,
+		0, // array element
+		1, // descriptor count
+		type,
+		&imageInfo,
+		nullptr, // buffer infos
+		nullptr // texel buffer views
+	};
+
+	vkUpdateDescriptorSets( device, 1, &write, 0, nullptr /*copies*/ );
+}
+
+VkSampler initSampler( VkDevice device ){
+	const VkSamplerCreateInfo samplerInfo{
+		VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+		nullptr, // pNext
+		0, // flags
+		VK_FILTER_NEAREST, // magFilter
+		VK_FILTER_NEAREST, // minFilter
+		VK_SAMPLER_MIPMAP_MODE_NEAREST,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, // U
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, // V
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, // W
+		0.0f, // mipLodBias
+		VK_FALSE, // anisotropyEnable
+		1.0f, // maxAnisotropy
+		VK_FALSE, // compareEnable
+		VK_COMPARE_OP_ALWAYS, // compareOp
+		0.0f, // minLod
+		VK_LOD_CLAMP_NONE, // maxLod
+		VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+		VK_FALSE // unnormalizedCoordinates
+	};
+
+	VkSampler sampler;
+	VkResult errorCode = vkCreateSampler( device, &samplerInfo, nullptr, &sampler ); RESULT_HANDLER( errorCode, "vkCreateSampler" );
+	return sampler;
+}
+
+void killSampler( VkDevice device, VkSampler sampler ){
+	vkDestroySampler( device, sampler, nullptr );
+}
+
+VkPipelineLayout initPipelineLayout( VkDevice device, VkDescriptorSetLayout descriptorSetLayout, const VkShaderStageFlags pushConstantsStages, const uint32_t pushConstantsSize ){
+	const VkPushConstantRange pushConstantRange{
+		pushConstantsStages,
+		0, // offset
+		pushConstantsSize
+	};
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		nullptr, // pNext
+		0, // flags - reserved for future use
+		1, // descriptorSetLayout count
+		&descriptorSetLayout,
+		pushConstantsSize ? 1u : 0u, // push constant range count
+		&pushConstantRange // push constant ranges
+	};
+
+	VkPipelineLayout pipelineLayout;
+	VkResult errorCode = vkCreatePipelineLayout( device, &pipelineLayoutInfo, nullptr, &pipelineLayout ); RESULT_HANDLER( errorCode, "vkCreatePipelineLayout" );
+
+	return pipelineLayout;
+}
+
+VkPipeline initComputePipeline( VkDevice device, VkPipelineCache pipelineCache, VkPipelineLayout pipelineLayout, VkShaderModule computeShader ){
+	const VkComputePipelineCreateInfo pipelineInfo{
+		VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		nullptr, // pNext
+		0, // flags
+		{
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			nullptr, // pNext
+			0, // flags - reserved for future use
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			computeShader,
+			u8"main",
+			nullptr // SpecializationInfo - constants pushed to shader on pipeline creation time
+		},
+		pipelineLayout,
+		VK_NULL_HANDLE, // base pipeline
+		-1 // base pipeline index
+	};
+
+	VkPipeline pipeline;
+	VkResult errorCode = vkCreateComputePipelines(
+		device,
+		pipelineCache,
+		1 /* info count */,
+		&pipelineInfo,
+		nullptr,
+		&pipeline
+	); RESULT_HANDLER( errorCode, "vkCreateComputePipelines" );
+	return pipeline;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void setVertexData( VkDevice device, VkDeviceMemory memory, vector<Vertex2D_ColorF_pack> vertices ){
-	TODO( "Should be in Device Local memory instead" )
-	setMemoryData(  device, memory, vertices.data(), sizeof( decltype(vertices)::value_type ) * vertices.size()  );
+UploadManager::Ticket setVertexData( UploadManager& uploader, VkBuffer vertexBuffer, const vector<Vertex2D_ColorF_pack>& vertices ){
+	uploader.uploadBuffer(  vertexBuffer, 0 /*offset*/, vertices.data(), sizeof( Vertex2D_ColorF_pack ) * vertices.size()  );
+	return uploader.flush();
+}
+
+UploadManager::Ticket setVertexData( UploadManager& uploader, VkBuffer vertexBuffer, const vector<ChunkVertex>& vertices ){
+	uploader.uploadBuffer(  vertexBuffer, 0 /*offset*/, vertices.data(), sizeof( ChunkVertex ) * vertices.size()  );
+	return uploader.flush();
 }
 
 VkSemaphore initSemaphore( VkDevice device ){
@@ -1192,11 +1614,48 @@ void killSemaphores( VkDevice device, vector<VkSemaphore>& semaphores ){
 	semaphores.clear();
 }
 
-VkCommandPool initCommandPool( VkDevice device, const uint32_t queueFamily ){
+VkSemaphore initTimelineSemaphore( VkDevice device, const uint64_t initialValue ){
+	const VkSemaphoreTypeCreateInfoKHR typeInfo{
+		VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR,
+		nullptr, // pNext
+		VK_SEMAPHORE_TYPE_TIMELINE_KHR,
+		initialValue
+	};
+
+	const VkSemaphoreCreateInfo semaphoreInfo{
+		VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+		&typeInfo, // pNext
+		0 // flags - reserved for future use
+	};
+
+	VkSemaphore semaphore;
+	VkResult errorCode = vkCreateSemaphore( device, &semaphoreInfo, nullptr, &semaphore ); RESULT_HANDLER( errorCode, "vkCreateSemaphore" );
+	return semaphore;
+}
+
+uint64_t getSemaphoreCounterValue( VkDevice device, VkSemaphore timelineSemaphore ){
+	uint64_t value;
+	VkResult errorCode = vkGetSemaphoreCounterValueKHR( device, timelineSemaphore, &value ); RESULT_HANDLER( errorCode, "vkGetSemaphoreCounterValueKHR" );
+	return value;
+}
+
+void waitSemaphore( VkDevice device, VkSemaphore timelineSemaphore, const uint64_t value ){
+	const VkSemaphoreWaitInfoKHR waitInfo{
+		VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR,
+		nullptr, // pNext
+		0, // flags
+		1, &timelineSemaphore,
+		&value
+	};
+
+	VkResult errorCode = vkWaitSemaphoresKHR( device, &waitInfo, UINT64_MAX ); RESULT_HANDLER( errorCode, "vkWaitSemaphoresKHR" );
+}
+
+VkCommandPool initCommandPool( VkDevice device, const uint32_t queueFamily, const VkCommandPoolCreateFlags flags ){
 	const VkCommandPoolCreateInfo commandPoolInfo{
 		VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
 		nullptr, // pNext
-		0, // flags
+		flags,
 		queueFamily
 	};
 
@@ -1209,7 +1668,7 @@ void killCommandPool( VkDevice device, VkCommandPool commandPool ){
 	vkDestroyCommandPool( device, commandPool, nullptr );
 }
 
-VkFence initFence( const VkDevice device, const VkFenceCreateFlags flags = 0 ){
+VkFence initFence( const VkDevice device, const VkFenceCreateFlags flags ){
 	const VkFenceCreateInfo fci{
 		VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
 		nullptr, // pNext
@@ -1236,7 +1695,38 @@ void killFences( const VkDevice device, vector<VkFence>& fences ){
 	fences.clear();
 }
 
-void acquireCommandBuffers( VkDevice device, VkCommandPool commandPool, uint32_t count, vector<VkCommandBuffer>& commandBuffers ){
+VkQueryPool initQueryPool( const VkDevice device, const VkQueryType type, const uint32_t count ){
+	const VkQueryPoolCreateInfo qpci{
+		VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+		nullptr, // pNext
+		0, // flags - reserved for future use
+		type,
+		count,
+		0 // pipelineStatistics -- ignored for non-statistics queries
+	};
+
+	VkQueryPool queryPool;
+	VkResult errorCode = vkCreateQueryPool( device, &qpci, nullptr, &queryPool ); RESULT_HANDLER( errorCode, "vkCreateQueryPool" );
+	return queryPool;
+}
+
+void killQueryPool( const VkDevice device, const VkQueryPool queryPool ){
+	vkDestroyQueryPool( device, queryPool, nullptr );
+}
+
+bool getTimestamps( const VkDevice device, const VkQueryPool queryPool, const uint32_t firstQuery, const uint32_t count, uint64_t* const timestamps ){
+	const VkResult errorCode = vkGetQueryPoolResults(
+		device, queryPool, firstQuery, count,
+		count * sizeof( uint64_t ), timestamps, sizeof( uint64_t ) /*stride*/,
+		VK_QUERY_RESULT_64_BIT
+	);
+	if( errorCode == VK_NOT_READY ) return false;
+	RESULT_HANDLER( errorCode, "vkGetQueryPoolResults" );
+
+	return true;
+}
+
+void acquireCommandBuffers( VkDevice device, VkCommandPool commandPool, uint32_t count, vector<VkCommandBuffer>& commandBuffers, const VkCommandBufferLevel level ){
 	const auto oldSize = static_cast<uint32_t>( commandBuffers.size() );
 
 	if( count > oldSize ){
@@ -1244,7 +1734,7 @@ void acquireCommandBuffers( VkDevice device, VkCommandPool commandPool, uint32_t
 			VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
 			nullptr, // pNext
 			commandPool,
-			VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			level,
 			count - oldSize // count
 		};
 
@@ -1258,18 +1748,39 @@ void acquireCommandBuffers( VkDevice device, VkCommandPool commandPool, uint32_t
 	}
 }
 
-void beginCommandBuffer( VkCommandBuffer commandBuffer ){
+void beginCommandBuffer( VkCommandBuffer commandBuffer, const VkCommandBufferUsageFlags flags ){
 	VkCommandBufferBeginInfo commandBufferInfo{
 		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
 		nullptr, // pNext
-		// same buffer can be re-executed before it finishes from last submit
-		VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT, // flags
+		flags, // by default SIMULTANEOUS_USE -- same buffer can be re-executed before it finishes from last submit
 		nullptr // inheritance
 	};
 
 	VkResult errorCode = vkBeginCommandBuffer( commandBuffer, &commandBufferInfo ); RESULT_HANDLER( errorCode, "vkBeginCommandBuffer" );
 }
 
+void beginSecondaryCommandBuffer( VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer ){
+	const VkCommandBufferInheritanceInfo inheritanceInfo{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+		nullptr, // pNext
+		renderPass,
+		0, // subpass
+		framebuffer, // may be VK_NULL_HANDLE, but knowing it can help the driver
+		VK_FALSE, // occlusionQueryEnable
+		0, // queryFlags
+		0 // pipelineStatistics
+	};
+
+	const VkCommandBufferBeginInfo commandBufferInfo{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		nullptr, // pNext
+		VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, // flags
+		&inheritanceInfo
+	};
+
+	VkResult errorCode = vkBeginCommandBuffer( commandBuffer, &commandBufferInfo ); RESULT_HANDLER( errorCode, "vkBeginCommandBuffer" );
+}
+
 void endCommandBuffer( VkCommandBuffer commandBuffer ){
 	VkResult errorCode = vkEndCommandBuffer( commandBuffer ); RESULT_HANDLER( errorCode, "vkEndCommandBuffer" );
 }
@@ -1280,19 +1791,24 @@ void recordBeginRenderPass(
 	VkRenderPass renderPass,
 	VkFramebuffer framebuffer,
 	VkClearValue clearValue,
-	uint32_t width, uint32_t height
+	uint32_t width, uint32_t height,
+	VkSubpassContents contents
 ){
+	// a render pass without depth ignores the second one
+	VkClearValue clearValues[2] = { clearValue, {} };
+	clearValues[1].depthStencil = { VulkanConfig::depthClearValue, 0 };
+
 	VkRenderPassBeginInfo renderPassInfo{
 		VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
 		nullptr, // pNext
 		renderPass,
 		framebuffer,
 		{{0,0}, {width,height}}, //render area - offset plus extent
-		1, // clear value count
-		&clearValue
+		2, // clear value count
+		clearValues
 	};
 
-	vkCmdBeginRenderPass( commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
+	vkCmdBeginRenderPass( commandBuffer, &renderPassInfo, contents );
 }
 
 void recordEndRenderPass( VkCommandBuffer commandBuffer ){
@@ -1303,15 +1819,158 @@ void recordBindPipeline( VkCommandBuffer commandBuffer, VkPipeline pipeline ){
 	vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline );
 }
 
+void recordSetViewport( VkCommandBuffer commandBuffer, const uint32_t width, const uint32_t height ){
+	const VkViewport viewport{
+		0.0f, // x
+		0.0f, // y
+		static_cast<float>( width ? width : 1 ),
+		static_cast<float>( height ? height : 1 ),
+		0.0f, // min depth
+		1.0f // max depth
+	};
+	vkCmdSetViewport( commandBuffer, 0 /*first viewport*/, 1, &viewport );
+
+	const VkRect2D scissor{
+		{0, 0}, // offset
+		{width, height}
+	};
+	vkCmdSetScissor( commandBuffer, 0 /*first scissor*/, 1, &scissor );
+}
+
 void recordBindVertexBuffer( VkCommandBuffer commandBuffer, const uint32_t vertexBufferBinding, VkBuffer vertexBuffer ){
 	VkDeviceSize offsets[] = {0};
 	vkCmdBindVertexBuffers( commandBuffer, vertexBufferBinding, 1 /*binding count*/, &vertexBuffer, offsets );
 }
 
+void recordBindIndexBuffer( VkCommandBuffer commandBuffer, VkBuffer indexBuffer ){
+	vkCmdBindIndexBuffer( commandBuffer, indexBuffer, 0 /*offset*/, VK_INDEX_TYPE_UINT32 );
+}
+
+void recordPushConstants( VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, const uint32_t offset, const uint32_t size, const void* const values ){
+	vkCmdPushConstants( commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, offset, size, values );
+}
+
 void recordDraw( VkCommandBuffer commandBuffer, const uint32_t vertexCount ){
 	vkCmdDraw( commandBuffer, vertexCount, 1 /*instance count*/, 0 /*first vertex*/, 0 /*first instance*/ );
 }
 
+void recordDrawIndexed( VkCommandBuffer commandBuffer, const uint32_t indexCount ){
+	vkCmdDrawIndexed( commandBuffer, indexCount, 1 /*instance count*/, 0 /*first index*/, 0 /*vertex offset*/, 0 /*first instance*/ );
+}
+
+void recordBufferBarrier(
+	VkCommandBuffer commandBuffer,
+	VkBuffer buffer,
+	const VkPipelineStageFlags srcStages, const VkAccessFlags srcAccess,
+	const VkPipelineStageFlags dstStages, const VkAccessFlags dstAccess
+){
+	const VkBufferMemoryBarrier barrier{
+		VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+		nullptr, // pNext
+		srcAccess, // srcAccessMask
+		dstAccess, // dstAccessMask
+		VK_QUEUE_FAMILY_IGNORED, // srcQueueFamilyIndex
+		VK_QUEUE_FAMILY_IGNORED, // dstQueueFamilyIndex
+		buffer,
+		0, // offset
+		VK_WHOLE_SIZE // size
+	};
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		srcStages, dstStages,
+		0, // dependencyFlags
+		0, nullptr, // memory barriers
+		1, &barrier, // buffer barriers
+		0, nullptr // image barriers
+	);
+}
+
+void recordImageBarrier(
+	VkCommandBuffer commandBuffer,
+	VkImage image,
+	const VkImageAspectFlags aspect,
+	const VkImageLayout oldLayout, const VkImageLayout newLayout,
+	const VkPipelineStageFlags srcStages, const VkAccessFlags srcAccess,
+	const VkPipelineStageFlags dstStages, const VkAccessFlags dstAccess
+){
+	const VkImageMemoryBarrier barrier{
+		VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		nullptr, // pNext
+		srcAccess, // srcAccessMask
+		dstAccess, // dstAccessMask
+		oldLayout,
+		newLayout,
+		VK_QUEUE_FAMILY_IGNORED, // srcQueueFamilyIndex
+		VK_QUEUE_FAMILY_IGNORED, // dstQueueFamilyIndex
+		image,
+		{
+			aspect,
+			0, // base mip-level
+			VK_REMAINING_MIP_LEVELS, // level count
+			0, // base array layer
+			VK_REMAINING_ARRAY_LAYERS // array layer count
+		}
+	};
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		srcStages, dstStages,
+		0, // dependencyFlags
+		0, nullptr, // memory barriers
+		0, nullptr, // buffer barriers
+		1, &barrier // image barriers
+	);
+}
+
+void recordResetQueries( VkCommandBuffer commandBuffer, VkQueryPool queryPool, const uint32_t firstQuery, const uint32_t count ){
+	vkCmdResetQueryPool( commandBuffer, queryPool, firstQuery, count );
+}
+
+void recordTimestamp( VkCommandBuffer commandBuffer, const VkPipelineStageFlagBits stage, VkQueryPool queryPool, const uint32_t query ){
+	vkCmdWriteTimestamp( commandBuffer, stage, queryPool, query );
+}
+
+void recordReadback( VkCommandBuffer commandBuffer, VkImage image, VkBuffer buffer, const uint32_t width, const uint32_t height ){
+	const VkBufferImageCopy region{
+		0, // bufferOffset
+		0, // bufferRowLength -- tightly packed
+		0, // bufferImageHeight -- tightly packed
+		{
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			0, // mip level
+			0, // base array layer
+			1 // layer count
+		},
+		{0, 0, 0}, // imageOffset
+		{width, height, 1} // imageExtent
+	};
+
+	// the render pass dependency already made the attachment writes available to the transfer
+	vkCmdCopyImageToBuffer( commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region );
+
+	const VkBufferMemoryBarrier toHost{
+		VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+		nullptr, // pNext
+		VK_ACCESS_TRANSFER_WRITE_BIT, // srcAccessMask
+		VK_ACCESS_HOST_READ_BIT, // dstAccessMask
+		VK_QUEUE_FAMILY_IGNORED, // srcQueueFamilyIndex
+		VK_QUEUE_FAMILY_IGNORED, // dstQueueFamilyIndex
+		buffer,
+		0, // offset
+		VK_WHOLE_SIZE // size
+	};
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+		0, // dependencyFlags
+		0, nullptr, // memory barriers
+		1, &toHost, // buffer barriers
+		0, nullptr // image barriers
+	);
+}
+
 void submitToQueue( VkQueue queue, VkCommandBuffer commandBuffer, VkSemaphore imageReadyS, VkSemaphore renderDoneS, VkFence fence ){
 	const VkPipelineStageFlags psw = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
@@ -1327,7 +1986,20 @@ void submitToQueue( VkQueue queue, VkCommandBuffer commandBuffer, VkSemaphore im
 	const VkResult errorCode = vkQueueSubmit( queue, 1 /*submit count*/, &submit, fence ); RESULT_HANDLER( errorCode, "vkQueueSubmit" );
 }
 
-void present( VkQueue queue, VkSwapchainKHR swapchain, uint32_t swapchainImageIndex, VkSemaphore renderDoneS ){
+void submitToQueue( VkQueue queue, VkCommandBuffer commandBuffer, VkFence fence ){
+	const VkSubmitInfo submit{
+		VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		nullptr, // pNext
+		0, nullptr, // wait semaphores
+		nullptr, // pipeline stages to wait for semaphore
+		1, &commandBuffer,
+		0, nullptr // signal semaphores
+	};
+
+	const VkResult errorCode = vkQueueSubmit( queue, 1 /*submit count*/, &submit, fence ); RESULT_HANDLER( errorCode, "vkQueueSubmit" );
+}
+
+SwapchainStatus present( VkQueue queue, VkSwapchainKHR swapchain, uint32_t swapchainImageIndex, VkSemaphore renderDoneS ){
 	const VkPresentInfoKHR presentInfo{
 		VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
 		nullptr, // pNext
@@ -1336,7 +2008,11 @@ void present( VkQueue queue, VkSwapchainKHR swapchain, uint32_t swapchainImageIn
 		nullptr // pResults
 	};
 
-	const VkResult errorCode = vkQueuePresentKHR( queue, &presentInfo ); RESULT_HANDLER( errorCode, "vkQueuePresentKHR" );
+	const VkResult errorCode = vkQueuePresentKHR( queue, &presentInfo );
+	if( errorCode == VK_ERROR_OUT_OF_DATE_KHR ) return SwapchainStatus::outOfDate; // an error code, but an expected one
+	RESULT_HANDLER( errorCode, "vkQueuePresentKHR" );
+
+	return errorCode == VK_SUBOPTIMAL_KHR ? SwapchainStatus::suboptimal : SwapchainStatus::optimal;
 }
 
 // cleanup dangerous semaphore with signal pending from vkAcquireNextImageKHR (tie it to a specific queue)
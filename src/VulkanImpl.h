@@ -8,6 +8,11 @@ using std::vector;
 
 #include "Vertex.h"
 #include "ErrorHandling.h"
+#include "MemoryAllocator.h"
+#include "PipelineCache.h"
+#include "SwapchainManager.h"
+#include "UploadManager.h"
+#include "VulkanConfig.h"
 #include "Wsi.h"
 
 //  forward declarations
@@ -18,7 +23,10 @@ bool isExtensionSupported( const char* extension, const vector<VkExtensionProper
 // treat layers as optional; app can always run without em -- i.e. return those supported
 vector<const char*> checkInstanceLayerSupport( const vector<const char*>& requestedLayers, const vector<VkLayerProperties>& supportedLayers );
 vector<VkExtensionProperties> getSupportedInstanceExtensions( const vector<const char*>& providingLayers );
+vector<VkExtensionProperties> getSupportedDeviceExtensions( VkPhysicalDevice physDevice, const vector<const char*>& providingLayers );
 bool checkExtensionSupport( const vector<const char*>& extensions, const vector<VkExtensionProperties>& supportedExtensions );
+// appends the whole group to extensions if every extension of it is supported; returns whether it did
+bool enableOptionalDeviceExtensions( VkPhysicalDevice physDevice, const vector<const char*>& providingLayers, const vector<const char*>& group, vector<const char*>& extensions );
 
 VkInstance initInstance( const vector<const char*>& layers = {}, const vector<const char*>& extensions = {} );
 void killInstance( VkInstance instance );
@@ -28,6 +36,9 @@ VkPhysicalDeviceProperties getPhysicalDeviceProperties( VkPhysicalDevice physica
 VkPhysicalDeviceMemoryProperties getPhysicalDeviceMemoryProperties( VkPhysicalDevice physicalDevice );
 
 std::pair<uint32_t, uint32_t> getQueueFamilies( VkPhysicalDevice physDevice, VkSurfaceKHR surface );
+uint32_t getGraphicsQueueFamily( VkPhysicalDevice physDevice ); // for rendering that is never presented
+// prefers a transfer-only (DMA) family, then any non-graphics family that can transfer; otherwise returns fallbackQueueFamily
+uint32_t getTransferQueueFamily( VkPhysicalDevice physDevice, uint32_t fallbackQueueFamily );
 vector<VkQueueFamilyProperties> getQueueFamilyProperties( VkPhysicalDevice device );
 
 VkDevice initDevice(
@@ -35,6 +46,7 @@ VkDevice initDevice(
 	const VkPhysicalDeviceFeatures& features,
 	uint32_t graphicsQueueFamily,
 	uint32_t presentQueueFamily,
+	uint32_t transferQueueFamily, // may equal one of the above
 	const vector<const char*>& layers = {},
 	const vector<const char*>& extensions = {}
 );
@@ -45,17 +57,21 @@ VkQueue getQueue( VkDevice device, uint32_t queueFamily, uint32_t queueIndex );
 
 enum class ResourceType{ Buffer, Image };
 
+// sub-allocates from the MemoryAllocator and binds the resource; free with killMemory()
 template< ResourceType resourceType, class T >
-VkDeviceMemory initMemory(
+MemoryAllocation initMemory(
 	VkDevice device,
 	VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties,
 	T resource,
 	const std::vector<VkMemoryPropertyFlags>& memoryTypePriority
 );
-void setMemoryData( VkDevice device, VkDeviceMemory memory, void* begin, size_t size );
-void killMemory( VkDevice device, VkDeviceMemory memory );
+void setMemoryData( VkDevice device, const MemoryAllocation& memory, void* begin, size_t size );
+void* mapMemory( VkDevice device, const MemoryAllocation& memory ); // HOST_VISIBLE memory is persistently mapped; no unmap needed
+void killMemory( VkDevice device, const MemoryAllocation& memory );
 
 VkBuffer initBuffer( VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage );
+// VK_SHARING_MODE_CONCURRENT if queueFamilies holds more than one family, so no ownership transfers are needed
+VkBuffer initBuffer( VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, const vector<uint32_t>& queueFamilies );
 void killBuffer( VkDevice device, VkBuffer buffer );
 
 VkImage initImage(
@@ -63,13 +79,42 @@ VkImage initImage(
 	VkFormat format,
 	uint32_t width, uint32_t height,
 	VkSampleCountFlagBits samples,
-	VkImageUsageFlags usage
+	VkImageUsageFlags usage,
+	uint32_t mipLevels = 1
 );
 void killImage( VkDevice device, VkImage image );
 
-VkImageView initImageView( VkDevice device, VkImage image, VkFormat format );
+// mipLevelCount levels from baseMipLevel; all of them by default
+VkImageView initImageView(
+	VkDevice device,
+	VkImage image,
+	VkFormat format,
+	VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+	uint32_t baseMipLevel = 0,
+	uint32_t mipLevelCount = VK_REMAINING_MIP_LEVELS
+);
 void killImageView( VkDevice device, VkImageView imageView );
 
+// the first of VulkanConfig::depthFormats the device can render depth to, with optimal tiling features on top,
+// e.g. VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT for a sampled depth buffer
+VkFormat getDepthFormat( VkPhysicalDevice physicalDevice, VkFormatFeatureFlags features = 0 );
+
+// depth attachment whose contents do not outlive a render pass (STORE_OP_DONT_CARE), so it may be lazily allocated;
+// unless sampled: then shaders may read it after a render pass that keeps it, like initEarlyRenderPass, through view
+struct DepthBuffer{
+	VkImage image;
+	MemoryAllocation memory;
+	VkImageView view; // depth aspect only
+};
+DepthBuffer initDepthBuffer(
+	VkDevice device,
+	VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties,
+	VkFormat format,
+	uint32_t width, uint32_t height,
+	bool sampled = false
+);
+void killDepthBuffer( VkDevice device, const DepthBuffer& depthBuffer );
+
 // initSurface() is platform dependent
 void killSurface( VkInstance instance, VkSurfaceKHR surface );
 
@@ -88,20 +133,33 @@ VkSwapchainKHR initSwapchain(
 );
 void killSwapchain( VkDevice device, VkSwapchainKHR swapchain );
 
-uint32_t getNextImageIndex( VkDevice device, VkSwapchainKHR swapchain, VkSemaphore imageReadyS );
+// imageIndex is valid unless outOfDate; imageReadyS is then not signaled either, so it needs no cleanup
+SwapchainStatus acquireNextImage( VkDevice device, VkSwapchainKHR swapchain, VkSemaphore imageReadyS, uint32_t& imageIndex );
 
 vector<VkImageView> initSwapchainImageViews( VkDevice device, vector<VkImage> images, VkFormat format );
 void killSwapchainImageViews( VkDevice device, vector<VkImageView>& imageViews );
 
 
-VkRenderPass initRenderPass( VkDevice device, VkSurfaceFormatKHR surfaceFormat );
+// attachment 0 is color, attachment 1 the depth of depthFormat, unless that is VK_FORMAT_UNDEFINED;
+// depth is cleared to VulkanConfig::depthClearValue and not stored
+VkRenderPass initRenderPass( VkDevice device, VkSurfaceFormatKHR surfaceFormat, VkFormat depthFormat );
+// leaves the color attachment in TRANSFER_SRC_OPTIMAL, ready to be copied out
+VkRenderPass initOffscreenRenderPass( VkDevice device, VkFormat format, VkFormat depthFormat );
+// A frame in two offscreen render passes with a compute pass between them, e.g. two-phase occlusion culling. The early
+// one clears like initOffscreenRenderPass, but stores depth and leaves it in DEPTH_STENCIL_READ_ONLY_OPTIMAL for compute
+// shaders to sample (so depthFormat must not be VK_FORMAT_UNDEFINED), and the color in COLOR_ATTACHMENT_OPTIMAL. The
+// late one loads both and ends like initOffscreenRenderPass. They are compatible, so they share the framebuffers.
+VkRenderPass initEarlyRenderPass( VkDevice device, VkFormat format, VkFormat depthFormat );
+VkRenderPass initLateRenderPass( VkDevice device, VkFormat format, VkFormat depthFormat );
 void killRenderPass( VkDevice device, VkRenderPass renderPass );
 
+// one per image view; all share depthView, if the render pass has depth -- the render pass orders their depth writes
 vector<VkFramebuffer> initFramebuffers(
 	VkDevice device,
 	VkRenderPass renderPass,
 	vector<VkImageView> imageViews,
-	uint32_t width, uint32_t height
+	uint32_t width, uint32_t height,
+	VkImageView depthView = VK_NULL_HANDLE
 );
 void killFramebuffers( VkDevice device, vector<VkFramebuffer>& framebuffers );
 
@@ -110,55 +168,133 @@ VkShaderModule initShaderModule( VkDevice device, const vector<uint32_t>& shader
 VkShaderModule initShaderModule( VkDevice device, string filename );
 void killShaderModule( VkDevice device, VkShaderModule shaderModule );
 
-VkPipelineLayout initPipelineLayout( VkDevice device );
+VkPipelineLayout initPipelineLayout( VkDevice device, uint32_t vertexPushConstantsSize = 0 ); // e.g. sizeof( ChunkPushConstants ) for VertexFormat::Chunk
 void killPipelineLayout( VkDevice device, VkPipelineLayout pipelineLayout );
 
 VkPipeline initPipeline(
 	VkDevice device,
+	VkPipelineCache pipelineCache,
 	VkPhysicalDeviceLimits limits,
 	VkPipelineLayout pipelineLayout,
 	VkRenderPass renderPass,
 	VkShaderModule vertexShader,
 	VkShaderModule fragmentShader,
 	const uint32_t vertexBufferBinding,
-	uint32_t width, uint32_t height
-);
+	VertexFormat vertexFormat = VertexFormat::Vertex2D_ColorF
+); // viewport and scissor are dynamic state -- see recordSetViewport; depth test and write with VulkanConfig::depthCompareOp (reversed-Z)
 void killPipeline( VkDevice device, VkPipeline pipeline );
 
+VkDescriptorSetLayout initDescriptorSetLayout( VkDevice device, const vector<VkDescriptorSetLayoutBinding>& bindings );
+void killDescriptorSetLayout( VkDevice device, VkDescriptorSetLayout descriptorSetLayout );
+
+// the sets allocated from it are freed with it
+VkDescriptorPool initDescriptorPool( VkDevice device, uint32_t maxSets, const vector<VkDescriptorPoolSize>& poolSizes );
+void killDescriptorPool( VkDevice device, VkDescriptorPool descriptorPool );
+vector<VkDescriptorSet> allocateDescriptorSets( VkDevice device, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, uint32_t count );
+
+// binding i of descriptorSet becomes the whole of buffers[i], as a storage buffer
+void writeStorageBufferDescriptors( VkDevice device, VkDescriptorSet descriptorSet, const vector<VkBuffer>& buffers );
+// one image descriptor; sampler is only used by VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+void writeImageDescriptor(
+	VkDevice device,
+	VkDescriptorSet descriptorSet,
+	uint32_t binding,
+	VkDescriptorType type,
+	VkSampler sampler,
+	VkImageView imageView,
+	VkImageLayout imageLayout
+);
+
+// nearest, clamped to the edge, every mip level; enough for texelFetch
+VkSampler initSampler( VkDevice device );
+void killSampler( VkDevice device, VkSampler sampler );
+
+// one descriptor set layout, and push constants from offset 0 for pushConstantsStages, if pushConstantsSize is not 0
+VkPipelineLayout initPipelineLayout( VkDevice device, VkDescriptorSetLayout descriptorSetLayout, VkShaderStageFlags pushConstantsStages, uint32_t pushConstantsSize );
 
-void setVertexData( VkDevice device, VkDeviceMemory memory, vector<Vertex2D_ColorF_pack> vertices );
+VkPipeline initComputePipeline( VkDevice device, VkPipelineCache pipelineCache, VkPipelineLayout pipelineLayout, VkShaderModule computeShader );
+
+
+// vertexBuffer needs VK_BUFFER_USAGE_TRANSFER_DST_BIT; returns ticket of the upload batch
+UploadManager::Ticket setVertexData( UploadManager& uploader, VkBuffer vertexBuffer, const vector<Vertex2D_ColorF_pack>& vertices );
+UploadManager::Ticket setVertexData( UploadManager& uploader, VkBuffer vertexBuffer, const vector<ChunkVertex>& vertices );
 
 VkSemaphore initSemaphore( VkDevice device );
 vector<VkSemaphore> initSemaphores( VkDevice device, size_t count );
 void killSemaphore( VkDevice device, VkSemaphore semaphore );
 void killSemaphores( VkDevice device, vector<VkSemaphore>& semaphores );
 
-VkCommandPool initCommandPool( VkDevice device, const uint32_t queueFamily );
+// needs VK_KHR_timeline_semaphore enabled on the device; initDevice turns on the feature when it is in the extension list
+VkSemaphore initTimelineSemaphore( VkDevice device, uint64_t initialValue = 0 );
+uint64_t getSemaphoreCounterValue( VkDevice device, VkSemaphore timelineSemaphore );
+void waitSemaphore( VkDevice device, VkSemaphore timelineSemaphore, uint64_t value ); // on host, until the counter reaches value
+
+VkCommandPool initCommandPool( VkDevice device, const uint32_t queueFamily, VkCommandPoolCreateFlags flags = 0 );
 void killCommandPool( VkDevice device, VkCommandPool commandPool );
 
+VkFence initFence( VkDevice device, VkFenceCreateFlags flags = 0 );
+void killFence( VkDevice device, VkFence fence );
 vector<VkFence> initFences( VkDevice device, size_t count, VkFenceCreateFlags flags = 0 );
 void killFences( VkDevice device, vector<VkFence>& fences );
 
-void acquireCommandBuffers( VkDevice device, VkCommandPool commandPool, uint32_t count, vector<VkCommandBuffer>& commandBuffers );
-void beginCommandBuffer( VkCommandBuffer commandBuffer );
+VkQueryPool initQueryPool( VkDevice device, VkQueryType type, uint32_t count );
+void killQueryPool( VkDevice device, VkQueryPool queryPool );
+// returns false if results are not available yet
+bool getTimestamps( VkDevice device, VkQueryPool queryPool, uint32_t firstQuery, uint32_t count, uint64_t* timestamps );
+
+void acquireCommandBuffers( VkDevice device, VkCommandPool commandPool, uint32_t count, vector<VkCommandBuffer>& commandBuffers, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY );
+void beginCommandBuffer( VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT );
+// one time submit secondary buffer that continues subpass 0 of renderPass
+void beginSecondaryCommandBuffer( VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer );
 void endCommandBuffer( VkCommandBuffer commandBuffer );
 
+// depth, if the render pass has it, is cleared to VulkanConfig::depthClearValue
 void recordBeginRenderPass(
 	VkCommandBuffer commandBuffer,
 	VkRenderPass renderPass,
 	VkFramebuffer framebuffer,
 	VkClearValue clearValue,
-	uint32_t width, uint32_t height
+	uint32_t width, uint32_t height,
+	VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE // SECONDARY_COMMAND_BUFFERS for vkCmdExecuteCommands
 );
 void recordEndRenderPass( VkCommandBuffer commandBuffer );
 
 void recordBindPipeline( VkCommandBuffer commandBuffer, VkPipeline pipeline );
+void recordSetViewport( VkCommandBuffer commandBuffer, uint32_t width, uint32_t height ); // and scissor to match
 void recordBindVertexBuffer( VkCommandBuffer commandBuffer, const uint32_t vertexBufferBinding, VkBuffer vertexBuffer );
+void recordBindIndexBuffer( VkCommandBuffer commandBuffer, VkBuffer indexBuffer ); // of uint32_t
 
+void recordPushConstants( VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t offset, uint32_t size, const void* values ); // vertex stage
 void recordDraw( VkCommandBuffer commandBuffer, uint32_t vertexCount );
+void recordDrawIndexed( VkCommandBuffer commandBuffer, uint32_t indexCount );
+
+// the whole buffer; queue family ownership stays as it is
+void recordBufferBarrier(
+	VkCommandBuffer commandBuffer,
+	VkBuffer buffer,
+	VkPipelineStageFlags srcStages, VkAccessFlags srcAccess,
+	VkPipelineStageFlags dstStages, VkAccessFlags dstAccess
+);
+
+// all mip levels and layers of image; queue family ownership stays as it is
+void recordImageBarrier(
+	VkCommandBuffer commandBuffer,
+	VkImage image,
+	VkImageAspectFlags aspect,
+	VkImageLayout oldLayout, VkImageLayout newLayout,
+	VkPipelineStageFlags srcStages, VkAccessFlags srcAccess,
+	VkPipelineStageFlags dstStages, VkAccessFlags dstAccess
+);
+
+void recordResetQueries( VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t firstQuery, uint32_t count );
+void recordTimestamp( VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage, VkQueryPool queryPool, uint32_t query );
+
+// copies a TRANSFER_SRC_OPTIMAL color image into a tightly packed buffer and makes the result visible to the host
+void recordReadback( VkCommandBuffer commandBuffer, VkImage image, VkBuffer buffer, uint32_t width, uint32_t height );
 
 void submitToQueue( VkQueue queue, VkCommandBuffer commandBuffer, VkSemaphore imageReadyS, VkSemaphore renderDoneS, VkFence fence = VK_NULL_HANDLE );
-void present( VkQueue queue, VkSwapchainKHR swapchain, uint32_t swapchainImageIndex, VkSemaphore renderDoneS );
+void submitToQueue( VkQueue queue, VkCommandBuffer commandBuffer, VkFence fence ); // no semaphores -- nothing is presented
+SwapchainStatus present( VkQueue queue, VkSwapchainKHR swapchain, uint32_t swapchainImageIndex, VkSemaphore renderDoneS );
 
 // cleanup dangerous semaphore with signal pending from vkAcquireNextImageKHR
 void cleanupUnsafeSemaphore( VkQueue queue, VkSemaphore semaphore );
@@ -191,11 +327,20 @@ inline vector<Type> loadBinaryFile( string filename ){
 	return data;
 }
 
+// dedicatedRequirements is filled only if not null, which needs VK_KHR_get_memory_requirements2 + VK_KHR_dedicated_allocation
 template< ResourceType resourceType, class T >
-inline VkMemoryRequirements getMemoryRequirements( VkDevice device, T resource );
+inline VkMemoryRequirements getMemoryRequirements( VkDevice device, T resource, VkMemoryDedicatedRequirementsKHR* dedicatedRequirements = nullptr );
 
 template<>
-inline VkMemoryRequirements getMemoryRequirements< ResourceType::Buffer >( VkDevice device, VkBuffer buffer ){
+inline VkMemoryRequirements getMemoryRequirements< ResourceType::Buffer >( VkDevice device, VkBuffer buffer, VkMemoryDedicatedRequirementsKHR* dedicatedRequirements ){
+	if( dedicatedRequirements ){
+		const VkBufferMemoryRequirementsInfo2KHR info{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2_KHR, nullptr, buffer };
+		VkMemoryRequirements2KHR memoryRequirements{ VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2_KHR, dedicatedRequirements, {} };
+		vkGetBufferMemoryRequirements2KHR( device, &info, &memoryRequirements );
+
+		return memoryRequirements.memoryRequirements;
+	}
+
 	VkMemoryRequirements memoryRequirements;
 	vkGetBufferMemoryRequirements( device, buffer, &memoryRequirements );
 
@@ -203,13 +348,34 @@ inline VkMemoryRequirements getMemoryRequirements< ResourceType::Buffer >( VkDev
 }
 
 template<>
-inline VkMemoryRequirements getMemoryRequirements< ResourceType::Image >( VkDevice device, VkImage image ){
+inline VkMemoryRequirements getMemoryRequirements< ResourceType::Image >( VkDevice device, VkImage image, VkMemoryDedicatedRequirementsKHR* dedicatedRequirements ){
+	if( dedicatedRequirements ){
+		const VkImageMemoryRequirementsInfo2KHR info{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2_KHR, nullptr, image };
+		VkMemoryRequirements2KHR memoryRequirements{ VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2_KHR, dedicatedRequirements, {} };
+		vkGetImageMemoryRequirements2KHR( device, &info, &memoryRequirements );
+
+		return memoryRequirements.memoryRequirements;
+	}
+
 	VkMemoryRequirements memoryRequirements;
 	vkGetImageMemoryRequirements( device, image, &memoryRequirements );
 
 	return memoryRequirements;
 }
 
+template< ResourceType resourceType, class T >
+inline VkMemoryDedicatedAllocateInfoKHR getDedicatedAllocateInfo( T resource );
+
+template<>
+inline VkMemoryDedicatedAllocateInfoKHR getDedicatedAllocateInfo< ResourceType::Buffer >( VkBuffer buffer ){
+	return { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO_KHR, nullptr, VK_NULL_HANDLE /*image*/, buffer };
+}
+
+template<>
+inline VkMemoryDedicatedAllocateInfoKHR getDedicatedAllocateInfo< ResourceType::Image >( VkImage image ){
+	return { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO_KHR, nullptr, image, VK_NULL_HANDLE /*buffer*/ };
+}
+
 template< ResourceType resourceType, class T >
 inline void bindMemory( VkDevice device, T buffer, VkDeviceMemory memory, VkDeviceSize offset );
 
@@ -224,13 +390,21 @@ inline void bindMemory< ResourceType::Image >( VkDevice device, VkImage image, V
 }
 
 template< ResourceType resourceType, class T >
-inline VkDeviceMemory initMemory(
+inline MemoryAllocation initMemory(
 	VkDevice device,
 	VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties,
 	T resource,
 	const std::vector<VkMemoryPropertyFlags>& memoryTypePriority
 ){
-	const VkMemoryRequirements memoryRequirements = getMemoryRequirements<resourceType>( device, resource );
+	const bool dedicatedAllocation = isDedicatedAllocationEnabled( device );
+
+	VkMemoryDedicatedRequirementsKHR dedicatedRequirements{
+		VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS_KHR,
+		nullptr, // pNext
+		VK_FALSE, // prefersDedicatedAllocation
+		VK_FALSE // requiresDedicatedAllocation
+	};
+	const VkMemoryRequirements memoryRequirements = getMemoryRequirements<resourceType>( device, resource, dedicatedAllocation ? &dedicatedRequirements : nullptr );
 
 	const auto indexToBit = []( const uint32_t index ){ return 0x1 << index; };
 
@@ -249,17 +423,27 @@ inline VkDeviceMemory initMemory(
 
 	if( memoryType == memoryTypeNotFound ) throw "Can't find compatible mappable memory for the resource";
 
-	VkMemoryAllocateInfo memoryInfo{
-		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-		nullptr, // pNext
-		memoryRequirements.size,
-		memoryType
-	};
+	// initImage() always makes optimal tiling images
+	const ResourceKind kind = resourceType == ResourceType::Image ? ResourceKind::Optimal : ResourceKind::Linear;
+
+	const bool preferDedicated =
+		   dedicatedRequirements.prefersDedicatedAllocation
+		|| dedicatedRequirements.requiresDedicatedAllocation
+		|| (resourceType == ResourceType::Image && memoryRequirements.size >= VulkanConfig::dedicatedImageThreshold);
+
+	const VkMemoryDedicatedAllocateInfoKHR dedicatedInfo = getDedicatedAllocateInfo<resourceType>( resource );
 
-	VkDeviceMemory memory;
-	VkResult errorCode = vkAllocateMemory( device, &memoryInfo, nullptr, &memory ); RESULT_HANDLER( errorCode, "vkAllocateMemory" );
+	const MemoryAllocation memory = allocateMemory(
+		device,
+		physicalDeviceMemoryProperties,
+		memoryRequirements,
+		memoryType,
+		kind,
+		preferDedicated,
+		dedicatedAllocation ? &dedicatedInfo : nullptr
+	);
 
-	bindMemory<resourceType>( device, resource, memory, 0 /*offset*/ );
+	bindMemory<resourceType>( device, resource, memory.memory, memory.offset );
 
 	return memory;
 }
@@ -267,15 +451,9 @@ inline VkDeviceMemory initMemory(
 //Kill all vulkan handles
 void cleanupVulkan(VkDevice device,
     VkInstance instance,
-    vector<VkSemaphore>& renderSs,
     VkPipeline pipeline,
-    vector<VkFramebuffer>& framebuffers,
-    vector<VkImageView>& imageViews,
-    VkSwapchainKHR swapchain,
     vector<VkSemaphore>& imageSs,
-    vector<VkFence>& fences,
-    VkCommandPool commandPool,
-    VkDeviceMemory vertexBufferMemory,
+    const MemoryAllocation& vertexBufferMemory,
     VkBuffer vertexBuffer,
     VkPipelineLayout pipelineLayout,
     VkShaderModule fragmentShader,
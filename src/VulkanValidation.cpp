@@ -10,7 +10,7 @@
 #include <EnumerateScheme.h>
 #include <VulkanConfig.h>
 #include <VulkanImpl.h>
-#include <Glfw.h>
+#include <Wsi.h>
 
 #include <vector>
 
@@ -41,8 +41,8 @@ VulkanManager :: VulkanManager()
   vector<const char*> requestedInstanceExtensions = {
     VK_KHR_SURFACE_EXTENSION_NAME,
     platformSurfaceExtension.c_str(),
+    VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, // VK_KHR_timeline_semaphore depends on it
 #ifdef __APPLE__
-    VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
     VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME
 #endif
   };
@@ -0,0 +1,109 @@
+// Headless (no display server) WSI handling and event loop -- uses VK_EXT_headless_surface
+#include "VulkanEnvironment.h"
+
+#include <WSI/Headless.h>
+
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <string>
+
+#include <vulkan/vulkan.h>
+
+#include "CompilerMessages.h"
+#include "ErrorHandling.h"
+#include "ExtensionLoader.h"
+#include "VulkanConfig.h"
+
+// Implementation
+//////////////////////////////////
+
+bool nullHandler(){ return false; }
+std::function<bool(void)> sizeEventHandler = nullHandler;
+
+void setSizeEventHandler( std::function<bool(void)> newSizeEventHandler ){
+	if( !newSizeEventHandler ) sizeEventHandler = nullHandler;
+	sizeEventHandler = newSizeEventHandler;
+}
+
+std::function<void(void)> paintEventHandler = nullHandler;
+
+void setPaintEventHandler( std::function<void(void)> newPaintEventHandler ){
+	if( !newPaintEventHandler ) paintEventHandler = nullHandler;
+	paintEventHandler = newPaintEventHandler;
+}
+
+
+uint64_t headlessFrameCount = VulkanConfig::headlessFrameCount;
+
+void setHeadlessFrameCount( const uint64_t frameCount ){
+	headlessFrameCount = frameCount;
+}
+
+uint64_t getHeadlessFrameCount(){
+	return headlessFrameCount;
+}
+
+
+bool hasSwapchain = false;
+
+void showWindow( PlatformWindow ){
+	// nothing ever resizes a headless surface, so this is the one and only size event
+	hasSwapchain = sizeEventHandler();
+}
+
+std::string getPlatformSurfaceExtensionName(){ return VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME; }
+
+int messageLoop( PlatformWindow ){
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+
+	if( !hasSwapchain ) throw "Headless surface does not allow creating a swapchain of the requested size!";
+
+	const auto start = steady_clock::now();
+
+	uint64_t framesPainted = 0;
+	while( framesPainted < headlessFrameCount ){
+		paintEventHandler();
+		++framesPainted;
+	}
+
+	const double seconds = duration<double>( steady_clock::now() - start ).count();
+	logger << "INFO: Headless WSI painted " << framesPainted << " frames in " << seconds << " s";
+	if( seconds > 0.0 ) logger << " (" << framesPainted / seconds << " FPS)";
+	logger << std::endl;
+
+	return EXIT_SUCCESS;
+}
+
+
+bool platformPresentationSupport( VkInstance, VkPhysicalDevice, uint32_t, PlatformWindow ){
+	return true; // VK_EXT_headless_surface does not restrict presentation; vkGetPhysicalDeviceSurfaceSupportKHR has the final word
+}
+
+PlatformWindow initWindow( const std::string&, const uint32_t canvasWidth, const uint32_t canvasHeight ){
+	if( canvasWidth == 0 || canvasHeight == 0 ) throw "Headless canvas must have non-zero size!";
+
+	return { canvasWidth, canvasHeight };
+}
+
+void killWindow( PlatformWindow ){
+	// nothing to destroy
+}
+
+VkSurfaceKHR initSurface( const VkInstance instance, const PlatformWindow ){
+	const VkHeadlessSurfaceCreateInfoEXT surfaceInfo{
+		VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT,
+		nullptr, // pNext
+		0 // flags - reserved for future use
+	};
+
+	VkSurfaceKHR surface;
+	const VkResult errorCode = vkCreateHeadlessSurfaceEXT( instance, &surfaceInfo, nullptr, &surface ); RESULT_HANDLER( errorCode, "vkCreateHeadlessSurfaceEXT" );
+
+	return surface;
+}
+
+uint32_t getWindowWidth( const PlatformWindow window ){ return window.width; }
+uint32_t getWindowHeight( const PlatformWindow window ){ return window.height; }
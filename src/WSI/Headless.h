@@ -0,0 +1,42 @@
+// Headless (no display server) WSI handling and event loop -- uses VK_EXT_headless_surface
+
+#ifndef COMMON_HEADLESS_WSI_H
+#define COMMON_HEADLESS_WSI_H
+
+#include <functional>
+#include <string>
+
+#include <vulkan/vulkan.h>
+
+#include "CompilerMessages.h"
+#include "ErrorHandling.h"
+
+
+// there is no real window; the "canvas" size is all the swapchain needs to know
+struct PlatformWindow{ uint32_t width; uint32_t height; };
+
+void setSizeEventHandler( std::function<bool(void)> newSizeEventHandler );
+void setPaintEventHandler( std::function<void(void)> newPaintEventHandler );
+
+// how many times messageLoop() calls the paint handler before it returns
+void setHeadlessFrameCount( uint64_t frameCount );
+uint64_t getHeadlessFrameCount();
+
+void showWindow( PlatformWindow window );
+std::string getPlatformSurfaceExtensionName();
+
+int messageLoop( PlatformWindow window );
+
+
+bool platformPresentationSupport( VkInstance instance, VkPhysicalDevice device, uint32_t queueFamilyIndex, PlatformWindow window );
+PlatformWindow initWindow( const std::string& name, uint32_t canvasWidth, uint32_t canvasHeight );
+void killWindow( PlatformWindow window );
+
+VkSurfaceKHR initSurface( VkInstance instance, PlatformWindow window );
+// killSurface() is not platform dependent
+
+// headless surface reports undefined currentExtent, so the swapchain takes the size from here
+uint32_t getWindowWidth( PlatformWindow window );
+uint32_t getWindowHeight( PlatformWindow window );
+
+#endif //COMMON_HEADLESS_WSI_H
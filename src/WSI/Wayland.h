@@ -144,7 +144,7 @@ void keyboardKeymapHandler( void* data, wl_keyboard* keyboard, uint32_t format,
 	xkb_state_unref( wnd->xkbState );
 	xkb_keymap_unref( wnd->keymap );
 
-	const char* keymapBuffer = (const char*)mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 ); RUNTIME_ASSERT( keymapBuffer != MAP_FAILED, "mmap of keymap")
+	const char* keymapBuffer = (const char*)mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 ); RUNTIME_ASSERT( keymapBuffer != MAP_FAILED, "mmap of keymap" );
 	wnd->keymap = xkb_keymap_new_from_string( wnd->xkbContext, keymapBuffer, XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS ); RUNTIME_ASSERT( wnd->keymap, "xkb_keymap_new_from_string" );
 	{const auto err = munmap( (void*)keymapBuffer, size ); RUNTIME_ASSERT( !err, "munmap of keymap" );}
 	{const auto err = close( fd ); RUNTIME_ASSERT( !err, "close of keymap fd" );}
@@ -0,0 +1,98 @@
+// Chase-Lev work-stealing deque: one owner thread pushes and pops at the bottom, any thread steals from the top
+
+#ifndef COMMON_WORK_STEALING_DEQUE_H
+#define COMMON_WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+// Lock-free, after "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli, 2013).
+// The owner works LIFO (cache-warm, depth-first), thieves take the oldest items, which tend to be the biggest pieces of work.
+// The ring grows on push when full; replaced rings are kept until destruction, as a thief may still be reading one.
+template<typename T>
+class WorkStealingDeque{
+public:
+	explicit WorkStealingDeque( size_t capacity = 1024 ) // rounded up to a power of 2
+	: m_top( 0 ), m_bottom( 0 )
+	{
+		size_t powerOf2 = 1;
+		while( powerOf2 < capacity ) powerOf2 *= 2;
+		m_rings.emplace_back( new Ring( powerOf2 ) );
+		m_ring.store( m_rings.back().get(), std::memory_order_relaxed );
+	}
+	WorkStealingDeque( const WorkStealingDeque& ) = delete;
+	WorkStealingDeque& operator=( const WorkStealingDeque& ) = delete;
+
+	// owner only
+	void push( T* const item ){
+		const int64_t bottom = m_bottom.load( std::memory_order_relaxed );
+		const int64_t top = m_top.load( std::memory_order_acquire );
+		Ring* ring = m_ring.load( std::memory_order_relaxed );
+
+		if( bottom - top > int64_t( ring->mask ) ) ring = grow( ring, top, bottom );
+
+		ring->at( bottom ).store( item, std::memory_order_relaxed );
+		m_bottom.store( bottom + 1, std::memory_order_release ); // publishes the item to the acquire in steal()
+	}
+
+	// owner only; nullptr if empty
+	T* pop(){
+		const int64_t bottom = m_bottom.load( std::memory_order_relaxed ) - 1;
+		Ring* const ring = m_ring.load( std::memory_order_relaxed );
+		m_bottom.store( bottom, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		int64_t top = m_top.load( std::memory_order_relaxed );
+
+		if( top > bottom ){ // was empty
+			m_bottom.store( bottom + 1, std::memory_order_relaxed );
+			return nullptr;
+		}
+
+		T* item = ring->at( bottom ).load( std::memory_order_relaxed );
+		if( top == bottom ){ // the last item; a thief may be after it too
+			if( !m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) item = nullptr;
+			m_bottom.store( bottom + 1, std::memory_order_relaxed );
+		}
+		return item;
+	}
+
+	// any thread; nullptr if empty or if another thread won the race for the item
+	T* steal(){
+		int64_t top = m_top.load( std::memory_order_acquire );
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		const int64_t bottom = m_bottom.load( std::memory_order_acquire );
+		if( top >= bottom ) return nullptr;
+
+		Ring* const ring = m_ring.load( std::memory_order_acquire );
+		T* const item = ring->at( top ).load( std::memory_order_relaxed );
+		if( !m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) return nullptr;
+		return item;
+	}
+
+private:
+	struct Ring{
+		explicit Ring( const size_t capacity ) : mask( capacity - 1 ), items( new std::atomic<T*>[capacity] ) {}
+		std::atomic<T*>& at( const int64_t i ){ return items[size_t( i ) & mask]; }
+
+		const size_t mask;
+		std::unique_ptr< std::atomic<T*>[] > items;
+	};
+
+	Ring* grow( Ring* const ring, const int64_t top, const int64_t bottom ){
+		m_rings.emplace_back(  new Ring( 2 * (ring->mask + 1) )  );
+		Ring* const bigger = m_rings.back().get();
+		for( int64_t i = top; i < bottom; ++i ) bigger->at( i ).store( ring->at( i ).load( std::memory_order_relaxed ), std::memory_order_relaxed );
+		m_ring.store( bigger, std::memory_order_release );
+		return bigger;
+	}
+
+	alignas( 64 ) std::atomic<int64_t> m_top; // thieves contend here; kept off the owner's cache line
+	alignas( 64 ) std::atomic<int64_t> m_bottom;
+	std::atomic<Ring*> m_ring;
+	std::vector< std::unique_ptr<Ring> > m_rings; // owner only; every ring ever used, the current one last
+};
+
+#endif //COMMON_WORK_STEALING_DEQUE_H
@@ -0,0 +1,261 @@
+// Chunk mesher working on 64-bit opacity masks of whole voxel rows; produces exactly the quads of GreedyMesher
+#include "BinaryMesher.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+// Implementation
+//////////////////////////////////
+
+static_assert( Chunk::size == 32, "The masks have one bit per voxel of a 32 wide chunk, plus padding" );
+
+static uint32_t countTrailingZeros( const uint32_t x ){ // x must not be 0
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward( &index, x );
+	return index;
+#else
+	return static_cast<uint32_t>( __builtin_ctz( x ) );
+#endif
+}
+
+static uint32_t countTrailingZeros64( const uint64_t x ){ // x must not be 0
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64( &index, x );
+	return index;
+#elif defined(_MSC_VER)
+	const uint32_t low = static_cast<uint32_t>( x );
+	return low ? countTrailingZeros( low ) : 32 + countTrailingZeros(  static_cast<uint32_t>( x >> 32 )  );
+#else
+	return static_cast<uint32_t>( __builtin_ctzll( x ) );
+#endif
+}
+
+// in place; bit c of a[r] becomes bit r of a[c]
+static void transpose32( uint32_t* const a ){
+	uint32_t mask = 0x0000FFFFu;
+	for( uint32_t j = 16; j != 0; j >>= 1, mask ^= mask << j ){
+		for( uint32_t k = 0; k < 32; k = (k + j + 1) & ~j ){
+			const uint32_t t = ((a[k] >> j) ^ a[k + j]) & mask;
+			a[k] ^= t << j;
+			a[k + j] ^= t;
+		}
+	}
+}
+
+// Bit x of opaque: row[x] is opaque; bit x of same: row[x] == material. For the paddedSize voxels of one padded row.
+static void classifyRow( const BlockId* const row, const BlockId material, uint64_t& opaque, uint64_t& same ){
+	opaque = 0;
+	same = 0;
+	for( uint32_t x = 0; x < paddedSize; ++x ){
+		opaque |= uint64_t( Block::isOpaque( row[x] ) ) << x;
+		same |= uint64_t( row[x] == material ) << x;
+	}
+}
+
+#if CPU_X86
+// one bit per 16-bit compare result of a and b; the pack interleaves the 128-bit lanes, the permute puts them back in order
+TARGET_AVX2 static inline uint64_t movemask16( const __m256i a, const __m256i b ){
+	const __m256i bytes = _mm256_permute4x64_epi64( _mm256_packs_epi16( a, b ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+	return uint64_t(  static_cast<uint32_t>( _mm256_movemask_epi8( bytes ) )  );
+}
+
+// Block::isOpaque() is block != air, which this does 16 voxels at a time
+TARGET_AVX2 static void classifyRowAvx2( const BlockId* const row, const BlockId material, uint64_t& opaque, uint64_t& same ){
+	const __m256i air = _mm256_setzero_si256();
+	const __m256i materials = _mm256_set1_epi16( static_cast<short>( material ) );
+
+	const __m256i low = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( row ) );
+	const __m256i high = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( row + 16 ) );
+
+	const uint64_t isAir = movemask16(  _mm256_cmpeq_epi16( low, air ), _mm256_cmpeq_epi16( high, air )  );
+	const uint64_t isSame = movemask16(  _mm256_cmpeq_epi16( low, materials ), _mm256_cmpeq_epi16( high, materials )  );
+
+	opaque = ~isAir & 0xFFFFFFFFull;
+	same = isSame;
+	for( uint32_t x = 32; x < paddedSize; ++x ){
+		opaque |= uint64_t( Block::isOpaque( row[x] ) ) << x;
+		same |= uint64_t( row[x] == material ) << x;
+	}
+}
+#endif
+
+BinaryMesher::BinaryMesher( const bool allowAvx2 )
+: m_avx2( allowAvx2 && getCpuFeatures().avx2 ), m_opaque( paddedSize * paddedSize ), m_faces( Face::count * Chunk::size * Chunk::size )
+{}
+
+void BinaryMesher::mesh( const ChunkNeighborhood& chunks, ChunkMesh& mesh ){
+	mesh.clear();
+	if( !hasVisibleFaces( chunks ) ) return;
+
+	gatherPaddedVoxels( chunks, m_voxels, m_span );
+	buildOpacity();
+	buildFaces();
+
+	// in the order of GreedyMesher, so even the quad order matches; slices without visible faces are skipped
+	for( uint8_t face = 0; face < Face::count; ++face ){
+		for( uint32_t slices = m_slices[face]; slices; slices &= slices - 1 ) mergeSlice( face, countTrailingZeros( slices ), mesh );
+	}
+
+	mesh.vertices.resize( 4 * mesh.quads.size() );
+	for( size_t i = 0; i < mesh.quads.size(); ++i ) writeQuadVertices( mesh.quads[i], &mesh.vertices[4 * i] );
+}
+
+void BinaryMesher::buildOpacity(){
+	const uint64_t center = 0x1FFFFFFFEull; // padded x of the chunk's own voxels
+
+	BlockId material = Block::air; // the first opaque block type met in the chunk
+	bool mixed = false;
+	for( uint32_t py = 0; py < paddedSize; ++py ){
+		for( uint32_t pz = 0; pz < paddedSize; ++pz ){
+			const BlockId* const row = m_voxels.data() + paddedIndex( 0, py, pz );
+
+			uint64_t opaque, same;
+#if CPU_X86
+			if( m_avx2 ) classifyRowAvx2( row, material, opaque, same );
+			else
+#endif
+			classifyRow( row, material, opaque, same );
+			m_opaque[py * paddedSize + pz] = opaque;
+
+			const bool inChunk = py - 1 < Chunk::size && pz - 1 < Chunk::size; // unsigned wrap-around rejects 0 too
+			const uint64_t opaqueInChunk = opaque & center;
+			if( !inChunk || !opaqueInChunk ) continue;
+
+			if( material == Block::air ){
+				material = row[countTrailingZeros64( opaqueInChunk )];
+				classifyRow( row, material, opaque, same );
+			}
+			mixed = mixed || (opaqueInChunk & ~same);
+		}
+	}
+
+	m_singleMaterial = !mixed;
+}
+
+void BinaryMesher::buildFaces(){
+	const uint32_t n = Chunk::size;
+	const auto rowAt = [this]( uint32_t py, uint32_t pz ){ return m_opaque[py * paddedSize + pz]; };
+	uint32_t* const faces = m_faces.data();
+	const auto slice = [faces, n]( uint8_t face, uint32_t slice ){ return faces + (face * n + slice) * n; };
+
+	// bit x of the result: the face of chunk voxel x is visible; the padding bits fall off
+	const auto visible = []( uint64_t voxels, uint64_t front ){ return static_cast<uint32_t>(  (voxels & ~front) >> 1  ); };
+
+	for( uint32_t& slices : m_slices ) slices = 0;
+
+	for( uint32_t y = 0; y < n; ++y ){
+		for( uint32_t z = 0; z < n; ++z ){
+			const uint64_t voxels = rowAt( y + 1, z + 1 );
+
+			// Z faces: slice z, rows y, bits x -- already in the layout the merge wants
+			const uint32_t posZ = slice( Face::posZ, z )[y] = visible( voxels, rowAt( y + 1, z + 2 ) );
+			const uint32_t negZ = slice( Face::negZ, z )[y] = visible( voxels, rowAt( y + 1, z ) );
+			m_slices[Face::posZ] |= uint32_t( posZ != 0 ) << z;
+			m_slices[Face::negZ] |= uint32_t( negZ != 0 ) << z;
+
+			// Y faces: slice y, rows x, bits z; stored as rows z, bits x, and transposed below
+			const uint32_t posY = slice( Face::posY, y )[z] = visible( voxels, rowAt( y + 2, z + 1 ) );
+			const uint32_t negY = slice( Face::negY, y )[z] = visible( voxels, rowAt( y, z + 1 ) );
+			m_slices[Face::posY] |= uint32_t( posY != 0 ) << y;
+			m_slices[Face::negY] |= uint32_t( negY != 0 ) << y;
+
+			// X faces: slice x, rows z, bits y; stored as [z][y], bits x, and transposed below
+			// the bits are x already, so any face of slice x sets bit x of the OR of them all
+			m_slices[Face::posX] |= slice( Face::posX, z )[y] = visible( voxels, voxels >> 1 );
+			m_slices[Face::negX] |= slice( Face::negX, z )[y] = visible( voxels, voxels << 1 );
+		}
+	}
+
+	for( const uint8_t face : {Face::posY, Face::negY} ){
+		for( uint32_t slices = m_slices[face]; slices; slices &= slices - 1 ){
+			transpose32(  slice( face, countTrailingZeros( slices ) )  ); // [y][x], bits z
+		}
+	}
+	for( const uint8_t face : {Face::posX, Face::negX} ){
+		for( uint32_t z = 0; z < n; ++z ){
+			uint32_t* const rows = slice( face, z );
+			uint32_t any = 0;
+			for( uint32_t i = 0; i < n; ++i ) any |= rows[i];
+			if( any ) transpose32( rows ); // [z][x], bits y
+		}
+
+		// and the words themselves to [x][z]
+		for( uint32_t x = 0; x < n; ++x ){
+			for( uint32_t z = x + 1; z < n; ++z ) std::swap( slice( face, x )[z], slice( face, z )[x] );
+		}
+	}
+}
+
+void BinaryMesher::mergeSlice( const uint8_t face, const uint32_t slice, ChunkMesh& mesh ){
+	const uint32_t n = Chunk::size;
+	uint32_t* const rows = m_faces.data() + (face * n + slice) * n;
+
+	const uint32_t axis = Face::axis( face );
+	const uint32_t u = (axis + 1) % 3;
+	const uint32_t v = (axis + 2) % 3;
+
+	// m_voxels index of the chunk voxel at (column, row) of this slice is base + column * strideU + row * strideV
+	const uint32_t strides[3] = { 1, paddedSize * paddedSize, paddedSize };
+	const uint32_t base = (slice + 1) * strides[axis] + strides[u] + strides[v];
+	const uint32_t strideU = strides[u];
+	const uint32_t strideV = strides[v];
+	const BlockId* const voxels = m_voxels.data();
+
+	const auto runMatches = [&]( uint32_t column, uint32_t width, uint32_t row, BlockId block ){
+		const BlockId* voxel = voxels + base + column * strideU + row * strideV;
+		for( uint32_t k = 0; k < width; ++k, voxel += strideU ) if( *voxel != block ) return false;
+		return true;
+	};
+
+	for( uint32_t row = 0; row < n; ++row ){
+		while( rows[row] ){
+			const uint32_t column = countTrailingZeros( rows[row] );
+			const BlockId block = voxels[base + column * strideU + row * strideV];
+
+			// the run of faces starting at column, cut where the block type changes
+			const uint32_t ones = rows[row] >> column;
+			uint32_t width = ~ones ? countTrailingZeros( ~ones ) : n - column;
+			if( !m_singleMaterial ){
+				const BlockId* voxel = voxels + base + (column + 1) * strideU + row * strideV;
+				for( uint32_t k = 1; k < width; ++k, voxel += strideU ){
+					if( *voxel != block ){
+						width = k;
+						break;
+					}
+				}
+			}
+
+			const uint32_t run = (width == 32 ? ~0u : (1u << width) - 1) << column;
+			rows[row] &= ~run;
+
+			uint32_t height = 1;
+			for( ; row + height < n; ++height ){
+				uint32_t& next = rows[row + height];
+				if( (next & run) != run ) break;
+				if( !m_singleMaterial && !runMatches( column, width, row + height, block ) ) break;
+				next &= ~run;
+			}
+
+			MeshQuad quad;
+			quad.face = face;
+			uint8_t* const position[3] = { &quad.x, &quad.y, &quad.z };
+			*position[axis] = static_cast<uint8_t>( slice );
+			*position[u] = static_cast<uint8_t>( column );
+			*position[v] = static_cast<uint8_t>( row );
+			quad.width = static_cast<uint8_t>( width );
+			quad.height = static_cast<uint8_t>( height );
+			quad.block = block;
+			mesh.quads.push_back( quad );
+			mesh.faceCount += width * height;
+		}
+	}
+}
@@ -0,0 +1,43 @@
+// Chunk mesher working on 64-bit opacity masks of whole voxel rows; produces exactly the quads of GreedyMesher
+
+#ifndef COMMON_BINARY_MESHER_H
+#define COMMON_BINARY_MESHER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Block.h"
+#include "Chunk.h"
+#include "ChunkMesh.h"
+
+
+// Opacity of every padded row along x is one 64-bit mask (34 bits used), so the visible faces of 32 voxels at once
+// are an AND-NOT against the row shifted by one (X faces) or against the neighboring row (Y and Z faces).
+// The face masks are transposed 32x32 where needed, so each slice is 32 rows of 32 bits along the quad's u axis,
+// and the greedy merge is find-first-set, run lengths and mask compares instead of a walk over every voxel.
+// Block types are only looked up along the runs, and not at all when the chunk has a single opaque block type.
+// AVX2 classifies the rows; without it the same is done by scalar code.
+class BinaryMesher{
+public:
+	explicit BinaryMesher( bool allowAvx2 = true ); // uses AVX2 if this allows it and the CPU has it
+
+	bool usesAvx2() const{ return m_avx2; }
+
+	void mesh( const ChunkNeighborhood& chunks, ChunkMesh& mesh ); // mesh is cleared first
+
+private:
+	void buildOpacity(); // m_opaque, m_singleMaterial from m_voxels
+	void buildFaces(); // m_faces from m_opaque
+	void mergeSlice( uint8_t face, uint32_t slice, ChunkMesh& mesh );
+
+	bool m_avx2;
+
+	std::vector<BlockId> m_voxels; // see gatherPaddedVoxels
+	std::vector<BlockId> m_span;
+	std::vector<uint64_t> m_opaque; // [py][pz], bit px; padded coordinates
+	std::vector<uint32_t> m_faces; // [face][slice][v], bit u; visible faces still to be merged
+	uint32_t m_slices[Face::count]; // bit slice: m_faces has any of that slice
+	bool m_singleMaterial;
+};
+
+#endif //COMMON_BINARY_MESHER_H
@@ -0,0 +1,25 @@
+// Block type ids stored in chunks, and their properties the mesher needs
+
+#ifndef COMMON_BLOCK_H
+#define COMMON_BLOCK_H
+
+#include <cstdint>
+
+
+using BlockId = uint16_t;
+
+namespace Block{
+	constexpr BlockId air = 0;
+	constexpr BlockId stone = 1;
+	constexpr BlockId dirt = 2;
+	constexpr BlockId grass = 3;
+	constexpr BlockId sand = 4;
+	constexpr BlockId water = 5;
+	constexpr BlockId snow = 6;
+	constexpr BlockId wood = 7;
+
+	// hides the faces of its neighbors; everything but air for now
+	inline bool isOpaque( const BlockId block ){ return block != air; }
+}
+
+#endif //COMMON_BLOCK_H
@@ -0,0 +1,252 @@
+// Fixed-size cube of voxels, stored as a per-chunk palette + bit-packed palette indices; knows nothing about Vulkan
+#include "Chunk.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Implementation
+//////////////////////////////////
+
+// the narrowest supported index width (log2 of 1, 2, 4, 8 or 16 bits) able to address paletteSize entries
+static uint32_t bitsLog2For( const size_t paletteSize ){
+	uint32_t bitsLog2 = 0;
+	while( bitsLog2 < 4 && (size_t( 1 ) << (1u << bitsLog2)) < paletteSize ) ++bitsLog2;
+	return bitsLog2;
+}
+
+// the fixed-size copies compile to a single move or two
+template< uint32_t perByte >
+static void decodeWords( const uint64_t* const words, const uint32_t wordCount, const BlockId (&table)[256][8], BlockId* out ){
+	for( uint32_t w = 0; w < wordCount; ++w ){
+		uint64_t word = words[w];
+		for( uint32_t byte = 0; byte < 8; ++byte, word >>= 8 ){
+			std::memcpy( out, table[word & 0xFF], perByte * sizeof( BlockId ) );
+			out += perByte;
+		}
+	}
+}
+
+Chunk::Chunk( const BlockId block )
+: m_palette{ block }, m_counts{ volume }
+{}
+
+void Chunk::set( const uint32_t index, const BlockId block ){
+	if( isUniform() ){
+		if( block == m_palette[0] ) return;
+
+		setBitsLog2( 0 );
+		m_words.assign( volume >> 6, 0 ); // every voxel is palette entry 0
+	}
+
+	const uint32_t oldEntry = readIndex( index );
+	if( m_palette[oldEntry] == block ) return;
+
+	const int32_t found = findEntry( block );
+	const uint32_t entry = found >= 0 ? static_cast<uint32_t>( found ) : addEntry( block ); // before writing; may re-encode
+	writeIndex( index, entry );
+
+	++m_counts[entry];
+	if( --m_counts[oldEntry] == 0 ) releaseEntry( oldEntry );
+
+	if( m_counts[entry] == volume ) fill( block ); // the last other voxel was overwritten
+}
+
+void Chunk::getSpan( const uint32_t begin, const uint32_t count, BlockId* const blocks ) const{
+	if( isUniform() ){
+		std::fill( blocks, blocks + count, m_palette[0] );
+		return;
+	}
+
+	// Narrow indices: a byte of them at a time, through a table of the 8, 4 or 2 blocks each byte value expands to.
+	// Building the table costs about as much as decoding a few hundred voxels one by one.
+	const uint32_t perByte = 8 >> m_bitsLog2;
+	if( m_bitsLog2 <= 2 && count >= 512 && begin % 64 == 0 && count % 64 == 0 ){
+		BlockId table[256][8];
+		for( uint32_t byte = 0; byte < 256; ++byte ){
+			for( uint32_t k = 0; k < perByte; ++k ){
+				const uint32_t entry = (byte >> (k << m_bitsLog2)) & static_cast<uint32_t>( m_indexMask );
+				table[byte][k] = entry < m_palette.size() ? m_palette[entry] : Block::air; // only used entries occur
+			}
+		}
+
+		const uint32_t firstWord = begin >> (6 - m_bitsLog2);
+		const uint32_t wordCount = count >> (6 - m_bitsLog2);
+		switch( perByte ){
+			case 8: decodeWords<8>( m_words.data() + firstWord, wordCount, table, blocks ); break;
+			case 4: decodeWords<4>( m_words.data() + firstWord, wordCount, table, blocks ); break;
+			default: decodeWords<2>( m_words.data() + firstWord, wordCount, table, blocks ); break;
+		}
+		return;
+	}
+
+	// whole words at a time instead of recomputing the position of every index
+	const uint32_t bits = 1u << m_bitsLog2;
+	const uint32_t slotsLog2 = 6 - m_bitsLog2;
+	const uint32_t slotMask = (1u << slotsLog2) - 1;
+	const uint32_t end = begin + count;
+
+	BlockId* out = blocks;
+	for( uint32_t i = begin; i < end; ){
+		const uint32_t slot = i & slotMask;
+		uint64_t word = m_words[i >> slotsLog2] >> (slot << m_bitsLog2);
+		const uint32_t inWord = std::min( end - i, (slotMask + 1) - slot );
+
+		for( uint32_t k = 0; k < inWord; ++k ){
+			*out++ = m_palette[word & m_indexMask];
+			word >>= bits;
+		}
+		i += inWord;
+	}
+}
+
+void Chunk::setSpan( const uint32_t begin, const uint32_t count, const BlockId* const blocks ){
+	if( begin != 0 || count != volume ){
+		for( uint32_t k = 0; k < count; ++k ) set( begin + k, blocks[k] );
+		return;
+	}
+
+	// Whole chunk (e.g. freshly generated): build the palette while the chunk is formally uniform, so adding entries
+	// never re-encodes, then encode once at the final width.
+	m_palette.clear();
+	m_counts.clear();
+	m_freeEntries.clear();
+	m_lookup.clear();
+	m_words.clear();
+
+	std::vector<uint32_t> indices( volume );
+	uint32_t entry = 0;
+	for( uint32_t i = 0; i < volume; ++i ){
+		if( i == 0 || blocks[i] != blocks[i - 1] ){ // runs are the common case
+			const int32_t found = findEntry( blocks[i] );
+			entry = found >= 0 ? static_cast<uint32_t>( found ) : addEntry( blocks[i] );
+		}
+		indices[i] = entry;
+		++m_counts[entry];
+	}
+
+	if( m_palette.size() == 1 ) fill( m_palette[0] );
+	else encode(  indices, bitsLog2For( m_palette.size() )  );
+}
+
+void Chunk::fill( const BlockId block ){
+	m_palette.assign( 1, block );
+	m_counts.assign( 1, volume );
+	m_freeEntries.clear();
+	m_lookup.clear();
+
+	m_words.clear();
+	m_words.shrink_to_fit();
+	setBitsLog2( 0 );
+}
+
+void Chunk::compact(){
+	if(  isUniform() || (m_freeEntries.empty() && bitsLog2For( m_palette.size() ) == m_bitsLog2)  ) return;
+
+	std::vector<uint32_t> remap( m_palette.size() );
+	std::vector<BlockId> palette;
+	std::vector<uint32_t> counts;
+	for( uint32_t entry = 0; entry < m_palette.size(); ++entry ){
+		if( m_counts[entry] == 0 ) continue;
+
+		remap[entry] = static_cast<uint32_t>( palette.size() );
+		palette.push_back( m_palette[entry] );
+		counts.push_back( m_counts[entry] );
+	}
+
+	std::vector<uint32_t> indices;
+	decode( indices );
+	for( auto& index : indices ) index = remap[index];
+
+	m_palette = std::move( palette );
+	m_counts = std::move( counts );
+	m_freeEntries.clear();
+
+	m_lookup.clear();
+	if( m_palette.size() > linearSearchLimit ){
+		for( uint32_t entry = 0; entry < m_palette.size(); ++entry ) m_lookup[m_palette[entry]] = entry;
+	}
+
+	encode(  indices, bitsLog2For( m_palette.size() )  );
+}
+
+size_t Chunk::memoryUsage() const{
+	size_t bytes = sizeof( Chunk );
+	bytes += m_words.capacity() * sizeof( uint64_t );
+	bytes += m_palette.capacity() * sizeof( BlockId );
+	bytes += m_counts.capacity() * sizeof( uint32_t );
+	bytes += m_freeEntries.capacity() * sizeof( uint32_t );
+	bytes += m_lookup.bucket_count() * sizeof( void* ) + m_lookup.size() * (sizeof( std::pair<BlockId, uint32_t> ) + sizeof( void* )); // estimate
+
+	return bytes;
+}
+
+int32_t Chunk::findEntry( const BlockId block ) const{
+	if( m_palette.size() > linearSearchLimit ){
+		const auto it = m_lookup.find( block );
+		return it == m_lookup.end() ? -1 : static_cast<int32_t>( it->second );
+	}
+
+	for( uint32_t entry = 0; entry < m_palette.size(); ++entry ){
+		if( m_palette[entry] == block && m_counts[entry] != 0 ) return static_cast<int32_t>( entry );
+	}
+	return -1;
+}
+
+uint32_t Chunk::addEntry( const BlockId block ){
+	uint32_t entry;
+	if( !m_freeEntries.empty() ){
+		entry = m_freeEntries.back();
+		m_freeEntries.pop_back();
+		m_palette[entry] = block;
+	}
+	else{
+		entry = static_cast<uint32_t>( m_palette.size() );
+		m_palette.push_back( block );
+		m_counts.push_back( 0 );
+
+		if( !isUniform() && entry > m_indexMask ){ // widen
+			std::vector<uint32_t> indices;
+			decode( indices );
+			encode( indices, m_bitsLog2 + 1 );
+		}
+	}
+
+	if( m_palette.size() > linearSearchLimit ){
+		if( m_lookup.empty() ){ // just outgrew the linear search
+			for( uint32_t e = 0; e < m_palette.size(); ++e ){
+				if( m_counts[e] != 0 ) m_lookup[m_palette[e]] = e;
+			}
+		}
+		m_lookup[block] = entry;
+	}
+
+	return entry;
+}
+
+void Chunk::releaseEntry( const uint32_t paletteIndex ){
+	m_freeEntries.push_back( paletteIndex );
+	if( !m_lookup.empty() ) m_lookup.erase( m_palette[paletteIndex] );
+}
+
+void Chunk::encode( const std::vector<uint32_t>& indices, const uint32_t bitsLog2 ){
+	setBitsLog2( bitsLog2 );
+
+	const uint32_t slotsLog2 = 6 - bitsLog2;
+	const uint32_t slotMask = (1u << slotsLog2) - 1;
+	m_words.assign( volume >> slotsLog2, 0 );
+	for( uint32_t i = 0; i < volume; ++i ){
+		m_words[i >> slotsLog2] |= uint64_t( indices[i] ) << ((i & slotMask) << bitsLog2);
+	}
+}
+
+void Chunk::decode( std::vector<uint32_t>& indices ) const{
+	indices.resize( volume );
+	for( uint32_t i = 0; i < volume; ++i ) indices[i] = readIndex( i );
+}
+
+void Chunk::setBitsLog2( const uint32_t bitsLog2 ){
+	m_bitsLog2 = bitsLog2;
+	m_indexMask = (uint64_t( 1 ) << (1u << bitsLog2)) - 1;
+}
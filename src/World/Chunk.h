@@ -0,0 +1,84 @@
+// Fixed-size cube of voxels, stored as a per-chunk palette + bit-packed palette indices; knows nothing about Vulkan
+
+#ifndef COMMON_CHUNK_H
+#define COMMON_CHUNK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Block.h"
+
+
+// A chunk with N distinct blocks stores each voxel as an index into its palette, ceil(log2 N) bits wide rounded up to
+// 1, 2, 4, 8 or 16 bits, so an index never straddles two 64-bit words and get()/set() stay O(1). A chunk of a single
+// block (all air, all stone) stores no indices at all. Typical terrain needs 2-4 bits per voxel instead of flat 16.
+// Not thread-safe; a chunk may be read from several threads as long as nobody modifies it.
+class Chunk{
+public:
+	static constexpr uint32_t sizeLog2 = 5;
+	static constexpr uint32_t size = 1u << sizeLog2; // voxels along each axis
+	static constexpr uint32_t volume = size * size * size;
+
+	// x runs fastest, then z, then y; so a row along x, and a horizontal layer, are contiguous spans
+	static uint32_t index( uint32_t x, uint32_t y, uint32_t z ){ return (y << 2*sizeLog2) | (z << sizeLog2) | x; }
+
+	explicit Chunk( BlockId block = Block::air ); // uniform
+
+	BlockId get( uint32_t x, uint32_t y, uint32_t z ) const{ return get(  index( x, y, z )  ); }
+	BlockId get( uint32_t index ) const{ return isUniform() ? m_palette[0] : m_palette[readIndex( index )]; }
+	void set( uint32_t x, uint32_t y, uint32_t z, BlockId block ){ set( index( x, y, z ), block ); }
+	void set( uint32_t index, BlockId block );
+
+	// bulk access of voxels [begin, begin + count) in index() order; much cheaper than get()/set() per voxel
+	void getSpan( uint32_t begin, uint32_t count, BlockId* blocks ) const;
+	void setSpan( uint32_t begin, uint32_t count, const BlockId* blocks ); // the whole chunk at once is re-encoded from scratch
+	void fill( BlockId block ); // makes the chunk uniform
+
+	bool isUniform() const{ return m_words.empty(); }
+	BlockId uniformBlock() const{ return m_palette[0]; } // only meaningful if isUniform()
+	bool isEmpty() const{ return isUniform() && m_palette[0] == Block::air; }
+
+	// Drops palette entries no voxel uses any more, and narrows the indices if the rest fits in fewer bits.
+	// set() only reuses freed entries, so a chunk that once held many block types stays wide until this is called.
+	void compact();
+
+	size_t paletteSize() const{ return m_palette.size() - m_freeEntries.size(); } // distinct blocks in the chunk
+	uint32_t bitsPerVoxel() const{ return isUniform() ? 0 : 1u << m_bitsLog2; }
+	size_t memoryUsage() const; // bytes, including the object itself
+	static constexpr size_t flatMemoryUsage(){ return volume * sizeof( BlockId ); } // the same voxels as a plain array
+
+private:
+	uint32_t readIndex( uint32_t index ) const{
+		const uint32_t slotsLog2 = 6 - m_bitsLog2; // entries per 64-bit word
+		const uint32_t shift = (index & ((1u << slotsLog2) - 1)) << m_bitsLog2;
+		return static_cast<uint32_t>(  (m_words[index >> slotsLog2] >> shift) & m_indexMask  );
+	}
+	void writeIndex( uint32_t index, uint32_t paletteIndex ){
+		const uint32_t slotsLog2 = 6 - m_bitsLog2;
+		const uint32_t shift = (index & ((1u << slotsLog2) - 1)) << m_bitsLog2;
+		uint64_t& word = m_words[index >> slotsLog2];
+		word = (word & ~(m_indexMask << shift)) | (uint64_t( paletteIndex ) << shift);
+	}
+
+	int32_t findEntry( BlockId block ) const; // -1 if not in the palette
+	uint32_t addEntry( BlockId block ); // may widen the indices
+	void releaseEntry( uint32_t paletteIndex );
+	void encode( const std::vector<uint32_t>& indices, uint32_t bitsLog2 ); // replaces m_words
+	void decode( std::vector<uint32_t>& indices ) const;
+	void setBitsLog2( uint32_t bitsLog2 );
+
+	std::vector<BlockId> m_palette; // entries with zero count are free, listed in m_freeEntries
+	std::vector<uint32_t> m_counts; // voxels using each palette entry
+	std::vector<uint32_t> m_freeEntries;
+	std::vector<uint64_t> m_words; // bit-packed palette indices; empty if uniform
+	uint32_t m_bitsLog2 = 0;
+	uint64_t m_indexMask = 0;
+
+	// small palettes are searched linearly; this is kept only once the palette outgrows linearSearchLimit
+	static constexpr size_t linearSearchLimit = 16;
+	std::unordered_map<BlockId, uint32_t> m_lookup;
+};
+
+#endif //COMMON_CHUNK_H
@@ -0,0 +1,253 @@
+// Frustum culling of chunk bounding boxes, region nodes first, 8 boxes per plane test with AVX2
+#include "ChunkCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+// Implementation
+//////////////////////////////////
+
+static uint32_t countTrailingZeros( const uint32_t x ){ // x must not be 0
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward( &index, x );
+	return index;
+#else
+	return static_cast<uint32_t>( __builtin_ctz( x ) );
+#endif
+}
+
+static int32_t floorDiv( const int32_t a, const int32_t b ){ // b > 0
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+void ChunkCuller::Boxes::resize( const size_t newCount ){
+	const size_t padded = (newCount + 7) & ~size_t( 7 );
+	for( int axis = 0; axis < 3; ++axis ){
+		center[axis].resize( padded, 0.0f );
+		extent[axis].resize( padded, 0.0f );
+	}
+	count = newCount;
+}
+
+void ChunkCuller::Boxes::set( const size_t index, const float min[3], const float max[3] ){
+	for( int axis = 0; axis < 3; ++axis ){
+		center[axis][index] = (min[axis] + max[axis]) * 0.5f;
+		extent[axis][index] = (max[axis] - min[axis]) * 0.5f;
+	}
+}
+
+void ChunkCuller::Boxes::move( const size_t from, const size_t to ){
+	for( int axis = 0; axis < 3; ++axis ){
+		center[axis][to] = center[axis][from];
+		extent[axis][to] = extent[axis][from];
+	}
+}
+
+ChunkCuller::ChunkCuller( const bool allowAvx2 )
+: m_avx2( allowAvx2 && getCpuFeatures().avx2 )
+{}
+
+ChunkCoord ChunkCuller::toNodeCoord( const ChunkCoord coord ){
+	return { floorDiv( coord.x, nodeSize ), floorDiv( coord.y, nodeSize ), floorDiv( coord.z, nodeSize ) };
+}
+
+void ChunkCuller::insert( const ChunkCoord coord, const uint32_t id, const float min[3], const float max[3] ){
+	const auto found = m_locations.find( coord );
+	if( found != m_locations.end() ){
+		Node& node = m_nodes[found->second.node];
+		node.ids[found->second.index] = id;
+		node.chunks.set( found->second.index, min, max );
+		node.dirty = true;
+		return;
+	}
+
+	const ChunkCoord nodeCoord = toNodeCoord( coord );
+	auto nodeIndex = m_nodeIndices.find( nodeCoord );
+	if( nodeIndex == m_nodeIndices.end() ){
+		nodeIndex = m_nodeIndices.emplace(  nodeCoord, static_cast<uint32_t>( m_nodes.size() )  ).first;
+		m_nodes.emplace_back();
+		m_nodes.back().coord = nodeCoord;
+		m_nodeBoxes.resize( m_nodes.size() );
+	}
+
+	Node& node = m_nodes[nodeIndex->second];
+	const size_t index = node.chunks.count;
+	node.chunks.resize( index + 1 );
+	node.chunks.set( index, min, max );
+	node.ids.push_back( id );
+	node.coords.push_back( coord );
+	node.dirty = true;
+	m_locations[coord] = { nodeIndex->second, static_cast<uint32_t>( index ) };
+}
+
+void ChunkCuller::insert( const ChunkCoord coord, const uint32_t id ){
+	const float size = static_cast<float>( Chunk::size );
+	const float min[3] = { coord.x * size, coord.y * size, coord.z * size };
+	const float max[3] = { min[0] + size, min[1] + size, min[2] + size };
+	insert( coord, id, min, max );
+}
+
+void ChunkCuller::remove( const ChunkCoord coord ){
+	const auto found = m_locations.find( coord );
+	if( found == m_locations.end() ) return;
+	const Location location = found->second;
+	m_locations.erase( found );
+
+	// the last chunk of the node takes the place of the removed one
+	Node& node = m_nodes[location.node];
+	const size_t last = node.chunks.count - 1;
+	if( location.index != last ){
+		node.chunks.move( last, location.index );
+		node.ids[location.index] = node.ids[last];
+		node.coords[location.index] = node.coords[last];
+		m_locations[node.coords[location.index]].index = location.index;
+	}
+	node.chunks.resize( last );
+	node.ids.pop_back();
+	node.coords.pop_back();
+	node.dirty = true;
+	if( node.chunks.count ) return;
+
+	// and the last node takes the place of a node left empty
+	m_nodeIndices.erase( node.coord );
+	const size_t lastNode = m_nodes.size() - 1;
+	if( location.node != lastNode ){
+		m_nodes[location.node] = std::move( m_nodes[lastNode] );
+		m_nodeBoxes.move( lastNode, location.node );
+		Node& moved = m_nodes[location.node];
+		m_nodeIndices[moved.coord] = location.node;
+		for( const ChunkCoord& chunk : moved.coords ) m_locations[chunk].node = location.node;
+	}
+	m_nodes.pop_back();
+	m_nodeBoxes.resize( m_nodes.size() );
+}
+
+void ChunkCuller::clear(){
+	m_nodes.clear();
+	m_nodeBoxes.resize( 0 );
+	m_nodeIndices.clear();
+	m_locations.clear();
+	m_statistics = {};
+}
+
+void ChunkCuller::updateNodeBox( const uint32_t nodeIndex ){
+	Node& node = m_nodes[nodeIndex];
+
+	float min[3], max[3];
+	for( int axis = 0; axis < 3; ++axis ){
+		min[axis] = INFINITY;
+		max[axis] = -INFINITY;
+		for( size_t i = 0; i < node.chunks.count; ++i ){
+			min[axis] = std::min( min[axis], node.chunks.center[axis][i] - node.chunks.extent[axis][i] );
+			max[axis] = std::max( max[axis], node.chunks.center[axis][i] + node.chunks.extent[axis][i] );
+		}
+	}
+	m_nodeBoxes.set( nodeIndex, min, max );
+	node.dirty = false;
+}
+
+// A box is outside a plane if even its corner farthest along the normal is behind it: distance of the center plus the
+// extents projected onto the normal is negative. It is inside if even the nearest corner is in front.
+void ChunkCuller::classifyScalar( const Boxes& boxes, const size_t first, const float planes[6][4], uint32_t& outside, uint32_t& inside ){
+	outside = 0;
+	inside = 0xFF;
+	for( uint32_t lane = 0; lane < 8; ++lane ){
+		const size_t i = first + lane;
+		for( int p = 0; p < 6; ++p ){
+			const float* const plane = planes[p];
+			const float distance = boxes.center[0][i] * plane[0] + boxes.center[1][i] * plane[1] + boxes.center[2][i] * plane[2] + plane[3];
+			const float radius = boxes.extent[0][i] * std::fabs( plane[0] ) + boxes.extent[1][i] * std::fabs( plane[1] ) + boxes.extent[2][i] * std::fabs( plane[2] );
+			if( distance + radius < 0.0f ) outside |= 1u << lane;
+			if( !(distance - radius >= 0.0f) ) inside &= ~(1u << lane);
+		}
+	}
+}
+
+#if CPU_X86
+TARGET_AVX2 void ChunkCuller::classifyAvx2( const Boxes& boxes, const size_t first, const float planes[6][4], uint32_t& outside, uint32_t& inside ){
+	const __m256 cx = _mm256_loadu_ps( &boxes.center[0][first] );
+	const __m256 cy = _mm256_loadu_ps( &boxes.center[1][first] );
+	const __m256 cz = _mm256_loadu_ps( &boxes.center[2][first] );
+	const __m256 ex = _mm256_loadu_ps( &boxes.extent[0][first] );
+	const __m256 ey = _mm256_loadu_ps( &boxes.extent[1][first] );
+	const __m256 ez = _mm256_loadu_ps( &boxes.extent[2][first] );
+	const __m256 zero = _mm256_setzero_ps();
+
+	__m256 isOutside = zero;
+	__m256 isInside = _mm256_castsi256_ps(  _mm256_set1_epi32( -1 )  );
+	for( int p = 0; p < 6; ++p ){
+		const float* const plane = planes[p];
+		const __m256 a = _mm256_set1_ps( plane[0] ), b = _mm256_set1_ps( plane[1] ), c = _mm256_set1_ps( plane[2] );
+		const __m256 absA = _mm256_set1_ps( std::fabs( plane[0] ) ), absB = _mm256_set1_ps( std::fabs( plane[1] ) ), absC = _mm256_set1_ps( std::fabs( plane[2] ) );
+
+		// separate multiplies and adds in the order of the scalar path, so no FMA changes the rounding
+		__m256 distance = _mm256_add_ps(  _mm256_mul_ps( cx, a ), _mm256_mul_ps( cy, b )  );
+		distance = _mm256_add_ps(  _mm256_add_ps( distance, _mm256_mul_ps( cz, c ) ), _mm256_set1_ps( plane[3] )  );
+		__m256 radius = _mm256_add_ps(  _mm256_mul_ps( ex, absA ), _mm256_mul_ps( ey, absB )  );
+		radius = _mm256_add_ps(  radius, _mm256_mul_ps( ez, absC )  );
+
+		isOutside = _mm256_or_ps(  isOutside, _mm256_cmp_ps( _mm256_add_ps( distance, radius ), zero, _CMP_LT_OQ )  );
+		isInside = _mm256_and_ps(  isInside, _mm256_cmp_ps( _mm256_sub_ps( distance, radius ), zero, _CMP_GE_OQ )  );
+	}
+
+	outside = static_cast<uint32_t>(  _mm256_movemask_ps( isOutside )  );
+	inside = static_cast<uint32_t>(  _mm256_movemask_ps( isInside )  );
+}
+#endif
+
+void ChunkCuller::cull( const float planes[6][4], std::vector<uint32_t>& visible ){
+	visible.clear();
+	m_statistics = {};
+	m_statistics.nodes = m_nodes.size();
+
+	for( uint32_t node = 0; node < m_nodes.size(); ++node ){
+		if( m_nodes[node].dirty ) updateNodeBox( node );
+	}
+
+	const auto classify = [this, planes]( const Boxes& boxes, const size_t first, uint32_t& outside, uint32_t& inside ){
+#if CPU_X86
+		if( m_avx2 ) classifyAvx2( boxes, first, planes, outside, inside );
+		else
+#endif
+		classifyScalar( boxes, first, planes, outside, inside );
+
+		const size_t lanes = std::min<size_t>( 8, boxes.count - first );
+		const uint32_t mask = (1u << lanes) - 1;
+		outside &= mask;
+		inside &= mask & ~outside;
+		return mask;
+	};
+
+	for( size_t firstNode = 0; firstNode < m_nodeBoxes.count; firstNode += 8 ){
+		uint32_t nodesOutside, nodesInside;
+		const uint32_t nodeMask = classify( m_nodeBoxes, firstNode, nodesOutside, nodesInside );
+
+		for( uint32_t lanes = nodeMask & ~nodesOutside; lanes; lanes &= lanes - 1 ){
+			const uint32_t lane = countTrailingZeros( lanes );
+			const Node& node = m_nodes[firstNode + lane];
+
+			if( nodesInside & (1u << lane) ){
+				visible.insert( visible.end(), node.ids.begin(), node.ids.end() );
+				++m_statistics.nodesInside;
+				continue;
+			}
+
+			for( size_t first = 0; first < node.chunks.count; first += 8 ){
+				uint32_t outside, inside;
+				const uint32_t mask = classify( node.chunks, first, outside, inside );
+				for( uint32_t chunks = mask & ~outside; chunks; chunks &= chunks - 1 ) visible.push_back( node.ids[first + countTrailingZeros( chunks )] );
+			}
+			m_statistics.chunksTested += node.chunks.count;
+		}
+		for( uint32_t lanes = nodesOutside; lanes; lanes &= lanes - 1 ) ++m_statistics.nodesCulled;
+	}
+
+	m_statistics.visibleChunks = visible.size();
+}
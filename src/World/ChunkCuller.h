@@ -0,0 +1,93 @@
+// Frustum culling of chunk bounding boxes, region nodes first, 8 boxes per plane test with AVX2
+
+#ifndef COMMON_CHUNK_CULLER_H
+#define COMMON_CHUNK_CULLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "CpuFeatures.h"
+#include "VoxelWorld.h"
+
+
+// Chunks are grouped into nodes of nodeSize^3 chunks, each with a box around the boxes of its chunks. cull() tests the
+// nodes first: a node outside a plane skips all its chunks, a node inside all six takes them all without testing them,
+// and only the chunks of the nodes crossing a plane are tested one by one. The boxes are kept as centers and half
+// extents in a structure of arrays, per node for the chunks, so 8 boxes go through a plane in a few AVX2 instructions;
+// the arrays are padded to a multiple of 8 and the padding lanes are masked out. Both paths do the same float operations
+// in the same order, so they cull the same chunks.
+// The result is the ids the chunks were inserted with, e.g. indices into the draw list the frame records.
+class ChunkCuller{
+public:
+	static constexpr int32_t nodeSize = 4; // chunks per node edge
+
+	struct Statistics{ // of the latest cull()
+		size_t nodes;
+		size_t nodesInside; // whose chunks were taken without testing them
+		size_t nodesCulled;
+		size_t chunksTested; // of the nodes crossing a plane
+		size_t visibleChunks;
+	};
+
+	explicit ChunkCuller( bool allowAvx2 = true ); // AVX2 if allowed and the CPU has it
+	bool usesAvx2() const{ return m_avx2; }
+
+	// bounds in world (voxel) units, e.g. those of the chunk's mesh; inserting a chunk already in replaces its id and bounds
+	void insert( ChunkCoord coord, uint32_t id, const float min[3], const float max[3] );
+	void insert( ChunkCoord coord, uint32_t id ); // bounded by the whole chunk
+	void remove( ChunkCoord coord ); // no-op if not in
+	void clear();
+	size_t size() const{ return m_locations.size(); }
+
+	// visible = the ids of the chunks whose box is not entirely outside one of the planes, e.g. from extractFrustumPlanes();
+	// a point p is inside plane { a, b, c, d } if a * p.x + b * p.y + c * p.z + d >= 0. Boxes only touching a plane count
+	// as visible. The order of the ids follows the nodes, not the distance.
+	void cull( const float planes[6][4], std::vector<uint32_t>& visible );
+
+	const Statistics& getStatistics() const{ return m_statistics; }
+
+private:
+	// boxes as centers and half extents, each array padded to a multiple of 8 with empty boxes
+	struct Boxes{
+		std::vector<float> center[3];
+		std::vector<float> extent[3];
+		size_t count = 0;
+
+		void resize( size_t newCount );
+		void set( size_t index, const float min[3], const float max[3] );
+		void move( size_t from, size_t to );
+	};
+
+	struct Node{
+		ChunkCoord coord; // in nodes
+		Boxes chunks;
+		std::vector<uint32_t> ids; // of the chunks, in the order of the boxes
+		std::vector<ChunkCoord> coords; // likewise; to find the location of a chunk moved by remove()
+		bool dirty; // the node box may be larger than its chunks need
+	};
+
+	struct Location{
+		uint32_t node;
+		uint32_t index; // in the node
+	};
+
+	static ChunkCoord toNodeCoord( ChunkCoord coord );
+	void updateNodeBox( uint32_t node ); // from the boxes of its chunks
+
+	// 8 boxes from first against all planes; bit i of the result is set for box first + i
+	static void classifyScalar( const Boxes& boxes, size_t first, const float planes[6][4], uint32_t& outside, uint32_t& inside );
+#if CPU_X86
+	static void classifyAvx2( const Boxes& boxes, size_t first, const float planes[6][4], uint32_t& outside, uint32_t& inside );
+#endif
+
+	bool m_avx2;
+	std::vector<Node> m_nodes;
+	Boxes m_nodeBoxes; // box i bounds the chunks of m_nodes[i]
+	std::unordered_map<ChunkCoord, uint32_t, ChunkCoordHash> m_nodeIndices; // node coordinate to index in m_nodes
+	std::unordered_map<ChunkCoord, Location, ChunkCoordHash> m_locations;
+	Statistics m_statistics = {};
+};
+
+#endif //COMMON_CHUNK_CULLER_H
@@ -0,0 +1,137 @@
+// What chunk meshers take (a chunk and its neighbors) and produce (merged face quads and their vertices)
+#include "ChunkMesh.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+// Implementation
+//////////////////////////////////
+
+ChunkNeighborhood getNeighborhood( const VoxelWorld& world, const ChunkCoord coord ){
+	ChunkNeighborhood chunks;
+	chunks.center = world.getChunk( coord );
+	chunks.neighbors[Face::posX] = world.getChunk( {coord.x + 1, coord.y, coord.z} );
+	chunks.neighbors[Face::negX] = world.getChunk( {coord.x - 1, coord.y, coord.z} );
+	chunks.neighbors[Face::posY] = world.getChunk( {coord.x, coord.y + 1, coord.z} );
+	chunks.neighbors[Face::negY] = world.getChunk( {coord.x, coord.y - 1, coord.z} );
+	chunks.neighbors[Face::posZ] = world.getChunk( {coord.x, coord.y, coord.z + 1} );
+	chunks.neighbors[Face::negZ] = world.getChunk( {coord.x, coord.y, coord.z - 1} );
+
+	return chunks;
+}
+
+bool hasVisibleFaces( const ChunkNeighborhood& chunks ){
+	if( !chunks.center || chunks.center->isEmpty() ) return false;
+
+	const auto isSolid = []( const Chunk* const chunk ){ return chunk && chunk->isUniform() && Block::isOpaque( chunk->uniformBlock() ); };
+	if( !isSolid( chunks.center ) ) return true;
+	for( const Chunk* const neighbor : chunks.neighbors ) if( !isSolid( neighbor ) ) return true;
+	return false;
+}
+
+void gatherPaddedVoxels( const ChunkNeighborhood& chunks, std::vector<BlockId>& voxels, std::vector<BlockId>& scratch ){
+	const uint32_t n = Chunk::size;
+	voxels.resize( paddedSize * paddedSize * paddedSize );
+	scratch.resize( Chunk::volume );
+
+	// rows along x are contiguous in both layouts
+	const auto copyRows = [&]( const BlockId* source, uint32_t sourceStride, uint32_t count, uint32_t py, uint32_t pz, bool alongY ){
+		for( uint32_t r = 0; r < count; ++r, source += sourceStride ){
+			std::copy( source, source + n, voxels.data() + (alongY ? paddedIndex( 1, py + r, pz ) : paddedIndex( 1, py, pz + r )) );
+		}
+	};
+
+	if( chunks.center && !chunks.center->isUniform() ){
+		chunks.center->getSpan( 0, Chunk::volume, scratch.data() );
+		for( uint32_t y = 0; y < n; ++y ) copyRows( scratch.data() + Chunk::index( 0, y, 0 ), n, n, y + 1, 1, false );
+	}
+	else{
+		const BlockId block = chunks.center ? chunks.center->uniformBlock() : Block::air;
+		for( uint32_t y = 1; y <= n; ++y ){
+			for( uint32_t z = 1; z <= n; ++z ) std::fill_n( voxels.data() + paddedIndex( 1, y, z ), n, block );
+		}
+	}
+
+	for( uint8_t face = 0; face < Face::count; ++face ){
+		const Chunk* const neighbor = chunks.neighbors[face];
+
+		const uint32_t axis = Face::axis( face );
+		const uint32_t u = (axis + 1) % 3;
+		const uint32_t v = (axis + 2) % 3;
+
+		// the neighbor's layer touching the chunk, into the padding on that side
+		const uint32_t sourceLayer = Face::isPositive( face ) ? 0 : n - 1;
+		const uint32_t targetLayer = Face::isPositive( face ) ? n + 1 : 0;
+
+		if( !neighbor || neighbor->isUniform() ){
+			const BlockId block = neighbor ? neighbor->uniformBlock() : Block::air;
+
+			uint32_t target[3];
+			target[axis] = targetLayer;
+			for( uint32_t b = 1; b <= n; ++b ){
+				for( uint32_t a = 1; a <= n; ++a ){
+					target[u] = a;  target[v] = b;
+					voxels[paddedIndex( target[0], target[1], target[2] )] = block;
+				}
+			}
+		}
+		else if( axis == 1 ){ // one contiguous span
+			neighbor->getSpan( Chunk::index( 0, sourceLayer, 0 ), n * n, scratch.data() );
+			copyRows( scratch.data(), n, n, targetLayer, 1, false );
+		}
+		else if( axis == 2 ){ // a row per y
+			for( uint32_t y = 0; y < n; ++y ) neighbor->getSpan( Chunk::index( 0, y, sourceLayer ), n, scratch.data() + y * n );
+			copyRows( scratch.data(), n, n, 1, targetLayer, true );
+		}
+		else{
+			uint32_t source[3], target[3];
+			source[axis] = sourceLayer;
+			target[axis] = targetLayer;
+			for( uint32_t b = 0; b < n; ++b ){
+				for( uint32_t a = 0; a < n; ++a ){
+					source[u] = a;  source[v] = b;
+					target[u] = a + 1;  target[v] = b + 1;
+					voxels[paddedIndex( target[0], target[1], target[2] )] = neighbor->get( source[0], source[1], source[2] );
+				}
+			}
+		}
+	}
+}
+
+bool MeshQuad::operator<( const MeshQuad& other ) const{
+	return std::tie( face, x, y, z, width, height, block ) < std::tie( other.face, other.x, other.y, other.z, other.width, other.height, other.block );
+}
+
+void writeQuadVertices( const MeshQuad& quad, ChunkVertex* const vertices ){
+	const uint32_t axis = Face::axis( quad.face );
+	const uint32_t u = (axis + 1) % 3;
+	const uint32_t v = (axis + 2) % 3;
+
+	uint8_t origin[3] = { quad.x, quad.y, quad.z };
+	if( Face::isPositive( quad.face ) ) ++origin[axis]; // the face lies on the far side of the voxel
+
+	// u x v points along +axis, so this order is counter-clockwise seen from the positive side
+	const uint8_t corners[4][2] = { {0, 0}, {quad.width, 0}, {quad.width, quad.height}, {0, quad.height} };
+	for( uint32_t i = 0; i < 4; ++i ){
+		const auto& corner = corners[Face::isPositive( quad.face ) ? i : (4 - i) % 4]; // reversed for negative faces
+
+		uint32_t position[3];
+		position[axis] = origin[axis];
+		position[u] = origin[u] + corner[0];
+		position[v] = origin[v] + corner[1];
+
+		// one texture layer per block type; no ambient occlusion yet, which would also need to stop merges across it
+		vertices[i] = ChunkVertex::pack( position[0], position[1], position[2], quad.face, ChunkVertex::aoUnoccluded, quad.block, corner[0], corner[1] );
+	}
+}
+
+std::vector<uint32_t> makeQuadIndices( const uint32_t quadCount ){
+	std::vector<uint32_t> indices( 6 * size_t( quadCount ) );
+	for( uint32_t quad = 0; quad < quadCount; ++quad ){
+		const uint32_t first = 4 * quad;
+		const uint32_t triangles[6] = { first, first + 1, first + 2, first + 2, first + 3, first };
+		std::copy( triangles, triangles + 6, &indices[6 * size_t( quad )] );
+	}
+	return indices;
+}
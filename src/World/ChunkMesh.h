@@ -0,0 +1,80 @@
+// What chunk meshers take (a chunk and its neighbors) and produce (merged face quads and their vertices)
+
+#ifndef COMMON_CHUNK_MESH_H
+#define COMMON_CHUNK_MESH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Vertex.h"
+#include "Block.h"
+#include "Chunk.h"
+#include "VoxelWorld.h"
+
+
+// direction a face looks; also the order of ChunkNeighborhood::neighbors and of the face in ChunkVertex::position
+namespace Face{
+	constexpr uint8_t posX = 0;
+	constexpr uint8_t negX = 1;
+	constexpr uint8_t posY = 2;
+	constexpr uint8_t negY = 3;
+	constexpr uint8_t posZ = 4;
+	constexpr uint8_t negZ = 5;
+	constexpr uint8_t count = 6;
+
+	inline uint32_t axis( const uint8_t face ){ return face >> 1; } // 0 = x, 1 = y, 2 = z
+	inline bool isPositive( const uint8_t face ){ return (face & 1) == 0; }
+}
+
+// the chunk to mesh, and the six chunks touching it; nullptr where none is loaded, which counts as air
+struct ChunkNeighborhood{
+	const Chunk* center;
+	const Chunk* neighbors[Face::count]; // by Face: the chunk on the +X side, on the -X side, ...
+};
+
+ChunkNeighborhood getNeighborhood( const VoxelWorld& world, ChunkCoord coord ); // center may be nullptr too
+
+// cheap check from the uniform chunks alone; false for e.g. an empty chunk, or an opaque one buried in opaque neighbors
+bool hasVisibleFaces( const ChunkNeighborhood& chunks );
+
+// The chunk plus the touching layer of each neighbor, as paddedSize^3 block ids laid out like Chunk::index() (x fastest,
+// then z, then y), with the chunk's voxel (x, y, z) at paddedIndex( x + 1, y + 1, z + 1 ). Air where no chunk is loaded.
+// The edges and corners, which no face looks at, are left as they were. scratch is reused between calls.
+constexpr uint32_t paddedSize = Chunk::size + 2;
+inline uint32_t paddedIndex( uint32_t x, uint32_t y, uint32_t z ){ return (y * paddedSize + z) * paddedSize + x; }
+void gatherPaddedVoxels( const ChunkNeighborhood& chunks, std::vector<BlockId>& voxels, std::vector<BlockId>& scratch );
+
+// A rectangle of coplanar faces of one block type. The face plane spans the axes u = (axis + 1) % 3 and
+// v = (axis + 2) % 3 of the face's axis; e.g. y and z for X faces.
+struct MeshQuad{
+	uint8_t face;
+	uint8_t x, y, z; // the voxel whose face is the quad corner with the lowest u and v
+	uint8_t width, height; // in voxels along u and v
+	BlockId block;
+
+	bool operator==( const MeshQuad& other ) const{
+		return face == other.face && x == other.x && y == other.y && z == other.z
+		    && width == other.width && height == other.height && block == other.block;
+	}
+	bool operator<( const MeshQuad& other ) const; // some total order, to compare meshes regardless of quad order
+};
+
+struct ChunkMesh{
+	std::vector<MeshQuad> quads;
+	std::vector<ChunkVertex> vertices; // 4 per quad, in quad order; triangles (0, 1, 2) and (2, 3, 0) of each
+	uint32_t faceCount = 0; // visible voxel faces before merging, i.e. what per-face meshing would emit
+
+	void clear(){ quads.clear(); vertices.clear(); faceCount = 0; }
+	uint32_t getTriangleCount() const{ return static_cast<uint32_t>( 2 * quads.size() ); }
+};
+
+void writeQuadVertices( const MeshQuad& quad, ChunkVertex* vertices ); // the 4 of the quad
+inline void appendQuadVertices( const MeshQuad& quad, std::vector<ChunkVertex>& vertices ){
+	vertices.resize( vertices.size() + 4 );
+	writeQuadVertices( quad, &vertices[vertices.size() - 4] );
+}
+
+// The index list of any quadCount quads of ChunkMesh::vertices; the same for every mesh, so one buffer serves all draws
+std::vector<uint32_t> makeQuadIndices( uint32_t quadCount );
+
+#endif //COMMON_CHUNK_MESH_H
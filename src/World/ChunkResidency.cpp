@@ -0,0 +1,378 @@
+// Bounds the memory of the voxel world: chunks that left the view distance are kept for a while, compressed, then evicted
+#include "ChunkResidency.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Implementation
+//////////////////////////////////
+
+static std::string toString( const ChunkCoord coord ){
+	return std::to_string( coord.x ) + " " + std::to_string( coord.y ) + " " + std::to_string( coord.z );
+}
+
+ChunkResidency::ChunkResidency( VoxelWorld& world, JobSystem& jobs, WorldStorage* const storage, Settings settings )
+: m_world( world ), m_jobs( jobs ), m_storage( storage ), m_settings( std::move( settings ) )
+{
+	if( !m_settings.generate ) throw "The chunk residency needs a generate function!";
+}
+
+ChunkResidency::~ChunkResidency(){
+	m_jobs.wait( m_counter ); // jobs catch their own exceptions, so this does not throw
+}
+
+bool ChunkResidency::isInView( const ChunkCoord coord, const ChunkCoord center ) const{
+	const int32_t dx = coord.x - center.x, dy = coord.y - center.y, dz = coord.z - center.z;
+	const int32_t r = m_settings.viewDistance;
+	return std::abs( dy ) <= m_settings.verticalViewDistance && dx * dx + dz * dz <= r * r;
+}
+
+void ChunkResidency::update( const float cameraPosition[3] ){
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		if( m_error ){
+			std::exception_ptr error;
+			std::swap( error, m_error );
+			std::rethrow_exception( error );
+		}
+	}
+
+	// direction of travel, smoothed over a few frames so a wobbling camera does not throw the prefetch around
+	if( m_hasPosition ){
+		float delta[3];
+		for( int i = 0; i < 3; ++i ) delta[i] = cameraPosition[i] - m_position[i];
+		const float length = std::sqrt( delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2] );
+		if( length > 0.0f ){
+			for( int i = 0; i < 3; ++i ) m_heading[i] = 0.7f * m_heading[i] + 0.3f * delta[i] / length;
+			const float heading = std::sqrt( m_heading[0] * m_heading[0] + m_heading[1] * m_heading[1] + m_heading[2] * m_heading[2] );
+			for( float& h : m_heading ) h = heading > 0.0f ? h / heading : 0.0f;
+		}
+		else for( float& h : m_heading ) h = 0.0f;
+	}
+	for( int i = 0; i < 3; ++i ) m_position[i] = cameraPosition[i];
+	m_hasPosition = true;
+
+	const ChunkCoord center = VoxelWorld::toChunkCoord(
+		static_cast<int32_t>(  std::floor( cameraPosition[0] )  ),
+		static_cast<int32_t>(  std::floor( cameraPosition[1] )  ),
+		static_cast<int32_t>(  std::floor( cameraPosition[2] )  )
+	);
+	const float d = static_cast<float>( m_settings.prefetchDistance );
+	const ChunkCoord target = {
+		center.x + static_cast<int32_t>(  std::lround( m_heading[0] * d )  ),
+		center.y + static_cast<int32_t>(  std::lround( m_heading[1] * d )  ),
+		center.z + static_cast<int32_t>(  std::lround( m_heading[2] * d )  )
+	};
+	if( center != m_center || target != m_prefetchTarget ){
+		m_center = center;
+		m_prefetchTarget = target;
+		schedulePrefetch();
+	}
+
+	// no prefetching while the budget is used up; it would only evict what it prefetched before
+	while( m_prefetchNext < m_prefetchQueue.size() ){
+		const ChunkCoord coord = m_prefetchQueue[m_prefetchNext];
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			if( m_prefetching.size() >= m_settings.maxPrefetchJobs ) break;
+			if( m_loadedBytes + m_statistics.cachedBytes + m_statistics.compressedBytes >= m_settings.memoryBudget ) break;
+			++m_prefetchNext;
+			if( m_records.count( coord ) || m_loaded.count( coord ) || m_prefetching.count( coord ) ) continue;
+			if( m_saving && m_savingCoord == coord ) continue; // just evicted
+			m_prefetching.emplace( coord, false );
+		}
+		m_jobs.run( [this, coord]{ prefetch( coord ); }, &m_counter );
+	}
+
+	// one eviction per lock, so loads on other threads get their turn in between
+	m_loadedBytes = m_world.getMemoryUsage();
+	for( ;; ){
+		std::unique_lock<std::mutex> lock( m_mutex );
+		if( m_loadedBytes + m_statistics.cachedBytes + m_statistics.compressedBytes <= m_settings.memoryBudget ) break;
+		if( !evictOne() ) break;
+		if( m_saving ) saveEvicted( lock );
+	}
+}
+
+void ChunkResidency::schedulePrefetch(){
+	m_prefetchQueue.clear();
+	m_prefetchNext = 0;
+	if( m_prefetchTarget == m_center ) return; // standing still
+
+	// what comes into view at each chunk of travel, nearest first; what is in view now is the streamer's already
+	std::unordered_set<ChunkCoord, ChunkCoordHash> queued;
+	const int32_t r = m_settings.viewDistance;
+	const int32_t h = m_settings.verticalViewDistance;
+	for( int32_t step = 1; step <= m_settings.prefetchDistance; ++step ){
+		const ChunkCoord ahead = {
+			m_center.x + static_cast<int32_t>(  std::lround( m_heading[0] * step )  ),
+			m_center.y + static_cast<int32_t>(  std::lround( m_heading[1] * step )  ),
+			m_center.z + static_cast<int32_t>(  std::lround( m_heading[2] * step )  )
+		};
+		for( int32_t dy = -h; dy <= h; ++dy ){
+			for( int32_t dz = -r; dz <= r; ++dz ){
+				for( int32_t dx = -r; dx <= r; ++dx ){
+					const ChunkCoord coord = { ahead.x + dx, ahead.y + dy, ahead.z + dz };
+					if( !isInView( coord, ahead ) || isInView( coord, m_center ) ) continue;
+					if( queued.insert( coord ).second ) m_prefetchQueue.push_back( coord );
+				}
+			}
+		}
+	}
+}
+
+void ChunkResidency::prefetch( const ChunkCoord coord ){
+	try{
+		std::vector<uint8_t> bytes;
+		uint64_t serial = 0;
+		Origin origin;
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			const auto it = m_records.find( coord );
+			if( it != m_records.end() ){
+				if( it->second.tier == Tier::cached ){
+					m_prefetching.erase( coord );
+					return;
+				}
+				bytes = it->second.bytes; // a copy; the record stays where it is, in case load() wants it meanwhile
+				serial = it->second.serial;
+				origin = it->second.origin;
+			}
+		}
+
+		std::unique_ptr<Chunk> chunk( new Chunk );
+		if( !bytes.empty() ){
+			if(  !decodeChunk( bytes.data(), bytes.size(), *chunk )  ) throw "Corrupt compressed chunk " + toString( coord );
+		}
+		else if(  m_storage && m_storage->load( coord, *chunk )  ) origin = { true, true };
+		else m_settings.generate( coord, *chunk );
+
+		std::lock_guard<std::mutex> lock( m_mutex );
+
+		// thrown away if load() took the chunk meanwhile: since then it may have been edited, released and even evicted
+		// to the storage, none of which what this job read knows about
+		const auto prefetching = m_prefetching.find( coord );
+		const bool stale = prefetching->second;
+		m_prefetching.erase( prefetching );
+		if( stale ) return;
+		const auto it = m_records.find( coord );
+		if( it != m_records.end() ){
+			if( bytes.empty() || it->second.serial != serial ) return;
+			erase( it );
+		}
+		else if( !bytes.empty() ) return;
+
+		const size_t size = chunk->memoryUsage();
+		Record& record = insert( coord, Tier::cached, origin )->second;
+		record.chunk = std::move( chunk );
+		record.size = size;
+		m_statistics.cachedBytes += size;
+		++m_statistics.prefetched;
+	}
+	catch( ... ){
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_prefetching.erase( coord );
+		if( !m_error ) m_error = std::current_exception();
+	}
+}
+
+void ChunkResidency::load( const ChunkCoord coord, Chunk& chunk ){
+	std::unique_ptr<Chunk> cached;
+	std::vector<uint8_t> bytes;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		const auto prefetching = m_prefetching.find( coord );
+		if( prefetching != m_prefetching.end() ) prefetching->second = true;
+
+		const auto it = m_records.find( coord );
+		if( it != m_records.end() ){
+			m_loaded[coord] = it->second.origin;
+			if( it->second.tier == Tier::cached ){
+				cached = std::move( it->second.chunk );
+				++m_statistics.cacheHits;
+			}
+			else{
+				bytes = std::move( it->second.bytes );
+				++m_statistics.compressedHits;
+			}
+			erase( it );
+		}
+		else if( m_saving && m_savingCoord == coord ){
+			m_loaded[coord] = { true, false }; // the save may yet fail
+			bytes = m_savingBytes; // a copy; update() is writing them out
+			++m_statistics.compressedHits;
+		}
+	}
+
+	if( cached ){
+		chunk = std::move( *cached );
+		return;
+	}
+	if( !bytes.empty() ){
+		if(  !decodeChunk( bytes.data(), bytes.size(), chunk )  ) throw "Corrupt compressed chunk " + toString( coord );
+		return;
+	}
+
+	Origin origin;
+	const bool stored = m_storage && m_storage->load( coord, chunk );
+	if( stored ) origin = { true, true };
+	else m_settings.generate( coord, chunk );
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_loaded[coord] = origin;
+	if( stored ) ++m_statistics.storageLoads;
+	else ++m_statistics.generated;
+
+	// a prefetch job may have put the same chunk into the cache meanwhile
+	const auto it = m_records.find( coord );
+	if( it != m_records.end() ) erase( it );
+}
+
+void ChunkResidency::release( const ChunkCoord coord, std::unique_ptr<Chunk> chunk, const bool edited ){
+	if( !chunk ) throw "Releasing a null chunk to the chunk residency!";
+	const size_t size = chunk->memoryUsage();
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+	Origin origin;
+	const auto loaded = m_loaded.find( coord );
+	if( loaded != m_loaded.end() ){
+		origin = loaded->second;
+		m_loaded.erase( loaded );
+	}
+	if( edited ) origin = { true, false };
+
+	const auto it = m_records.find( coord );
+	if( it != m_records.end() ) erase( it ); // older than this one
+
+	Record& record = insert( coord, Tier::cached, origin )->second;
+	record.chunk = std::move( chunk );
+	record.size = size;
+	m_statistics.cachedBytes += size;
+	++m_statistics.released;
+}
+
+bool ChunkResidency::evictOne(){
+	if( !m_cachedLru.empty() ){
+		Record& record = m_records.find( m_cachedLru.front() )->second;
+		std::vector<uint8_t> bytes;
+		encodeChunk( *record.chunk, bytes );
+		bytes.shrink_to_fit();
+
+		m_statistics.cachedBytes -= record.size;
+		record.tier = Tier::compressed;
+		record.chunk.reset();
+		record.bytes = std::move( bytes );
+		record.size = record.bytes.size();
+		record.serial = m_nextSerial++;
+		m_compressedLru.splice( m_compressedLru.end(), m_cachedLru, record.lru );
+		m_statistics.compressedBytes += record.size;
+		++m_statistics.compressions;
+		return true;
+	}
+
+	if( !m_compressedLru.empty() ){
+		const auto it = m_records.find( m_compressedLru.front() );
+		Record& record = it->second;
+		if( record.origin.edited && !record.origin.saved ){
+			if( m_storage ){
+				m_saving = true;
+				m_savingCoord = it->first;
+				m_savingBytes = std::move( record.bytes );
+			}
+			else ++m_statistics.lostEdits;
+		}
+		erase( it );
+		++m_statistics.evictions;
+		return true;
+	}
+
+	return false;
+}
+
+void ChunkResidency::saveEvicted( std::unique_lock<std::mutex>& lock ){
+	// the disk write would stall every load() and prefetch job behind it; while it runs, the chunk is nowhere but in
+	// m_savingBytes, which only this thread changes, so reading them without the lock is fine
+	lock.unlock();
+	try{
+		m_storage->saveEncoded( m_savingCoord, m_savingBytes );
+	}
+	catch( ... ){
+		lock.lock();
+		// back into the compressed tier, so the edit is not lost with the save; unless load() has it by now
+		if( !m_loaded.count( m_savingCoord ) ){
+			Record& record = insert( m_savingCoord, Tier::compressed, { true, false } )->second;
+			record.bytes = std::move( m_savingBytes );
+			record.size = record.bytes.size();
+			m_statistics.compressedBytes += record.size;
+		}
+		m_savingBytes.clear();
+		m_saving = false;
+		throw;
+	}
+
+	lock.lock();
+	m_savingBytes.clear();
+	m_saving = false;
+	++m_statistics.saves;
+}
+
+ChunkResidency::RecordMap::iterator ChunkResidency::insert( const ChunkCoord coord, const Tier tier, const Origin origin ){
+	std::list<ChunkCoord>& lru = tier == Tier::cached ? m_cachedLru : m_compressedLru;
+	const auto it = m_records.emplace( coord, Record() ).first;
+	Record& record = it->second;
+	record.tier = tier;
+	record.origin = origin;
+	record.size = 0;
+	record.serial = m_nextSerial++;
+	record.lru = lru.insert( lru.end(), coord );
+	return it;
+}
+
+void ChunkResidency::erase( const RecordMap::iterator record ){
+	if( record->second.tier == Tier::cached ){
+		m_statistics.cachedBytes -= record->second.size;
+		m_cachedLru.erase( record->second.lru );
+	}
+	else{
+		m_statistics.compressedBytes -= record->second.size;
+		m_compressedLru.erase( record->second.lru );
+	}
+	m_records.erase( record );
+}
+
+void ChunkResidency::flush(){
+	if( !m_storage ) return;
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		for( auto& record : m_records ){
+			Origin& origin = record.second.origin;
+			if( !origin.edited || origin.saved ) continue;
+
+			if( record.second.tier == Tier::cached ) m_storage->save( record.first, *record.second.chunk );
+			else m_storage->saveEncoded( record.first, record.second.bytes );
+			origin.saved = true;
+			++m_statistics.saves;
+		}
+	}
+	m_storage->flush();
+}
+
+ChunkResidency::Statistics ChunkResidency::getStatistics() const{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	Statistics statistics = m_statistics;
+	statistics.loadedBytes = m_loadedBytes;
+	statistics.residentBytes = m_loadedBytes + statistics.cachedBytes + statistics.compressedBytes;
+	statistics.cachedChunks = m_cachedLru.size();
+	statistics.compressedChunks = m_compressedLru.size();
+	statistics.prefetchJobsInFlight = static_cast<uint32_t>( m_prefetching.size() );
+	return statistics;
+}
@@ -0,0 +1,142 @@
+// Bounds the memory of the voxel world: chunks that left the view distance are kept for a while, compressed, then evicted
+
+#ifndef COMMON_CHUNK_RESIDENCY_H
+#define COMMON_CHUNK_RESIDENCY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+#include "VoxelWorld.h"
+#include "WorldStorage.h"
+#include "JobSystem.h"
+
+
+// The source of a ChunkStreamer's chunks (load() as its generate function) and the sink of those it unloads (release()).
+// A released chunk is cached as it is; once the loaded chunks, the cached ones and the compressed ones take more than
+// the memory budget, update() compresses the least recently released cached chunk, and once nothing is left to compress,
+// evicts the least recently compressed one: to the storage if it was edited since it was generated or last saved, else
+// it is simply dropped, as the generator makes it again. Without a storage, evicted edits are lost. The save runs outside
+// the lock, so loads on other threads do not wait for the disk.
+// load() takes a chunk from the first tier that has it: cached, compressed, storage, and only else generates it.
+// Prefetch: update() follows the camera, and while it moves, starts jobs loading into the cache the chunks that come into
+// view over the next prefetchDistance chunks of travel, so the streamer finds them there.
+// The loaded chunks themselves are the streamer's to unload; if they alone exceed the budget, nothing more can go.
+// load() is thread-safe; everything else belongs to the thread that owns the world, like ChunkStreamer.
+class ChunkResidency{
+public:
+	struct Settings{
+		size_t memoryBudget; // bytes of chunk voxels: loaded in the world, cached, and compressed
+		int32_t viewDistance; // the streamer's; what is in view needs no prefetching
+		int32_t verticalViewDistance;
+		int32_t prefetchDistance; // chunks of travel ahead; 0 disables prefetching
+		uint32_t maxPrefetchJobs; // in flight
+		std::function<void(ChunkCoord, Chunk&)> generate; // fills a new, all air chunk; called from jobs on any thread
+	};
+
+	struct Statistics{
+		uint64_t cacheHits; // loads taken from the cache
+		uint64_t compressedHits; // loads decompressed
+		uint64_t storageLoads; // loads read from the storage
+		uint64_t generated; // loads nothing had
+		uint64_t prefetched; // chunks prefetch jobs put into the cache
+		uint64_t released;
+		uint64_t compressions; // cached chunks compressed to make room
+		uint64_t evictions; // compressed chunks dropped or saved to make room
+		uint64_t saves; // evictions saved to the storage
+		uint64_t lostEdits; // evictions of edited chunks without a storage
+		size_t loadedBytes; // the world's chunks, as of the latest update()
+		size_t cachedBytes;
+		size_t compressedBytes;
+		size_t residentBytes; // all three
+		size_t cachedChunks;
+		size_t compressedChunks;
+		uint32_t prefetchJobsInFlight;
+	};
+
+	// storage may be nullptr
+	ChunkResidency( VoxelWorld& world, JobSystem& jobs, WorldStorage* storage, Settings settings );
+	~ChunkResidency(); // waits for the prefetch jobs
+	ChunkResidency( const ChunkResidency& ) = delete;
+	ChunkResidency& operator=( const ChunkResidency& ) = delete;
+
+	// once per frame; camera in world (voxel) units. Starts prefetch jobs and evicts down to the budget.
+	// Rethrows the exception of a failed prefetch job.
+	void update( const float cameraPosition[3] );
+
+	void load( ChunkCoord coord, Chunk& chunk ); // any thread; the chunk is the loader's until released
+	void release( ChunkCoord coord, std::unique_ptr<Chunk> chunk, bool edited ); // edited since load()
+
+	void flush(); // saves the edited chunks cached or compressed to the storage, if any
+
+	Statistics getStatistics() const;
+
+private:
+	enum class Tier : uint8_t{ cached, compressed };
+
+	// whether a chunk differs from what the generator makes, and whether the storage has it as it is
+	struct Origin{
+		bool edited = false;
+		bool saved = false;
+	};
+
+	struct Record{
+		Tier tier;
+		Origin origin;
+		std::unique_ptr<Chunk> chunk; // if cached
+		std::vector<uint8_t> bytes; // if compressed; encodeChunk()
+		size_t size; // bytes counted against the budget
+		uint64_t serial; // tells a prefetch job whether the record it read is still the same one
+		std::list<ChunkCoord>::iterator lru; // in the list of its tier
+	};
+
+	using RecordMap = std::unordered_map<ChunkCoord, Record, ChunkCoordHash>;
+
+	bool isInView( ChunkCoord coord, ChunkCoord center ) const;
+	void schedulePrefetch(); // refills m_prefetchQueue for m_center and m_heading
+	void prefetch( ChunkCoord coord ); // on a job thread
+	bool evictOne(); // under m_mutex; false if nothing is left to evict. An edit to save is left in m_saving for update().
+	void saveEvicted( std::unique_lock<std::mutex>& lock ); // of m_mutex; saves m_saving with the lock released
+	RecordMap::iterator insert( ChunkCoord coord, Tier tier, Origin origin ); // under m_mutex
+	void erase( RecordMap::iterator record ); // under m_mutex
+
+	VoxelWorld& m_world;
+	JobSystem& m_jobs;
+	WorldStorage* m_storage;
+	Settings m_settings;
+
+	mutable std::mutex m_mutex; // guards what load() and the prefetch jobs touch: everything below up to the line
+	RecordMap m_records;
+	std::list<ChunkCoord> m_cachedLru; // least recently released first
+	std::list<ChunkCoord> m_compressedLru; // least recently compressed first
+	std::unordered_map<ChunkCoord, Origin, ChunkCoordHash> m_loaded; // handed out by load(), not yet released
+	// jobs in flight; true once load() took the chunk meanwhile, which makes what the job read stale
+	std::unordered_map<ChunkCoord, bool, ChunkCoordHash> m_prefetching;
+	bool m_saving = false; // an evicted edit is being saved; load() reads it from m_savingBytes meanwhile
+	ChunkCoord m_savingCoord = { 0, 0, 0 };
+	std::vector<uint8_t> m_savingBytes; // changed only by update(), under m_mutex
+	uint64_t m_nextSerial = 0;
+	std::exception_ptr m_error; // of a prefetch job
+	Statistics m_statistics = {};
+	//-----------------------------------------------------
+
+	bool m_hasPosition = false;
+	float m_position[3] = {};
+	float m_heading[3] = {}; // smoothed direction of travel; zero while the camera stands still
+	ChunkCoord m_center = { 0, 0, 0 };
+	ChunkCoord m_prefetchTarget = { 0, 0, 0 }; // the camera's chunk after prefetchDistance chunks of travel
+	std::vector<ChunkCoord> m_prefetchQueue; // nearest travel first
+	size_t m_prefetchNext = 0;
+	size_t m_loadedBytes = 0;
+
+	JobCounter m_counter; // of the prefetch jobs
+};
+
+#endif //COMMON_CHUNK_RESIDENCY_H
@@ -0,0 +1,423 @@
+// Keeps the chunks around the camera loaded and meshed: generate, light and mesh run as jobs, the most needed chunks first
+#include "ChunkStreamer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Block.h"
+
+// Implementation
+//////////////////////////////////
+
+static ChunkCoord getNeighborCoord( const ChunkCoord coord, const uint8_t face ){
+	const int32_t step = Face::isPositive( face ) ? 1 : -1;
+	switch( Face::axis( face ) ){
+		case 0: return { coord.x + step, coord.y, coord.z };
+		case 1: return { coord.x, coord.y + step, coord.z };
+		default: return { coord.x, coord.y, coord.z + step };
+	}
+}
+
+static void computeLight( const Chunk& chunk, ChunkLight& light ){
+	const uint32_t n = Chunk::size;
+	const uint32_t columns = n * n;
+
+	if( chunk.isUniform() ){
+		std::fill(  light.skyHeight, light.skyHeight + columns, uint8_t( Block::isOpaque( chunk.uniformBlock() ) ? n : 0 )  );
+		return;
+	}
+
+	// horizontal layers top down, until every column has met an opaque voxel
+	std::fill( light.skyHeight, light.skyHeight + columns, uint8_t( 0 ) );
+	BlockId layer[columns];
+	uint32_t openColumns = columns;
+	for( uint32_t y = n; y-- > 0 && openColumns; ){
+		chunk.getSpan( Chunk::index( 0, y, 0 ), columns, layer );
+		for( uint32_t column = 0; column < columns; ++column ){
+			if( light.skyHeight[column] || !Block::isOpaque( layer[column] ) ) continue;
+			light.skyHeight[column] = uint8_t( y + 1 );
+			--openColumns;
+		}
+	}
+}
+
+ChunkStreamer::ChunkStreamer( VoxelWorld& world, JobSystem& jobs, Settings settings )
+: m_world( world ), m_jobs( jobs ), m_settings( std::move( settings ) )
+{
+	if( m_jobs.getSlotCount() < 2 ) throw "The chunk streamer needs a job system with worker threads!";
+	if( !m_settings.generate ) throw "The chunk streamer needs a generate function!";
+
+	if( !m_settings.maxJobsInFlight ) m_settings.maxJobsInFlight = defaultJobsPerThread * m_jobs.getThreadCount();
+
+	for( uint32_t slot = 0; slot < m_jobs.getSlotCount(); ++slot ) m_meshers.emplace_back( new BinaryMesher );
+}
+
+ChunkStreamer::~ChunkStreamer(){
+	for( auto& entry : m_entries ) entry.second->cancelled.store( true, std::memory_order_relaxed );
+	m_jobs.wait( m_counter ); // jobs catch their own exceptions, so this does not throw
+
+	while( Entry* const entry = m_completed.pop() ){
+		if( entry->generated ) release( *entry, std::move( entry->generated ) );
+	}
+}
+
+template<typename Function>
+void ChunkStreamer::forEachNeighbor( const ChunkCoord coord, const Function& function ){
+	for( uint8_t face = 0; face < Face::count; ++face ){
+		const auto it = m_entries.find(  getNeighborCoord( coord, face )  );
+		if( it != m_entries.end() ) function( face, *it->second );
+	}
+}
+
+void ChunkStreamer::update( const float cameraPosition[3], const float viewDirection[3] ){
+	// results first, so their chunks can go on to the next stage right away
+	while( Entry* const entry = m_completed.pop() ) complete( *entry );
+	takeEdits();
+
+	const ChunkCoord center = VoxelWorld::toChunkCoord(
+		static_cast<int32_t>(  std::floor( cameraPosition[0] )  ),
+		static_cast<int32_t>(  std::floor( cameraPosition[1] )  ),
+		static_cast<int32_t>(  std::floor( cameraPosition[2] )  )
+	);
+	if( !m_hasCenter || center != m_center ) setCenter( center );
+
+	float direction[3] = { viewDirection[0], viewDirection[1], viewDirection[2] };
+	const float length = std::sqrt( direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2] );
+	for( float& d : direction ) d = length > 0.0f ? d / length : 0.0f;
+
+	m_candidates.clear();
+	for( auto it = m_entries.begin(); it != m_entries.end(); ){
+		Entry& entry = *it->second;
+
+		if( !entry.wanted ){
+			if( entry.task == Task::none ){
+				unload( entry );
+				it = m_entries.erase( it );
+			}
+			else ++it;
+			continue;
+		}
+		++it;
+
+		// distance to the chunk's center; behind the camera counts up to twice as far as straight ahead
+		const float half = 0.5f * Chunk::size;
+		const float offset[3] = {
+			entry.coord.x * float( Chunk::size ) + half - cameraPosition[0],
+			entry.coord.y * float( Chunk::size ) + half - cameraPosition[1],
+			entry.coord.z * float( Chunk::size ) + half - cameraPosition[2]
+		};
+		const float distance = std::sqrt( offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2] );
+		const float cosine = distance > 0.0f ? (offset[0] * direction[0] + offset[1] * direction[1] + offset[2] * direction[2]) / distance : 1.0f;
+		entry.priority = distance * (1.5f - 0.5f * cosine);
+		if( entry.batches ) entry.priority = 0.0f; // edits are where the player is looking; they come first
+
+		if(  entry.task == Task::none && (entry.stage != Stage::lit || entry.meshDirty)  ) m_candidates.push_back( &entry );
+	}
+
+	if( m_jobsInFlight >= m_settings.maxJobsInFlight ) return;
+
+	const auto byPriority = []( const Entry* a, const Entry* b ){ return a->priority < b->priority; };
+	std::sort( m_candidates.begin(), m_candidates.end(), byPriority );
+	for( Entry* const entry : m_candidates ){
+		if( m_jobsInFlight >= m_settings.maxJobsInFlight ) break;
+
+		const Task task = getNextTask( *entry );
+		if( task != Task::none ) start( *entry, task );
+	}
+}
+
+void ChunkStreamer::upload( const uint32_t maxMeshes, const UploadFunction& upload ){
+	for( const ChunkCoord coord : m_unloaded ) upload( coord, nullptr );
+	m_unloaded.clear();
+
+	// whole batches, regardless of maxMeshes
+	const auto now = std::chrono::steady_clock::now();
+	for( size_t i = 0; i < m_batches.size(); ){
+		const EditBatch& batch = m_batches[i];
+		if( !batch.isComplete() ){
+			++i;
+			continue;
+		}
+
+		for( const auto& member : batch.entries ){
+			--member.first->batches;
+			if( member.first->uploadPending ) hand( *member.first, upload );
+		}
+		m_editLatencies.push_back(  std::chrono::duration<double, std::milli>( now - batch.firstEdit ).count()  );
+		++m_statistics.editBatches;
+		m_batches.erase( m_batches.begin() + i );
+	}
+
+	m_candidates.clear();
+	for( const auto& entry : m_entries ){
+		if( entry.second->uploadPending && entry.second->wanted && !entry.second->batches ) m_candidates.push_back( entry.second.get() );
+	}
+
+	const size_t count = std::min<size_t>( maxMeshes, m_candidates.size() );
+	const auto byPriority = []( const Entry* a, const Entry* b ){ return a->priority < b->priority; };
+	std::partial_sort( m_candidates.begin(), m_candidates.begin() + count, m_candidates.end(), byPriority );
+
+	for( size_t i = 0; i < count; ++i ) hand( *m_candidates[i], upload );
+}
+
+void ChunkStreamer::takeEditLatencies( std::vector<double>& latencies ){
+	latencies.insert( latencies.end(), m_editLatencies.begin(), m_editLatencies.end() );
+	m_editLatencies.clear();
+}
+
+const ChunkLight* ChunkStreamer::getLight( const ChunkCoord coord ) const{
+	const auto it = m_entries.find( coord );
+	return it != m_entries.end() && it->second->stage == Stage::lit ? it->second->light.get() : nullptr;
+}
+
+bool ChunkStreamer::isWanted( const ChunkCoord coord ) const{
+	const auto it = m_entries.find( coord );
+	return it != m_entries.end() && it->second->wanted;
+}
+
+ChunkStreamer::Statistics ChunkStreamer::getStatistics() const{
+	Statistics statistics = m_statistics;
+	statistics.jobsInFlight = m_jobsInFlight;
+	statistics.chunks = m_entries.size();
+	statistics.pendingUploads = 0;
+	for( const auto& entry : m_entries ) statistics.pendingUploads += entry.second->uploadPending && entry.second->wanted;
+	return statistics;
+}
+
+void ChunkStreamer::hand( Entry& entry, const UploadFunction& upload ){
+	upload( entry.coord, &entry.mesh );
+	entry.mesh = ChunkMesh(); // the renderer has its own copy now
+	entry.uploadPending = false;
+	entry.uploaded = true;
+	++m_statistics.uploaded;
+}
+
+void ChunkStreamer::setCenter( const ChunkCoord center ){
+	m_center = center;
+	m_hasCenter = true;
+
+	for( auto& entry : m_entries ) entry.second->wanted = false;
+
+	const int32_t r = m_settings.viewDistance;
+	const int32_t h = m_settings.verticalViewDistance;
+	for( int32_t dy = -h; dy <= h; ++dy ){
+		for( int32_t dz = -r; dz <= r; ++dz ){
+			for( int32_t dx = -r; dx <= r; ++dx ){
+				if( dx * dx + dz * dz > r * r ) continue;
+
+				const ChunkCoord coord = { center.x + dx, center.y + dy, center.z + dz };
+				std::unique_ptr<Entry>& entry = m_entries[coord];
+				if( !entry ){
+					entry.reset( new Entry );
+					entry->coord = coord;
+				}
+				entry->wanted = true;
+			}
+		}
+	}
+
+	// a job already started may still check the flag and skip its work; either way its results are thrown away
+	for( auto& entry : m_entries ){
+		if( !entry.second->wanted && entry.second->task != Task::none ) entry.second->cancelled.store( true, std::memory_order_relaxed );
+	}
+}
+
+void ChunkStreamer::takeEdits(){
+	m_dirty.clear();
+	m_world.takeDirtyChunks( m_dirty );
+	if( m_dirty.empty() ) return;
+
+	EditBatch batch;
+	batch.firstEdit = std::chrono::steady_clock::time_point::max();
+
+	for( const DirtyChunk& dirty : m_dirty ){
+		const auto it = m_entries.find( dirty.coord );
+		if( it == m_entries.end() || it->second->stage != Stage::lit ) continue; // the edit is in its first light and mesh anyway
+
+		Entry& entry = *it->second;
+		entry.relight = true;
+		entry.edited = true;
+		if( !entry.meshed ) continue;
+
+		entry.meshDirty = true;
+		++entry.editSerial;
+		++entry.batches;
+		batch.entries.push_back(  {&entry, entry.editSerial}  );
+		batch.firstEdit = std::min( batch.firstEdit, dirty.firstEdit );
+		++m_statistics.editRemeshes;
+	}
+
+	if( !batch.entries.empty() ) m_batches.push_back( std::move( batch ) );
+}
+
+bool ChunkStreamer::EditBatch::isComplete() const{
+	for( const auto& member : entries ){
+		if( member.first->meshSerial < member.second ) return false;
+	}
+	return true;
+}
+
+ChunkStreamer::Task ChunkStreamer::getNextTask( const Entry& entry ) const{
+	if( entry.task != Task::none ) return Task::none;
+
+	if( entry.stage == Stage::queued ) return Task::generate;
+	if( !entry.meshDirty ) return Task::none;
+
+	// a neighbor that is coming would change the faces on that side; unwanted ones count as air
+	for( uint8_t face = 0; face < Face::count; ++face ){
+		const auto it = m_entries.find(  getNeighborCoord( entry.coord, face )  );
+		if( it != m_entries.end() && it->second->wanted && it->second->stage == Stage::queued ) return Task::none;
+	}
+	return Task::mesh;
+}
+
+void ChunkStreamer::start( Entry& entry, const Task task ){
+	entry.task = task;
+	entry.cancelled.store( false, std::memory_order_relaxed );
+
+	if( task == Task::mesh ){
+		entry.meshDirty = false;
+		entry.meshed = true;
+
+		// the job gets copies, so the world can be edited, and neighbors unloaded, while it runs
+		const ChunkNeighborhood chunks = getNeighborhood( m_world, entry.coord );
+		entry.neighborhood.center = takeSnapshot( entry, *entry.chunk );
+		for( uint8_t face = 0; face < Face::count; ++face ){
+			entry.neighborhood.neighbors[face] = chunks.neighbors[face] ? takeSnapshot( entry, *chunks.neighbors[face] ) : nullptr;
+		}
+
+		if( entry.relight ){
+			entry.relight = false;
+			entry.jobLight.reset( new ChunkLight );
+		}
+		entry.jobSerial = entry.editSerial;
+	}
+
+	++m_jobsInFlight;
+	Entry* const job = &entry;
+	m_jobs.run( [this, job]{ runTask( *job ); }, &m_counter );
+}
+
+const Chunk* ChunkStreamer::takeSnapshot( Entry& entry, const Chunk& chunk ){
+	if( m_snapshotPool.empty() ) entry.snapshots.emplace_back( new Chunk );
+	else{
+		entry.snapshots.push_back(  std::move( m_snapshotPool.back() )  );
+		m_snapshotPool.pop_back();
+	}
+
+	*entry.snapshots.back() = chunk; // reuses the copy's memory
+	return entry.snapshots.back().get();
+}
+
+void ChunkStreamer::runTask( Entry& entry ){
+	try{
+		if( !entry.cancelled.load( std::memory_order_relaxed ) ){
+			switch( entry.task ){
+				case Task::generate:
+					entry.generated.reset( new Chunk );
+					m_settings.generate( entry.coord, *entry.generated );
+					entry.jobLight.reset( new ChunkLight );
+					computeLight( *entry.generated, *entry.jobLight );
+					break;
+				case Task::mesh:
+					if( entry.jobLight ) computeLight( *entry.neighborhood.center, *entry.jobLight );
+					m_meshers[m_jobs.getThreadIndex()]->mesh( entry.neighborhood, entry.jobMesh );
+					break;
+				case Task::none:
+					break;
+			}
+		}
+	}
+	catch( ... ){
+		entry.error = std::current_exception();
+	}
+
+	m_completed.push( &entry ); // the entry belongs to the owner again from here on
+}
+
+void ChunkStreamer::complete( Entry& entry ){
+	--m_jobsInFlight;
+	const Task task = entry.task;
+	entry.task = Task::none;
+
+	for( auto& snapshot : entry.snapshots ) m_snapshotPool.push_back( std::move( snapshot ) );
+	entry.snapshots.clear();
+
+	if( entry.error ){
+		std::exception_ptr error;
+		std::swap( error, entry.error );
+		std::rethrow_exception( error );
+	}
+
+	if(  entry.cancelled.load( std::memory_order_relaxed )  ){
+		++m_statistics.cancelled;
+		if( entry.generated ) release( entry, std::move( entry.generated ) );
+		if( task == Task::mesh ){ // in case it is wanted again
+			entry.meshDirty = true;
+			entry.relight = entry.relight || entry.jobLight;
+		}
+		entry.jobLight.reset();
+		return;
+	}
+
+	switch( task ){
+		case Task::generate:
+			entry.chunk = entry.generated.get();
+			m_world.insertChunk( entry.coord, std::move( entry.generated ) );
+			entry.light = std::move( entry.jobLight );
+			entry.stage = Stage::lit;
+			entry.meshDirty = true;
+			++m_statistics.generated;
+			markNeighborsDirty( entry.coord );
+			break;
+		case Task::mesh:
+			if( entry.jobLight ) entry.light = std::move( entry.jobLight );
+			std::swap( entry.mesh, entry.jobMesh );
+			entry.meshSerial = entry.jobSerial;
+			entry.uploadPending = true;
+			++m_statistics.meshed;
+
+			break;
+		case Task::none:
+			break;
+	}
+}
+
+void ChunkStreamer::unload( Entry& entry ){
+	if( entry.chunk ){
+		release(  entry, m_world.takeChunk( entry.coord )  );
+		++m_statistics.unloaded;
+	}
+	if( entry.uploaded ) m_unloaded.push_back( entry.coord );
+
+	// the batches waiting for it do not anymore
+	for( size_t i = 0; entry.batches && i < m_batches.size(); ){
+		auto& entries = m_batches[i].entries;
+		const auto isEntry = [&entry]( const std::pair<Entry*, uint32_t>& member ){ return member.first == &entry; };
+		const auto removed = std::remove_if( entries.begin(), entries.end(), isEntry );
+		entry.batches -= static_cast<uint32_t>( entries.end() - removed );
+		entries.erase( removed, entries.end() );
+
+		if( entries.empty() ) m_batches.erase( m_batches.begin() + i );
+		else ++i;
+	}
+
+	// the neighbors keep their meshes; the faces toward this chunk are at the edge of the view distance anyway
+}
+
+void ChunkStreamer::release( Entry& entry, std::unique_ptr<Chunk> chunk ){
+	if( m_settings.release && chunk ) m_settings.release( entry.coord, std::move( chunk ), entry.edited );
+}
+
+void ChunkStreamer::markNeighborsDirty( const ChunkCoord coord ){
+	forEachNeighbor(  coord, []( uint8_t, Entry& neighbor ){
+		if( neighbor.meshed ) neighbor.meshDirty = true;
+	}  );
+}
@@ -0,0 +1,178 @@
+// Keeps the chunks around the camera loaded and meshed: generate, light and mesh run as jobs, the most needed chunks first
+
+#ifndef COMMON_CHUNK_STREAMER_H
+#define COMMON_CHUNK_STREAMER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Chunk.h"
+#include "ChunkMesh.h"
+#include "BinaryMesher.h"
+#include "VoxelWorld.h"
+#include "JobSystem.h"
+#include "MpscQueue.h"
+
+
+// Sky exposure of a chunk's columns, seen from the chunk alone: per column (index x + z * Chunk::size),
+// 1 + the y of its topmost opaque voxel, or 0 if the column is open all the way through.
+struct ChunkLight{
+	uint8_t skyHeight[Chunk::size * Chunk::size];
+};
+
+// A chunk moves through: generate (a job fills a new chunk, which is then inserted into the world), light (its ChunkLight;
+// done by the same job, as it needs nothing but the new chunk), mesh (a job meshes it once its wanted neighbors are
+// generated too) and upload (handed to the render thread by upload(), as many per frame as it allows).
+// Each frame, update() ranks the chunks still waiting by their distance from the camera, weighted by how far they are
+// off the view direction, and starts jobs for the best ones up to a budget of jobs in flight, so a far chunk never holds
+// up one in front of the camera. Chunks that leave the view distance get their jobs cancelled, and are unloaded.
+// Jobs never touch the streamer's bookkeeping: a job hands its chunk back through a lock-free queue as the last thing it
+// does, and only update() on the owning thread acts on the results.
+// Edits: update() takes the chunks VoxelWorld::setBlock() dirtied, and relights and remeshes only those, before anything
+// else. The chunks dirtied by the edits of one frame are a batch; upload() hands over their new meshes all in the same
+// call once the last one is done, so e.g. a hole dug at a chunk border never shows through the old mesh of the chunk next
+// to it. Until then the renderer keeps drawing the old meshes. (A chunk edited again before its previous batch was handed
+// over may bring its newer edits along early; holding everything back while edits keep coming would never end.)
+// Mesh jobs read copies of their chunks, so the world may be edited any time between calls; but an edit of a chunk that
+// has not been generated yet is lost, as the generated chunk replaces it. Not thread-safe, like VoxelWorld.
+// Unloaded chunks are deleted, unless Settings::release takes them; e.g. a ChunkResidency, which then also generates them.
+class ChunkStreamer{
+public:
+	struct Settings{
+		int32_t viewDistance; // in chunks; horizontally, a circle around the camera's chunk
+		int32_t verticalViewDistance; // in chunks, up and down
+		uint32_t maxJobsInFlight; // 0 means defaultJobsPerThread per thread of the job system
+		std::function<void(ChunkCoord, Chunk&)> generate; // fills a new, all air chunk; called from jobs on any thread
+		// takes the chunks unloaded, and those generated by cancelled jobs, with whether they were edited since generate;
+		// optional, they are deleted if empty. Called by update() and the destructor
+		std::function<void(ChunkCoord, std::unique_ptr<Chunk>, bool edited)> release;
+	};
+
+	// Jobs finish within a frame, but are only followed up on by the next update(), so the budget has to cover about
+	// a frame of work; more only delays reprioritizing.
+	static constexpr uint32_t defaultJobsPerThread = 32;
+
+	struct Statistics{
+		uint64_t generated; // and lit chunks
+		uint64_t meshed; // meshes, remeshes included
+		uint64_t uploaded;
+		uint64_t unloaded;
+		uint64_t cancelled; // jobs whose results were thrown away, as their chunk left the view distance
+		uint64_t editRemeshes; // chunks dirtied by edits
+		uint64_t editBatches; // handed over by upload()
+		uint32_t jobsInFlight;
+		size_t chunks; // managed by the streamer, loaded or not yet
+		size_t pendingUploads;
+	};
+
+	// mesh is nullptr when the chunk was unloaded and the renderer should drop it; an empty mesh is a chunk with nothing to draw
+	using UploadFunction = std::function<void(ChunkCoord coord, const ChunkMesh* mesh)>;
+
+	// jobs must have worker threads, i.e. not only a participating main thread, or they never run while the frame loop does
+	ChunkStreamer( VoxelWorld& world, JobSystem& jobs, Settings settings );
+	~ChunkStreamer(); // waits for the jobs in flight; the chunks it loaded stay in the world
+	ChunkStreamer( const ChunkStreamer& ) = delete;
+	ChunkStreamer& operator=( const ChunkStreamer& ) = delete;
+
+	// once per frame: takes the results of finished jobs and the world's dirty chunks, then reranks and starts more jobs;
+	// camera in world (voxel) units. Rethrows the exception of a failed job.
+	void update( const float cameraPosition[3], const float viewDirection[3] );
+
+	// Hands the unloaded chunks, the finished edit batches, and up to maxMeshes other new meshes to upload, most needed
+	// first; the mesh is only valid during the call. A chunk can come again later, with a newer mesh.
+	void upload( uint32_t maxMeshes, const UploadFunction& upload );
+
+	// per edit batch handed over since the last call, the milliseconds from its first edit until upload() handed it; appended
+	void takeEditLatencies( std::vector<double>& latencies );
+
+	const ChunkLight* getLight( ChunkCoord coord ) const; // nullptr if the chunk has not been lit yet
+	bool isWanted( ChunkCoord coord ) const; // in the view distance of the latest update()
+	Statistics getStatistics() const;
+
+private:
+	enum class Stage : uint8_t{ queued, lit };
+	enum class Task : uint8_t{ none, generate, mesh }; // generate includes lighting; mesh relights after edits
+
+	// the streamer's state of a chunk; the fields below the line belong to its job while one is in flight
+	struct Entry : MpscNode{
+		ChunkCoord coord;
+		Stage stage = Stage::queued;
+		Task task = Task::none; // in flight
+		bool wanted = true;
+		bool meshed = false; // a mesh job was started since it was loaded, so new neighbors mean a remesh
+		bool meshDirty = false; // to be (re)meshed once lit
+		bool relight = false; // edited since its light was computed
+		bool uploadPending = false; // mesh is newer than what the renderer has
+		bool uploaded = false; // the renderer has a mesh of it
+		bool edited = false; // since it was generated
+		uint32_t editSerial = 0; // counts the frames that edited it
+		uint32_t meshSerial = 0; // editSerial as of the snapshot of mesh
+		uint32_t batches = 0; // edit batches waiting for it; its mesh is held back for them
+		float priority = 0.0f; // lower goes first
+		ChunkMesh mesh; // the latest one, while uploadPending
+		std::unique_ptr<ChunkLight> light; // once lit
+		Chunk* chunk = nullptr; // in the world, once generated
+
+		//-----------------------------------------------------
+		std::atomic<bool> cancelled{ false };
+		std::unique_ptr<Chunk> generated;
+		std::vector< std::unique_ptr<Chunk> > snapshots; // the copies neighborhood points to
+		ChunkNeighborhood neighborhood;
+		std::unique_ptr<ChunkLight> jobLight; // if set, the mesh job relights into it
+		uint32_t jobSerial; // editSerial as of the snapshots
+		ChunkMesh jobMesh;
+		std::exception_ptr error;
+	};
+
+	// the chunks dirtied in one frame
+	struct EditBatch{
+		std::vector< std::pair<Entry*, uint32_t> > entries; // and the editSerial its mesh needs to show the batch's edits
+		std::chrono::steady_clock::time_point firstEdit;
+
+		bool isComplete() const;
+	};
+
+	void setCenter( ChunkCoord center ); // the camera's chunk changed; marks what is wanted now
+	void takeEdits(); // the world's dirty chunks, as a new batch
+	void complete( Entry& entry ); // its job finished
+	void unload( Entry& entry );
+	void release( Entry& entry, std::unique_ptr<Chunk> chunk ); // to m_settings.release, if any
+	Task getNextTask( const Entry& entry ) const; // none if it has to wait
+	void start( Entry& entry, Task task );
+	void runTask( Entry& entry ); // on a job thread
+	const Chunk* takeSnapshot( Entry& entry, const Chunk& chunk ); // a copy for entry's job
+	void hand( Entry& entry, const UploadFunction& upload ); // its mesh to the renderer
+	void markNeighborsDirty( ChunkCoord coord ); // a chunk appeared next to them
+	template<typename Function> void forEachNeighbor( ChunkCoord coord, const Function& function ); // ( face, Entry& ) of those with one
+
+	VoxelWorld& m_world;
+	JobSystem& m_jobs;
+	Settings m_settings;
+
+	std::unordered_map< ChunkCoord, std::unique_ptr<Entry>, ChunkCoordHash > m_entries;
+	std::vector<Entry*> m_candidates; // scratch of update() and upload()
+	std::vector<ChunkCoord> m_unloaded; // not yet told to the renderer
+	bool m_hasCenter = false;
+	ChunkCoord m_center = { 0, 0, 0 };
+
+	std::vector<DirtyChunk> m_dirty; // scratch of takeEdits()
+	std::vector<EditBatch> m_batches; // not handed over yet, oldest first
+	std::vector<double> m_editLatencies;
+
+	JobCounter m_counter; // of all jobs in flight
+	MpscQueue<Entry> m_completed;
+	uint32_t m_jobsInFlight = 0;
+	std::vector< std::unique_ptr<BinaryMesher> > m_meshers; // per job system thread slot
+	std::vector< std::unique_ptr<Chunk> > m_snapshotPool; // from finished mesh jobs, for reuse
+
+	Statistics m_statistics = {};
+};
+
+#endif //COMMON_CHUNK_STREAMER_H
@@ -0,0 +1,88 @@
+// Reference chunk mesher: merges visible coplanar faces of the same block type into as few quads as it greedily can
+#include "GreedyMesher.h"
+
+#include <cstdint>
+#include <vector>
+
+// Implementation
+//////////////////////////////////
+
+GreedyMesher::GreedyMesher()
+: m_faces( Chunk::size * Chunk::size )
+{}
+
+void GreedyMesher::mesh( const ChunkNeighborhood& chunks, ChunkMesh& mesh ){
+	mesh.clear();
+	if( !hasVisibleFaces( chunks ) ) return;
+
+	gatherPaddedVoxels( chunks, m_voxels, m_span );
+
+	const uint32_t n = Chunk::size;
+	const int32_t strides[3] = { 1, int32_t( paddedSize * paddedSize ), int32_t( paddedSize ) }; // of x, y, z in m_voxels
+
+	for( uint8_t face = 0; face < Face::count; ++face ){
+		const uint32_t axis = Face::axis( face );
+		const uint32_t u = (axis + 1) % 3;
+		const uint32_t v = (axis + 2) % 3;
+		const int32_t front = Face::isPositive( face ) ? strides[axis] : -strides[axis]; // the voxel the face looks at
+
+		uint32_t position[3];
+		for( uint32_t slice = 0; slice < n; ++slice ){
+			position[axis] = slice;
+
+			for( uint32_t row = 0; row < n; ++row ){
+				position[v] = row;
+				for( uint32_t column = 0; column < n; ++column ){
+					position[u] = column;
+
+					const uint32_t i = paddedIndex( position[0] + 1, position[1] + 1, position[2] + 1 );
+					const BlockId block = m_voxels[i];
+					const bool visible = Block::isOpaque( block ) && !Block::isOpaque( m_voxels[i + front] );
+
+					m_faces[row * n + column] = visible ? block : Block::air;
+					mesh.faceCount += visible;
+				}
+			}
+
+			for( uint32_t row = 0; row < n; ++row ){
+				for( uint32_t column = 0; column < n; ){
+					const BlockId block = m_faces[row * n + column];
+					if( block == Block::air ){
+						++column;
+						continue;
+					}
+
+					uint32_t width = 1;
+					while( column + width < n && m_faces[row * n + column + width] == block ) ++width;
+
+					uint32_t height = 1;
+					for( ; row + height < n; ++height ){
+						const BlockId* const next = &m_faces[(row + height) * n + column];
+
+						bool matches = true;
+						for( uint32_t k = 0; k < width && matches; ++k ) matches = next[k] == block;
+						if( !matches ) break;
+					}
+
+					for( uint32_t r = row; r < row + height; ++r ){
+						for( uint32_t k = column; k < column + width; ++k ) m_faces[r * n + k] = Block::air;
+					}
+
+					position[u] = column;
+					position[v] = row;
+					mesh.quads.push_back( {
+						face,
+						uint8_t( position[0] ), uint8_t( position[1] ), uint8_t( position[2] ),
+						uint8_t( width ), uint8_t( height ),
+						block
+					} );
+
+					column += width;
+				}
+			}
+		}
+	}
+
+	mesh.vertices.resize( 4 * mesh.quads.size() );
+	for( size_t i = 0; i < mesh.quads.size(); ++i ) writeQuadVertices( mesh.quads[i], &mesh.vertices[4 * i] );
+}
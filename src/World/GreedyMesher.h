@@ -0,0 +1,29 @@
+// Reference chunk mesher: merges visible coplanar faces of the same block type into as few quads as it greedily can
+
+#ifndef COMMON_GREEDY_MESHER_H
+#define COMMON_GREEDY_MESHER_H
+
+#include <vector>
+
+#include "Block.h"
+#include "Chunk.h"
+#include "ChunkMesh.h"
+
+
+// A face is visible if its voxel is opaque and the voxel in front of it is not. Per slice of the chunk, the visible
+// faces are scanned row by row (v), and each not yet covered face starts a quad that is first extended along u as far
+// as the faces match, then along v as far as whole rows match. Other meshers must reproduce exactly these quads.
+// Keeps its scratch buffers between calls, so reuse one instance per thread.
+class GreedyMesher{
+public:
+	GreedyMesher();
+
+	void mesh( const ChunkNeighborhood& chunks, ChunkMesh& mesh ); // mesh is cleared first
+
+private:
+	std::vector<BlockId> m_voxels; // see gatherPaddedVoxels
+	std::vector<BlockId> m_faces; // visible faces of one slice; air where none
+	std::vector<BlockId> m_span;
+};
+
+#endif //COMMON_GREEDY_MESHER_H
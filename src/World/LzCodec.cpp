@@ -0,0 +1,126 @@
+// Small, fast LZ77 byte codec for saved chunks; favors speed over ratio, like LZ4
+#include "LzCodec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Implementation
+//////////////////////////////////
+
+static constexpr size_t minMatch = 4;
+static constexpr size_t maxOffset = 0xFFFF;
+static constexpr uint32_t hashBits = 12;
+
+static uint32_t read32( const uint8_t* const bytes ){
+	uint32_t value;
+	std::memcpy( &value, bytes, sizeof( value ) );
+	return value;
+}
+
+static uint32_t hashPrefix( const uint32_t prefix ){
+	return (prefix * 2654435761u) >> (32 - hashBits);
+}
+
+// the nibble of a length, plus as many 255s and a remainder as it takes past 15
+static void writeLength( size_t length, std::vector<uint8_t>& output ){
+	if( length < 15 ) return;
+	length -= 15;
+	while( length >= 255 ){
+		output.push_back( 255 );
+		length -= 255;
+	}
+	output.push_back( static_cast<uint8_t>( length ) );
+}
+
+static void writeSequence( const uint8_t* const literals, const size_t literalCount, const size_t offset, const size_t matchLength, std::vector<uint8_t>& output ){
+	const size_t matchCode = matchLength ? matchLength - minMatch : 0;
+	const uint8_t literalNibble = static_cast<uint8_t>( literalCount < 15 ? literalCount : 15 );
+	const uint8_t matchNibble = static_cast<uint8_t>( matchCode < 15 ? matchCode : 15 );
+	output.push_back(  static_cast<uint8_t>( literalNibble << 4 | matchNibble )  );
+
+	writeLength( literalCount, output );
+	output.insert( output.end(), literals, literals + literalCount );
+	if( !matchLength ) return; // the last sequence
+
+	output.push_back(  static_cast<uint8_t>( offset & 0xFF )  );
+	output.push_back(  static_cast<uint8_t>( offset >> 8 )  );
+	writeLength( matchCode, output );
+}
+
+size_t lzMaxCompressedSize( const size_t size ){
+	return size + size / 255 + 16;
+}
+
+void lzCompress( const uint8_t* const input, const size_t size, std::vector<uint8_t>& output ){
+	uint32_t table[1u << hashBits]; // position + 1 of the latest prefix with each hash; 0 is none
+	std::memset( table, 0, sizeof( table ) );
+
+	size_t anchor = 0; // first byte not yet written
+	size_t i = 0;
+	while( i + minMatch <= size ){
+		const uint32_t prefix = read32( input + i );
+		uint32_t& slot = table[hashPrefix( prefix )];
+		const size_t candidate = slot;
+		slot = static_cast<uint32_t>( i + 1 );
+
+		if( !candidate || i - (candidate - 1) > maxOffset || read32( input + candidate - 1 ) != prefix ){
+			++i;
+			continue;
+		}
+
+		const size_t match = candidate - 1;
+		size_t length = minMatch;
+		while( i + length < size && input[match + length] == input[i + length] ) ++length;
+
+		writeSequence( input + anchor, i - anchor, i - match, length, output );
+		i += length;
+		anchor = i;
+	}
+
+	writeSequence( input + anchor, size - anchor, 0, 0, output );
+}
+
+bool lzDecompress( const uint8_t* input, const size_t size, uint8_t* const output, const size_t outputSize ){
+	const uint8_t* const end = input + size;
+	size_t written = 0;
+
+	const auto readLength = [&]( size_t length ) -> size_t{ // SIZE_MAX if the input ends first
+		if( length < 15 ) return length;
+		while( true ){
+			if( input == end ) return SIZE_MAX;
+			const uint8_t extra = *input++;
+			length += extra;
+			if( extra != 255 ) return length;
+		}
+	};
+
+	while( input < end ){
+		const uint8_t token = *input++;
+
+		const size_t literalCount = readLength( token >> 4 );
+		if( literalCount == SIZE_MAX || literalCount > size_t( end - input ) || literalCount > outputSize - written ) return false;
+		std::memcpy( output + written, input, literalCount );
+		input += literalCount;
+		written += literalCount;
+
+		if( input == end ) break; // the last sequence has no match
+
+		if( end - input < 2 ) return false;
+		const size_t offset = size_t( input[0] ) | size_t( input[1] ) << 8;
+		input += 2;
+		const size_t matchCode = readLength( token & 15 );
+		if( matchCode == SIZE_MAX ) return false;
+		const size_t length = matchCode + minMatch;
+		if( offset == 0 || offset > written || length > outputSize - written ) return false;
+
+		// byte by byte, as the match may overlap what it writes
+		const uint8_t* source = output + written - offset;
+		uint8_t* target = output + written;
+		for( size_t b = 0; b < length; ++b ) target[b] = source[b];
+		written += length;
+	}
+
+	return written == outputSize;
+}
@@ -0,0 +1,23 @@
+// Small, fast LZ77 byte codec for saved chunks; favors speed over ratio, like LZ4
+
+#ifndef COMMON_LZ_CODEC_H
+#define COMMON_LZ_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// The stream is a series of sequences: a token byte (literal count in the high nibble, match length - 4 in the low one;
+// 15 means more length bytes follow, each adding up to 255), the literals, then a 2-byte little-endian offset back into
+// the output and the extra match length bytes. The last sequence has literals only. Matches may overlap their own
+// output, so a run of one byte costs a few bytes whatever its length. Greedy matching through a hash of 4-byte prefixes.
+
+// appends the compressed data to output; never fails, at worst output grows by lzMaxCompressedSize( size )
+void lzCompress( const uint8_t* input, size_t size, std::vector<uint8_t>& output );
+size_t lzMaxCompressedSize( size_t size );
+
+// false if input is malformed, or does not decompress to exactly outputSize bytes; never reads or writes out of bounds
+bool lzDecompress( const uint8_t* input, size_t size, uint8_t* output, size_t outputSize );
+
+#endif //COMMON_LZ_CODEC_H
@@ -0,0 +1,338 @@
+// One file holding the saved chunks of a cube of chunk coordinates, with a memory-mapped index for O(1) lookups
+#if defined(_WIN32)
+	#include "LeanWindowsEnvironment.h"
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#include <cerrno>
+#endif
+
+#include "RegionFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AtomicFile.h"
+
+// Implementation
+//////////////////////////////////
+
+// The header is used in place, so the file is in the byte order of the machine; little-endian, on all the targets so far.
+static const char magic[8] = { 'H', 'V', 'R', 'E', 'G', 'I', 'O', 'N' };
+static constexpr uint32_t formatVersion = 2; // 2: the record header before each payload
+
+// FNV-1a; only has to tell a payload from a torn or stale one
+static uint32_t checksum( const uint8_t* const bytes, const size_t size ){
+	uint32_t hash = 2166136261u;
+	for( size_t i = 0; i < size; ++i ) hash = (hash ^ bytes[i]) * 16777619u;
+	return hash;
+}
+
+static_assert( RegionFile::slotCount * 8 % RegionFile::sectorSize == 0, "The index fills whole sectors" );
+static_assert( RegionFile::recordHeaderSize == 2 * sizeof( uint32_t ), "The record header is the slot and the checksum" );
+
+
+// OS file access: positioned reads and writes, and the header mapped into memory
+
+#if defined(_WIN32)
+
+struct RegionFile::NativeFile{
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+	void* header = nullptr;
+	size_t headerSize = 0;
+
+	~NativeFile(){
+		if( header ) UnmapViewOfFile( header );
+		if( mapping ) CloseHandle( mapping );
+		if( file != INVALID_HANDLE_VALUE ) CloseHandle( file );
+	}
+};
+
+static bool openNative( const std::string& path, RegionFile::NativeFile& native, uint64_t& fileSize ){
+	native.file = CreateFileA( path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( native.file == INVALID_HANDLE_VALUE ) return false;
+
+	LARGE_INTEGER size;
+	if( !GetFileSizeEx( native.file, &size ) ) return false;
+	fileSize = static_cast<uint64_t>( size.QuadPart );
+	return true;
+}
+
+static bool mapHeader( RegionFile::NativeFile& native, const size_t size ){
+	native.mapping = CreateFileMappingA( native.file, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>( size ), nullptr );
+	if( !native.mapping ) return false;
+	native.header = MapViewOfFile( native.mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size );
+	native.headerSize = size;
+	return native.header != nullptr;
+}
+
+static OVERLAPPED toOverlapped( const uint64_t offset ){
+	OVERLAPPED overlapped = {};
+	overlapped.Offset = static_cast<DWORD>( offset );
+	overlapped.OffsetHigh = static_cast<DWORD>( offset >> 32 );
+	return overlapped;
+}
+
+static bool readAt( RegionFile::NativeFile& native, const uint64_t offset, void* const data, const size_t size ){
+	OVERLAPPED overlapped = toOverlapped( offset );
+	DWORD read = 0;
+	return ReadFile( native.file, data, static_cast<DWORD>( size ), &read, &overlapped ) && read == size;
+}
+
+static bool writeAt( RegionFile::NativeFile& native, const uint64_t offset, const void* const data, const size_t size ){
+	OVERLAPPED overlapped = toOverlapped( offset );
+	DWORD written = 0;
+	return WriteFile( native.file, data, static_cast<DWORD>( size ), &written, &overlapped ) && written == size;
+}
+
+static bool syncNative( RegionFile::NativeFile& native ){
+	return FlushViewOfFile( native.header, 0 ) && FlushFileBuffers( native.file );
+}
+
+#else
+
+struct RegionFile::NativeFile{
+	int file = -1;
+	void* header = nullptr;
+	size_t headerSize = 0;
+
+	~NativeFile(){
+		if( header ) munmap( header, headerSize );
+		if( file >= 0 ) ::close( file );
+	}
+};
+
+static bool openNative( const std::string& path, RegionFile::NativeFile& native, uint64_t& fileSize ){
+	native.file = ::open( path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644 );
+	if( native.file < 0 ) return false;
+
+	struct stat status;
+	if( fstat( native.file, &status ) != 0 ) return false;
+	fileSize = static_cast<uint64_t>( status.st_size );
+	return true;
+}
+
+static bool mapHeader( RegionFile::NativeFile& native, const size_t size ){
+	void* const header = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, native.file, 0 );
+	if( header == MAP_FAILED ) return false;
+	native.header = header;
+	native.headerSize = size;
+	return true;
+}
+
+static bool readAt( RegionFile::NativeFile& native, uint64_t offset, void* const data, const size_t size ){
+	char* bytes = static_cast<char*>( data );
+	size_t left = size;
+	while( left ){
+		const ssize_t read = pread( native.file, bytes, left, static_cast<off_t>( offset ) );
+		if( read < 0 && errno == EINTR ) continue;
+		if( read <= 0 ) return false; // an error, or the file ends first
+		bytes += read;
+		left -= size_t( read );
+		offset += uint64_t( read );
+	}
+	return true;
+}
+
+static bool writeAt( RegionFile::NativeFile& native, uint64_t offset, const void* const data, const size_t size ){
+	const char* bytes = static_cast<const char*>( data );
+	size_t left = size;
+	while( left ){
+		const ssize_t written = pwrite( native.file, bytes, left, static_cast<off_t>( offset ) );
+		if( written < 0 && errno == EINTR ) continue;
+		if( written <= 0 ) return false;
+		bytes += written;
+		left -= size_t( written );
+		offset += uint64_t( written );
+	}
+	return true;
+}
+
+static bool syncNative( RegionFile::NativeFile& native ){
+	return msync( native.header, native.headerSize, MS_SYNC ) == 0 && fsync( native.file ) == 0;
+}
+
+#endif
+
+
+RegionFile::RegionFile( std::string path )
+: m_path( std::move( path ) )
+{
+	open();
+}
+
+RegionFile::~RegionFile() = default; // the OS writes back what is not flushed yet
+
+void RegionFile::open(){
+	m_file.reset( new NativeFile );
+	uint64_t fileSize = 0;
+	if(  !openNative( m_path, *m_file, fileSize )  ) throw "Failed to open the region file " + m_path;
+
+	const size_t headerSize = size_t( headerSectors ) * sectorSize;
+	if( fileSize == 0 ){ // new: the magic number and an empty index
+		std::vector<uint8_t> header( headerSize, 0 );
+		std::memcpy( header.data(), magic, sizeof( magic ) );
+		std::memcpy( header.data() + sizeof( magic ), &formatVersion, sizeof( formatVersion ) );
+		if(  !writeAt( *m_file, 0, header.data(), header.size() )  ) throw "Failed to write the header of the region file " + m_path;
+		fileSize = headerSize;
+	}
+	else if( fileSize < headerSize ) throw "Not a region file (too small): " + m_path;
+
+	if(  !mapHeader( *m_file, headerSize )  ) throw "Failed to map the header of the region file " + m_path;
+
+	const uint8_t* const header = static_cast<const uint8_t*>( m_file->header );
+	uint32_t version;
+	std::memcpy( &version, header + sizeof( magic ), sizeof( version ) );
+	if(  std::memcmp( header, magic, sizeof( magic ) ) != 0  ) throw "Not a region file (no magic number): " + m_path;
+	if( version != formatVersion ) throw "Unknown region file version " + std::to_string( version ) + ": " + m_path;
+
+	m_index = reinterpret_cast<IndexEntry*>( static_cast<uint8_t*>( m_file->header ) + sectorSize );
+	m_sectorCount = static_cast<uint32_t>(  (fileSize + sectorSize - 1) / sectorSize  );
+	validateIndex();
+}
+
+void RegionFile::close(){
+	m_index = nullptr;
+	m_released.clear(); // validateIndex() starts over from the index of the reopened file
+	m_releasedSectorCount = 0;
+	m_file.reset();
+}
+
+void RegionFile::validateIndex(){
+	m_used.assign( m_sectorCount, false );
+	for( uint32_t s = 0; s < headerSectors; ++s ) m_used[s] = true;
+
+	for( uint32_t slot = 0; slot < slotCount; ++slot ){
+		IndexEntry& entry = m_index[slot];
+		if( !entry.sector ) continue;
+
+		const uint32_t count = toSectorCount( entry.size );
+		bool valid = entry.size > 0 && entry.sector >= headerSectors && uint64_t( entry.sector ) + count <= m_sectorCount;
+		for( uint32_t s = entry.sector; valid && s < entry.sector + count; ++s ) valid = !m_used[s];
+
+		if( !valid ){ // e.g. a crash before the payload it points to was written; the chunk is gone, not the region
+			entry = { 0, 0 };
+			continue;
+		}
+		for( uint32_t s = entry.sector; s < entry.sector + count; ++s ) m_used[s] = true;
+	}
+
+	m_freeSectorCount = 0;
+	for( uint32_t s = headerSectors; s < m_sectorCount; ++s ) m_freeSectorCount += !m_used[s];
+}
+
+uint32_t RegionFile::allocate( const uint32_t sectorCount ){
+	if( m_freeSectorCount >= sectorCount ){
+		uint32_t run = 0;
+		for( uint32_t s = headerSectors; s < m_sectorCount; ++s ){
+			run = m_used[s] ? 0 : run + 1;
+			if( run < sectorCount ) continue;
+
+			const uint32_t first = s + 1 - sectorCount;
+			for( uint32_t u = first; u <= s; ++u ) m_used[u] = true;
+			m_freeSectorCount -= sectorCount;
+			return first;
+		}
+	}
+
+	// append; a gap at the end of the file is grown rather than skipped
+	uint32_t first = m_sectorCount;
+	while( first > headerSectors && !m_used[first - 1] ) --first;
+	m_freeSectorCount -= m_sectorCount - first;
+	m_sectorCount = first + sectorCount;
+	m_used.resize( m_sectorCount );
+	for( uint32_t u = first; u < m_sectorCount; ++u ) m_used[u] = true;
+	return first;
+}
+
+void RegionFile::release( const uint32_t sector, const uint32_t sectorCount ){
+	m_released.push_back( { sector, sectorCount } );
+	m_releasedSectorCount += sectorCount;
+}
+
+void RegionFile::markFree( const uint32_t sector, const uint32_t sectorCount ){
+	for( uint32_t s = sector; s < sector + sectorCount; ++s ) m_used[s] = false;
+	m_freeSectorCount += sectorCount;
+}
+
+bool RegionFile::read( const uint32_t slot, std::vector<uint8_t>& payload ) const{
+	const IndexEntry entry = m_index[slot];
+	if( !entry.sector ) return false;
+
+	uint32_t header[2]; // slot, checksum
+	payload.resize( recordHeaderSize + entry.size );
+	if(  !readAt( *m_file, uint64_t( entry.sector ) * sectorSize, payload.data(), payload.size() )  ) throw "Failed to read from the region file " + m_path;
+	std::memcpy( header, payload.data(), recordHeaderSize );
+	payload.erase( payload.begin(), payload.begin() + recordHeaderSize );
+
+	// e.g. the index reached the disk before a crash and the payload did not, or the sectors held another chunk before
+	return header[0] == slot && header[1] == checksum( payload.data(), payload.size() );
+}
+
+void RegionFile::write( const uint32_t slot, const uint8_t* const payload, const uint32_t size ){
+	if( !size ){
+		erase( slot );
+		return;
+	}
+
+	// the new payload always goes to sectors of its own, and only then does the index point at it, so the old payload
+	// stays whole until the new one is; see release() for why the old sectors are not reused right away
+	IndexEntry& entry = m_index[slot];
+	const uint32_t count = toSectorCount( size );
+	const uint32_t sector = allocate( count );
+	const uint32_t header[2] = { slot, checksum( payload, size ) };
+	const uint64_t offset = uint64_t( sector ) * sectorSize;
+	if(  !writeAt( *m_file, offset, header, recordHeaderSize ) || !writeAt( *m_file, offset + recordHeaderSize, payload, size )  ){
+		markFree( sector, count ); // nothing points at them
+		throw "Failed to write to the region file " + m_path;
+	}
+
+	const IndexEntry old = entry;
+	entry = { sector, size };
+	if( old.sector ) release( old.sector, toSectorCount( old.size ) );
+}
+
+void RegionFile::erase( const uint32_t slot ){
+	IndexEntry& entry = m_index[slot];
+	if( !entry.sector ) return;
+
+	release( entry.sector, toSectorCount( entry.size ) );
+	entry = { 0, 0 };
+}
+
+void RegionFile::flush(){
+	if(  !syncNative( *m_file )  ) throw "Failed to flush the region file " + m_path;
+
+	// the index on the disk no longer points at the released sectors
+	for( const std::pair<uint32_t, uint32_t>& released : m_released ) markFree( released.first, released.second );
+	m_released.clear();
+	m_releasedSectorCount = 0;
+}
+
+void RegionFile::compact(){
+	const std::string compactedPath = m_path + ".compact";
+	std::remove( compactedPath.c_str() ); // a leftover of an interrupted compaction
+
+	{
+		RegionFile compacted( compactedPath );
+		std::vector<uint8_t> payload;
+		for( uint32_t slot = 0; slot < slotCount; ++slot ){
+			if(  read( slot, payload )  ) compacted.write(  slot, payload.data(), static_cast<uint32_t>( payload.size() )  );
+		}
+		compacted.flush();
+	}
+
+	close();
+	const bool replaced = replaceFile( compactedPath, m_path );
+	open(); // the compacted file, or still the old one
+	if( !replaced ) throw "Failed to replace the region file " + m_path + " with its compacted copy";
+}
@@ -0,0 +1,81 @@
+// One file holding the saved chunks of a cube of chunk coordinates, with a memory-mapped index for O(1) lookups
+
+#ifndef COMMON_REGION_FILE_H
+#define COMMON_REGION_FILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// The file is made of sectors of sectorSize bytes. The first headerSectors hold a magic number and an index of
+// slotCount entries, one per chunk of the region (see slotOf), each the first sector and byte size of the chunk's
+// payload; sector 0 means none. A payload is stored after a record header of its slot and checksum. Only the header is mapped into memory, so a lookup is one load whatever the file size,
+// and payloads are read and written with positioned file I/O.
+// A payload goes into the first gap that is big enough, or is appended at the end of the file, and only then does the
+// index point at it; it never overwrites the payload it replaces. The sectors a payload leaves behind, when rewritten or
+// erased, are not reused until flush() has put an index that no longer points at them on the disk. So after a crash
+// an index entry points at the payload it had, or at one whose writes did not all reach the disk, which the record
+// header tells apart. Gaps come from payloads left behind; compact() rewrites the file without them. Writes reach the disk when the OS gets to it; flush() waits until they have.
+// Payloads are opaque to this class. Not thread-safe.
+class RegionFile{
+public:
+	static constexpr uint32_t sizeLog2 = 4;
+	static constexpr uint32_t size = 1u << sizeLog2; // chunks along each axis
+	static constexpr uint32_t slotCount = size * size * size;
+	static constexpr uint32_t sectorSize = 512; // small, as compressed chunks mostly take a KiB or two
+	static constexpr uint32_t headerSectors = 1 + slotCount * 8 / sectorSize; // the magic number's sector, then the index
+	static constexpr uint32_t recordHeaderSize = 8; // before each payload
+
+	// chunk coordinates within the region, each below size
+	static uint32_t slotOf( uint32_t x, uint32_t y, uint32_t z ){ return (y << 2*sizeLog2) | (z << sizeLog2) | x; }
+
+	// creates an empty region file if there is none at path; throws if it cannot, or if the file is not a region file
+	explicit RegionFile( std::string path );
+	~RegionFile();
+	RegionFile( const RegionFile& ) = delete;
+	RegionFile& operator=( const RegionFile& ) = delete;
+
+	const std::string& getPath() const{ return m_path; }
+
+	bool has( uint32_t slot ) const{ return m_index[slot].sector != 0; }
+	// replaces payload; false if the slot is empty, or if its payload is not the one written last (torn by a crash)
+	bool read( uint32_t slot, std::vector<uint8_t>& payload ) const;
+	void write( uint32_t slot, const uint8_t* payload, uint32_t size ); // an empty payload erases the slot
+	void erase( uint32_t slot );
+
+	void flush(); // the index and all payloads written so far are on the disk
+	void compact(); // rewrites the file with the payloads back to back; flushes
+
+	uint32_t getSectorCount() const{ return m_sectorCount; } // of the file, header included
+	uint32_t getFreeSectorCount() const{ return m_freeSectorCount + m_releasedSectorCount; } // in gaps between payloads
+
+	struct NativeFile; // the OS handles; per platform, in the .cpp
+
+private:
+	struct IndexEntry{
+		uint32_t sector;
+		uint32_t size; // bytes
+	};
+
+	void open();
+	void close();
+	void validateIndex(); // drops entries pointing outside the file or overlapping another
+	uint32_t allocate( uint32_t sectorCount ); // first gap that fits, or the end of the file
+	void release( uint32_t sector, uint32_t sectorCount ); // free once flush() is done, as the index on the disk may point at them
+	void markFree( uint32_t sector, uint32_t sectorCount );
+	static uint32_t toSectorCount( uint32_t payloadSize ){ return static_cast<uint32_t>(  (uint64_t( recordHeaderSize ) + payloadSize + sectorSize - 1) / sectorSize  ); }
+
+	std::string m_path;
+	std::unique_ptr<NativeFile> m_file;
+	IndexEntry* m_index = nullptr; // in the mapped header
+	std::vector<bool> m_used; // per sector of the file
+	uint32_t m_sectorCount = 0;
+	uint32_t m_freeSectorCount = 0; // free for allocate()
+	std::vector< std::pair<uint32_t, uint32_t> > m_released; // first sector and count, still used until flush()
+	uint32_t m_releasedSectorCount = 0;
+};
+
+#endif //COMMON_REGION_FILE_H
@@ -0,0 +1,514 @@
+// Seeded 2D/3D simplex gradient noise and fractal sums of it, evaluated in batches with AVX2, SSE4.1 or scalar code
+#include "SimplexNoise.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Implementation
+//////////////////////////////////
+
+// The SIMD kernels below mirror the scalar ones operation for operation; keep them that way, or the paths stop agreeing.
+
+static constexpr float F2 = 0.36602540378f; // (sqrt( 3 ) - 1) / 2: skews the plane onto the triangle lattice
+static constexpr float G2 = 0.21132486540f; // (3 - sqrt( 3 )) / 6: unskews it
+static constexpr float twoG2 = 2.0f * G2;
+static constexpr float F3 = 1.0f / 3.0f;
+static constexpr float G3 = 1.0f / 6.0f;
+static constexpr float twoG3 = 2.0f * G3;
+static constexpr float threeG3 = 3.0f * G3;
+
+// bring the sums of the corner contributions to about [-1, 1]; measured
+static constexpr float scale2 = 90.0f;
+static constexpr float scale3 = 76.0f;
+
+static constexpr uint32_t primeX = 0x8DA6B343u;
+static constexpr uint32_t primeY = 0xD8163841u;
+static constexpr uint32_t primeZ = 0xCB1AB31Fu;
+static constexpr uint32_t hashMultiplier = 0x27D4EB2Du;
+
+struct Octave{
+	uint32_t seed;
+	float frequency;
+	float amplitude; // normalized, so the weights of all octaves sum to 1
+};
+
+static uint32_t getOctaves( const uint32_t seed, const SimplexNoise::Fractal& fractal, Octave* const octaves ){
+	if( fractal.octaves == 0 || fractal.octaves > SimplexNoise::maxOctaves ) throw "Fractal noise needs 1 to SimplexNoise::maxOctaves octaves";
+
+	float frequency = fractal.frequency;
+	float amplitude = 1.0f;
+	float total = 0.0f;
+	for( uint32_t o = 0; o < fractal.octaves; ++o ){
+		octaves[o] = { seed + o * 0x9E3779B9u, frequency, amplitude };
+		total += amplitude;
+		frequency *= fractal.lacunarity;
+		amplitude *= fractal.gain;
+	}
+	for( uint32_t o = 0; o < fractal.octaves; ++o ) octaves[o].amplitude /= total;
+
+	return fractal.octaves;
+}
+
+
+// Scalar
+
+static uint32_t hash( const uint32_t seed, const int32_t i, const int32_t j ){
+	uint32_t h = seed ^ uint32_t( i ) * primeX ^ uint32_t( j ) * primeY;
+	h *= hashMultiplier;
+	return h ^ (h >> 15);
+}
+
+static uint32_t hash( const uint32_t seed, const int32_t i, const int32_t j, const int32_t k ){
+	uint32_t h = seed ^ uint32_t( i ) * primeX ^ uint32_t( j ) * primeY ^ uint32_t( k ) * primeZ;
+	h *= hashMultiplier;
+	return h ^ (h >> 15);
+}
+
+// one of 8 directions: ( +-1, +-0.5 ) or ( +-0.5, +-1 )
+static float gradient( const uint32_t h, const float x, const float y ){
+	const float u = h & 1 ? y : x;
+	const float v = h & 1 ? x : y;
+	return (h & 2 ? -u : u) + (h & 4 ? -(v * 0.5f) : v * 0.5f);
+}
+
+// one of the 12 edge directions of a cube, 4 of them twice (Perlin's improved noise)
+static float gradient( const uint32_t h, const float x, const float y, const float z ){
+	const uint32_t g = h & 15;
+	const float u = g < 8 ? x : y;
+	const float v = g < 4 ? y : (g | 2) == 14 ? x : z;
+	return (h & 1 ? -u : u) + (h & 2 ? -v : v);
+}
+
+static float corner( const uint32_t h, const float x, const float y ){
+	const float t = 0.5f - x * x - y * y;
+	if( !(t > 0.0f) ) return 0.0f;
+	const float t2 = t * t;
+	return t2 * t2 * gradient( h, x, y );
+}
+
+static float corner( const uint32_t h, const float x, const float y, const float z ){
+	const float t = 0.5f - x * x - y * y - z * z;
+	if( !(t > 0.0f) ) return 0.0f;
+	const float t2 = t * t;
+	return t2 * t2 * gradient( h, x, y, z );
+}
+
+static float simplex2( const uint32_t seed, const float x, const float y ){
+	const float s = (x + y) * F2;
+	const int32_t i = static_cast<int32_t>(  std::floor( x + s )  );
+	const int32_t j = static_cast<int32_t>(  std::floor( y + s )  );
+	const float t = static_cast<float>( i + j ) * G2;
+	const float x0 = x - (static_cast<float>( i ) - t);
+	const float y0 = y - (static_cast<float>( j ) - t);
+
+	// the middle corner of the triangle the position is in
+	const int32_t i1 = x0 > y0 ? 1 : 0;
+	const int32_t j1 = 1 - i1;
+
+	const float x1 = x0 - static_cast<float>( i1 ) + G2;
+	const float y1 = y0 - static_cast<float>( j1 ) + G2;
+	const float x2 = x0 - 1.0f + twoG2;
+	const float y2 = y0 - 1.0f + twoG2;
+
+	const float n = corner( hash( seed, i, j ), x0, y0 ) + corner( hash( seed, i + i1, j + j1 ), x1, y1 ) + corner( hash( seed, i + 1, j + 1 ), x2, y2 );
+	return n * scale2;
+}
+
+static float simplex3( const uint32_t seed, const float x, const float y, const float z ){
+	const float s = (x + y + z) * F3;
+	const int32_t i = static_cast<int32_t>(  std::floor( x + s )  );
+	const int32_t j = static_cast<int32_t>(  std::floor( y + s )  );
+	const int32_t k = static_cast<int32_t>(  std::floor( z + s )  );
+	const float t = static_cast<float>( i + j + k ) * G3;
+	const float x0 = x - (static_cast<float>( i ) - t);
+	const float y0 = y - (static_cast<float>( j ) - t);
+	const float z0 = z - (static_cast<float>( k ) - t);
+
+	// the two middle corners of the tetrahedron the position is in: one step along the axis of the largest offset,
+	// then one along that of the second largest
+	const bool xy = x0 >= y0, xz = x0 >= z0, yz = y0 >= z0;
+	const int32_t i1 = xy && xz, j1 = !xy && yz, k1 = !xz && !yz;
+	const int32_t i2 = xy || xz, j2 = !xy || yz, k2 = !xz || !yz;
+
+	const float x1 = x0 - static_cast<float>( i1 ) + G3;
+	const float y1 = y0 - static_cast<float>( j1 ) + G3;
+	const float z1 = z0 - static_cast<float>( k1 ) + G3;
+	const float x2 = x0 - static_cast<float>( i2 ) + twoG3;
+	const float y2 = y0 - static_cast<float>( j2 ) + twoG3;
+	const float z2 = z0 - static_cast<float>( k2 ) + twoG3;
+	const float x3 = x0 - 1.0f + threeG3;
+	const float y3 = y0 - 1.0f + threeG3;
+	const float z3 = z0 - 1.0f + threeG3;
+
+	const float n = corner( hash( seed, i, j, k ), x0, y0, z0 )
+	              + corner( hash( seed, i + i1, j + j1, k + k1 ), x1, y1, z1 )
+	              + corner( hash( seed, i + i2, j + j2, k + k2 ), x2, y2, z2 )
+	              + corner( hash( seed, i + 1, j + 1, k + 1 ), x3, y3, z3 );
+	return n * scale3;
+}
+
+static void fractal2Scalar( const Octave* const octaves, const uint32_t octaveCount, const float* const x, const float* const y, const size_t begin, const size_t end, float* const result ){
+	for( size_t n = begin; n < end; ++n ){
+		float sum = 0.0f;
+		for( uint32_t o = 0; o < octaveCount; ++o ){
+			sum += simplex2( octaves[o].seed, x[n] * octaves[o].frequency, y[n] * octaves[o].frequency ) * octaves[o].amplitude;
+		}
+		result[n] = sum;
+	}
+}
+
+static void fractal3Scalar( const Octave* const octaves, const uint32_t octaveCount, const float* const x, const float* const y, const float* const z, const size_t begin, const size_t end, float* const result ){
+	for( size_t n = begin; n < end; ++n ){
+		float sum = 0.0f;
+		for( uint32_t o = 0; o < octaveCount; ++o ){
+			const float frequency = octaves[o].frequency;
+			sum += simplex3( octaves[o].seed, x[n] * frequency, y[n] * frequency, z[n] * frequency ) * octaves[o].amplitude;
+		}
+		result[n] = sum;
+	}
+}
+
+
+#if CPU_X86
+
+// SSE4.1: 4 lanes
+
+TARGET_SSE41 static __m128i hashSse41( const __m128i seed, const __m128i i, const __m128i j ){
+	__m128i h = _mm_xor_si128(  seed, _mm_xor_si128( _mm_mullo_epi32( i, _mm_set1_epi32( int32_t( primeX ) ) ), _mm_mullo_epi32( j, _mm_set1_epi32( int32_t( primeY ) ) ) )  );
+	h = _mm_mullo_epi32( h, _mm_set1_epi32( int32_t( hashMultiplier ) ) );
+	return _mm_xor_si128( h, _mm_srli_epi32( h, 15 ) );
+}
+
+TARGET_SSE41 static __m128i hashSse41( const __m128i seed, const __m128i i, const __m128i j, const __m128i k ){
+	__m128i h = _mm_xor_si128(  seed, _mm_xor_si128( _mm_mullo_epi32( i, _mm_set1_epi32( int32_t( primeX ) ) ), _mm_mullo_epi32( j, _mm_set1_epi32( int32_t( primeY ) ) ) )  );
+	h = _mm_xor_si128(  h, _mm_mullo_epi32( k, _mm_set1_epi32( int32_t( primeZ ) ) )  );
+	h = _mm_mullo_epi32( h, _mm_set1_epi32( int32_t( hashMultiplier ) ) );
+	return _mm_xor_si128( h, _mm_srli_epi32( h, 15 ) );
+}
+
+// the hash bit b moved to the sign bit, which is what blendv looks at and what flips the sign of a float
+TARGET_SSE41 static __m128 bitToSignSse41( const __m128i h, const int b ){
+	return _mm_castsi128_ps(  _mm_slli_epi32( _mm_srli_epi32( h, b ), 31 )  );
+}
+
+// the lattice coordinate c + 1 where mask is set
+TARGET_SSE41 static __m128i stepSse41( const __m128i c, const __m128 mask ){
+	return _mm_sub_epi32(  c, _mm_castps_si128( mask )  );
+}
+
+TARGET_SSE41 static __m128 gradientSse41( const __m128i h, const __m128 x, const __m128 y ){
+	const __m128 swap = bitToSignSse41( h, 0 );
+	const __m128 u = _mm_blendv_ps( x, y, swap );
+	const __m128 v = _mm_blendv_ps( y, x, swap );
+	return _mm_add_ps(  _mm_xor_ps( u, bitToSignSse41( h, 1 ) ), _mm_xor_ps( _mm_mul_ps( v, _mm_set1_ps( 0.5f ) ), bitToSignSse41( h, 2 ) )  );
+}
+
+TARGET_SSE41 static __m128 gradientSse41( const __m128i h, const __m128 x, const __m128 y, const __m128 z ){
+	const __m128i g = _mm_and_si128( h, _mm_set1_epi32( 15 ) );
+	const __m128 u = _mm_blendv_ps(  x, y, _mm_castsi128_ps( _mm_cmpgt_epi32( g, _mm_set1_epi32( 7 ) ) )  );
+	const __m128 vIsX = _mm_castsi128_ps(  _mm_cmpeq_epi32( _mm_or_si128( g, _mm_set1_epi32( 2 ) ), _mm_set1_epi32( 14 ) )  );
+	const __m128 vIsY = _mm_castsi128_ps(  _mm_cmplt_epi32( g, _mm_set1_epi32( 4 ) )  );
+	const __m128 v = _mm_blendv_ps( _mm_blendv_ps( z, x, vIsX ), y, vIsY );
+	return _mm_add_ps(  _mm_xor_ps( u, bitToSignSse41( h, 0 ) ), _mm_xor_ps( v, bitToSignSse41( h, 1 ) )  );
+}
+
+TARGET_SSE41 static __m128 cornerSse41( const __m128i h, const __m128 x, const __m128 y ){
+	const __m128 t = _mm_sub_ps(  _mm_sub_ps( _mm_set1_ps( 0.5f ), _mm_mul_ps( x, x ) ), _mm_mul_ps( y, y )  );
+	const __m128 t2 = _mm_mul_ps( t, t );
+	const __m128 n = _mm_mul_ps(  _mm_mul_ps( t2, t2 ), gradientSse41( h, x, y )  );
+	return _mm_and_ps(  _mm_cmpgt_ps( t, _mm_setzero_ps() ), n  );
+}
+
+TARGET_SSE41 static __m128 cornerSse41( const __m128i h, const __m128 x, const __m128 y, const __m128 z ){
+	const __m128 t = _mm_sub_ps(  _mm_sub_ps( _mm_sub_ps( _mm_set1_ps( 0.5f ), _mm_mul_ps( x, x ) ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z )  );
+	const __m128 t2 = _mm_mul_ps( t, t );
+	const __m128 n = _mm_mul_ps(  _mm_mul_ps( t2, t2 ), gradientSse41( h, x, y, z )  );
+	return _mm_and_ps(  _mm_cmpgt_ps( t, _mm_setzero_ps() ), n  );
+}
+
+TARGET_SSE41 static __m128 simplex2Sse41( const __m128i seed, const __m128 x, const __m128 y ){
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128i oneI = _mm_set1_epi32( 1 );
+
+	const __m128 s = _mm_mul_ps(  _mm_add_ps( x, y ), _mm_set1_ps( F2 )  );
+	const __m128i i = _mm_cvttps_epi32(  _mm_floor_ps( _mm_add_ps( x, s ) )  );
+	const __m128i j = _mm_cvttps_epi32(  _mm_floor_ps( _mm_add_ps( y, s ) )  );
+	const __m128 t = _mm_mul_ps(  _mm_cvtepi32_ps( _mm_add_epi32( i, j ) ), _mm_set1_ps( G2 )  );
+	const __m128 x0 = _mm_sub_ps(  x, _mm_sub_ps( _mm_cvtepi32_ps( i ), t )  );
+	const __m128 y0 = _mm_sub_ps(  y, _mm_sub_ps( _mm_cvtepi32_ps( j ), t )  );
+
+	const __m128 i1 = _mm_cmpgt_ps( x0, y0 ); // all bits set where the step is along x; -1 as an integer
+	const __m128i i1I = _mm_castps_si128( i1 );
+	const __m128i j1I = _mm_xor_si128(  i1I, _mm_set1_epi32( -1 )  );
+
+	const __m128 x1 = _mm_add_ps(  _mm_sub_ps( x0, _mm_and_ps( i1, one ) ), _mm_set1_ps( G2 )  );
+	const __m128 y1 = _mm_add_ps(  _mm_sub_ps( y0, _mm_andnot_ps( i1, one ) ), _mm_set1_ps( G2 )  );
+	const __m128 x2 = _mm_add_ps(  _mm_sub_ps( x0, one ), _mm_set1_ps( twoG2 )  );
+	const __m128 y2 = _mm_add_ps(  _mm_sub_ps( y0, one ), _mm_set1_ps( twoG2 )  );
+
+	const __m128 n0 = cornerSse41( hashSse41( seed, i, j ), x0, y0 );
+	const __m128 n1 = cornerSse41(  hashSse41( seed, _mm_sub_epi32( i, i1I ), _mm_sub_epi32( j, j1I ) ), x1, y1  );
+	const __m128 n2 = cornerSse41(  hashSse41( seed, _mm_add_epi32( i, oneI ), _mm_add_epi32( j, oneI ) ), x2, y2  );
+	return _mm_mul_ps(  _mm_add_ps( _mm_add_ps( n0, n1 ), n2 ), _mm_set1_ps( scale2 )  );
+}
+
+TARGET_SSE41 static __m128 simplex3Sse41( const __m128i seed, const __m128 x, const __m128 y, const __m128 z ){
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128i oneI = _mm_set1_epi32( 1 );
+
+	const __m128 s = _mm_mul_ps(  _mm_add_ps( _mm_add_ps( x, y ), z ), _mm_set1_ps( F3 )  );
+	const __m128i i = _mm_cvttps_epi32(  _mm_floor_ps( _mm_add_ps( x, s ) )  );
+	const __m128i j = _mm_cvttps_epi32(  _mm_floor_ps( _mm_add_ps( y, s ) )  );
+	const __m128i k = _mm_cvttps_epi32(  _mm_floor_ps( _mm_add_ps( z, s ) )  );
+	const __m128 t = _mm_mul_ps(  _mm_cvtepi32_ps( _mm_add_epi32( _mm_add_epi32( i, j ), k ) ), _mm_set1_ps( G3 )  );
+	const __m128 x0 = _mm_sub_ps(  x, _mm_sub_ps( _mm_cvtepi32_ps( i ), t )  );
+	const __m128 y0 = _mm_sub_ps(  y, _mm_sub_ps( _mm_cvtepi32_ps( j ), t )  );
+	const __m128 z0 = _mm_sub_ps(  z, _mm_sub_ps( _mm_cvtepi32_ps( k ), t )  );
+
+	const __m128 xy = _mm_cmpge_ps( x0, y0 );
+	const __m128 xz = _mm_cmpge_ps( x0, z0 );
+	const __m128 yz = _mm_cmpge_ps( y0, z0 );
+	const __m128 i1 = _mm_and_ps( xy, xz );
+	const __m128 j1 = _mm_andnot_ps( xy, yz );
+	const __m128 k1 = _mm_andnot_ps(  _mm_or_ps( xz, yz ), _mm_castsi128_ps( _mm_set1_epi32( -1 ) )  );
+	const __m128 i2 = _mm_or_ps( xy, xz );
+	const __m128 j2 = _mm_or_ps(  _mm_andnot_ps( xy, _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) ), yz  );
+	const __m128 k2 = _mm_andnot_ps(  _mm_and_ps( xz, yz ), _mm_castsi128_ps( _mm_set1_epi32( -1 ) )  );
+
+	const __m128 x1 = _mm_add_ps(  _mm_sub_ps( x0, _mm_and_ps( i1, one ) ), _mm_set1_ps( G3 )  );
+	const __m128 y1 = _mm_add_ps(  _mm_sub_ps( y0, _mm_and_ps( j1, one ) ), _mm_set1_ps( G3 )  );
+	const __m128 z1 = _mm_add_ps(  _mm_sub_ps( z0, _mm_and_ps( k1, one ) ), _mm_set1_ps( G3 )  );
+	const __m128 x2 = _mm_add_ps(  _mm_sub_ps( x0, _mm_and_ps( i2, one ) ), _mm_set1_ps( twoG3 )  );
+	const __m128 y2 = _mm_add_ps(  _mm_sub_ps( y0, _mm_and_ps( j2, one ) ), _mm_set1_ps( twoG3 )  );
+	const __m128 z2 = _mm_add_ps(  _mm_sub_ps( z0, _mm_and_ps( k2, one ) ), _mm_set1_ps( twoG3 )  );
+	const __m128 x3 = _mm_add_ps(  _mm_sub_ps( x0, one ), _mm_set1_ps( threeG3 )  );
+	const __m128 y3 = _mm_add_ps(  _mm_sub_ps( y0, one ), _mm_set1_ps( threeG3 )  );
+	const __m128 z3 = _mm_add_ps(  _mm_sub_ps( z0, one ), _mm_set1_ps( threeG3 )  );
+
+	const __m128 n0 = cornerSse41( hashSse41( seed, i, j, k ), x0, y0, z0 );
+	const __m128 n1 = cornerSse41(  hashSse41( seed, stepSse41( i, i1 ), stepSse41( j, j1 ), stepSse41( k, k1 ) ), x1, y1, z1  );
+	const __m128 n2 = cornerSse41(  hashSse41( seed, stepSse41( i, i2 ), stepSse41( j, j2 ), stepSse41( k, k2 ) ), x2, y2, z2  );
+	const __m128 n3 = cornerSse41(  hashSse41( seed, _mm_add_epi32( i, oneI ), _mm_add_epi32( j, oneI ), _mm_add_epi32( k, oneI ) ), x3, y3, z3  );
+	return _mm_mul_ps(  _mm_add_ps( _mm_add_ps( _mm_add_ps( n0, n1 ), n2 ), n3 ), _mm_set1_ps( scale3 )  );
+}
+
+// returns how many positions it did, a multiple of 4
+TARGET_SSE41 static size_t fractal2Sse41( const Octave* const octaves, const uint32_t octaveCount, const float* const x, const float* const y, const size_t count, float* const result ){
+	size_t n = 0;
+	for( ; n + 4 <= count; n += 4 ){
+		const __m128 px = _mm_loadu_ps( x + n );
+		const __m128 py = _mm_loadu_ps( y + n );
+		__m128 sum = _mm_setzero_ps();
+		for( uint32_t o = 0; o < octaveCount; ++o ){
+			const __m128 frequency = _mm_set1_ps( octaves[o].frequency );
+			const __m128 noise = simplex2Sse41(  _mm_set1_epi32( int32_t( octaves[o].seed ) ), _mm_mul_ps( px, frequency ), _mm_mul_ps( py, frequency )  );
+			sum = _mm_add_ps(  sum, _mm_mul_ps( noise, _mm_set1_ps( octaves[o].amplitude ) )  );
+		}
+		_mm_storeu_ps( result + n, sum );
+	}
+	return n;
+}
+
+TARGET_SSE41 static size_t fractal3Sse41( const Octave* const octaves, const uint32_t octaveCount, const float* const x, const float* const y, const float* const z, const size_t count, float* const result ){
+	size_t n = 0;
+	for( ; n + 4 <= count; n += 4 ){
+		const __m128 px = _mm_loadu_ps( x + n );
+		const __m128 py = _mm_loadu_ps( y + n );
+		const __m128 pz = _mm_loadu_ps( z + n );
+		__m128 sum = _mm_setzero_ps();
+		for( uint32_t o = 0; o < octaveCount; ++o ){
+			const __m128 frequency = _mm_set1_ps( octaves[o].frequency );
+			const __m128 noise = simplex3Sse41(  _mm_set1_epi32( int32_t( octaves[o].seed ) ), _mm_mul_ps( px, frequency ), _mm_mul_ps( py, frequency ), _mm_mul_ps( pz, frequency )  );
+			sum = _mm_add_ps(  sum, _mm_mul_ps( noise, _mm_set1_ps( octaves[o].amplitude ) )  );
+		}
+		_mm_storeu_ps( result + n, sum );
+	}
+	return n;
+}
+
+
+// AVX2: 8 lanes; the same as the SSE4.1 code, twice as wide
+
+TARGET_AVX2 static __m256i hashAvx2( const __m256i seed, const __m256i i, const __m256i j ){
+	__m256i h = _mm256_xor_si256(  seed, _mm256_xor_si256( _mm256_mullo_epi32( i, _mm256_set1_epi32( int32_t( primeX ) ) ), _mm256_mullo_epi32( j, _mm256_set1_epi32( int32_t( primeY ) ) ) )  );
+	h = _mm256_mullo_epi32( h, _mm256_set1_epi32( int32_t( hashMultiplier ) ) );
+	return _mm256_xor_si256( h, _mm256_srli_epi32( h, 15 ) );
+}
+
+TARGET_AVX2 static __m256i hashAvx2( const __m256i seed, const __m256i i, const __m256i j, const __m256i k ){
+	__m256i h = _mm256_xor_si256(  seed, _mm256_xor_si256( _mm256_mullo_epi32( i, _mm256_set1_epi32( int32_t( primeX ) ) ), _mm256_mullo_epi32( j, _mm256_set1_epi32( int32_t( primeY ) ) ) )  );
+	h = _mm256_xor_si256(  h, _mm256_mullo_epi32( k, _mm256_set1_epi32( int32_t( primeZ ) ) )  );
+	h = _mm256_mullo_epi32( h, _mm256_set1_epi32( int32_t( hashMultiplier ) ) );
+	return _mm256_xor_si256( h, _mm256_srli_epi32( h, 15 ) );
+}
+
+TARGET_AVX2 static __m256 bitToSignAvx2( const __m256i h, const int b ){
+	return _mm256_castsi256_ps(  _mm256_slli_epi32( _mm256_srli_epi32( h, b ), 31 )  );
+}
+
+TARGET_AVX2 static __m256i stepAvx2( const __m256i c, const __m256 mask ){
+	return _mm256_sub_epi32(  c, _mm256_castps_si256( mask )  );
+}
+
+TARGET_AVX2 static __m256 gradientAvx2( const __m256i h, const __m256 x, const __m256 y ){
+	const __m256 swap = bitToSignAvx2( h, 0 );
+	const __m256 u = _mm256_blendv_ps( x, y, swap );
+	const __m256 v = _mm256_blendv_ps( y, x, swap );
+	return _mm256_add_ps(  _mm256_xor_ps( u, bitToSignAvx2( h, 1 ) ), _mm256_xor_ps( _mm256_mul_ps( v, _mm256_set1_ps( 0.5f ) ), bitToSignAvx2( h, 2 ) )  );
+}
+
+TARGET_AVX2 static __m256 gradientAvx2( const __m256i h, const __m256 x, const __m256 y, const __m256 z ){
+	const __m256i g = _mm256_and_si256( h, _mm256_set1_epi32( 15 ) );
+	const __m256 u = _mm256_blendv_ps(  x, y, _mm256_castsi256_ps( _mm256_cmpgt_epi32( g, _mm256_set1_epi32( 7 ) ) )  );
+	const __m256 vIsX = _mm256_castsi256_ps(  _mm256_cmpeq_epi32( _mm256_or_si256( g, _mm256_set1_epi32( 2 ) ), _mm256_set1_epi32( 14 ) )  );
+	const __m256 vIsY = _mm256_castsi256_ps(  _mm256_cmpgt_epi32( _mm256_set1_epi32( 4 ), g )  );
+	const __m256 v = _mm256_blendv_ps( _mm256_blendv_ps( z, x, vIsX ), y, vIsY );
+	return _mm256_add_ps(  _mm256_xor_ps( u, bitToSignAvx2( h, 0 ) ), _mm256_xor_ps( v, bitToSignAvx2( h, 1 ) )  );
+}
+
+TARGET_AVX2 static __m256 cornerAvx2( const __m256i h, const __m256 x, const __m256 y ){
+	const __m256 t = _mm256_sub_ps(  _mm256_sub_ps( _mm256_set1_ps( 0.5f ), _mm256_mul_ps( x, x ) ), _mm256_mul_ps( y, y )  );
+	const __m256 t2 = _mm256_mul_ps( t, t );
+	const __m256 n = _mm256_mul_ps(  _mm256_mul_ps( t2, t2 ), gradientAvx2( h, x, y )  );
+	return _mm256_and_ps(  _mm256_cmp_ps( t, _mm256_setzero_ps(), _CMP_GT_OQ ), n  );
+}
+
+TARGET_AVX2 static __m256 cornerAvx2( const __m256i h, const __m256 x, const __m256 y, const __m256 z ){
+	const __m256 t = _mm256_sub_ps(  _mm256_sub_ps( _mm256_sub_ps( _mm256_set1_ps( 0.5f ), _mm256_mul_ps( x, x ) ), _mm256_mul_ps( y, y ) ), _mm256_mul_ps( z, z )  );
+	const __m256 t2 = _mm256_mul_ps( t, t );
+	const __m256 n = _mm256_mul_ps(  _mm256_mul_ps( t2, t2 ), gradientAvx2( h, x, y, z )  );
+	return _mm256_and_ps(  _mm256_cmp_ps( t, _mm256_setzero_ps(), _CMP_GT_OQ ), n  );
+}
+
+TARGET_AVX2 static __m256 simplex2Avx2( const __m256i seed, const __m256 x, const __m256 y ){
+	const __m256 one = _mm256_set1_ps( 1.0f );
+	const __m256i oneI = _mm256_set1_epi32( 1 );
+
+	const __m256 s = _mm256_mul_ps(  _mm256_add_ps( x, y ), _mm256_set1_ps( F2 )  );
+	const __m256i i = _mm256_cvttps_epi32(  _mm256_floor_ps( _mm256_add_ps( x, s ) )  );
+	const __m256i j = _mm256_cvttps_epi32(  _mm256_floor_ps( _mm256_add_ps( y, s ) )  );
+	const __m256 t = _mm256_mul_ps(  _mm256_cvtepi32_ps( _mm256_add_epi32( i, j ) ), _mm256_set1_ps( G2 )  );
+	const __m256 x0 = _mm256_sub_ps(  x, _mm256_sub_ps( _mm256_cvtepi32_ps( i ), t )  );
+	const __m256 y0 = _mm256_sub_ps(  y, _mm256_sub_ps( _mm256_cvtepi32_ps( j ), t )  );
+
+	const __m256 i1 = _mm256_cmp_ps( x0, y0, _CMP_GT_OQ );
+	const __m256i i1I = _mm256_castps_si256( i1 );
+	const __m256i j1I = _mm256_xor_si256(  i1I, _mm256_set1_epi32( -1 )  );
+
+	const __m256 x1 = _mm256_add_ps(  _mm256_sub_ps( x0, _mm256_and_ps( i1, one ) ), _mm256_set1_ps( G2 )  );
+	const __m256 y1 = _mm256_add_ps(  _mm256_sub_ps( y0, _mm256_andnot_ps( i1, one ) ), _mm256_set1_ps( G2 )  );
+	const __m256 x2 = _mm256_add_ps(  _mm256_sub_ps( x0, one ), _mm256_set1_ps( twoG2 )  );
+	const __m256 y2 = _mm256_add_ps(  _mm256_sub_ps( y0, one ), _mm256_set1_ps( twoG2 )  );
+
+	const __m256 n0 = cornerAvx2( hashAvx2( seed, i, j ), x0, y0 );
+	const __m256 n1 = cornerAvx2(  hashAvx2( seed, _mm256_sub_epi32( i, i1I ), _mm256_sub_epi32( j, j1I ) ), x1, y1  );
+	const __m256 n2 = cornerAvx2(  hashAvx2( seed, _mm256_add_epi32( i, oneI ), _mm256_add_epi32( j, oneI ) ), x2, y2  );
+	return _mm256_mul_ps(  _mm256_add_ps( _mm256_add_ps( n0, n1 ), n2 ), _mm256_set1_ps( scale2 )  );
+}
+
+TARGET_AVX2 static __m256 simplex3Avx2( const __m256i seed, const __m256 x, const __m256 y, const __m256 z ){
+	const __m256 one = _mm256_set1_ps( 1.0f );
+	const __m256i oneI = _mm256_set1_epi32( 1 );
+	const __m256 allSet = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+
+	const __m256 s = _mm256_mul_ps(  _mm256_add_ps( _mm256_add_ps( x, y ), z ), _mm256_set1_ps( F3 )  );
+	const __m256i i = _mm256_cvttps_epi32(  _mm256_floor_ps( _mm256_add_ps( x, s ) )  );
+	const __m256i j = _mm256_cvttps_epi32(  _mm256_floor_ps( _mm256_add_ps( y, s ) )  );
+	const __m256i k = _mm256_cvttps_epi32(  _mm256_floor_ps( _mm256_add_ps( z, s ) )  );
+	const __m256 t = _mm256_mul_ps(  _mm256_cvtepi32_ps( _mm256_add_epi32( _mm256_add_epi32( i, j ), k ) ), _mm256_set1_ps( G3 )  );
+	const __m256 x0 = _mm256_sub_ps(  x, _mm256_sub_ps( _mm256_cvtepi32_ps( i ), t )  );
+	const __m256 y0 = _mm256_sub_ps(  y, _mm256_sub_ps( _mm256_cvtepi32_ps( j ), t )  );
+	const __m256 z0 = _mm256_sub_ps(  z, _mm256_sub_ps( _mm256_cvtepi32_ps( k ), t )  );
+
+	const __m256 xy = _mm256_cmp_ps( x0, y0, _CMP_GE_OQ );
+	const __m256 xz = _mm256_cmp_ps( x0, z0, _CMP_GE_OQ );
+	const __m256 yz = _mm256_cmp_ps( y0, z0, _CMP_GE_OQ );
+	const __m256 i1 = _mm256_and_ps( xy, xz );
+	const __m256 j1 = _mm256_andnot_ps( xy, yz );
+	const __m256 k1 = _mm256_andnot_ps( _mm256_or_ps( xz, yz ), allSet );
+	const __m256 i2 = _mm256_or_ps( xy, xz );
+	const __m256 j2 = _mm256_or_ps( _mm256_andnot_ps( xy, allSet ), yz );
+	const __m256 k2 = _mm256_andnot_ps( _mm256_and_ps( xz, yz ), allSet );
+
+	const __m256 x1 = _mm256_add_ps(  _mm256_sub_ps( x0, _mm256_and_ps( i1, one ) ), _mm256_set1_ps( G3 )  );
+	const __m256 y1 = _mm256_add_ps(  _mm256_sub_ps( y0, _mm256_and_ps( j1, one ) ), _mm256_set1_ps( G3 )  );
+	const __m256 z1 = _mm256_add_ps(  _mm256_sub_ps( z0, _mm256_and_ps( k1, one ) ), _mm256_set1_ps( G3 )  );
+	const __m256 x2 = _mm256_add_ps(  _mm256_sub_ps( x0, _mm256_and_ps( i2, one ) ), _mm256_set1_ps( twoG3 )  );
+	const __m256 y2 = _mm256_add_ps(  _mm256_sub_ps( y0, _mm256_and_ps( j2, one ) ), _mm256_set1_ps( twoG3 )  );
+	const __m256 z2 = _mm256_add_ps(  _mm256_sub_ps( z0, _mm256_and_ps( k2, one ) ), _mm256_set1_ps( twoG3 )  );
+	const __m256 x3 = _mm256_add_ps(  _mm256_sub_ps( x0, one ), _mm256_set1_ps( threeG3 )  );
+	const __m256 y3 = _mm256_add_ps(  _mm256_sub_ps( y0, one ), _mm256_set1_ps( threeG3 )  );
+	const __m256 z3 = _mm256_add_ps(  _mm256_sub_ps( z0, one ), _mm256_set1_ps( threeG3 )  );
+
+	const __m256 n0 = cornerAvx2( hashAvx2( seed, i, j, k ), x0, y0, z0 );
+	const __m256 n1 = cornerAvx2(  hashAvx2( seed, stepAvx2( i, i1 ), stepAvx2( j, j1 ), stepAvx2( k, k1 ) ), x1, y1, z1  );
+	const __m256 n2 = cornerAvx2(  hashAvx2( seed, stepAvx2( i, i2 ), stepAvx2( j, j2 ), stepAvx2( k, k2 ) ), x2, y2, z2  );
+	const __m256 n3 = cornerAvx2(  hashAvx2( seed, _mm256_add_epi32( i, oneI ), _mm256_add_epi32( j, oneI ), _mm256_add_epi32( k, oneI ) ), x3, y3, z3  );
+	return _mm256_mul_ps(  _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( n0, n1 ), n2 ), n3 ), _mm256_set1_ps( scale3 )  );
+}
+
+// returns how many positions it did, a multiple of 8
+TARGET_AVX2 static size_t fractal2Avx2( const Octave* const octaves, const uint32_t octaveCount, const float* const x, const float* const y, const size_t count, float* const result ){
+	size_t n = 0;
+	for( ; n + 8 <= count; n += 8 ){
+		const __m256 px = _mm256_loadu_ps( x + n );
+		const __m256 py = _mm256_loadu_ps( y + n );
+		__m256 sum = _mm256_setzero_ps();
+		for( uint32_t o = 0; o < octaveCount; ++o ){
+			const __m256 frequency = _mm256_set1_ps( octaves[o].frequency );
+			const __m256 noise = simplex2Avx2(  _mm256_set1_epi32( int32_t( octaves[o].seed ) ), _mm256_mul_ps( px, frequency ), _mm256_mul_ps( py, frequency )  );
+			sum = _mm256_add_ps(  sum, _mm256_mul_ps( noise, _mm256_set1_ps( octaves[o].amplitude ) )  );
+		}
+		_mm256_storeu_ps( result + n, sum );
+	}
+	return n;
+}
+
+TARGET_AVX2 static size_t fractal3Avx2( const Octave* const octaves, const uint32_t octaveCount, const float* const x, const float* const y, const float* const z, const size_t count, float* const result ){
+	size_t n = 0;
+	for( ; n + 8 <= count; n += 8 ){
+		const __m256 px = _mm256_loadu_ps( x + n );
+		const __m256 py = _mm256_loadu_ps( y + n );
+		const __m256 pz = _mm256_loadu_ps( z + n );
+		__m256 sum = _mm256_setzero_ps();
+		for( uint32_t o = 0; o < octaveCount; ++o ){
+			const __m256 frequency = _mm256_set1_ps( octaves[o].frequency );
+			const __m256 noise = simplex3Avx2(  _mm256_set1_epi32( int32_t( octaves[o].seed ) ), _mm256_mul_ps( px, frequency ), _mm256_mul_ps( py, frequency ), _mm256_mul_ps( pz, frequency )  );
+			sum = _mm256_add_ps(  sum, _mm256_mul_ps( noise, _mm256_set1_ps( octaves[o].amplitude ) )  );
+		}
+		_mm256_storeu_ps( result + n, sum );
+	}
+	return n;
+}
+
+#endif // CPU_X86
+
+
+SimplexNoise::SimplexNoise( const uint32_t seed, const SimdLevel highest )
+: m_seed( seed ), m_simd( ::getSimdLevel( highest ) )
+{}
+
+void SimplexNoise::fractal2( const float* const x, const float* const y, const size_t count, const Fractal& fractal, float* const result ) const{
+	Octave octaves[maxOctaves];
+	const uint32_t octaveCount = getOctaves( m_seed, fractal, octaves );
+
+	size_t done = 0;
+#if CPU_X86
+	if( m_simd == SimdLevel::avx2 ) done = fractal2Avx2( octaves, octaveCount, x, y, count, result );
+	else if( m_simd == SimdLevel::sse41 ) done = fractal2Sse41( octaves, octaveCount, x, y, count, result );
+#endif
+	fractal2Scalar( octaves, octaveCount, x, y, done, count, result );
+}
+
+void SimplexNoise::fractal3( const float* const x, const float* const y, const float* const z, const size_t count, const Fractal& fractal, float* const result ) const{
+	Octave octaves[maxOctaves];
+	const uint32_t octaveCount = getOctaves( m_seed, fractal, octaves );
+
+	size_t done = 0;
+#if CPU_X86
+	if( m_simd == SimdLevel::avx2 ) done = fractal3Avx2( octaves, octaveCount, x, y, z, count, result );
+	else if( m_simd == SimdLevel::sse41 ) done = fractal3Sse41( octaves, octaveCount, x, y, z, count, result );
+#endif
+	fractal3Scalar( octaves, octaveCount, x, y, z, done, count, result );
+}
@@ -0,0 +1,46 @@
+// Seeded 2D/3D simplex gradient noise and fractal sums of it, evaluated in batches with AVX2, SSE4.1 or scalar code
+
+#ifndef COMMON_SIMPLEX_NOISE_H
+#define COMMON_SIMPLEX_NOISE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "CpuFeatures.h"
+
+
+// Gradients are picked by hashing the lattice point with the seed, so there are no permutation tables to gather from
+// and a vector lane costs the same as the scalar code. Every path does the same float operations in the same order,
+// so the result only depends on the seed and the position, bit for bit, whichever path runs and on however many threads
+// (on targets doing float math in SSE registers without fused multiply-add contraction, like the default x86-64 builds).
+// Batches run 8 positions at a time with AVX2 and 4 with SSE4.1; the rest of a batch takes the scalar path.
+// Positions must stay below 2^24 in magnitude after scaling by the frequencies, as the lattice is 32-bit.
+// Immutable once constructed, so it can be used from any number of threads.
+class SimplexNoise{
+public:
+	static constexpr uint32_t maxOctaves = 16;
+
+	// fractal Brownian motion: octave o samples at frequency * lacunarity^o with weight gain^o, each with a seed of its own;
+	// the sum is normalized back to about [-1, 1]. One octave of frequency 1 is the plain noise.
+	struct Fractal{
+		uint32_t octaves;
+		float frequency;
+		float lacunarity;
+		float gain;
+	};
+
+	explicit SimplexNoise( uint32_t seed, SimdLevel highest = SimdLevel::avx2 ); // the best path the CPU has, up to highest
+
+	uint32_t getSeed() const{ return m_seed; }
+	SimdLevel getSimdLevel() const{ return m_simd; }
+
+	// result[i] for the position ( x[i], y[i] ) or ( x[i], y[i], z[i] ); about [-1, 1]. result must not alias the inputs.
+	void fractal2( const float* x, const float* y, size_t count, const Fractal& fractal, float* result ) const;
+	void fractal3( const float* x, const float* y, const float* z, size_t count, const Fractal& fractal, float* result ) const;
+
+private:
+	uint32_t m_seed;
+	SimdLevel m_simd;
+};
+
+#endif //COMMON_SIMPLEX_NOISE_H
@@ -0,0 +1,97 @@
+// Deterministic synthetic terrains for benchmarks and for comparing mesher backends
+#include "TestTerrain.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Block.h"
+
+// Implementation
+//////////////////////////////////
+
+static uint32_t hash( int32_t x, int32_t y, int32_t z ){
+	uint32_t h = uint32_t( x ) * 0x8DA6B343u ^ uint32_t( y ) * 0xD8163841u ^ uint32_t( z ) * 0xCB1AB31Fu;
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 12;
+	return h;
+}
+
+// value noise in [0, 1] with a lattice every cellSize voxels
+static float valueNoise( const int32_t x, const int32_t y, const int32_t z, const int32_t cellSize ){
+	const auto floorDiv = [cellSize]( int32_t a ){ return a >= 0 ? a / cellSize : -((-a + cellSize - 1) / cellSize); };
+	const auto smooth = []( float t ){ return t * t * (3.0f - 2.0f * t); };
+	const auto lattice = []( int32_t x, int32_t y, int32_t z ){ return float( hash( x, y, z ) & 0xFFFF ) / 65535.0f; };
+
+	const int32_t cx = floorDiv( x ), cy = floorDiv( y ), cz = floorDiv( z );
+	const float tx = smooth(  float( x - cx * cellSize ) / cellSize  );
+	const float ty = smooth(  float( y - cy * cellSize ) / cellSize  );
+	const float tz = smooth(  float( z - cz * cellSize ) / cellSize  );
+
+	float result = 0.0f;
+	for( int32_t corner = 0; corner < 8; ++corner ){
+		const int32_t dx = corner & 1, dy = (corner >> 1) & 1, dz = corner >> 2;
+		const float weight = (dx ? tx : 1.0f - tx) * (dy ? ty : 1.0f - ty) * (dz ? tz : 1.0f - tz);
+		result += weight * lattice( cx + dx, cy + dy, cz + dz );
+	}
+	return result;
+}
+
+static BlockId generateBlock( const TestTerrain terrain, const int32_t x, const int32_t y, const int32_t z ){
+	switch( terrain ){
+		case TestTerrain::flat:
+			if( y < 12 ) return Block::stone;
+			if( y < 15 ) return Block::dirt;
+			if( y == 15 ) return Block::grass;
+			return Block::air;
+
+		case TestTerrain::hills:{
+			const int32_t height = static_cast<int32_t>(  24.0f + 10.0f * std::sin( x * 0.07f ) + 7.0f * std::cos( z * 0.05f + x * 0.02f )  );
+			if( y < height - 4 ) return Block::stone;
+			if( y < height ) return Block::dirt;
+			if( y == height ) return height < 18 ? Block::sand : height > 36 ? Block::snow : Block::grass;
+			if( y <= 16 ) return Block::water;
+			return Block::air;
+		}
+
+		case TestTerrain::caves:
+			if( y > 56 ) return Block::air;
+			if( valueNoise( x, y, z, 12 ) > 0.6f ) return Block::air;
+			if( y == 56 ) return Block::grass;
+			if( y > 52 ) return Block::dirt;
+			if( hash( x, y, z ) % 40 == 0 ) return Block::wood; // scattered ore-like specks break up the merging
+			return valueNoise( x + 1000, y, z, 6 ) > 0.7f ? Block::sand : Block::stone;
+
+		case TestTerrain::checkerboard:
+			return ((x + y + z) & 1) ? Block::stone : Block::air;
+	}
+
+	return Block::air;
+}
+
+const char* getTestTerrainName( const TestTerrain terrain ){
+	switch( terrain ){
+		case TestTerrain::flat: return "flat";
+		case TestTerrain::hills: return "hills";
+		case TestTerrain::caves: return "caves";
+		case TestTerrain::checkerboard: return "checkerboard";
+	}
+
+	return "unknown";
+}
+
+void generateTestTerrain( const TestTerrain terrain, const ChunkCoord coord, Chunk& chunk ){
+	std::vector<BlockId> blocks( Chunk::volume );
+
+	const int32_t n = static_cast<int32_t>( Chunk::size );
+	for( int32_t y = 0; y < n; ++y ){
+		for( int32_t z = 0; z < n; ++z ){
+			for( int32_t x = 0; x < n; ++x ){
+				blocks[Chunk::index( x, y, z )] = generateBlock( terrain, coord.x * n + x, coord.y * n + y, coord.z * n + z );
+			}
+		}
+	}
+
+	chunk.setSpan( 0, Chunk::volume, blocks.data() );
+}
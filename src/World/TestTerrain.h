@@ -0,0 +1,24 @@
+// Deterministic synthetic terrains for benchmarks and for comparing mesher backends
+
+#ifndef COMMON_TEST_TERRAIN_H
+#define COMMON_TEST_TERRAIN_H
+
+#include "Chunk.h"
+#include "VoxelWorld.h"
+
+
+enum class TestTerrain{
+	flat, // layered ground at a fixed height; the best case of merging
+	hills, // smooth heightmap with layers of different blocks
+	caves, // solid ground riddled with 3D noise caves and mixed ores
+	checkerboard // 3D checkerboard of stone and air; nothing can merge, the worst case
+};
+
+constexpr TestTerrain testTerrains[] = { TestTerrain::flat, TestTerrain::hills, TestTerrain::caves, TestTerrain::checkerboard };
+
+const char* getTestTerrainName( TestTerrain terrain ); // e.g. "flat"
+
+// the chunk at coord of the infinite terrain; only depends on the arguments
+void generateTestTerrain( TestTerrain terrain, ChunkCoord coord, Chunk& chunk );
+
+#endif //COMMON_TEST_TERRAIN_H
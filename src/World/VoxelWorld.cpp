@@ -0,0 +1,90 @@
+// The loaded part of the voxel world: chunks addressed by chunk coordinates, and blocks by world coordinates
+#include "VoxelWorld.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Implementation
+//////////////////////////////////
+
+Chunk* VoxelWorld::getChunk( const ChunkCoord coord ){
+	const auto it = m_chunks.find( coord );
+	return it == m_chunks.end() ? nullptr : it->second.get();
+}
+
+const Chunk* VoxelWorld::getChunk( const ChunkCoord coord ) const{
+	const auto it = m_chunks.find( coord );
+	return it == m_chunks.end() ? nullptr : it->second.get();
+}
+
+Chunk& VoxelWorld::getOrCreateChunk( const ChunkCoord coord ){
+	auto& chunk = m_chunks[coord];
+	if( !chunk ) chunk.reset( new Chunk( Block::air ) );
+	return *chunk;
+}
+
+void VoxelWorld::insertChunk( const ChunkCoord coord, std::unique_ptr<Chunk> chunk ){
+	if( !chunk ) throw "Inserting a null chunk into the voxel world!";
+	m_chunks[coord] = std::move( chunk );
+}
+
+bool VoxelWorld::removeChunk( const ChunkCoord coord ){
+	m_dirty.erase( coord );
+	return m_chunks.erase( coord ) != 0;
+}
+
+std::unique_ptr<Chunk> VoxelWorld::takeChunk( const ChunkCoord coord ){
+	m_dirty.erase( coord );
+	const auto it = m_chunks.find( coord );
+	if( it == m_chunks.end() ) return nullptr;
+
+	std::unique_ptr<Chunk> chunk = std::move( it->second );
+	m_chunks.erase( it );
+	return chunk;
+}
+
+BlockId VoxelWorld::getBlock( const int32_t x, const int32_t y, const int32_t z ) const{
+	const Chunk* chunk = getChunk(  toChunkCoord( x, y, z )  );
+	return chunk ? chunk->get(  toLocal( x ), toLocal( y ), toLocal( z )  ) : Block::air;
+}
+
+void VoxelWorld::setBlock( const int32_t x, const int32_t y, const int32_t z, const BlockId block ){
+	const ChunkCoord coord = toChunkCoord( x, y, z );
+	const uint32_t local[3] = { toLocal( x ), toLocal( y ), toLocal( z ) };
+
+	Chunk& chunk = getOrCreateChunk( coord );
+	if( chunk.get( local[0], local[1], local[2] ) == block ) return;
+	chunk.set( local[0], local[1], local[2], block );
+
+	const auto now = std::chrono::steady_clock::now();
+	markDirty( coord, now );
+
+	// the neighbor's faces toward this block appear or disappear
+	const int32_t c[3] = { coord.x, coord.y, coord.z };
+	for( uint32_t axis = 0; axis < 3; ++axis ){
+		if( local[axis] != 0 && local[axis] != Chunk::size - 1 ) continue;
+
+		int32_t neighbor[3] = { c[0], c[1], c[2] };
+		neighbor[axis] += local[axis] == 0 ? -1 : 1;
+		const ChunkCoord neighborCoord = { neighbor[0], neighbor[1], neighbor[2] };
+		if( getChunk( neighborCoord ) ) markDirty( neighborCoord, now );
+	}
+}
+
+void VoxelWorld::takeDirtyChunks( std::vector<DirtyChunk>& chunks ){
+	for( const auto& dirty : m_dirty ) chunks.push_back( {dirty.first, dirty.second} );
+	m_dirty.clear();
+}
+
+void VoxelWorld::markDirty( const ChunkCoord coord, const std::chrono::steady_clock::time_point now ){
+	m_dirty.emplace( coord, now ); // keeps the first edit's time if already dirty
+}
+
+size_t VoxelWorld::getMemoryUsage() const{
+	size_t bytes = 0;
+	for( const auto& chunk : m_chunks ) bytes += chunk.second->memoryUsage();
+	return bytes;
+}
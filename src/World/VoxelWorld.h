@@ -0,0 +1,78 @@
+// The loaded part of the voxel world: chunks addressed by chunk coordinates, and blocks by world coordinates
+
+#ifndef COMMON_VOXEL_WORLD_H
+#define COMMON_VOXEL_WORLD_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Block.h"
+#include "Chunk.h"
+
+
+struct ChunkCoord{
+	int32_t x, y, z;
+
+	bool operator==( const ChunkCoord& other ) const{ return x == other.x && y == other.y && z == other.z; }
+	bool operator!=( const ChunkCoord& other ) const{ return !(*this == other); }
+};
+
+struct ChunkCoordHash{
+	size_t operator()( const ChunkCoord& c ) const{
+		uint64_t h = uint64_t( uint32_t( c.x ) ) * 0x9E3779B97F4A7C15ull;
+		h ^= uint64_t( uint32_t( c.y ) ) * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+		h ^= uint64_t( uint32_t( c.z ) ) * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+		return static_cast<size_t>( h );
+	}
+};
+
+// a chunk whose mesh is out of date because of setBlock()
+struct DirtyChunk{
+	ChunkCoord coord;
+	std::chrono::steady_clock::time_point firstEdit; // the oldest edit not yet taken by takeDirtyChunks()
+};
+
+// Chunks are heap objects, so a Chunk* stays valid until that chunk is removed, however many others come and go.
+// setBlock() keeps track of the chunks it changed the look of, for whoever meshes them to take with takeDirtyChunks();
+// any number of edits between two takes make a chunk dirty once.
+// Not thread-safe.
+class VoxelWorld{
+public:
+	using ChunkMap = std::unordered_map< ChunkCoord, std::unique_ptr<Chunk>, ChunkCoordHash >;
+
+	// the chunk containing a block, and the block's coordinates inside it
+	static ChunkCoord toChunkCoord( int32_t x, int32_t y, int32_t z ){ return { x >> Chunk::sizeLog2, y >> Chunk::sizeLog2, z >> Chunk::sizeLog2 }; }
+	static uint32_t toLocal( int32_t c ){ return static_cast<uint32_t>( c ) & (Chunk::size - 1); }
+
+	Chunk* getChunk( ChunkCoord coord ); // nullptr if not loaded
+	const Chunk* getChunk( ChunkCoord coord ) const;
+	Chunk& getOrCreateChunk( ChunkCoord coord ); // a new chunk is all air
+	void insertChunk( ChunkCoord coord, std::unique_ptr<Chunk> chunk ); // replaces the loaded one, if any
+	bool removeChunk( ChunkCoord coord ); // also forgets that it was dirty
+	std::unique_ptr<Chunk> takeChunk( ChunkCoord coord ); // removes it, handing it over; nullptr if not loaded
+	void clear(){ m_chunks.clear(); m_dirty.clear(); }
+
+	BlockId getBlock( int32_t x, int32_t y, int32_t z ) const; // air where no chunk is loaded
+	// Loads an empty chunk there first if needed. Dirties the chunk if the block changes, and also the loaded neighbor
+	// across a chunk border the block touches, as the faces between them change.
+	void setBlock( int32_t x, int32_t y, int32_t z, BlockId block );
+
+	void takeDirtyChunks( std::vector<DirtyChunk>& chunks ); // appends them, in no particular order, and forgets them
+	size_t getDirtyChunkCount() const{ return m_dirty.size(); }
+
+	const ChunkMap& getChunks() const{ return m_chunks; }
+	size_t getChunkCount() const{ return m_chunks.size(); }
+	size_t getMemoryUsage() const; // bytes used by the voxels of all loaded chunks
+
+private:
+	void markDirty( ChunkCoord coord, std::chrono::steady_clock::time_point now );
+
+	ChunkMap m_chunks;
+	std::unordered_map< ChunkCoord, std::chrono::steady_clock::time_point, ChunkCoordHash > m_dirty; // to the first edit
+};
+
+#endif //COMMON_VOXEL_WORLD_H
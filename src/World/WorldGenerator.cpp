@@ -0,0 +1,99 @@
+// Procedural terrain of a seed: fractal noise hills and mountains, with caves carved by 3D noise
+#include "WorldGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Block.h"
+
+// Implementation
+//////////////////////////////////
+
+static const SimplexNoise::Fractal surfaceFractal = { 5, 1.0f / 256.0f, 2.0f, 0.5f };
+static const SimplexNoise::Fractal caveFractal = { 2, 1.0f / 48.0f, 2.0f, 0.5f };
+
+static constexpr float mountainStart = 0.3f; // surface noise above which mountains rise
+static constexpr float caveThreshold = 0.45f; // cave noise above which the ground is hollow
+static constexpr int32_t caveCover = 3; // voxels of ground left above caves
+static constexpr int32_t snowLine = 56;
+
+static int32_t getSurfaceHeight( const float noise ){
+	float height = WorldGenerator::baseHeight + WorldGenerator::hillHeight * noise;
+	if( noise > mountainStart ){
+		const float rise = (noise - mountainStart) / (1.0f - mountainStart);
+		height += WorldGenerator::mountainHeight * rise * rise;
+	}
+	return std::min(  static_cast<int32_t>( std::floor( height ) ), WorldGenerator::maxHeight  );
+}
+
+WorldGenerator::WorldGenerator( const uint32_t seed, const SimdLevel highest )
+: m_surface( seed, highest ), m_caves( seed ^ 0x5BD1E995u, highest )
+{}
+
+void WorldGenerator::generate( const ChunkCoord coord, Chunk& chunk ) const{
+	const int32_t n = static_cast<int32_t>( Chunk::size );
+	const int32_t x0 = coord.x * n, y0 = coord.y * n, z0 = coord.z * n;
+
+	if( y0 > maxHeight ){ // maxHeight is above seaLevel too
+		chunk.fill( Block::air );
+		return;
+	}
+
+	// the surface height of each column, index x + z * size
+	float columnX[Chunk::size * Chunk::size];
+	float columnZ[Chunk::size * Chunk::size];
+	float noise[Chunk::size * Chunk::size];
+	for( int32_t z = 0; z < n; ++z ){
+		for( int32_t x = 0; x < n; ++x ){
+			columnX[x + z * n] = static_cast<float>( x0 + x );
+			columnZ[x + z * n] = static_cast<float>( z0 + z );
+		}
+	}
+	m_surface.fractal2( columnX, columnZ, Chunk::size * Chunk::size, surfaceFractal, noise );
+
+	int32_t heights[Chunk::size * Chunk::size];
+	int32_t rowTops[Chunk::size]; // the highest surface of each row along x
+	for( int32_t z = 0; z < n; ++z ){
+		rowTops[z] = INT32_MIN;
+		for( int32_t x = 0; x < n; ++x ){
+			heights[x + z * n] = getSurfaceHeight( noise[x + z * n] );
+			rowTops[z] = std::max( rowTops[z], heights[x + z * n] );
+		}
+	}
+
+	float rowX[Chunk::size], rowY[Chunk::size], rowZ[Chunk::size], caves[Chunk::size];
+	for( int32_t x = 0; x < n; ++x ) rowX[x] = static_cast<float>( x0 + x );
+
+	std::vector<BlockId> blocks( Chunk::volume );
+	for( int32_t y = 0; y < n; ++y ){
+		const int32_t wy = y0 + y;
+		std::fill( rowY, rowY + n, static_cast<float>( wy ) );
+
+		for( int32_t z = 0; z < n; ++z ){
+			const int32_t* const rowHeights = heights + z * n;
+			const bool hasCaves = wy < rowTops[z] - caveCover;
+			if( hasCaves ){
+				std::fill(  rowZ, rowZ + n, static_cast<float>( z0 + z )  );
+				m_caves.fractal3( rowX, rowY, rowZ, Chunk::size, caveFractal, caves );
+			}
+
+			BlockId* const row = blocks.data() + Chunk::index( 0, y, z );
+			for( int32_t x = 0; x < n; ++x ){
+				const int32_t height = rowHeights[x];
+
+				BlockId block;
+				if( wy > height ) block = wy <= seaLevel ? Block::water : Block::air;
+				else if( wy == height ) block = height < seaLevel + 2 ? Block::sand : height > snowLine ? Block::snow : Block::grass;
+				else if( wy > height - 4 ) block = Block::dirt;
+				else block = Block::stone;
+
+				if( hasCaves && wy < height - caveCover && caves[x] > caveThreshold ) block = Block::air;
+				row[x] = block;
+			}
+		}
+	}
+
+	chunk.setSpan( 0, Chunk::volume, blocks.data() );
+}
@@ -0,0 +1,38 @@
+// Procedural terrain of a seed: fractal noise hills and mountains, with caves carved by 3D noise
+
+#ifndef COMMON_WORLD_GENERATOR_H
+#define COMMON_WORLD_GENERATOR_H
+
+#include <cstdint>
+
+#include "Chunk.h"
+#include "VoxelWorld.h"
+#include "SimplexNoise.h"
+#include "CpuFeatures.h"
+
+
+// A chunk only depends on the seed and its coordinate, whichever SIMD path the noise takes and whatever thread or order
+// the chunks are generated in (see SimplexNoise). The surface height comes from one batch of 2D noise per chunk; 3D noise
+// for the caves is only evaluated in the rows of voxels that have ground in them, and chunks entirely above the highest
+// possible surface skip the noise altogether. Immutable once constructed, so any number of threads can generate at once.
+class WorldGenerator{
+public:
+	static constexpr int32_t seaLevel = 16; // air at or below it is water
+	static constexpr int32_t baseHeight = 24; // of the surface, on average
+	static constexpr int32_t hillHeight = 20; // the surface varies by up to this around baseHeight
+	static constexpr int32_t mountainHeight = 40; // more on top of the highest hills
+	static constexpr int32_t maxHeight = baseHeight + hillHeight + mountainHeight;
+
+	explicit WorldGenerator( uint32_t seed, SimdLevel highest = SimdLevel::avx2 );
+
+	uint32_t getSeed() const{ return m_surface.getSeed(); }
+	SimdLevel getSimdLevel() const{ return m_surface.getSimdLevel(); }
+
+	void generate( ChunkCoord coord, Chunk& chunk ) const; // replaces all of chunk
+
+private:
+	SimplexNoise m_surface;
+	SimplexNoise m_caves;
+};
+
+#endif //COMMON_WORLD_GENERATOR_H
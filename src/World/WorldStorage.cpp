@@ -0,0 +1,267 @@
+// Saved chunks on disk: region files in a directory, each chunk stored as its palette + indices, LZ compressed
+#include "WorldStorage.h"
+
+#if defined(_WIN32)
+	#include <direct.h>
+#else
+	#include <sys/stat.h>
+	#include <sys/types.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "Block.h"
+#include "LzCodec.h"
+
+// Implementation
+//////////////////////////////////
+
+// [format][raw size, 4 bytes][lz stream of raw]; raw is [palette size, 2 bytes][palette][indices], all little-endian
+// (native, on every target so far) like the region file header
+static constexpr uint8_t chunkFormat = 1;
+static constexpr size_t linearSearchLimit = 16; // palettes bigger than this are looked up through a hash map
+
+static void makeDirectory( const std::string& directory ){ // one level; fine if it exists
+	if( directory.empty() ) return;
+#if defined(_WIN32)
+	_mkdir( directory.c_str() );
+#else
+	mkdir( directory.c_str(), 0755 );
+#endif
+}
+
+static bool fileExists( const std::string& path ){
+	FILE* const file = std::fopen( path.c_str(), "rb" );
+	if( !file ) return false;
+	std::fclose( file );
+	return true;
+}
+
+void encodeChunk( const Chunk& chunk, std::vector<uint8_t>& bytes ){
+	std::vector<BlockId> blocks( Chunk::volume );
+	chunk.getSpan( 0, Chunk::volume, blocks.data() );
+
+	std::vector<BlockId> palette;
+	std::vector<uint16_t> indices( Chunk::volume );
+	std::unordered_map<BlockId, uint16_t> lookup;
+	uint16_t last = 0; // runs of one block are the common case
+	for( uint32_t i = 0; i < Chunk::volume; ++i ){
+		const BlockId block = blocks[i];
+		if( !palette.empty() && palette[last] == block ){
+			indices[i] = last;
+			continue;
+		}
+
+		int32_t found = -1;
+		if( palette.size() <= linearSearchLimit ){
+			for( size_t p = 0; p < palette.size() && found < 0; ++p ) if( palette[p] == block ) found = int32_t( p );
+		}
+		else{
+			const auto it = lookup.find( block );
+			if( it != lookup.end() ) found = it->second;
+		}
+
+		if( found < 0 ){
+			found = int32_t( palette.size() );
+			palette.push_back( block );
+			if( palette.size() > linearSearchLimit ){
+				if( lookup.empty() ) for( size_t p = 0; p < palette.size(); ++p ) lookup[palette[p]] = uint16_t( p );
+				else lookup[block] = uint16_t( found );
+			}
+		}
+		last = uint16_t( found );
+		indices[i] = last;
+	}
+
+	const uint16_t paletteSize = static_cast<uint16_t>( palette.size() ); // a chunk has fewer distinct blocks than voxels
+	const size_t indexBytes = paletteSize == 1 ? 0 : paletteSize <= 256 ? 1 : 2;
+
+	std::vector<uint8_t> raw( sizeof( paletteSize ) + palette.size() * sizeof( BlockId ) + indexBytes * Chunk::volume );
+	uint8_t* out = raw.data();
+	std::memcpy( out, &paletteSize, sizeof( paletteSize ) );
+	out += sizeof( paletteSize );
+	std::memcpy( out, palette.data(), palette.size() * sizeof( BlockId ) );
+	out += palette.size() * sizeof( BlockId );
+	if( indexBytes == 1 ) for( uint32_t i = 0; i < Chunk::volume; ++i ) out[i] = static_cast<uint8_t>( indices[i] );
+	else if( indexBytes == 2 ) std::memcpy( out, indices.data(), indices.size() * sizeof( uint16_t ) );
+
+	const uint32_t rawSize = static_cast<uint32_t>( raw.size() );
+	bytes.clear();
+	bytes.reserve(  1 + sizeof( rawSize ) + lzMaxCompressedSize( raw.size() )  );
+	bytes.push_back( chunkFormat );
+	bytes.resize( 1 + sizeof( rawSize ) );
+	std::memcpy( bytes.data() + 1, &rawSize, sizeof( rawSize ) );
+	lzCompress( raw.data(), raw.size(), bytes );
+}
+
+bool decodeChunk( const uint8_t* const bytes, const size_t size, Chunk& chunk ){
+	uint32_t rawSize;
+	if( size < 1 + sizeof( rawSize ) || bytes[0] != chunkFormat ) return false;
+	std::memcpy( &rawSize, bytes + 1, sizeof( rawSize ) );
+	if( rawSize > sizeof( uint16_t ) + 2 * Chunk::volume * (sizeof( BlockId ) + sizeof( uint16_t )) ) return false;
+
+	std::vector<uint8_t> raw( rawSize );
+	if(  !lzDecompress( bytes + 1 + sizeof( rawSize ), size - 1 - sizeof( rawSize ), raw.data(), raw.size() )  ) return false;
+
+	uint16_t paletteSize;
+	if( raw.size() < sizeof( paletteSize ) ) return false;
+	std::memcpy( &paletteSize, raw.data(), sizeof( paletteSize ) );
+	const size_t indexBytes = paletteSize == 1 ? 0 : paletteSize <= 256 ? 1 : 2;
+	if( !paletteSize || raw.size() != sizeof( paletteSize ) + paletteSize * sizeof( BlockId ) + indexBytes * Chunk::volume ) return false;
+
+	std::vector<BlockId> palette( paletteSize );
+	std::memcpy( palette.data(), raw.data() + sizeof( paletteSize ), paletteSize * sizeof( BlockId ) );
+	if( paletteSize == 1 ){
+		chunk.fill( palette[0] );
+		return true;
+	}
+
+	const uint8_t* const in = raw.data() + sizeof( paletteSize ) + paletteSize * sizeof( BlockId );
+	std::vector<BlockId> blocks( Chunk::volume );
+	for( uint32_t i = 0; i < Chunk::volume; ++i ){
+		uint16_t index = in[i * indexBytes];
+		if( indexBytes == 2 ) std::memcpy( &index, in + 2 * i, sizeof( index ) );
+		if( index >= paletteSize ) return false;
+		blocks[i] = palette[index];
+	}
+	chunk.setSpan( 0, Chunk::volume, blocks.data() );
+	return true;
+}
+
+
+WorldStorage::WorldStorage( std::string directory )
+: m_directory( std::move( directory ) )
+{
+	makeDirectory( m_directory );
+}
+
+WorldStorage::~WorldStorage(){
+	try{
+		flush();
+	}
+	catch( ... ){} // the OS still writes back what it has; nothing better to do in a destructor
+}
+
+std::string WorldStorage::getRegionPath( const ChunkCoord regionCoord ) const{
+	const std::string name = "r." + std::to_string( regionCoord.x ) + "." + std::to_string( regionCoord.y ) + "." + std::to_string( regionCoord.z ) + ".region";
+	return m_directory.empty() ? name : m_directory + "/" + name;
+}
+
+uint32_t WorldStorage::getSlot( const ChunkCoord coord ){
+	const int32_t mask = RegionFile::size - 1;
+	return RegionFile::slotOf( uint32_t( coord.x & mask ), uint32_t( coord.y & mask ), uint32_t( coord.z & mask ) );
+}
+
+RegionFile& WorldStorage::getRegion( const ChunkCoord coord ){
+	const ChunkCoord regionCoord = toRegionCoord( coord );
+	std::unique_ptr<RegionFile>& region = m_regions[regionCoord];
+	if( !region ){
+		try{
+			region.reset(  new RegionFile( getRegionPath( regionCoord ) )  );
+		}
+		catch( ... ){
+			m_regions.erase( regionCoord );
+			throw;
+		}
+		m_missingRegions.erase( regionCoord );
+	}
+	return *region;
+}
+
+RegionFile* WorldStorage::findRegion( const ChunkCoord coord ){
+	const ChunkCoord regionCoord = toRegionCoord( coord );
+	const auto it = m_regions.find( regionCoord );
+	if( it != m_regions.end() ) return it->second.get();
+	if( m_missingRegions.count( regionCoord ) ) return nullptr;
+
+	// RegionFile would create it, leaving an empty file behind every probe of new terrain
+	if(  !fileExists( getRegionPath( regionCoord ) )  ){
+		m_missingRegions.insert( regionCoord );
+		return nullptr;
+	}
+	return &getRegion( coord );
+}
+
+bool WorldStorage::load( const ChunkCoord coord, Chunk& chunk ){
+	std::vector<uint8_t> bytes;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		RegionFile* const region = findRegion( coord );
+		if(  !region || !region->read( getSlot( coord ), bytes )  ) return false;
+		++m_statistics.loaded;
+	}
+
+	// only this chunk is lost; it is made again like one never saved, rather than stopping the streaming of the world
+	if(  !decodeChunk( bytes.data(), bytes.size(), chunk )  ){
+		std::cout << "WARNING: Dropping corrupt saved chunk " + std::to_string( coord.x ) + " " + std::to_string( coord.y ) + " " + std::to_string( coord.z ) + "\n" << std::flush;
+		std::lock_guard<std::mutex> lock( m_mutex );
+		++m_statistics.corrupt;
+		return false;
+	}
+	return true;
+}
+
+void WorldStorage::save( const ChunkCoord coord, const Chunk& chunk ){
+	std::vector<uint8_t> bytes;
+	encodeChunk( chunk, bytes );
+	saveEncoded( coord, bytes );
+}
+
+void WorldStorage::saveEncoded( const ChunkCoord coord, const std::vector<uint8_t>& bytes ){
+	uint32_t rawSize;
+	if( bytes.size() < 1 + sizeof( rawSize ) ) throw "Saving bytes that are not an encoded chunk!";
+	std::memcpy( &rawSize, bytes.data() + 1, sizeof( rawSize ) );
+
+	std::lock_guard<std::mutex> lock( m_mutex );
+	getRegion( coord ).write(  getSlot( coord ), bytes.data(), static_cast<uint32_t>( bytes.size() )  );
+	++m_statistics.saved;
+	m_statistics.rawBytes += rawSize;
+	m_statistics.storedBytes += bytes.size();
+}
+
+void WorldStorage::erase( const ChunkCoord coord ){
+	std::lock_guard<std::mutex> lock( m_mutex );
+	RegionFile* const region = findRegion( coord );
+	if( region ) region->erase( getSlot( coord ) );
+}
+
+bool WorldStorage::has( const ChunkCoord coord ){
+	std::lock_guard<std::mutex> lock( m_mutex );
+	RegionFile* const region = findRegion( coord );
+	return region && region->has( getSlot( coord ) );
+}
+
+void WorldStorage::flush(){
+	std::lock_guard<std::mutex> lock( m_mutex );
+	for( auto& region : m_regions ) region.second->flush();
+}
+
+void WorldStorage::compact( const double minFreeRatio ){
+	std::lock_guard<std::mutex> lock( m_mutex );
+	for( auto& region : m_regions ){
+		const uint32_t free = region.second->getFreeSectorCount();
+		if( free && free >= minFreeRatio * region.second->getSectorCount() ) region.second->compact();
+	}
+}
+
+WorldStorage::Statistics WorldStorage::getStatistics(){
+	std::lock_guard<std::mutex> lock( m_mutex );
+	Statistics statistics = m_statistics;
+	statistics.regions = static_cast<uint32_t>( m_regions.size() );
+	statistics.fileBytes = 0;
+	statistics.freeBytes = 0;
+	for( const auto& region : m_regions ){
+		statistics.fileBytes += uint64_t( region.second->getSectorCount() ) * RegionFile::sectorSize;
+		statistics.freeBytes += uint64_t( region.second->getFreeSectorCount() ) * RegionFile::sectorSize;
+	}
+	return statistics;
+}
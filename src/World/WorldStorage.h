@@ -0,0 +1,72 @@
+// Saved chunks on disk: region files in a directory, each chunk stored as its palette + indices, LZ compressed
+
+#ifndef COMMON_WORLD_STORAGE_H
+#define COMMON_WORLD_STORAGE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Chunk.h"
+#include "VoxelWorld.h"
+#include "RegionFile.h"
+
+
+// A region file holds RegionFile::size^3 chunks, named after the region's coordinates; they are opened on first use and
+// stay open. Only saves create them: loading a chunk of a region without a file finds nothing, and leaves no file behind. A chunk is saved as its distinct blocks followed by one palette index per voxel, 1 byte wide if it has
+// at most 256 blocks (else 2), and that is compressed with lzCompress(): terrain chunks take a KiB or two, uniform ones a few bytes.
+// Thread-safe: the region files are accessed under a lock, (de)compression runs outside of it.
+class WorldStorage{
+public:
+	struct Statistics{
+		uint64_t saved;
+		uint64_t loaded;
+		uint64_t corrupt; // loaded but not decodable, so treated as never saved
+		uint64_t rawBytes; // saved, before compression
+		uint64_t storedBytes; // saved, after compression
+		uint32_t regions; // open
+		uint64_t fileBytes; // of the open regions, in whole sectors
+		uint64_t freeBytes; // in gaps of the open regions, to be reclaimed by compact()
+	};
+
+	explicit WorldStorage( std::string directory ); // created if missing; "" means the working directory
+	~WorldStorage(); // flushes
+	WorldStorage( const WorldStorage& ) = delete;
+	WorldStorage& operator=( const WorldStorage& ) = delete;
+
+	bool load( ChunkCoord coord, Chunk& chunk ); // false, leaving chunk alone, if it was never saved or did not survive a crash
+	void save( ChunkCoord coord, const Chunk& chunk );
+	void saveEncoded( ChunkCoord coord, const std::vector<uint8_t>& bytes ); // as made by encodeChunk()
+	void erase( ChunkCoord coord );
+	bool has( ChunkCoord coord );
+
+	void flush(); // all saves so far are on the disk
+	// rewrites the open regions whose gaps make up at least minFreeRatio of the file
+	void compact( double minFreeRatio = 0.25 );
+
+	Statistics getStatistics();
+	std::string getRegionPath( ChunkCoord regionCoord ) const; // e.g. "world/r.0.-1.2.region"
+
+	static ChunkCoord toRegionCoord( ChunkCoord coord ){ return { coord.x >> RegionFile::sizeLog2, coord.y >> RegionFile::sizeLog2, coord.z >> RegionFile::sizeLog2 }; }
+
+private:
+	RegionFile& getRegion( ChunkCoord coord ); // of the chunk, created if it has no file; under m_mutex
+	RegionFile* findRegion( ChunkCoord coord ); // of the chunk, nullptr if it has no file; under m_mutex
+	static uint32_t getSlot( ChunkCoord coord );
+
+	std::string m_directory;
+	std::mutex m_mutex;
+	std::unordered_map< ChunkCoord, std::unique_ptr<RegionFile>, ChunkCoordHash > m_regions;
+	std::unordered_set<ChunkCoord, ChunkCoordHash> m_missingRegions; // found without a file; until a save creates it
+	Statistics m_statistics = {};
+};
+
+// a chunk as bytes and back; decodeChunk() returns false if the bytes are not a chunk, leaving chunk alone
+void encodeChunk( const Chunk& chunk, std::vector<uint8_t>& bytes ); // replaces bytes; compressed
+bool decodeChunk( const uint8_t* bytes, size_t size, Chunk& chunk );
+
+#endif //COMMON_WORLD_STORAGE_H
@@ -1,7 +1,8 @@
 #ifndef HELLO_TRIANGLE_WSI_PLATFORM_H
 #define HELLO_TRIANGLE_WSI_PLATFORM_H
 
-#if  !defined(USE_PLATFORM_GLFW) \
+#if  !defined(USE_PLATFORM_NONE) \
+  && !defined(USE_PLATFORM_GLFW) \
   && !defined(VK_USE_PLATFORM_ANDROID_KHR) \
   && !defined(VK_USE_PLATFORM_WAYLAND_KHR) \
   && !defined(VK_USE_PLATFORM_WIN32_KHR) \
@@ -13,7 +14,9 @@
 	#error "Exactly one Vulkan WSI platform must be defined."
 #endif
 
-#if defined(USE_PLATFORM_GLFW)
+#if defined(USE_PLATFORM_NONE)
+	#include "WSI/Headless.h"
+#elif defined(USE_PLATFORM_GLFW)
 	#include "WSI/Glfw.h"
 #elif defined(VK_USE_PLATFORM_WIN32_KHR)
 	#include "WSI/Win32.h"
@@ -27,7 +30,7 @@
 	#error "Unsupported Vulkan WSI platform, or none selected."
 #endif
 
-#ifndef VK_USE_PLATFORM_WAYLAND_KHR
+#if !defined(VK_USE_PLATFORM_WAYLAND_KHR) && !defined(USE_PLATFORM_NONE)
 // dummy impl for platforms that do not need these functions
 inline uint32_t getWindowWidth( PlatformWindow ){ return 0; }
 inline uint32_t getWindowHeight( PlatformWindow ){ return 0; }
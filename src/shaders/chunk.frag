@@ -0,0 +1,34 @@
+#version 450
+
+layout (location = 0) smooth in vec3 inNormal;
+layout (location = 1) smooth in vec2 inUv;
+layout (location = 2) smooth in float inAo;
+layout (location = 3) flat in uint inLayer;
+
+layout (location = 0) out vec4 outFragColor;
+
+// stand-in for a texture array: one color per layer, which is the BlockId (see World/Block.h)
+const vec3 layerColors[8] = vec3[](
+	vec3( 1.0, 0.0, 1.0 ), // air; never meshed
+	vec3( 0.5, 0.5, 0.5 ), // stone
+	vec3( 0.45, 0.3, 0.2 ), // dirt
+	vec3( 0.3, 0.6, 0.2 ), // grass
+	vec3( 0.85, 0.8, 0.55 ), // sand
+	vec3( 0.2, 0.35, 0.8 ), // water
+	vec3( 0.95, 0.95, 0.95 ), // snow
+	vec3( 0.5, 0.35, 0.15 ) // wood
+);
+
+const vec3 lightDirection = vec3( 0.32, 0.88, 0.36 ); // normalized
+
+void main(){
+	vec3 albedo = layerColors[min( inLayer, 7u )];
+
+	// a faint grid on the voxel boundaries, so merged faces still read as voxels
+	vec2 edge = min( fract( inUv ), 1.0 - fract( inUv ) );
+	float grid = mix( 0.85, 1.0, smoothstep( 0.0, 0.04, min( edge.x, edge.y ) ) );
+
+	float diffuse = 0.35 + 0.65 * max( dot( inNormal, lightDirection ), 0.0 );
+	float occlusion = mix( 0.5, 1.0, inAo );
+	outFragColor = vec4( albedo * diffuse * occlusion * grid, 1.0 );
+}
@@ -0,0 +1,51 @@
+#version 450
+
+// chunk.vert for IndirectChunkRenderer: the chunk origin comes from the chunk buffer, at the instance index of the draw
+
+// ChunkVertex; see Vertex.h for the bit layout
+layout (location = 0) in uvec2 inPacked;
+
+// ChunkDrawData; std430
+struct ChunkDrawData{
+	vec4 boundsMin;
+	vec4 boundsMax;
+	vec4 origin;
+	uint firstIndex;
+	int vertexOffset;
+	uint indexCount;
+	uint padding;
+};
+
+layout (std430, set = 0, binding = 0) readonly buffer Chunks{ ChunkDrawData chunks[]; };
+
+// ChunkIndirectPushConstants
+layout (push_constant) uniform ChunkIndirectPushConstants{
+	mat4 viewProjection;
+} pushConstants;
+
+layout (location = 0) smooth out vec3 outNormal;
+layout (location = 1) smooth out vec2 outUv;
+layout (location = 2) smooth out float outAo;
+layout (location = 3) flat out uint outLayer;
+
+const vec3 faceNormals[6] = vec3[](
+	vec3( 1.0, 0.0, 0.0 ), vec3( -1.0, 0.0, 0.0 ),
+	vec3( 0.0, 1.0, 0.0 ), vec3( 0.0, -1.0, 0.0 ),
+	vec3( 0.0, 0.0, 1.0 ), vec3( 0.0, 0.0, -1.0 )
+);
+
+void main(){
+	uint position = inPacked.x;
+	uint material = inPacked.y;
+
+	vec3 local = vec3( bitfieldExtract( position, 0, 6 ), bitfieldExtract( position, 6, 6 ), bitfieldExtract( position, 12, 6 ) );
+	uint face = bitfieldExtract( position, 18, 3 );
+	uint ao = bitfieldExtract( position, 21, 2 );
+
+	outNormal = faceNormals[face];
+	outUv = vec2( bitfieldExtract( material, 16, 6 ), bitfieldExtract( material, 22, 6 ) );
+	outAo = float( ao ) / 3.0;
+	outLayer = bitfieldExtract( material, 0, 16 );
+
+	gl_Position = pushConstants.viewProjection * vec4( chunks[gl_InstanceIndex].origin.xyz + local, 1.0 );
+}
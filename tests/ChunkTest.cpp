@@ -0,0 +1,151 @@
+// Chunk's palette and bit-packed indices must keep every voxel through widening to 1, 2, 4, 8 and 16 bits and back
+#include <cstdint>
+#include <vector>
+
+#include "World/Block.h"
+#include "World/Chunk.h"
+
+#include "TestCheck.h"
+
+// Implementation
+//////////////////////////////////
+
+// the width the palette comment in Chunk.h promises for a chunk of paletteSize distinct blocks
+static uint32_t expectedBits( const size_t paletteSize ){
+	if( paletteSize <= 1 ) return 0;
+	uint32_t bits = 1;
+	while( (size_t( 1 ) << bits) < paletteSize ) bits *= 2;
+	return bits;
+}
+
+// through get() and getSpan(), the whole chunk and a span that starts and ends inside a 64-bit word
+static bool matches( const Chunk& chunk, const std::vector<BlockId>& reference ){
+	for( uint32_t i = 0; i < Chunk::volume; ++i ) if( chunk.get( i ) != reference[i] ) return false;
+
+	std::vector<BlockId> blocks( Chunk::volume );
+	chunk.getSpan( 0, Chunk::volume, blocks.data() );
+	if( blocks != reference ) return false;
+
+	const uint32_t begin = 1001, count = 3333;
+	chunk.getSpan( begin, count, blocks.data() );
+	for( uint32_t k = 0; k < count; ++k ) if( blocks[k] != reference[begin + k] ) return false;
+	return true;
+}
+
+static uint32_t nextRandom( uint32_t& state ){
+	state = state * 1664525u + 1013904223u;
+	return state >> 8;
+}
+
+// one new block at a time: every step up in width re-encodes the indices written so far
+static void testGrowth(){
+	Chunk chunk;
+	std::vector<BlockId> reference( Chunk::volume, Block::air );
+	CHECK( chunk.isUniform() && chunk.bitsPerVoxel() == 0 );
+
+	uint32_t widths = 0;
+	uint32_t lastBits = 0;
+	for( uint32_t i = 0; i < 300; ++i ){
+		const uint32_t index = (i * 7919u) % Chunk::volume; // distinct for all i, as 7919 is odd
+		const BlockId block = BlockId( 100 + i );
+		chunk.set( index, block );
+		reference[index] = block;
+
+		CHECK(  chunk.paletteSize() == i + 2  );
+		CHECK(  chunk.bitsPerVoxel() == expectedBits( i + 2 )  );
+		if( chunk.bitsPerVoxel() != lastBits ){
+			lastBits = chunk.bitsPerVoxel();
+			++widths;
+			CHECK(  matches( chunk, reference )  );
+		}
+	}
+	CHECK( widths == 5 ); // 1, 2, 4, 8, 16
+	CHECK(  matches( chunk, reference )  );
+
+	// random writes of blocks already in the palette and new ones, at the widest width
+	uint32_t state = 1;
+	for( uint32_t n = 0; n < 20000; ++n ){
+		const uint32_t index = nextRandom( state ) % Chunk::volume;
+		const BlockId block = BlockId( nextRandom( state ) % 400 );
+		chunk.set( index, block );
+		reference[index] = block;
+	}
+	CHECK(  matches( chunk, reference )  );
+}
+
+// freed entries are reused without narrowing; compact() narrows, and the narrower chunk still takes writes
+static void testShrink(){
+	std::vector<BlockId> reference( Chunk::volume );
+	for( uint32_t i = 0; i < Chunk::volume; ++i ) reference[i] = BlockId( i % 300 );
+	Chunk chunk;
+	chunk.setSpan( 0, Chunk::volume, reference.data() );
+	CHECK( chunk.paletteSize() == 300 && chunk.bitsPerVoxel() == 16 );
+	CHECK(  matches( chunk, reference )  );
+
+	// down to 3 blocks by set(), which keeps the width
+	for( uint32_t i = 0; i < Chunk::volume; ++i ){
+		const BlockId block = BlockId( i % 7 == 0 ? Block::stone : i % 7 == 1 ? Block::dirt : Block::air );
+		chunk.set( i, block );
+		reference[i] = block;
+	}
+	CHECK( chunk.paletteSize() == 3 && chunk.bitsPerVoxel() == 16 );
+	CHECK(  matches( chunk, reference )  );
+	const size_t wideUsage = chunk.memoryUsage();
+
+	chunk.compact();
+	CHECK( chunk.paletteSize() == 3 && chunk.bitsPerVoxel() == 2 );
+	CHECK( chunk.memoryUsage() < wideUsage );
+	CHECK(  matches( chunk, reference )  );
+
+	// writes after narrowing, growing it again: 2 bits hold 4 blocks, the fifth needs 4
+	const uint32_t indices[] = { 5, 64, 65, 4095, Chunk::volume - 1 };
+	const BlockId blocks[] = { Block::sand, Block::water, Block::snow, Block::sand, Block::air };
+	for( size_t k = 0; k < 5; ++k ){
+		chunk.set( indices[k], blocks[k] );
+		reference[indices[k]] = blocks[k];
+	}
+	CHECK( chunk.paletteSize() == 6 && chunk.bitsPerVoxel() == 4 );
+	CHECK(  matches( chunk, reference )  );
+
+	// down to 2 blocks: 1 bit
+	for( uint32_t i = 0; i < Chunk::volume; ++i ){
+		if( reference[i] == Block::air ) continue;
+		chunk.set( i, Block::stone );
+		reference[i] = Block::stone;
+	}
+	chunk.compact();
+	CHECK( chunk.paletteSize() == 2 && chunk.bitsPerVoxel() == 1 );
+	CHECK(  matches( chunk, reference )  );
+
+	// the last other voxel overwritten: uniform again
+	for( uint32_t i = 0; i < Chunk::volume; ++i ){
+		if( reference[i] != Block::air ) chunk.set( i, Block::air );
+	}
+	CHECK( chunk.isUniform() && chunk.isEmpty() && chunk.bitsPerVoxel() == 0 );
+	CHECK( chunk.paletteSize() == 1 );
+}
+
+// a span inside the chunk goes through set(), widening on the way
+static void testPartialSpan(){
+	Chunk chunk( Block::stone );
+	std::vector<BlockId> reference( Chunk::volume, Block::stone );
+
+	const uint32_t begin = 777, count = 5000;
+	std::vector<BlockId> blocks( count );
+	for( uint32_t k = 0; k < count; ++k ) blocks[k] = BlockId( k / 250 ); // 20 blocks, air among them
+	chunk.setSpan( begin, count, blocks.data() );
+	for( uint32_t k = 0; k < count; ++k ) reference[begin + k] = blocks[k];
+
+	CHECK( chunk.paletteSize() == 20 && chunk.bitsPerVoxel() == 8 );
+	CHECK(  matches( chunk, reference )  );
+
+	chunk.fill( Block::grass );
+	CHECK( chunk.isUniform() && chunk.uniformBlock() == Block::grass && chunk.get( 123 ) == Block::grass );
+}
+
+int main(){
+	testGrowth();
+	testShrink();
+	testPartialSpan();
+	return testResult();
+}
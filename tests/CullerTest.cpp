@@ -0,0 +1,136 @@
+// ChunkCuller's node hierarchy and AVX2 path must keep exactly the chunks a flat scalar loop over all boxes keeps
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "Camera.h"
+#include "World/Chunk.h"
+#include "World/ChunkCuller.h"
+#include "World/VoxelWorld.h"
+
+#include "TestCheck.h"
+
+// Implementation
+//////////////////////////////////
+
+struct TestBox{
+	ChunkCoord coord;
+	float min[3], max[3];
+};
+
+// every box on its own, with the float operations of ChunkCuller's scalar path
+static std::vector<uint32_t> cullEachBox( const std::unordered_map<uint32_t, TestBox>& boxes, const float planes[6][4] ){
+	std::vector<uint32_t> visible;
+	for( const auto& entry : boxes ){
+		const TestBox& box = entry.second;
+		float center[3], extent[3];
+		for( int axis = 0; axis < 3; ++axis ){
+			center[axis] = (box.min[axis] + box.max[axis]) * 0.5f;
+			extent[axis] = (box.max[axis] - box.min[axis]) * 0.5f;
+		}
+
+		bool outside = false;
+		for( int p = 0; p < 6; ++p ){
+			const float* const plane = planes[p];
+			const float distance = center[0] * plane[0] + center[1] * plane[1] + center[2] * plane[2] + plane[3];
+			const float radius = extent[0] * std::fabs( plane[0] ) + extent[1] * std::fabs( plane[1] ) + extent[2] * std::fabs( plane[2] );
+			if( distance + radius < 0.0f ) outside = true;
+		}
+		if( !outside ) visible.push_back( entry.first );
+	}
+	std::sort( visible.begin(), visible.end() );
+	return visible;
+}
+
+int main(){
+	ChunkCuller scalar( false );
+	ChunkCuller avx2;
+	std::cout << "culler AVX2 path: " << (avx2.usesAvx2() ? "tested" : "not supported by this CPU") << std::endl;
+
+	// chunks around the origin, boxes of meshes that fill part of their chunk, in nodes on both sides of 0
+	std::unordered_map<uint32_t, TestBox> boxes;
+	uint32_t state = 12345;
+	const auto random = [&state]( const uint32_t range ){
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) % range;
+	};
+	const int32_t distance = 9;
+	const float size = float( Chunk::size );
+	uint32_t id = 0;
+	for( int32_t y = -2; y < 3; ++y ){
+		for( int32_t z = -distance; z <= distance; ++z ){
+			for( int32_t x = -distance; x <= distance; ++x ){
+				TestBox box = { {x, y, z}, {}, {} };
+				const int32_t origin[3] = { x, y, z };
+				for( int axis = 0; axis < 3; ++axis ){
+					const uint32_t low = random( Chunk::size / 2 );
+					box.min[axis] = origin[axis] * size + float( low );
+					box.max[axis] = box.min[axis] + float(  1 + random( Chunk::size - low )  );
+				}
+				boxes[id] = box;
+				scalar.insert( box.coord, id, box.min, box.max );
+				avx2.insert( box.coord, id, box.min, box.max );
+				++id;
+			}
+		}
+	}
+
+	// removing chunks, a whole node of them too, and replacing some, moves boxes around inside the culler
+	for( auto it = boxes.begin(); it != boxes.end(); ){
+		const ChunkCoord coord = it->second.coord;
+		const bool wholeNode = coord.x >= 4 && coord.x < 8 && coord.y >= 0 && coord.y < 3 && coord.z >= -4 && coord.z < 0;
+		if( wholeNode || random( 7 ) == 0 ){
+			scalar.remove( coord );
+			avx2.remove( coord );
+			it = boxes.erase( it );
+		}
+		else ++it;
+	}
+	for( auto& entry : boxes ){
+		if( random( 5 ) ) continue;
+		TestBox& box = entry.second;
+		box.max[1] = box.min[1] + 1.0f;
+		scalar.insert( box.coord, entry.first, box.min, box.max );
+		avx2.insert( box.coord, entry.first, box.min, box.max );
+	}
+	CHECK( scalar.size() == boxes.size() && avx2.size() == boxes.size() );
+
+	// a camera looking every way from inside the chunks and from above them
+	float projection[16];
+	makeReversedZPerspective( 1.2f, 16.0f / 9.0f, 0.1f, 0.0f, projection );
+	const float positions[][3] = { {0.5f, 8.0f, 0.5f}, {-70.0f, 120.0f, 33.0f}, {200.0f, 0.0f, -3.0f} };
+	std::vector<uint32_t> visible, reference;
+	uint64_t visibleCount = 0;
+	for( const auto& position : positions ){
+		for( int step = 0; step < 48; ++step ){
+			const float angle = float( step ) * 0.37f;
+			const float direction[3] = { std::cos( angle ), std::sin( angle * 0.7f ) * 0.8f, std::sin( angle ) };
+			float view[16], viewProjection[16], planes[6][4];
+			makeViewMatrix( position, direction, view );
+			multiplyMatrices( projection, view, viewProjection );
+			extractFrustumPlanes( viewProjection, planes );
+
+			scalar.cull( planes, visible );
+			avx2.cull( planes, reference );
+			CHECK( visible == reference ); // the same order too
+
+			std::sort( visible.begin(), visible.end() );
+			CHECK(  visible == cullEachBox( boxes, planes )  );
+			visibleCount += visible.size();
+		}
+	}
+	CHECK( visibleCount > 0 ); // not trivially passing
+
+	// everything is inside these planes, but nothing is left to see
+	const float everywhere[6][4] = { {0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 1.0f} };
+	avx2.cull( everywhere, visible );
+	CHECK( visible.size() == boxes.size() );
+	scalar.clear();
+	scalar.cull( everywhere, visible );
+	CHECK( visible.empty() );
+
+	return testResult();
+}
@@ -0,0 +1,87 @@
+// The SIMD paths of the noise and of the world generator must give the scalar results, bit for bit
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "CpuFeatures.h"
+#include "World/Block.h"
+#include "World/Chunk.h"
+#include "World/SimplexNoise.h"
+#include "World/VoxelWorld.h"
+#include "World/WorldGenerator.h"
+
+#include "TestCheck.h"
+
+// Implementation
+//////////////////////////////////
+
+static const uint32_t seed = 1337;
+static const SimdLevel simdLevels[] = { SimdLevel::sse41, SimdLevel::avx2 };
+
+// batches of odd sizes, so the SIMD paths also hand a remainder to the scalar one
+static void checkNoise( const SimdLevel level ){
+	const SimplexNoise reference( seed, SimdLevel::scalar );
+	const SimplexNoise noise( seed, level );
+	const SimplexNoise::Fractal fractal = { 4, 0.01f, 2.0f, 0.5f };
+
+	const size_t count = 1003;
+	std::vector<float> x( count ), y( count ), z( count ), expected( count ), result( count );
+	for( size_t i = 0; i < count; ++i ){
+		x[i] = float( i ) * 1.37f - 500.0f;
+		y[i] = float( i % 37 ) * -2.9f;
+		z[i] = float( i * i % 1009 ) * 0.61f;
+	}
+
+	reference.fractal2( x.data(), y.data(), count, fractal, expected.data() );
+	noise.fractal2( x.data(), y.data(), count, fractal, result.data() );
+	CHECK(  std::memcmp( expected.data(), result.data(), count * sizeof( float ) ) == 0  );
+
+	reference.fractal3( x.data(), y.data(), z.data(), count, fractal, expected.data() );
+	noise.fractal3( x.data(), y.data(), z.data(), count, fractal, result.data() );
+	CHECK(  std::memcmp( expected.data(), result.data(), count * sizeof( float ) ) == 0  );
+}
+
+int main(){
+	// from caves deep down up to the mountain tops, on both sides of the origin
+	std::vector<ChunkCoord> coords;
+	const int32_t top = WorldGenerator::maxHeight / int32_t( Chunk::size );
+	for( int32_t y = -2; y <= top; ++y ){
+		for( const int32_t xz : {-3, 0, 2} ) coords.push_back( {xz, y, -xz} );
+	}
+
+	const WorldGenerator reference( seed, SimdLevel::scalar );
+	std::vector<BlockId> expected( Chunk::volume ), blocks( Chunk::volume );
+	Chunk chunk;
+
+	// the same chunk twice is the same chunk too
+	for( const ChunkCoord coord : coords ){
+		reference.generate( coord, chunk );
+		chunk.getSpan( 0, Chunk::volume, expected.data() );
+		reference.generate( coord, chunk );
+		chunk.getSpan( 0, Chunk::volume, blocks.data() );
+		CHECK( blocks == expected );
+	}
+
+	for( const SimdLevel level : simdLevels ){
+		if( getSimdLevel( level ) != level ){
+			std::cout << getSimdLevelName( level ) << ": not supported by this CPU" << std::endl;
+			continue;
+		}
+		std::cout << getSimdLevelName( level ) << ": tested" << std::endl;
+
+		checkNoise( level );
+
+		const WorldGenerator generator( seed, level );
+		CHECK( generator.getSimdLevel() == level );
+		for( const ChunkCoord coord : coords ){
+			reference.generate( coord, chunk );
+			chunk.getSpan( 0, Chunk::volume, expected.data() );
+			generator.generate( coord, chunk );
+			chunk.getSpan( 0, Chunk::volume, blocks.data() );
+			CHECK( blocks == expected );
+		}
+	}
+
+	return testResult();
+}
@@ -0,0 +1,146 @@
+// WorkStealingDeque hands every item out exactly once under concurrent stealing; JobSystem counters wait for all their jobs
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+#include "WorkStealingDeque.h"
+
+#include "TestCheck.h"
+
+// Implementation
+//////////////////////////////////
+
+// the owner pushes in bursts and pops some back, thieves steal all along; the ring starts tiny, so it grows meanwhile
+static void testDeque(){
+	const uint32_t itemCount = 200000;
+	const uint32_t thiefCount = 3;
+
+	std::vector<uint32_t> items( itemCount );
+	for( uint32_t i = 0; i < itemCount; ++i ) items[i] = i;
+	std::vector< std::atomic<uint32_t> > taken( itemCount );
+	for( auto& count : taken ) count.store( 0, std::memory_order_relaxed );
+	const auto take = [&]( const uint32_t* const item ){ taken[*item].fetch_add( 1, std::memory_order_relaxed ); };
+
+	WorkStealingDeque<uint32_t> deque( 4 );
+	std::atomic<bool> done{ false };
+	std::vector<uint64_t> stolen( thiefCount, 0 );
+	std::vector<std::thread> thieves;
+	for( uint32_t t = 0; t < thiefCount; ++t ){
+		thieves.emplace_back( [&, t]{
+			for( ;; ){
+				const bool last = done.load( std::memory_order_acquire ); // checked before the steal, so none is missed
+				if( uint32_t* const item = deque.steal() ){
+					take( item );
+					++stolen[t];
+				}
+				else if( last ) return;
+			}
+		} );
+	}
+
+	uint64_t popped = 0;
+	for( uint32_t i = 0; i < itemCount; ++i ){
+		deque.push( &items[i] );
+		if( i % 3 == 2 ){
+			if( uint32_t* const item = deque.pop() ){
+				take( item );
+				++popped;
+			}
+		}
+	}
+	while( uint32_t* const item = deque.pop() ){
+		take( item );
+		++popped;
+	}
+	done.store( true, std::memory_order_release );
+	for( std::thread& thief : thieves ) thief.join();
+
+	uint32_t lost = 0, duplicated = 0;
+	for( const auto& count : taken ){
+		const uint32_t times = count.load( std::memory_order_relaxed );
+		if( times == 0 ) ++lost;
+		else if( times > 1 ) ++duplicated;
+	}
+	CHECK( lost == 0 );
+	CHECK( duplicated == 0 );
+	uint64_t total = popped;
+	for( const uint64_t count : stolen ) total += count;
+	CHECK( total == itemCount );
+	CHECK( deque.pop() == nullptr && deque.steal() == nullptr );
+}
+
+static void testJobSystem( const uint32_t threadCount, const bool mainThreadParticipates ){
+	JobSystem jobs( threadCount, mainThreadParticipates );
+
+	// nested jobs: each pushes more to the deque of the thread running it, which others steal
+	const uint32_t jobCount = 2000;
+	std::atomic<uint32_t> ran{ 0 };
+	JobCounter counter;
+	for( uint32_t i = 0; i < jobCount / 4; ++i ){
+		jobs.run( [&]{
+			for( int j = 0; j < 3; ++j ) jobs.run( [&]{ ran.fetch_add( 1, std::memory_order_relaxed ); }, &counter );
+			ran.fetch_add( 1, std::memory_order_relaxed );
+		}, &counter );
+	}
+	jobs.wait( counter );
+	CHECK( counter.isDone() );
+	CHECK( ran.load() == jobCount );
+
+	// the counter is reusable; waiting for one whose jobs are all done already returns at once
+	if( !mainThreadParticipates ){
+		for( uint32_t i = 0; i < jobCount; ++i ) jobs.run( [&]{ ran.fetch_add( 1, std::memory_order_relaxed ); }, &counter );
+		while( !counter.isDone() ) std::this_thread::yield();
+		jobs.wait( counter );
+		CHECK( ran.load() == 2 * jobCount );
+	}
+
+	// a continuation sees all of its dependency's work
+	std::atomic<uint32_t> before{ 0 };
+	uint32_t seen = 0;
+	JobCounter dependency, after;
+	for( uint32_t i = 0; i < 100; ++i ) jobs.run( [&]{ before.fetch_add( 1, std::memory_order_relaxed ); }, &dependency );
+	jobs.runAfter( dependency, [&]{ seen = before.load( std::memory_order_relaxed ); }, &after );
+	jobs.wait( after );
+	jobs.wait( dependency );
+	CHECK( seen == 100 );
+
+	// wait() rethrows, once the other jobs of the counter are done too
+	std::atomic<uint32_t> others{ 0 };
+	for( uint32_t i = 0; i < 50; ++i ){
+		jobs.run( [&, i]{
+			if( i == 25 ) throw std::runtime_error( "job failed" );
+			others.fetch_add( 1, std::memory_order_relaxed );
+		}, &counter );
+	}
+	bool threw = false;
+	try{
+		jobs.wait( counter );
+	}
+	catch( const std::runtime_error& ){
+		threw = true;
+	}
+	CHECK( threw );
+	CHECK( others.load() == 49 );
+
+	// every index once
+	std::vector< std::atomic<uint32_t> > visits( 10000 );
+	for( auto& count : visits ) count.store( 0, std::memory_order_relaxed );
+	jobs.parallelFor( 0, visits.size(), 7, [&]( const size_t begin, const size_t end ){
+		for( size_t i = begin; i < end; ++i ) visits[i].fetch_add( 1, std::memory_order_relaxed );
+	} );
+	bool once = true;
+	for( const auto& count : visits ) once = once && count.load() == 1;
+	CHECK( once );
+}
+
+int main(){
+	testDeque();
+	testJobSystem( 4, true );
+	testJobSystem( 4, false );
+	testJobSystem( 1, true ); // no workers: the jobs run while the main thread waits
+	return testResult();
+}
@@ -0,0 +1,75 @@
+// The binary mesher, scalar and AVX2, must produce the very quads of the greedy mesher
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "World/BinaryMesher.h"
+#include "World/Block.h"
+#include "World/Chunk.h"
+#include "World/ChunkMesh.h"
+#include "World/GreedyMesher.h"
+#include "World/TestTerrain.h"
+#include "World/VoxelWorld.h"
+
+#include "TestCheck.h"
+
+// Implementation
+//////////////////////////////////
+
+static void checkSameMeshes( const ChunkNeighborhood& chunks, GreedyMesher& greedy, BinaryMesher& binary, BinaryMesher& binaryAvx2 ){
+	ChunkMesh reference, mesh;
+	greedy.mesh( chunks, reference );
+	for( BinaryMesher* mesher : {&binary, &binaryAvx2} ){
+		mesher->mesh( chunks, mesh );
+		CHECK( mesh.quads == reference.quads );
+		CHECK( mesh.faceCount == reference.faceCount );
+		CHECK( mesh.vertices.size() == reference.vertices.size() );
+	}
+}
+
+int main(){
+	GreedyMesher greedy;
+	BinaryMesher binary( false );
+	BinaryMesher binaryAvx2;
+	std::cout << "binary mesher AVX2 path: " << (binaryAvx2.usesAvx2() ? "tested" : "not supported by this CPU") << std::endl;
+
+	// every chunk of a small world of each terrain, with the chunks around it loaded
+	const int32_t worldWidth = 3;
+	for( const TestTerrain terrain : testTerrains ){
+		VoxelWorld world;
+		for( int32_t y = -1; y <= 2; ++y ){
+			for( int32_t z = -1; z <= worldWidth; ++z ){
+				for( int32_t x = -1; x <= worldWidth; ++x ){
+					std::unique_ptr<Chunk> chunk( new Chunk );
+					generateTestTerrain( terrain, {x, y, z}, *chunk );
+					world.insertChunk( {x, y, z}, std::move( chunk ) );
+				}
+			}
+		}
+
+		const int failures = testFailures();
+		for( int32_t y = 0; y < 2; ++y ){
+			for( int32_t z = 0; z < worldWidth; ++z ){
+				for( int32_t x = 0; x < worldWidth; ++x ) checkSameMeshes( getNeighborhood( world, {x, y, z} ), greedy, binary, binaryAvx2 );
+			}
+		}
+		if( testFailures() != failures ) std::cout << "on " << getTestTerrainName( terrain ) << " terrain" << std::endl;
+	}
+
+	// the edge cases: nothing at all, a lone solid chunk with no neighbors loaded, and voxel noise
+	Chunk empty, solid( Block::stone ), noise;
+	std::vector<BlockId> blocks( Chunk::volume );
+	for( uint32_t i = 0; i < Chunk::volume; ++i ) blocks[i] = BlockId(  (i * 2654435761u >> 13) % 3  );
+	noise.setSpan( 0, Chunk::volume, blocks.data() );
+	for( const Chunk* chunk : {&empty, &solid, &noise} ){
+		ChunkNeighborhood chunks = {};
+		chunks.center = chunk;
+		checkSameMeshes( chunks, greedy, binary, binaryAvx2 );
+
+		for( const Chunk*& neighbor : chunks.neighbors ) neighbor = &solid;
+		checkSameMeshes( chunks, greedy, binary, binaryAvx2 );
+	}
+
+	return testResult();
+}
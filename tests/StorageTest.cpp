@@ -0,0 +1,276 @@
+// Saved chunks: LZ and chunk codec round trips and malformed input, region files across reopening and compaction, atomic files
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "AtomicFile.h"
+#include "World/Block.h"
+#include "World/Chunk.h"
+#include "World/LzCodec.h"
+#include "World/RegionFile.h"
+#include "World/TestTerrain.h"
+#include "World/VoxelWorld.h"
+#include "World/WorldStorage.h"
+
+#include "TestCheck.h"
+
+// Implementation
+//////////////////////////////////
+
+static std::vector<uint8_t> makeBytes( const size_t size, const uint32_t seed, const uint32_t alphabet ){
+	std::vector<uint8_t> bytes( size );
+	uint32_t state = seed;
+	for( uint8_t& byte : bytes ){
+		state = state * 1664525u + 1013904223u;
+		byte = static_cast<uint8_t>( (state >> 24) % alphabet );
+	}
+	return bytes;
+}
+
+static std::vector<BlockId> getBlocks( const Chunk& chunk ){
+	std::vector<BlockId> blocks( Chunk::volume );
+	chunk.getSpan( 0, Chunk::volume, blocks.data() );
+	return blocks;
+}
+
+static void flipByte( const std::string& path, const long offsetFromEnd ){
+	FILE* const file = std::fopen( path.c_str(), "r+b" );
+	if(  !CHECK( file != nullptr )  ) return;
+	std::fseek( file, -offsetFromEnd, SEEK_END );
+	const int byte = std::fgetc( file );
+	std::fseek( file, -offsetFromEnd, SEEK_END );
+	std::fputc( byte ^ 0x5A, file );
+	std::fclose( file );
+}
+
+static bool fileExists( const std::string& path ){
+	FILE* const file = std::fopen( path.c_str(), "rb" );
+	if( !file ) return false;
+	std::fclose( file );
+	return true;
+}
+
+static void testLz(){
+	std::vector<std::vector<uint8_t>> inputs = {
+		{}, {7}, {1, 2, 3}, std::vector<uint8_t>( 5000, 42 ), // empty, shorter than a match, one long run
+		makeBytes( 3000, 1, 256 ), // incompressible
+		makeBytes( 100000, 2, 4 ) // matches everywhere, over more than the 64 KiB window
+	};
+	std::vector<uint8_t> text;
+	for( int i = 0; i < 300; ++i ) text.insert(  text.end(), {'v', 'o', 'x', 'e', 'l', uint8_t( '0' + i % 10 )}  );
+	inputs.push_back( text );
+
+	for( const std::vector<uint8_t>& input : inputs ){
+		std::vector<uint8_t> compressed = { 0xAB }; // lzCompress() appends
+		lzCompress( input.data(), input.size(), compressed );
+		CHECK( compressed[0] == 0xAB );
+		compressed.erase( compressed.begin() );
+		CHECK(  compressed.size() <= lzMaxCompressedSize( input.size() )  );
+
+		std::vector<uint8_t> output( input.size() + 1 );
+		CHECK(  lzDecompress( compressed.data(), compressed.size(), output.data(), input.size() )  );
+		CHECK(  std::equal( input.begin(), input.end(), output.begin() )  );
+
+		// the wrong size fails; a truncation too, unless all it cut off is the empty last sequence; damage anywhere
+		// stays in bounds
+		CHECK(  !lzDecompress( compressed.data(), compressed.size(), output.data(), input.size() + 1 )  );
+		if( !input.empty() ) CHECK(  !lzDecompress( compressed.data(), compressed.size(), output.data(), input.size() - 1 )  );
+		for( size_t size = 0; size < compressed.size(); size += 1 + size / 64 ){
+			if(  lzDecompress( compressed.data(), size, output.data(), input.size() )  ){
+				CHECK(  size + 1 == compressed.size() && compressed.back() == 0 && std::equal( input.begin(), input.end(), output.begin() )  );
+			}
+		}
+		for( size_t i = 0; i < compressed.size(); i += 1 + i / 16 ){
+			std::vector<uint8_t> damaged = compressed;
+			damaged[i] ^= 0xFF;
+			lzDecompress( damaged.data(), damaged.size(), output.data(), input.size() );
+		}
+	}
+
+	// a match before the start of the output
+	const uint8_t badOffset[] = { 0x10, 'a', 0x05, 0x00 };
+	uint8_t output[16];
+	CHECK(  !lzDecompress( badOffset, sizeof( badOffset ), output, 5 )  );
+	const uint8_t zeroOffset[] = { 0x10, 'a', 0x00, 0x00 };
+	CHECK(  !lzDecompress( zeroOffset, sizeof( zeroOffset ), output, 5 )  );
+
+	for( uint32_t seed = 0; seed < 200; ++seed ){
+		const std::vector<uint8_t> garbage = makeBytes( 1 + seed % 97, seed, 256 );
+		lzDecompress( garbage.data(), garbage.size(), output, sizeof( output ) );
+	}
+}
+
+static void testChunkCodec(){
+	Chunk terrain, wide;
+	generateTestTerrain( TestTerrain::caves, {0, 0, 0}, terrain );
+	std::vector<BlockId> blocks( Chunk::volume );
+	for( uint32_t i = 0; i < Chunk::volume; ++i ) blocks[i] = BlockId( i % 300 ); // more than 256 blocks: 2-byte indices
+	wide.setSpan( 0, Chunk::volume, blocks.data() );
+
+	std::vector<uint8_t> bytes;
+	for( const Chunk& chunk : {Chunk(), Chunk( Block::stone ), terrain, wide} ){
+		encodeChunk( chunk, bytes );
+		Chunk decoded( Block::water );
+		CHECK(  decodeChunk( bytes.data(), bytes.size(), decoded )  );
+		CHECK(  getBlocks( decoded ) == getBlocks( chunk )  );
+
+		// a failed decode leaves the chunk alone
+		const std::vector<BlockId> before = getBlocks( terrain );
+		Chunk untouched = terrain;
+		for( size_t size = 0; size < bytes.size(); size += 1 + size / 8 ) CHECK(  !decodeChunk( bytes.data(), size, untouched )  );
+		std::vector<uint8_t> damaged = bytes;
+		damaged[0] ^= 0xFF; // the format
+		CHECK(  !decodeChunk( damaged.data(), damaged.size(), untouched )  );
+		damaged = bytes;
+		damaged[1] ^= 0x10; // the raw size
+		CHECK(  !decodeChunk( damaged.data(), damaged.size(), untouched )  );
+		CHECK(  getBlocks( untouched ) == before  );
+		for( size_t i = 5; i < bytes.size(); i += 1 + i / 16 ){
+			damaged = bytes;
+			damaged[i] ^= 0xFF;
+			decodeChunk( damaged.data(), damaged.size(), untouched );
+		}
+	}
+}
+
+static void testRegionFile(){
+	const std::string path = "StorageTest.region";
+	std::remove( path.c_str() );
+
+	const std::vector<uint8_t> small = makeBytes( 100, 3, 256 ), large = makeBytes( 3000, 4, 256 ), other = makeBytes( 700, 5, 256 );
+	std::vector<uint8_t> payload;
+	{
+		RegionFile region( path );
+		CHECK( !region.has( 0 ) && !region.read( 0, payload ) );
+
+		region.write( 0, small.data(), uint32_t( small.size() ) );
+		region.write( 1, large.data(), uint32_t( large.size() ) );
+		region.write( RegionFile::slotCount - 1, other.data(), uint32_t( other.size() ) );
+		region.write( 0, large.data(), uint32_t( large.size() ) ); // grows
+		region.write( 1, small.data(), uint32_t( small.size() ) ); // shrinks, and still goes elsewhere
+		CHECK( region.read( 0, payload ) && payload == large );
+		CHECK( region.read( 1, payload ) && payload == small );
+		CHECK( region.getFreeSectorCount() > 0 );
+
+		region.write( 2, small.data(), uint32_t( small.size() ) );
+		region.erase( 2 );
+		CHECK( !region.has( 2 ) );
+		region.flush();
+	}
+
+	{
+		RegionFile region( path );
+		CHECK( region.read( 0, payload ) && payload == large );
+		CHECK( region.read( 1, payload ) && payload == small );
+		CHECK( region.read( RegionFile::slotCount - 1, payload ) && payload == other );
+		CHECK( !region.has( 2 ) );
+
+		const uint32_t sectorCount = region.getSectorCount();
+		CHECK( region.getFreeSectorCount() > 0 );
+		region.compact();
+		CHECK( region.getFreeSectorCount() == 0 );
+		CHECK( region.getSectorCount() < sectorCount );
+		CHECK( region.read( 0, payload ) && payload == large );
+		CHECK( region.read( 1, payload ) && payload == small );
+		CHECK( region.read( RegionFile::slotCount - 1, payload ) && payload == other );
+	}
+
+	// a payload torn by a crash reads as missing, the others as they were
+	flipByte( path, 10 ); // the last payload of the compacted file is the one of the last slot
+	{
+		RegionFile region( path );
+		CHECK( !region.read( RegionFile::slotCount - 1, payload ) );
+		CHECK( region.read( 0, payload ) && payload == large );
+	}
+	std::remove( path.c_str() );
+
+	// not a region file
+	const std::string notRegion = "StorageTest.txt";
+	FILE* const file = std::fopen( notRegion.c_str(), "wb" );
+	if( CHECK( file != nullptr ) ){
+		const std::vector<uint8_t> junk( RegionFile::headerSectors * RegionFile::sectorSize, 'x' );
+		std::fwrite( junk.data(), 1, junk.size(), file );
+		std::fclose( file );
+	}
+	bool threw = false;
+	try{
+		RegionFile region( notRegion );
+	}
+	catch( ... ){
+		threw = true;
+	}
+	CHECK( threw );
+	std::remove( notRegion.c_str() );
+}
+
+static void testWorldStorage(){
+	const ChunkCoord coords[] = { {-33, 5, 7}, {-34, 5, 7}, {-33, 6, 7} };
+	std::vector<std::string> paths;
+	Chunk terrain, loaded;
+	generateTestTerrain( TestTerrain::hills, {0, 0, 0}, terrain );
+	{
+		WorldStorage storage( "" );
+		for( const ChunkCoord coord : coords ) paths.push_back(  storage.getRegionPath( WorldStorage::toRegionCoord( coord ) )  );
+		for( const std::string& path : paths ) std::remove( path.c_str() );
+
+		storage.save( coords[0], terrain );
+		storage.save( coords[1], Chunk( Block::sand ) );
+
+		// bytes that are no chunk, e.g. saved by a broken build, load as never saved
+		const std::vector<uint8_t> notChunk = { 1, 100, 0, 0, 0, 0xFF, 0xFF };
+		storage.saveEncoded( coords[2], notChunk );
+	}
+	{
+		WorldStorage storage( "" );
+		CHECK(  storage.load( coords[0], loaded ) && getBlocks( loaded ) == getBlocks( terrain )  );
+		CHECK(  storage.load( coords[1], loaded ) && getBlocks( loaded ) == getBlocks( Chunk( Block::sand ) )  );
+		CHECK(  !storage.load( coords[2], loaded ) && getBlocks( loaded ) == getBlocks( Chunk( Block::sand ) )  );
+		CHECK( storage.getStatistics().corrupt == 1 );
+		CHECK(  !storage.load( {-33, 5, 8}, loaded )  );
+
+		// probing a region without a file creates none; the first save does
+		const ChunkCoord unsaved = { 1000, 0, 0 };
+		paths.push_back(  storage.getRegionPath( WorldStorage::toRegionCoord( unsaved ) )  );
+		std::remove( paths.back().c_str() );
+		CHECK(  !storage.has( unsaved ) && !storage.load( unsaved, loaded )  );
+		storage.erase( unsaved );
+		CHECK(  !fileExists( paths.back() )  );
+		storage.save( unsaved, terrain );
+		CHECK(  fileExists( paths.back() ) && storage.has( unsaved )  );
+		CHECK(  storage.load( unsaved, loaded ) && getBlocks( loaded ) == getBlocks( terrain )  );
+	}
+	for( const std::string& path : paths ) std::remove( path.c_str() );
+}
+
+static void testAtomicFile(){
+	const std::string path = "StorageTest.bin";
+	const std::vector<uint8_t> first = makeBytes( 1000, 6, 256 ), second = makeBytes( 300, 7, 256 );
+	std::remove( path.c_str() );
+
+	// creates, then replaces a longer file with a shorter one, leaving no temporary file behind
+	CHECK(  writeFileAtomically( path, first.data(), first.size() )  );
+	CHECK(  writeFileAtomically( path, second.data(), second.size() )  );
+	std::vector<uint8_t> read( 2000 );
+	FILE* const file = std::fopen( path.c_str(), "rb" );
+	if( CHECK( file != nullptr ) ){
+		read.resize(  std::fread( read.data(), 1, read.size(), file )  );
+		std::fclose( file );
+		CHECK( read == second );
+	}
+	CHECK(  !fileExists( path + ".tmp" )  );
+	std::remove( path.c_str() );
+
+	CHECK(  !writeFileAtomically( "no such directory/" + path, first.data(), first.size() )  );
+}
+
+int main(){
+	testLz();
+	testChunkCodec();
+	testRegionFile();
+	testWorldStorage();
+	testAtomicFile();
+	return testResult();
+}
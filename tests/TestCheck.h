@@ -0,0 +1,31 @@
+// Minimal checks for the test executables: each failed check is reported, and testResult() is what main() returns
+
+#ifndef COMMON_TEST_CHECK_H
+#define COMMON_TEST_CHECK_H
+
+#include <cstdlib>
+#include <iostream>
+
+
+inline int& testFailures(){
+	static int failures = 0;
+	return failures;
+}
+
+// keeps going after a failure, so one run reports all of them
+inline bool check( const bool condition, const char* const what, const char* const file, const int line ){
+	if( !condition ){
+		std::cout << file << ":" << line << ": FAILED: " << what << std::endl;
+		++testFailures();
+	}
+	return condition;
+}
+
+#define CHECK( condition ) check( (condition), #condition, __FILE__, __LINE__ )
+
+inline int testResult(){
+	if( testFailures() ) std::cout << testFailures() << " checks failed" << std::endl;
+	return testFailures() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif //COMMON_TEST_CHECK_H